@@ -41,6 +41,14 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/queue.h"
 
 namespace ns3 {
 
@@ -86,6 +94,13 @@ OnOffApplication::GetTypeId (void)
                    TypeIdValue (UdpSocketFactory::GetTypeId ()),
                    MakeTypeIdAccessor (&OnOffApplication::m_tid),
                    MakeTypeIdChecker ())
+    .AddAttribute ("Fluid",
+                   "Whether the traffic is background load added as a rate to the "
+                   "transmit queues on the route to the destination, rather than "
+                   "sent as packets.  The destination must be an IPv4 address.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&OnOffApplication::m_fluid),
+                   MakeBooleanChecker ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&OnOffApplication::m_txTrace),
                      "ns3::Packet::TracedCallback")
@@ -99,7 +114,9 @@ OnOffApplication::OnOffApplication ()
     m_connected (false),
     m_residualBits (0),
     m_lastStartTime (Seconds (0)),
-    m_totBytes (0)
+    m_totBytes (0),
+    m_fluid (false),
+    m_fluidOn (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -138,6 +155,7 @@ OnOffApplication::DoDispose (void)
   NS_LOG_FUNCTION (this);
 
   m_socket = 0;
+  m_fluidPath.clear ();
   // chain up
   Application::DoDispose ();
 }
@@ -147,6 +165,18 @@ void OnOffApplication::StartApplication () // Called at time specified by Start
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_fluid)
+    {
+      // no socket: the traffic is added to the queues on the route
+      if (m_fluidPath.empty ())
+        {
+          ResolveFluidPath ();
+        }
+      CancelEvents ();
+      ScheduleStartEvent ();
+      return;
+    }
+
   // Create the socket if not already
   if (!m_socket)
     {
@@ -183,6 +213,11 @@ void OnOffApplication::StopApplication () // Called at time specified by Stop
   NS_LOG_FUNCTION (this);
 
   CancelEvents ();
+  if (m_fluid)
+    {
+      SetFluidOn (false);
+      return;
+    }
   if(m_socket != 0)
     {
       m_socket->Close ();
@@ -214,6 +249,26 @@ void OnOffApplication::StartSending ()
 {
   NS_LOG_FUNCTION (this);
   m_lastStartTime = Simulator::Now ();
+  if (m_fluid)
+    {
+      if (m_maxBytes > 0 && m_totBytes >= m_maxBytes)
+        {
+          return;
+        }
+      SetFluidOn (true);
+      ScheduleStopEvent ();
+      if (m_maxBytes > 0)
+        {
+          // stop once the last bytes are sent
+          Time left = Seconds ((m_maxBytes - m_totBytes) * 8.0 / m_fluidRate.GetBitRate ());
+          if (left < Simulator::GetDelayLeft (m_startStopEvent))
+            {
+              Simulator::Cancel (m_startStopEvent);
+              m_startStopEvent = Simulator::Schedule (left, &OnOffApplication::StopSending, this);
+            }
+        }
+      return;
+    }
   ScheduleNextTx ();  // Schedule the send packet event
   ScheduleStopEvent ();
 }
@@ -223,6 +278,14 @@ void OnOffApplication::StopSending ()
   NS_LOG_FUNCTION (this);
   CancelEvents ();
 
+  if (m_fluid)
+    {
+      SetFluidOn (false);
+      if (m_maxBytes > 0 && m_totBytes >= m_maxBytes)
+        {
+          return;
+        }
+    }
   ScheduleStartEvent ();
 }
 
@@ -299,6 +362,104 @@ void OnOffApplication::SendPacket ()
 }
 
 
+void OnOffApplication::ResolveFluidPath ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!InetSocketAddress::IsMatchingType (m_peer))
+    {
+      NS_FATAL_ERROR ("OnOffApplication: fluid traffic needs an IPv4 destination");
+    }
+  Ipv4Address destination = InetSocketAddress::ConvertFrom (m_peer).GetIpv4 ();
+  Ptr<Node> node = GetNode ();
+  Time delay = Seconds (0);
+  // follow the route hop by hop, as a packet would be forwarded
+  for (uint32_t hop = 0; hop < 64; ++hop)
+    {
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      if (ipv4 == 0 || ipv4->GetInterfaceForAddress (destination) >= 0)
+        {
+          return;
+        }
+      Ipv4Header header;
+      header.SetDestination (destination);
+      Socket::SocketErrno error;
+      Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol ()->RouteOutput (0, header, 0, error);
+      if (route == 0)
+        {
+          NS_LOG_WARN ("No route to " << destination << " from node " << node->GetId ());
+          return;
+        }
+      Ptr<NetDevice> device = route->GetOutputDevice ();
+      PointerValue queue;
+      if (device->GetAttributeFailSafe ("TxQueue", queue) && queue.Get<Queue> () != 0)
+        {
+          NS_LOG_LOGIC ("Fluid through the queue of device " << device->GetIfIndex ()
+                        << " of node " << node->GetId () << " after " << delay);
+          m_fluidPath.push_back (std::make_pair (queue.Get<Queue> (), delay));
+        }
+      Ptr<Channel> channel = device->GetChannel ();
+      if (channel == 0)
+        {
+          return;
+        }
+      TimeValue channelDelay;
+      if (channel->GetAttributeFailSafe ("Delay", channelDelay))
+        {
+          delay += channelDelay.Get ();
+        }
+      Ipv4Address gateway = route->GetGateway ();
+      if (gateway == Ipv4Address::GetAny ())
+        {
+          gateway = destination;
+        }
+      Ptr<Node> next = 0;
+      for (uint32_t i = 0; i < channel->GetNDevices () && next == 0; ++i)
+        {
+          Ptr<NetDevice> peer = channel->GetDevice (i);
+          Ptr<Ipv4> peerIpv4 = peer->GetNode ()->GetObject<Ipv4> ();
+          if (peer != device && peerIpv4 != 0 && peerIpv4->GetInterfaceForAddress (gateway) >= 0)
+            {
+              next = peer->GetNode ();
+            }
+        }
+      if (next == 0 || next->GetSystemId () != GetNode ()->GetSystemId ())
+        {
+          return;
+        }
+      node = next;
+    }
+}
+
+void OnOffApplication::SetFluidOn (bool on)
+{
+  NS_LOG_FUNCTION (this << on);
+  if (on == m_fluidOn)
+    {
+      return;
+    }
+  m_fluidOn = on;
+  if (on)
+    {
+      m_fluidRate = m_cbrRate;
+    }
+  else
+    {
+      Time delta = Simulator::Now () - m_lastStartTime;
+      m_totBytes += static_cast<uint32_t> (delta.GetSeconds () * m_fluidRate.GetBitRate () / 8 + 0.5);
+      if (m_maxBytes > 0 && m_totBytes > m_maxBytes)
+        {
+          m_totBytes = m_maxBytes;
+        }
+    }
+  for (uint32_t i = 0; i < m_fluidPath.size (); ++i)
+    {
+      Simulator::Schedule (m_fluidPath[i].second,
+                           on ? &Queue::AddFluid : &Queue::RemoveFluid,
+                           m_fluidPath[i].first, m_fluidRate, m_pktSize);
+    }
+}
+
 void OnOffApplication::ConnectionSucceeded (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
@@ -31,12 +31,16 @@
 #include "ns3/ptr.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+
+#include <vector>
 
 namespace ns3 {
 
 class Address;
 class RandomVariableStream;
 class Socket;
+class Queue;
 
 /**
  * \ingroup applications 
@@ -82,6 +86,16 @@ class Socket;
 *
 * If the underlying socket type supports broadcast, this application
 * will automatically enable the SetAllowBroadcast(true) socket option.
+*
+* With the Fluid attribute set, the traffic is background load
+* represented by its rate rather than by packets: during the "On"
+* state, the rate is added, with Queue::AddFluid, to the transmit queues
+* of the devices on the IPv4 route to the destination, each after the
+* propagation delay of the channels before it, and no packet is sent.
+* The fluid is offered to every queue of the route at the data rate:
+* the losses and the queueing upstream do not shape it.  The route is
+* resolved when the application starts; it ends at the first node of
+* another system, in a distributed simulation.
 */
 class OnOffApplication : public Application 
 {
@@ -147,6 +161,15 @@ private:
    * \brief Send a packet
    */
   void SendPacket ();
+  /**
+   * \brief Find the transmit queues on the route to the destination
+   */
+  void ResolveFluidPath ();
+  /**
+   * \brief Start or stop the fluid flow along its route
+   * \param on whether the fluid flows
+   */
+  void SetFluidOn (bool on);
 
   Ptr<Socket>     m_socket;       //!< Associated socket
   Address         m_peer;         //!< Peer address
@@ -163,6 +186,11 @@ private:
   EventId         m_startStopEvent;     //!< Event id for next start or stop event
   EventId         m_sendEvent;    //!< Event id of pending "send packet" event
   TypeId          m_tid;          //!< Type of the socket used
+  bool            m_fluid;        //!< True if the traffic is fluid
+  bool            m_fluidOn;      //!< True if the fluid flows
+  DataRate        m_fluidRate;    //!< Rate of the fluid flowing
+  /// The transmit queues on the route, with the delay to reach each
+  std::vector<std::pair<Ptr<Queue>, Time> > m_fluidPath;
 
   /// Traced Callback: transmitted packets.
   TracedCallback<Ptr<const Packet> > m_txTrace;
@@ -27,6 +27,8 @@
 #include "log.h"
 
 #include <sstream>
+#include <algorithm>
+#include <map>
 
 /**
  * \file
@@ -156,6 +158,9 @@ public:
   /**
    * Construct from a Config path specification.
    *
+   * The specification is parsed once, into the ranges of indexes
+   * it matches.
+   *
    * \param [in] element The Config path specification.
    */
   ArrayMatcher (std::string element);
@@ -166,7 +171,21 @@ public:
    * \returns \c true if the index matches the Config Path.
    */
   bool Matches (uint32_t i) const;
+  /**
+   * Get the indexes matching the Config Path, in increasing order.
+   *
+   * \param [in] limit The largest number of indexes to get.
+   * \param [out] indexes The matching indexes.
+   * \returns \c false if the Config Path matches more than \p limit indexes.
+   */
+  bool GetIndexes (uint32_t limit, std::vector<uint32_t> *indexes) const;
 private:
+  /**
+   * Parse a Config path specification, or one of its alternatives.
+   *
+   * \param [in] element The Config path specification.
+   */
+  void Parse (std::string element);
   /**
    * Convert a string to an \c uint32_t.
    *
@@ -177,78 +196,111 @@ private:
   bool StringToUint32 (std::string str, uint32_t *value) const;
   /** The Config path element. */
   std::string m_element;
+  /** Whether the Config path element matches every index. */
+  bool m_all;
+  /** The ranges of matching indexes, bounds included. */
+  std::vector<std::pair<uint32_t, uint32_t> > m_ranges;
 };
 
 
 ArrayMatcher::ArrayMatcher (std::string element)
-  : m_element (element)
+  : m_element (element),
+    m_all (false)
 {
   NS_LOG_FUNCTION (this << element);
+  Parse (element);
+  std::sort (m_ranges.begin (), m_ranges.end ());
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_all = true;
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      Parse (element.substr (0, tmp-0));
+      Parse (element.substr (tmp+1, element.size () - (tmp + 1)));
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
       if (StringToUint32 (lowerBound, &min) && 
           StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
+          min <= max)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          m_ranges.push_back (std::make_pair (min, max));
         }
+      return;
     }
   uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  if (StringToUint32 (element, &value))
+    {
+      m_ranges.push_back (std::make_pair (value, value));
+    }
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_all)
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+      NS_LOG_DEBUG ("Array "<<i<<" matches *");
       return true;
     }
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator j = m_ranges.begin ();
+       j != m_ranges.end () && j->first <= i; j++)
+    {
+      if (i <= j->second)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
+    }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
 
+bool
+ArrayMatcher::GetIndexes (uint32_t limit, std::vector<uint32_t> *indexes) const
+{
+  NS_LOG_FUNCTION (this << limit << indexes);
+  indexes->clear ();
+  if (m_all)
+    {
+      return false;
+    }
+  // the ranges are sorted, but may overlap
+  uint64_t next = 0;
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator j = m_ranges.begin ();
+       j != m_ranges.end (); j++)
+    {
+      for (uint64_t k = std::max<uint64_t> (j->first, next); k <= j->second; k++)
+        {
+          if (indexes->size () >= limit)
+            {
+              return false;
+            }
+          indexes->push_back (k);
+        }
+      next = std::max<uint64_t> (next, uint64_t (j->second) + 1);
+    }
+  return true;
+}
+
 bool
 ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
 {
@@ -259,54 +311,248 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
   return !iss.bad () && !iss.fail ();
 }
 
+/**
+ * A Config path, split once into its elements.
+ *
+ * The Config paths are compiled the first time they are used,
+ * and cached by ConfigImpl.
+ */
+class CompiledPath : public SimpleRefCount<CompiledPath>
+{
+public:
+  /**
+   * Construct from a Config path.
+   *
+   * \param [in] path The Config path.
+   */
+  CompiledPath (std::string path);
+  /**
+   * Get the number of elements of the path.
+   *
+   * \returns The number of elements.
+   */
+  uint32_t GetN (void) const;
+  /**
+   * Get an element of the path.
+   *
+   * \param [in] i The index of the element.
+   * \returns The element.
+   */
+  const std::string & GetItem (uint32_t i) const;
+  /**
+   * Get the array indexes matched by an element of the path.
+   *
+   * \param [in] i The index of the element.
+   * \returns The matcher of the element.
+   */
+  const ArrayMatcher & GetMatcher (uint32_t i) const;
+private:
+  /** The elements of the path, between the slashes. */
+  std::vector<std::string> m_items;
+  /** The matchers of the elements, used for the array indexes. */
+  std::vector<ArrayMatcher> m_matchers;
+};
+
+CompiledPath::CompiledPath (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+
+  // ensure that we start and end with a '/'
+  std::string::size_type tmp = path.find ("/");
+  if (tmp != 0)
+    {
+      // no slash at start
+      path = "/" + path;
+    }
+  tmp = path.find_last_of ("/");
+  if (tmp != (path.size () - 1))
+    {
+      // no slash at end
+      path = path + "/";
+    }
+
+  std::string::size_type start = 1;
+  std::string::size_type next;
+  while ((next = path.find ("/", start)) != std::string::npos)
+    {
+      std::string item = path.substr (start, next - start);
+      m_items.push_back (item);
+      m_matchers.push_back (ArrayMatcher (item));
+      start = next + 1;
+    }
+}
+uint32_t
+CompiledPath::GetN (void) const
+{
+  return m_items.size ();
+}
+const std::string &
+CompiledPath::GetItem (uint32_t i) const
+{
+  return m_items[i];
+}
+const ArrayMatcher &
+CompiledPath::GetMatcher (uint32_t i) const
+{
+  return m_matchers[i];
+}
+
+/** An attribute holding objects, to which a Config path element resolves. */
+struct ObjectAttribute
+{
+  std::string name;                       //!< The attribute name.
+  uint32_t flags;                         //!< The attribute flags.
+  Ptr<const AttributeAccessor> accessor;  //!< The attribute accessor.
+  bool isContainer;                       //!< The attribute is a container of objects, not a pointer.
+};
+
+/**
+ * Get the attributes holding objects which a Config path element
+ * resolves to, for the instances of a TypeId.
+ *
+ * The attributes are looked up once per TypeId and element.
+ *
+ * \param [in] tid The instance TypeId.
+ * \param [in] item The Config path element: an attribute name, or "*".
+ * \returns The matching attributes, from the TypeId to its ancestors.
+ */
+static const std::vector<ObjectAttribute> &
+LookupObjectAttributes (TypeId tid, const std::string &item)
+{
+  NS_LOG_FUNCTION (tid << item);
+  typedef std::map<std::pair<uint16_t, std::string>, std::vector<ObjectAttribute> > Cache;
+  static Cache cache;
+  std::pair<uint16_t, std::string> key (tid.GetUid (), item);
+  Cache::const_iterator it = cache.find (key);
+  if (it != cache.end ())
+    {
+      return it->second;
+    }
+
+  std::vector<ObjectAttribute> &attributes = cache[key];
+  TypeId nextTid = tid;
+  do
+    {
+      tid = nextTid;
+      for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+        {
+          struct TypeId::AttributeInformation info;
+          info = tid.GetAttribute(i);
+          if (info.name != item && item != "*")
+            {
+              continue;
+            }
+          ObjectAttribute attribute;
+          attribute.name = info.name;
+          attribute.flags = info.flags;
+          attribute.accessor = info.accessor;
+          // attempt to cast to a pointer checker, or an object vector.
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.isContainer = false;
+              attributes.push_back (attribute);
+            }
+          else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.isContainer = true;
+              attributes.push_back (attribute);
+            }
+          // this could be anything else and we don't know what to do with it.
+          // So, we just ignore it.
+        }
+      nextTid = tid.GetParent ();
+    } while (nextTid != tid);
+  return attributes;
+}
+
+/**
+ * Get the value of an attribute holding objects.
+ *
+ * \param [in] object The object holding the attribute.
+ * \param [in] attribute The attribute.
+ * \param [out] value The value of the attribute.
+ */
+static void
+GetObjectAttribute (Ptr<Object> object, const ObjectAttribute &attribute, AttributeValue &value)
+{
+  if (!(attribute.flags & TypeId::ATTR_GET) || !attribute.accessor->HasGetter () ||
+      !attribute.accessor->Get (PeekPointer (object), value))
+    {
+      // let the attribute system report the error
+      object->GetAttribute (attribute.name, value);
+    }
+}
+
 /**
  * Abstract class to parse Config paths into object references.
+ *
+ * Several Config paths can be resolved in a single traversal of the
+ * objects: the paths sharing a prefix share its traversal.
  */
 class Resolver
 {
 public:
   /**
-   * Construct from a base Config path.
+   * Construct from base Config paths.
    *
-   * \param [in] path The Config path.
+   * \param [in] paths The compiled Config paths.
    */
-  Resolver (std::string path);
+  Resolver (const std::vector<Ptr<const CompiledPath> > &paths);
   /** Destructor. */
   virtual ~Resolver ();
 
   /**
-   * Parse the stored Config path into an object reference,
+   * Parse the stored Config paths into object references,
    * beginning at the indicated root object.
    *
    * \param [in] root The object corresponding to the current position in
-   *                  in the Config path.
+   *                  in the Config paths.
    */
   void Resolve (Ptr<Object> root);
   
 private:
-  /** Ensure the Config path starts and ends with a '/'. */
-  void Canonicalize (void);
+  /** A position in one of the Config paths. */
+  struct Cursor
+  {
+    uint32_t path;     //!< The index of the Config path.
+    uint32_t element;  //!< The index of the next element of the Config path.
+  };
+  /** The positions in the Config paths sharing an element, by element. */
+  typedef std::map<std::string, std::vector<Cursor> > CursorGroups;
+
+  /**
+   * Parse the next element of the Config paths.
+   *
+   * \param [in] cursors The current positions in the Config paths.
+   * \param [in] root The object corresponding to the current positon
+   *                  in the Config paths.
+   */
+  void DoResolve (const std::vector<Cursor> &cursors, Ptr<Object> root);
   /**
-   * Parse the next element in the Config path.
+   * Parse one element shared by Config paths.
    *
-   * \param [in] path The remaining portion of the Config path.
+   * \param [in] item The element.
+   * \param [in] cursors The positions in the Config paths after the element.
    * \param [in] root The object corresponding to the current positon
-   *                  in the Config path.
+   *                  in the Config paths.
    */
-  void DoResolve (std::string path, Ptr<Object> root);
+  void DoResolveItem (const std::string &item, const std::vector<Cursor> &cursors, Ptr<Object> root);
   /**
-   * Parse an index on the Config path.
+   * Parse an index on the Config paths.
    *
-   * \param [in] path The remaining Config path.
-   * \param [in,out] vector The resulting list of matching objects.
+   * \param [in] cursors The positions in the Config paths, on the index.
+   * \param [in] root The object holding the container.
+   * \param [in] attribute The container attribute.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoArrayResolve (const std::vector<Cursor> &cursors, Ptr<Object> root,
+                       const ObjectAttribute &attribute);
   /**
-   * Handle one object found on the path.
+   * Handle one object found on a path.
    *
+   * \param [in] path The index of the Config path.
    * \param [in] object The current object on the Config path.
    */
-  void DoResolveOne (Ptr<Object> object);
+  void DoResolveOne (uint32_t path, Ptr<Object> object);
   /**
    * Get the current Config path.
    *
@@ -316,53 +562,42 @@ private:
   /**
    * Handle one found object.
    *
+   * \param [in] path The index of the Config path.
    * \param [in] object The found object.
-   * \param [in] path The matching Config path context.
+   * \param [in] context The matching Config path context.
    */
-  virtual void DoOne (Ptr<Object> object, std::string path) = 0;
+  virtual void DoOne (uint32_t path, Ptr<Object> object, std::string context) = 0;
 
   /** Current list of path tokens. */
   std::vector<std::string> m_workStack;
-  /** The Config path. */
-  std::string m_path;
+  /** The Config paths. */
+  std::vector<Ptr<const CompiledPath> > m_paths;
 };
 
-Resolver::Resolver (std::string path)
-  : m_path (path)
+Resolver::Resolver (const std::vector<Ptr<const CompiledPath> > &paths)
+  : m_paths (paths)
 {
-  NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
+  NS_LOG_FUNCTION (this << paths.size ());
 }
 Resolver::~Resolver ()
 {
   NS_LOG_FUNCTION (this);
 }
-void
-Resolver::Canonicalize (void)
-{
-  NS_LOG_FUNCTION (this);
-
-  // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
-  if (tmp != 0)
-    {
-      // no slash at start
-      m_path = "/" + m_path;
-    }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
-    {
-      // no slash at end
-      m_path = m_path + "/";
-    }
-}
 
 void 
 Resolver::Resolve (Ptr<Object> root)
 {
   NS_LOG_FUNCTION (this << root);
 
-  DoResolve (m_path, root);
+  std::vector<Cursor> cursors;
+  for (uint32_t i = 0; i < m_paths.size (); i++)
+    {
+      Cursor cursor;
+      cursor.path = i;
+      cursor.element = 0;
+      cursors.push_back (cursor);
+    }
+  DoResolve (cursors, root);
 }
 
 std::string
@@ -379,39 +614,52 @@ Resolver::GetResolvedPath (void) const
 }
 
 void 
-Resolver::DoResolveOne (Ptr<Object> object)
+Resolver::DoResolveOne (uint32_t path, Ptr<Object> object)
 {
-  NS_LOG_FUNCTION (this << object);
+  NS_LOG_FUNCTION (this << path << object);
 
   NS_LOG_DEBUG ("resolved="<<GetResolvedPath ());
-  DoOne (object, GetResolvedPath ());
+  DoOne (path, object, GetResolvedPath ());
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+Resolver::DoResolve (const std::vector<Cursor> &cursors, Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << cursors.size () << root);
 
-  if (next == std::string::npos)
+  CursorGroups groups;
+  for (std::vector<Cursor>::const_iterator i = cursors.begin (); i != cursors.end (); i++)
     {
-      //
-      // If root is zero, we're beginning to see if we can use the object name 
-      // service to resolve this path.  It is impossible to have a object name 
-      // associated with the root of the object name service since that root
-      // is not an object.  This path must be referring to something in another
-      // namespace and it will have been found already since the name service
-      // is always consulted last.
-      // 
-      if (root)
+      if (i->element == m_paths[i->path]->GetN ())
         {
-          DoResolveOne (root);
+          //
+          // If root is zero, we're beginning to see if we can use the object name 
+          // service to resolve this path.  It is impossible to have a object name 
+          // associated with the root of the object name service since that root
+          // is not an object.  This path must be referring to something in another
+          // namespace and it will have been found already since the name service
+          // is always consulted last.
+          // 
+          if (root)
+            {
+              DoResolveOne (i->path, root);
+            }
+          continue;
         }
-      return;
+      Cursor next = *i;
+      next.element++;
+      groups[m_paths[i->path]->GetItem (i->element)].push_back (next);
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  for (CursorGroups::const_iterator i = groups.begin (); i != groups.end (); i++)
+    {
+      DoResolveItem (i->first, i->second, root);
+    }
+}
+
+void
+Resolver::DoResolveItem (const std::string &item, const std::vector<Cursor> &cursors, Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << item << cursors.size () << root);
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -422,11 +670,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   //
   if (root == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
+      if (item.compare (0, 5, "Names") == 0)
         {
           m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
+          DoResolve (cursors, root);
           m_workStack.pop_back ();
           return;
         }
@@ -443,7 +690,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
       m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      DoResolve (cursors, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -473,69 +720,43 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
           return;
         }
       m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      DoResolve (cursors, object);
       m_workStack.pop_back ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
-      bool foundMatch = false;
-      
-      do
+      const std::vector<ObjectAttribute> &attributes =
+        LookupObjectAttributes (root->GetInstanceTypeId (), item);
+      for (std::vector<ObjectAttribute>::const_iterator i = attributes.begin (); i != attributes.end (); i++)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          if (!i->isContainer)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
+              PointerValue ptr;
+              GetObjectAttribute (root, *i, ptr);
+              Ptr<Object> object = ptr.Get<Object> ();
+              if (object == 0)
                 {
+                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
                   continue;
                 }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
-                }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
-                }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              m_workStack.push_back (i->name);
+              DoResolve (cursors, object);
+              m_workStack.pop_back ();
             }
-
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath ());
+              m_workStack.push_back (i->name);
+              DoArrayResolve (cursors, root, *i);
+              m_workStack.pop_back ();
+            }
+        }
       
-      if (!foundMatch)
+      if (attributes.empty ())
         {
           NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
           return;
@@ -544,29 +765,82 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (const std::vector<Cursor> &cursors, Ptr<Object> root,
+                          const ObjectAttribute &attribute)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION(this << cursors.size () << root << attribute.name);
+
+  // the paths ending with the container match nothing
+  CursorGroups groups;
+  for (std::vector<Cursor>::const_iterator i = cursors.begin (); i != cursors.end (); i++)
     {
-      return;
+      if (i->element < m_paths[i->path]->GetN ())
+        {
+          Cursor next = *i;
+          next.element++;
+          groups[m_paths[i->path]->GetItem (i->element)].push_back (next);
+        }
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
 
-  ArrayMatcher matcher = ArrayMatcher (item);
-  ObjectPtrContainerValue::Iterator it;
-  for (it = container.Begin (); it != container.End (); ++it)
+  const ObjectPtrContainerAccessor *accessor =
+    dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (attribute.accessor));
+  ObjectPtrContainerValue container;
+  bool haveContainer = false;
+  for (CursorGroups::const_iterator i = groups.begin (); i != groups.end (); i++)
     {
-      if (matcher.Matches ((*it).first))
+      Cursor cursor = i->second.front ();
+      const ArrayMatcher &matcher = m_paths[cursor.path]->GetMatcher (cursor.element - 1);
+      std::vector<std::pair<uint32_t, Ptr<Object> > > matches;
+
+      //
+      // Look the matching indexes up directly when the container is indexed
+      // by position, such as the NodeList, rather than copying it whole.
+      //
+      std::vector<uint32_t> indexes;
+      uint32_t n;
+      bool found = accessor != 0 && (attribute.flags & TypeId::ATTR_GET)
+        && accessor->GetN (PeekPointer (root), &n)
+        && matcher.GetIndexes (n, &indexes);
+      for (std::vector<uint32_t>::const_iterator j = indexes.begin (); found && j != indexes.end (); j++)
+        {
+          uint32_t index = *j;
+          Ptr<Object> object;
+          if (index < n)
+            {
+              object = accessor->GetElement (PeekPointer (root), *j, &index);
+            }
+          if (index != *j || *j >= n)
+            {
+              found = false;
+              break;
+            }
+          matches.push_back (std::make_pair (index, object));
+        }
+      if (!found)
+        {
+          matches.clear ();
+          if (!haveContainer)
+            {
+              GetObjectAttribute (root, attribute, container);
+              haveContainer = true;
+            }
+          ObjectPtrContainerValue::Iterator it;
+          for (it = container.Begin (); it != container.End (); ++it)
+            {
+              if (matcher.Matches ((*it).first))
+                {
+                  matches.push_back (*it);
+                }
+            }
+        }
+
+      for (std::vector<std::pair<uint32_t, Ptr<Object> > >::const_iterator j = matches.begin ();
+           j != matches.end (); j++)
         {
           std::ostringstream oss;
-          oss << (*it).first;
+          oss << j->first;
           m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
+          DoResolve (i->second, j->second);
           m_workStack.pop_back ();
         }
     }
@@ -586,8 +860,10 @@ public:
   void DisconnectWithoutContext (std::string path, const CallbackBase &cb);
   /** \copydoc Config::Disconnect() */
   void Disconnect (std::string path, const CallbackBase &cb);
-  /** \copydoc Config::LookupMatches() */
+  /** \copydoc Config::LookupMatches(std::string) */
   Config::MatchContainer LookupMatches (std::string path);
+  /** \copydoc Config::LookupMatches(const std::vector<std::string>&) */
+  std::vector<Config::MatchContainer> LookupMatches (const std::vector<std::string> &paths);
 
   /** \copydoc Config::RegisterRootNamespaceObject() */
   void RegisterRootNamespaceObject (Ptr<Object> obj);
@@ -608,14 +884,33 @@ private:
    * \param [in,out] leaf The trailing part of the \p path.
    */
   void ParsePath (std::string path, std::string *root, std::string *leaf) const;
+  /**
+   * Get the compiled form of a Config path, compiling it
+   * the first time it is used.
+   * \param [in] path The Config path.
+   * \returns The compiled Config path.
+   */
+  Ptr<const CompiledPath> Compile (std::string path);
 
   /** Container type to hold the root Config path tokens. */
   typedef std::vector<Ptr<Object> > Roots;
+  /** Container type to hold the compiled Config paths. */
+  typedef std::map<std::string, Ptr<const CompiledPath> > CompiledPaths;
 
   /** The list of Config path roots. */
   Roots m_roots;
+  /** The compiled Config paths, by path. */
+  CompiledPaths m_compiledPaths;
 };
 
+/**
+ * The largest number of compiled Config paths kept by ConfigImpl.
+ * Scripts building their paths from the node and device indexes
+ * use each path only once, so the cache is cleared when full
+ * rather than growing with them.
+ */
+static const uint32_t MAX_COMPILED_PATHS = 1024;
+
 void 
 ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) const
 {
@@ -677,23 +972,60 @@ ConfigImpl::Disconnect (std::string path, const CallbackBase &cb)
   container.Disconnect (leaf, cb);
 }
 
+Ptr<const CompiledPath>
+ConfigImpl::Compile (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+
+  CompiledPaths::const_iterator it = m_compiledPaths.find (path);
+  if (it != m_compiledPaths.end ())
+    {
+      return it->second;
+    }
+  if (m_compiledPaths.size () >= MAX_COMPILED_PATHS)
+    {
+      m_compiledPaths.clear ();
+    }
+  Ptr<const CompiledPath> compiled = Create<CompiledPath> (path);
+  m_compiledPaths[path] = compiled;
+  return compiled;
+}
+
 Config::MatchContainer 
 ConfigImpl::LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
+  std::vector<std::string> paths;
+  paths.push_back (path);
+  return LookupMatches (paths).front ();
+}
+
+std::vector<Config::MatchContainer>
+ConfigImpl::LookupMatches (const std::vector<std::string> &paths)
+{
+  NS_LOG_FUNCTION (this << paths.size ());
   class LookupMatchesResolver : public Resolver 
   {
   public:
-    LookupMatchesResolver (std::string path)
-      : Resolver (path)
+    LookupMatchesResolver (const std::vector<Ptr<const CompiledPath> > &paths)
+      : Resolver (paths),
+        m_objects (paths.size ()),
+        m_contexts (paths.size ())
     {}
-    virtual void DoOne (Ptr<Object> object, std::string path) {
-      m_objects.push_back (object);
-      m_contexts.push_back (path);
+    virtual void DoOne (uint32_t path, Ptr<Object> object, std::string context) {
+      m_objects[path].push_back (object);
+      m_contexts[path].push_back (context);
     }
-    std::vector<Ptr<Object> > m_objects;
-    std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
+    std::vector<std::vector<Ptr<Object> > > m_objects;
+    std::vector<std::vector<std::string> > m_contexts;
+  };
+
+  std::vector<Ptr<const CompiledPath> > compiled;
+  for (std::vector<std::string>::const_iterator i = paths.begin (); i != paths.end (); i++)
+    {
+      compiled.push_back (Compile (*i));
+    }
+  LookupMatchesResolver resolver (compiled);
   for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
     {
       resolver.Resolve (*i);
@@ -706,7 +1038,12 @@ ConfigImpl::LookupMatches (std::string path)
   //
   resolver.Resolve (0);
 
-  return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
+  std::vector<Config::MatchContainer> containers;
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      containers.push_back (Config::MatchContainer (resolver.m_objects[i], resolver.m_contexts[i], paths[i]));
+    }
+  return containers;
 }
 
 void 
@@ -848,6 +1185,11 @@ Config::MatchContainer LookupMatches (std::string path)
   NS_LOG_FUNCTION (path);
   return ConfigImpl::Get ()->LookupMatches (path);
 }
+std::vector<Config::MatchContainer> LookupMatches (const std::vector<std::string> &paths)
+{
+  NS_LOG_FUNCTION (paths.size ());
+  return ConfigImpl::Get ()->LookupMatches (paths);
+}
 
 void RegisterRootNamespaceObject (Ptr<Object> obj)
 {
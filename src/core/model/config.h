@@ -257,6 +257,18 @@ private:
  *          path.
  */
 MatchContainer LookupMatches (std::string path);
+/**
+ * \ingroup config
+ * \param [in] paths The paths to perform a match against
+ * \returns One container per input path, in the same order, each of which
+ *          contains all the objects which match its path.
+ *
+ * The paths are resolved in a single traversal of the objects, the
+ * paths sharing a prefix sharing its resolution, so that looking many
+ * paths up together, for example one per node, is cheaper than looking
+ * each one up on its own.
+ */
+std::vector<MatchContainer> LookupMatches (const std::vector<std::string> &paths);
 
 /**
  * \ingroup config
@@ -220,6 +220,25 @@ public:
   virtual bool Get (const ObjectBase * object, AttributeValue &value) const;
   virtual bool HasGetter (void) const;
   virtual bool HasSetter (void) const;
+  /**
+   * Get the number of instances in the container.
+   *
+   * \param [in] object The container object.
+   * \param [out] n The number of instances in the container.
+   * \returns true if the value could be obtained successfully.
+   */
+  bool GetN (const ObjectBase *object, uint32_t *n) const;
+  /**
+   * Get one instance from the container, without copying the
+   * whole container into an ObjectPtrContainerValue.
+   *
+   * \param [in] object The container object.
+   * \param [in] i The position of the instance, less than the number
+   *            of instances.
+   * \param [out] index The index of the instance.
+   * \returns The instance.
+   */
+  Ptr<Object> GetElement (const ObjectBase *object, uint32_t i, uint32_t *index) const;
 private:
   /**
    * Get the number of instances in the container.
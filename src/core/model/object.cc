@@ -102,6 +102,7 @@ Object::Object ()
 {
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
+  m_aggregates->index = 0;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object () 
@@ -120,10 +121,13 @@ Object::~Object ()
           m_aggregates->n--;
         }
     }
+  // the lookups may have returned this object
+  ClearIndex (m_aggregates);
   // finally, if all objects have been removed from the list,
   // delete the aggregate list
   if (m_aggregates->n == 0)
     {
+      std::free (m_aggregates->index);
       std::free (m_aggregates);
     }
   m_aggregates = 0;
@@ -136,6 +140,7 @@ Object::Object (const Object &o)
     m_getObjectCount (0)
 {
   m_aggregates->n = 1;
+  m_aggregates->index = 0;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -151,6 +156,20 @@ Object::DoGetObject (TypeId tid) const
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
+  struct AggregatesIndex *index = m_aggregates->index;
+  if (index == 0)
+    {
+      index = (struct AggregatesIndex *) std::calloc (1, sizeof (struct AggregatesIndex));
+      m_aggregates->index = index;
+    }
+  uint16_t uid = tid.GetUid ();
+  uint32_t slot = uid & (AggregatesIndex::SIZE - 1);
+  if (uid != 0 && index->tid[slot] == uid)
+    {
+      return index->object[slot];
+    }
+
+  Object *found = 0;
   uint32_t n = m_aggregates->n;
   TypeId objectTid = Object::GetTypeId ();
   for (uint32_t i = 0; i < n; i++)
@@ -173,11 +192,14 @@ Object::DoGetObject (TypeId tid) const
           current->m_getObjectCount++;
           // then, update the sort
           UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
-          return const_cast<Object *> (current);
+          found = current;
+          break;
         }
     }
-  return 0;
+  // finally, remember the match for the next lookups of this TypeId
+  index->tid[slot] = uid;
+  index->object[slot] = found;
+  return found;
 }
 void
 Object::Initialize (void)
@@ -230,6 +252,15 @@ restart:
     }
 }
 void
+Object::ClearIndex (struct Aggregates *aggregates) const
+{
+  NS_LOG_FUNCTION (this << aggregates);
+  if (aggregates->index != 0)
+    {
+      std::memset (aggregates->index, 0, sizeof (struct AggregatesIndex));
+    }
+}
+void
 Object::UpdateSortedArray (struct Aggregates *aggregates, uint32_t j) const
 {
   NS_LOG_FUNCTION (this << aggregates << j);
@@ -264,6 +295,7 @@ Object::AggregateObject (Ptr<Object> o)
   struct Aggregates *aggregates = 
     (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
   aggregates->n = total;
+  aggregates->index = 0;
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -307,7 +339,9 @@ Object::AggregateObject (Ptr<Object> o)
     }
 
   // Now that we are done with them, we can free our old aggregate buffers
+  std::free (a->index);
   std::free (a);
+  std::free (b->index);
   std::free (b);
 }
 /**
@@ -333,6 +367,7 @@ Object::SetTypeId (TypeId tid)
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (Check ());
   m_tid = tid;
+  ClearIndex (m_aggregates);
 }
 
 void
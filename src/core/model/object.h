@@ -316,6 +316,25 @@ private:
   friend class AggregateIterator;
   friend struct ObjectDeleter;
 
+  /**
+   * The results of the lookups by TypeId in a list of aggregates.
+   *
+   * DoGetObject() looks the TypeId up in this direct-mapped table,
+   * indexed by the TypeId uid, before scanning the aggregates, and
+   * records the result of the scan, found or not.  The table belongs
+   * to an Aggregates list: it is dropped with the list when
+   * AggregateObject() replaces it, and cleared when an Object leaves
+   * the list or changes its TypeId.
+   */
+  struct AggregatesIndex {
+    /** The number of entries, a power of two. */
+    enum { SIZE = 16 };
+    /** The uid of the TypeId looked up, or 0 if the entry is empty. */
+    uint16_t tid[SIZE];
+    /** The matching aggregate, or 0 if there is none. */
+    Object *object[SIZE];
+  };
+
   /**
    * The list of Objects aggregated to this one.
    *
@@ -331,6 +350,8 @@ private:
   struct Aggregates {
     /** The number of entries in \c buffer. */
     uint32_t n;
+    /** The results of the lookups by TypeId, allocated on the first lookup. */
+    struct AggregatesIndex *index;
     /** The array of Objects. */
     Object *buffer[1];
   };
@@ -389,6 +410,12 @@ private:
    * \param [in] i The most recently used entry in the list.
    */
   void UpdateSortedArray (struct Aggregates *aggregates, uint32_t i) const;
+  /**
+   * Forget the results of the lookups by TypeId in a list of aggregates.
+   *
+   * \param [in,out] aggregates The list of aggregated Objects.
+   */
+  void ClearIndex (struct Aggregates *aggregates) const;
   /**
    * Attempt to delete this Object.
    *
@@ -21,7 +21,7 @@
 #ifndef TRACED_CALLBACK_H
 #define TRACED_CALLBACK_H
 
-#include <list>
+#include <vector>
 #include "callback.h"
 
 /**
@@ -32,6 +32,32 @@
 
 namespace ns3 {
 
+/**
+ * \ingroup tracing
+ * Type of the arguments of the TracedCallback functors: a constant
+ * reference, so that hitting a TracedCallback without Callbacks does
+ * not copy its arguments.
+ *
+ * \tparam T \explicit The argument type.
+ */
+template <typename T>
+struct TracedCallbackArg
+{
+  typedef const T & Type; //!< Constant reference to the argument type.
+};
+
+/**
+ * \ingroup tracing
+ * Type of the reference arguments of the TracedCallback functors.
+ *
+ * \tparam T \explicit The referenced type.
+ */
+template <typename T>
+struct TracedCallbackArg<T &>
+{
+  typedef T & Type; //!< The argument type, already a reference.
+};
+
 /**
  * \ingroup tracing
  * \brief Forward calls to a chain of Callback
@@ -46,6 +72,12 @@ namespace ns3 {
  * calling one of the \c operator() forms with the appropriate
  * number of arguments.
  *
+ * The functors take their arguments by constant reference and return
+ * right away when the chain is empty, so hitting a trace source which
+ * no sink is connected to costs a test.  Code computing the arguments
+ * of a trace source (such as a copy of a packet) should check IsEmpty
+ * first, to skip that work too.  The chain is stored contiguously.
+ *
  * \tparam T1 \explicit Type of the first argument to the functor.
  * \tparam T2 \explicit Type of the second argument to the functor.
  * \tparam T3 \explicit Type of the third argument to the functor.
@@ -64,6 +96,15 @@ class TracedCallback
 public:
   /** Constructor. */
   TracedCallback ();
+  /**
+   * Check for an empty chain of Callbacks.
+   *
+   * \returns \c true if no Callback is connected.
+   */
+  bool IsEmpty (void) const
+  {
+    return m_callbackList.empty ();
+  }
   /**
    * Append a Callback to the chain (without a context).
    *
@@ -93,6 +134,19 @@ public:
    * \param [in] path Context path which was used to connect the Callback.
    */
   void Disconnect (const CallbackBase & callback, std::string path);
+  /**
+   * \name Types of the arguments of the functors.
+   */
+  /**@{*/
+  typedef typename TracedCallbackArg<T1>::Type Arg1; //!< First argument.
+  typedef typename TracedCallbackArg<T2>::Type Arg2; //!< Second argument.
+  typedef typename TracedCallbackArg<T3>::Type Arg3; //!< Third argument.
+  typedef typename TracedCallbackArg<T4>::Type Arg4; //!< Fourth argument.
+  typedef typename TracedCallbackArg<T5>::Type Arg5; //!< Fifth argument.
+  typedef typename TracedCallbackArg<T6>::Type Arg6; //!< Sixth argument.
+  typedef typename TracedCallbackArg<T7>::Type Arg7; //!< Seventh argument.
+  typedef typename TracedCallbackArg<T8>::Type Arg8; //!< Eighth argument.
+  /**@}*/
   /**
    * \name Functors taking various numbers of arguments.
    *
@@ -108,7 +162,7 @@ public:
    * \tparam T1 \deduced Type of the first argument to the functor.
    * \param [in] a1 The first argument to the functor.
    */
-  void operator() (T1 a1) const;
+  void operator() (Arg1 a1) const;
   /**
    * \copybrief operator()()
    * \tparam T1 \deduced Type of the first argument to the functor.
@@ -116,7 +170,7 @@ public:
    * \param [in] a1 The first argument to the functor.
    * \param [in] a2 The second argument to the functor.
    */
-  void operator() (T1 a1, T2 a2) const;
+  void operator() (Arg1 a1, Arg2 a2) const;
   /**
    * \copybrief operator()()
    * \tparam T1 \deduced Type of the first argument to the functor.
@@ -126,7 +180,7 @@ public:
    * \param [in] a2 The second argument to the functor.
    * \param [in] a3 The third argument to the functor.
    */
-  void operator() (T1 a1, T2 a2, T3 a3) const;
+  void operator() (Arg1 a1, Arg2 a2, Arg3 a3) const;
   /**
    * \copybrief operator()()
    * \tparam T1 \deduced Type of the first argument to the functor.
@@ -138,7 +192,7 @@ public:
    * \param [in] a3 The third argument to the functor.
    * \param [in] a4 The fourth argument to the functor.
    */
-  void operator() (T1 a1, T2 a2, T3 a3, T4 a4) const;
+  void operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4) const;
   /**
    * \copybrief operator()()
    * \tparam T1 \deduced Type of the first argument to the functor.
@@ -152,7 +206,7 @@ public:
    * \param [in] a4 The fourth argument to the functor.
    * \param [in] a5 The fifth argument to the functor.
    */
-  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const;
+  void operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5) const;
   /**
    * \copybrief operator()()
    * \tparam T1 \deduced Type of the first argument to the functor.
@@ -168,7 +222,7 @@ public:
    * \param [in] a5 The fifth argument to the functor.
    * \param [in] a6 The sixth argument to the functor.
    */
-  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const;
+  void operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5, Arg6 a6) const;
   /**
    * \copybrief operator()()
    * \tparam T1 \deduced Type of the first argument to the functor.
@@ -186,7 +240,7 @@ public:
    * \param [in] a6 The sixth argument to the functor.
    * \param [in] a7 The seventh argument to the functor.
    */
-  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const;
+  void operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5, Arg6 a6, Arg7 a7) const;
   /**
    * \copybrief operator()()
    * \tparam T1 \deduced Type of the first argument to the functor.
@@ -206,7 +260,7 @@ public:
    * \param [in] a7 The seventh argument to the functor.
    * \param [in] a8 The eighth argument to the functor.
    */
-  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const;
+  void operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5, Arg6 a6, Arg7 a7, Arg8 a8) const;
   /**@}*/
 
   /**
@@ -225,6 +279,9 @@ private:
   /**
    * Container type for holding the chain of Callbacks.
    *
+   * The functors index the chain rather than iterate over it, since
+   * a Callback may connect others to the chain.
+   *
    * \tparam T1 \deduced Type of the first argument to the functor.
    * \tparam T2 \deduced Type of the second argument to the functor.
    * \tparam T3 \deduced Type of the third argument to the functor.
@@ -234,7 +291,7 @@ private:
    * \tparam T7 \deduced Type of the seventh argument to the functor.
    * \tparam T8 \deduced Type of the eighth argument to the functor.
    */
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+  typedef std::vector<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
   /** The chain of Callbacks. */
   CallbackList m_callbackList;
 };
@@ -321,10 +378,9 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)();
+      m_callbackList[i] ();
     }
 }
 template<typename T1, typename T2, 
@@ -332,12 +388,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1);
+      m_callbackList[i] (a1);
     }
 }
 template<typename T1, typename T2, 
@@ -345,12 +400,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1, Arg2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2);
+      m_callbackList[i] (a1, a2);
     }
 }
 template<typename T1, typename T2, 
@@ -358,12 +412,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1, Arg2 a2, Arg3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3);
+      m_callbackList[i] (a1, a2, a3);
     }
 }
 template<typename T1, typename T2, 
@@ -371,12 +424,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4);
+      m_callbackList[i] (a1, a2, a3, a4);
     }
 }
 template<typename T1, typename T2, 
@@ -384,12 +436,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5);
+      m_callbackList[i] (a1, a2, a3, a4, a5);
     }
 }
 template<typename T1, typename T2, 
@@ -397,12 +448,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5, Arg6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      m_callbackList[i] (a1, a2, a3, a4, a5, a6);
     }
 }
 template<typename T1, typename T2, 
@@ -410,12 +460,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5, Arg6 a6, Arg7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      m_callbackList[i] (a1, a2, a3, a4, a5, a6, a7);
     }
 }
 template<typename T1, typename T2, 
@@ -423,12 +472,11 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
-TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (Arg1 a1, Arg2 a2, Arg3 a3, Arg4 a4, Arg5 a5, Arg6 a6, Arg7 a7, Arg8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      m_callbackList[i] (a1, a2, a3, a4, a5, a6, a7, a8);
     }
 }
 
@@ -721,6 +721,83 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test for the ability to look many paths up at once.
+// ===========================================================================
+class LookupMatchesConfigTestCase : public TestCase
+{
+public:
+  LookupMatchesConfigTestCase ();
+  virtual ~LookupMatchesConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+LookupMatchesConfigTestCase::LookupMatchesConfigTestCase ()
+  : TestCase ("Check that a batch of paths resolves like each path on its own")
+{
+}
+
+void
+LookupMatchesConfigTestCase::DoRun (void)
+{
+  //
+  // Create a root namespace object, with a vector of objects which each
+  // hold an object.
+  //
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  std::vector<Ptr<ConfigTestObject> > nodes;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<ConfigTestObject> node = CreateObject<ConfigTestObject> ();
+      node->SetNodeB (CreateObject<ConfigTestObject> ());
+      root->AddNodeA (node);
+      nodes.push_back (node);
+    }
+
+  std::vector<std::string> paths;
+  paths.push_back ("/NodesA/*/NodeB");
+  paths.push_back ("/NodesA/3");
+  paths.push_back ("/NodesA/[1-2]|0/NodeB");
+  paths.push_back ("/NodesA/2|[1-2]|2");
+  paths.push_back ("/NodesA/7|[5-9]");
+  paths.push_back ("/NodesA/*/NodeA");
+  paths.push_back ("NodesA/1/");
+  paths.push_back ("/NodesA/*/NodeB");
+
+  std::vector<Config::MatchContainer> batch = Config::LookupMatches (paths);
+  NS_TEST_ASSERT_MSG_EQ (batch.size (), paths.size (), "One container per path expected");
+
+  uint32_t expected[] = { 4, 1, 3, 2, 0, 0, 1, 4 };
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      Config::MatchContainer single = Config::LookupMatches (paths[i]);
+      NS_TEST_ASSERT_MSG_EQ (batch[i].GetPath (), paths[i], "Container of the wrong path");
+      NS_TEST_ASSERT_MSG_EQ (batch[i].GetN (), expected[i], "Unexpected number of matches for " << paths[i]);
+      NS_TEST_ASSERT_MSG_EQ (single.GetN (), batch[i].GetN (), "Batch and single lookups differ for " << paths[i]);
+      for (uint32_t j = 0; j < single.GetN (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (batch[i].Get (j), single.Get (j), "Batch and single lookups differ for " << paths[i]);
+          NS_TEST_ASSERT_MSG_EQ (batch[i].GetMatchedPath (j), single.GetMatchedPath (j),
+                                 "Batch and single lookups differ for " << paths[i]);
+        }
+    }
+
+  //
+  // The indexes match in increasing order, once each.
+  //
+  NS_TEST_ASSERT_MSG_EQ (batch[2].GetMatchedPath (0), "/NodesA/0/NodeB/", "Unexpected matched path");
+  NS_TEST_ASSERT_MSG_EQ (batch[2].GetMatchedPath (2), "/NodesA/2/NodeB/", "Unexpected matched path");
+  NS_TEST_ASSERT_MSG_EQ (batch[3].Get (0), nodes[1], "Unexpected match");
+  NS_TEST_ASSERT_MSG_EQ (batch[3].Get (1), nodes[2], "Unexpected match");
+  NS_TEST_ASSERT_MSG_EQ (batch[1].Get (0), nodes[3], "Unexpected match");
+  NS_TEST_ASSERT_MSG_EQ (batch[6].GetMatchedPath (0), "/NodesA/1/", "Unexpected matched path");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +814,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new LookupMatchesConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
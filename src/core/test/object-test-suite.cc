@@ -359,6 +359,61 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that the lookups by TypeId follow the aggregation.
+// ===========================================================================
+class AggregateLookupTestCase : public TestCase
+{
+public:
+  AggregateLookupTestCase ();
+  virtual ~AggregateLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AggregateLookupTestCase::AggregateLookupTestCase ()
+  : TestCase ("Check that repeated GetObject lookups follow aggregation")
+{
+}
+
+AggregateLookupTestCase::~AggregateLookupTestCase ()
+{
+}
+
+void
+AggregateLookupTestCase::DoRun (void)
+{
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+
+  //
+  // Look up the missing types a few times, so that the misses are remembered.
+  //
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseB> (), 0, "Unexpectedly found a BaseB through derivedA");
+      NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<DerivedB> (), 0, "Unexpectedly found a DerivedB through derivedA");
+      NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), 0, "Unexpectedly found a BaseA through derivedB");
+    }
+
+  //
+  // Once aggregated, the same lookups must find the new aggregates, through
+  // the TypeId of the aggregate and the TypeIds of its parents.
+  //
+  derivedA->AggregateObject (derivedB);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseB> (), derivedB, "GetObject (through derivedA) for BaseB failed");
+      NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<DerivedB> (), derivedB, "GetObject (through derivedA) for DerivedB failed");
+      NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), derivedA, "GetObject (through derivedB) for BaseA failed");
+      NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (DerivedA::GetTypeId ()), derivedA,
+                             "GetObject (through derivedB) for DerivedA failed");
+      NS_TEST_ASSERT_MSG_NE (derivedB->GetObject<Object> (Object::GetTypeId ()), 0,
+                             "GetObject (through derivedB) for Object failed");
+    }
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -445,6 +500,7 @@ ObjectTestSuite::ObjectTestSuite ()
 {
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
+  AddTestCase (new AggregateLookupTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
 }
 
@@ -62,6 +62,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   // these methods do is to set corresponding member variables m_one and m_two.
   //
   TracedCallback<uint8_t, double> trace;
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "New TracedCallback not empty");
 
   //
   // Connect both callbacks to their respective test methods.  If we hit the 
@@ -70,6 +71,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   //
   trace.ConnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbOne, this));
   trace.ConnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbTwo, this));
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), false, "Connected TracedCallback empty");
   m_one = false;
   m_two = false;
   trace (1, 2);
@@ -90,6 +92,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   // If we now disconnect callback two then neither callback should be called.
   //
   trace.DisconnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbTwo, this));
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "Disconnected TracedCallback not empty");
   m_one = false;
   m_two = false;
   trace (1, 2);
@@ -108,6 +111,61 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+class ReentrantTracedCallbackTestCase : public TestCase
+{
+public:
+  ReentrantTracedCallbackTestCase ();
+  virtual ~ReentrantTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void CbConnect (const std::string &a, uint32_t b);
+  void CbCount (const std::string &a, uint32_t b);
+
+  TracedCallback<const std::string &, uint32_t> m_trace;
+  uint32_t m_count;
+  uint32_t m_sum;
+};
+
+ReentrantTracedCallbackTestCase::ReentrantTracedCallbackTestCase ()
+  : TestCase ("Check TracedCallback connecting a Callback while it is invoked")
+{
+}
+
+void
+ReentrantTracedCallbackTestCase::CbConnect (const std::string &a, uint32_t b)
+{
+  m_trace.ConnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::CbCount, this));
+}
+
+void
+ReentrantTracedCallbackTestCase::CbCount (const std::string &a, uint32_t b)
+{
+  m_count++;
+  m_sum += a.size () + b;
+}
+
+void
+ReentrantTracedCallbackTestCase::DoRun (void)
+{
+  m_count = 0;
+  m_sum = 0;
+  m_trace ("unused", 1);
+
+  //
+  // The Callback connected by CbConnect is called when the chain is invoked:
+  // the first time once, the second time twice.
+  //
+  m_trace.ConnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::CbConnect, this));
+  m_trace ("abc", 1);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Connected Callback not called");
+  NS_TEST_ASSERT_MSG_EQ (m_sum, 4, "Connected Callback called with wrong arguments");
+  m_trace ("abc", 2);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 3, "Connected Callbacks not called");
+  NS_TEST_ASSERT_MSG_EQ (m_sum, 14, "Connected Callbacks called with wrong arguments");
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -118,6 +176,7 @@ TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new ReentrantTracedCallbackTestCase, TestCase::QUICK);
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
@@ -719,9 +719,14 @@ CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
 
   //
   // Trace sinks will expect complete packets, not packets without some of the
-  // headers.
+  // headers.  Only copy the packet if some sink is connected.
   //
-  Ptr<Packet> originalPacket = packet->Copy ();
+  Ptr<Packet> originalPacket;
+  if (!m_promiscSnifferTrace.IsEmpty () || !m_macPromiscRxTrace.IsEmpty ()
+      || !m_snifferTrace.IsEmpty () || !m_macRxTrace.IsEmpty ())
+    {
+      originalPacket = packet->Copy ();
+    }
 
   EthernetTrailer trailer;
   packet->RemoveTrailer (trailer);
@@ -22,8 +22,14 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cmath>
 
 #define INDENT(level) for (int __xpto = 0; __xpto < level; __xpto++) os << ' ';
 
@@ -72,6 +78,43 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("ExportInterval", ("The interval between the exports of the flow records "
+                                      "to the ExportFileName file.  Zero disables the export."),
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&FlowMonitor::m_exportInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("ExportFileName", ("The name of the file where the flow records are exported."),
+                   StringValue ("flowmon-records.csv"),
+                   MakeStringAccessor (&FlowMonitor::m_exportFileName),
+                   MakeStringChecker ())
+    .AddAttribute ("ExportFormat", ("The format of the exported flow records."),
+                   EnumValue (FlowMonitor::EXPORT_CSV),
+                   MakeEnumAccessor (&FlowMonitor::m_exportFormat),
+                   MakeEnumChecker (FlowMonitor::EXPORT_CSV, "Csv",
+                                    FlowMonitor::EXPORT_BINARY, "Binary"))
+    .AddAttribute ("FlowIdleTimeout", ("The time without any packet after which a flow is "
+                                       "removed from the statistics, once its records are exported.  "
+                                       "Zero keeps all the flows.  Used only when the export is enabled."),
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&FlowMonitor::m_flowIdleTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("SamplingRate", ("The probes track one packet in SamplingRate, chosen by "
+                                    "a hash of the flow and packet identifiers."),
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&FlowMonitor::m_samplingRate),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ProbeForwarding", ("If false, the probes do not monitor the forwarding hops: "
+                                       "timesForwarded and the per-probe statistics of the routers "
+                                       "are then not collected."),
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&FlowMonitor::m_probeForwarding),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UsePacketTags", ("If false, the probes that can identify the packets from their "
+                                     "headers (IPv4) do so instead of adding a byte tag to them.  "
+                                     "Queue drops are then accounted for as lost packets."),
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&FlowMonitor::m_usePacketTags),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -83,14 +126,28 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_enabled (false),
+    m_exportFormat (EXPORT_CSV),
+    m_samplingRate (1),
+    m_probeForwarding (true),
+    m_usePacketTags (true)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
 
+size_t
+FlowMonitor::TrackedPacketKeyHash::operator() (const std::pair<FlowId, FlowPacketId> &key) const
+{
+  uint32_t h = key.first * 2654435761U;
+  h ^= key.second + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
 void
 FlowMonitor::DoDispose (void)
 {
+  Simulator::Cancel (m_exportEvent);
+  CloseExport ();
   for (std::list<Ptr<FlowClassifier> >::iterator iter = m_classifiers.begin ();
       iter != m_classifiers.end ();
       iter ++)
@@ -105,14 +162,46 @@ FlowMonitor::DoDispose (void)
   Object::DoDispose ();
 }
 
+inline FlowMonitor::FlowEntry&
+FlowMonitor::GetFlowEntry (FlowId flowId)
+{
+  if (flowId >= m_flowIndex.size ())
+    {
+      FlowEntry entry;
+      entry.stats = 0;
+      entry.exported.txBytes = 0;
+      entry.exported.rxBytes = 0;
+      entry.exported.txPackets = 0;
+      entry.exported.rxPackets = 0;
+      entry.exported.lostPackets = 0;
+      entry.dirty = false;
+      entry.txBytesSquares = 0;
+      entry.rxBytesSquares = 0;
+      entry.delaySquares = 0;
+      m_flowIndex.resize (flowId + 1, entry);
+    }
+  return m_flowIndex[flowId];
+}
+
+inline void
+FlowMonitor::MarkDirty (FlowId flowId)
+{
+  FlowEntry &entry = m_flowIndex[flowId];
+  if (!entry.dirty && m_exportStream.is_open ())
+    {
+      entry.dirty = true;
+      m_dirtyFlows.push_back (flowId);
+    }
+}
+
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
-  FlowStatsContainerI iter;
-  iter = m_flowStats.find (flowId);
-  if (iter == m_flowStats.end ())
+  FlowEntry &entry = GetFlowEntry (flowId);
+  if (entry.stats == 0)
     {
       FlowMonitor::FlowStats &ref = m_flowStats[flowId];
+      entry.stats = &ref;
       ref.delaySum = Seconds (0);
       ref.jitterSum = Seconds (0);
       ref.lastDelay = Seconds (0);
@@ -130,8 +219,41 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
     }
   else
     {
-      return iter->second;
+      return *entry.stats;
+    }
+}
+
+FlowMonitor::TrackedPacket&
+FlowMonitor::AddTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  std::pair<TrackedPacketMap::iterator, bool> insert =
+    m_trackedPackets.insert (std::make_pair (std::make_pair (flowId, packetId), 0U));
+  if (insert.second)
+    {
+      if (m_freeTrackedPackets.empty ())
+        {
+          insert.first->second = m_trackedPacketPool.size ();
+          m_trackedPacketPool.push_back (TrackedPacket ());
+        }
+      else
+        {
+          insert.first->second = m_freeTrackedPackets.back ();
+          m_freeTrackedPackets.pop_back ();
+        }
     }
+  TrackedPacket &tracked = m_trackedPacketPool[insert.first->second];
+  tracked.flowId = flowId;
+  tracked.packetId = packetId;
+  tracked.inUse = true;
+  return tracked;
+}
+
+void
+FlowMonitor::RemoveTrackedPacket (TrackedPacketMap::iterator iter)
+{
+  m_trackedPacketPool[iter->second].inUse = false;
+  m_freeTrackedPackets.push_back (iter->second);
+  m_trackedPackets.erase (iter);
 }
 
 
@@ -143,7 +265,7 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
+  TrackedPacket &tracked = AddTrackedPacket (flowId, packetId);
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
@@ -160,6 +282,8 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       stats.timeFirstTxPacket = now;
     }
   stats.timeLastTxPacket = now;
+  m_flowIndex[flowId].txBytesSquares += static_cast<double> (packetSize) * packetSize;
+  MarkDirty (flowId);
 }
 
 
@@ -179,10 +303,11 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
       return;
     }
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  TrackedPacket &record = m_trackedPacketPool[tracked->second];
+  record.timesForwarded++;
+  record.lastSeenTime = Simulator::Now ();
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - record.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
@@ -202,8 +327,9 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
       return;
     }
 
+  TrackedPacket &record = m_trackedPacketPool[tracked->second];
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - record.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
@@ -242,12 +368,16 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += record.timesForwarded;
+  FlowEntry &entry = m_flowIndex[flowId];
+  entry.rxBytesSquares += static_cast<double> (packetSize) * packetSize;
+  entry.delaySquares += delay.GetSeconds () * delay.GetSeconds ();
+  MarkDirty (flowId);
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  RemoveTrackedPacket (tracked); // we don't need to track this packet anymore
 }
 
 void
@@ -270,6 +400,7 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
     }
   ++stats.packetsDropped[reasonCode];
   stats.bytesDropped[reasonCode] += packetSize;
+  MarkDirty (flowId);
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
   TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
@@ -279,7 +410,7 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      RemoveTrackedPacket (tracked);
     }
 }
 
@@ -290,27 +421,136 @@ FlowMonitor::GetFlowStats () const
 }
 
 
+bool
+FlowMonitor::IsSampled (FlowId flowId, FlowPacketId packetId) const
+{
+  if (m_samplingRate == 1)
+    {
+      return true;
+    }
+  // mix the identifiers, so that the choice does not follow the patterns of the packet ids
+  uint32_t h = flowId * 0x9e3779b1U ^ packetId;
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h % m_samplingRate == 0;
+}
+
+uint32_t
+FlowMonitor::GetSamplingRate () const
+{
+  return m_samplingRate;
+}
+
+bool
+FlowMonitor::GetProbeForwarding () const
+{
+  return m_probeForwarding;
+}
+
+bool
+FlowMonitor::GetUsePacketTags () const
+{
+  return m_usePacketTags;
+}
+
+/**
+ * \brief Estimate a count from the number of tracked occurrences
+ * \param count the number of tracked occurrences
+ * \param rate the sampling rate
+ * \param z the quantile of the confidence level
+ * \returns the estimate
+ */
+static FlowMonitor::Estimate
+EstimateCount (double count, uint32_t rate, double z)
+{
+  FlowMonitor::Estimate estimate;
+  estimate.value = rate * count;
+  double halfWidth = z * std::sqrt (static_cast<double> (rate) * (rate - 1) * count);
+  estimate.lowerBound = std::max (count, estimate.value - halfWidth);
+  estimate.upperBound = estimate.value + halfWidth;
+  return estimate;
+}
+
+/**
+ * \brief Estimate a sum from the sum of the tracked values
+ * \param sum the sum of the tracked values
+ * \param squares the sum of the squares of the tracked values
+ * \param rate the sampling rate
+ * \param z the quantile of the confidence level
+ * \returns the estimate
+ */
+static FlowMonitor::Estimate
+EstimateSum (double sum, double squares, uint32_t rate, double z)
+{
+  FlowMonitor::Estimate estimate;
+  estimate.value = rate * sum;
+  double halfWidth = z * std::sqrt (static_cast<double> (rate) * (rate - 1) * squares);
+  estimate.lowerBound = std::max (sum, estimate.value - halfWidth);
+  estimate.upperBound = estimate.value + halfWidth;
+  return estimate;
+}
+
+FlowMonitor::FlowStatsEstimate
+FlowMonitor::EstimateFlowStats (FlowId flowId, double z) const
+{
+  FlowStatsEstimate estimate;
+  if (flowId >= m_flowIndex.size () || m_flowIndex[flowId].stats == 0)
+    {
+      Estimate zero = { 0, 0, 0 };
+      estimate.txPackets = estimate.txBytes = estimate.rxPackets = zero;
+      estimate.rxBytes = estimate.lostPackets = estimate.meanDelay = zero;
+      return estimate;
+    }
+  const FlowEntry &entry = m_flowIndex[flowId];
+  const FlowStats &stats = *entry.stats;
+  estimate.txPackets = EstimateCount (stats.txPackets, m_samplingRate, z);
+  estimate.txBytes = EstimateSum (stats.txBytes, entry.txBytesSquares, m_samplingRate, z);
+  estimate.rxPackets = EstimateCount (stats.rxPackets, m_samplingRate, z);
+  estimate.rxBytes = EstimateSum (stats.rxBytes, entry.rxBytesSquares, m_samplingRate, z);
+  estimate.lostPackets = EstimateCount (stats.lostPackets, m_samplingRate, z);
+
+  // the mean delay is not scaled: its interval comes from the spread of the tracked delays
+  Estimate &delay = estimate.meanDelay;
+  delay.value = delay.lowerBound = delay.upperBound = 0;
+  if (stats.rxPackets > 0)
+    {
+      double n = stats.rxPackets;
+      delay.value = stats.delaySum.GetSeconds () / n;
+      double variance = 0;
+      if (n > 1)
+        {
+          variance = std::max (0.0, (entry.delaySquares - n * delay.value * delay.value) / (n - 1));
+        }
+      double halfWidth = z * std::sqrt (variance / n);
+      delay.lowerBound = std::max (0.0, delay.value - halfWidth);
+      delay.upperBound = delay.value + halfWidth;
+    }
+  return estimate;
+}
+
 void
 FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  // scan the pool rather than the hash table: the records are contiguous
+  for (uint32_t i = 0; i < m_trackedPacketPool.size (); i++)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      TrackedPacket &record = m_trackedPacketPool[i];
+      if (record.inUse && now - record.lastSeenTime >= maxDelay)
         {
           // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
+          // (the flow may have been removed by RemoveIdleFlows)
+          GetStatsForFlow (record.flowId).lostPackets++;
+          MarkDirty (record.flowId);
 
           // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
-        {
-          iter++;
+          TrackedPacketMap::iterator iter = m_trackedPackets.find (std::make_pair (record.flowId, record.packetId));
+          NS_ASSERT (iter != m_trackedPackets.end () && iter->second == i);
+          RemoveTrackedPacket (iter);
         }
     }
 }
@@ -380,6 +620,25 @@ FlowMonitor::StartRightNow ()
       return;
     }
   m_enabled = true;
+  if (!m_exportInterval.IsStrictlyPositive ())
+    {
+      return;
+    }
+  if (!m_exportStream.is_open ())
+    {
+      m_exportStream.open (m_exportFileName.c_str (), std::ios::out | std::ios::binary);
+      if (!m_exportStream.is_open ())
+        {
+          NS_FATAL_ERROR ("Cannot open the flow records export file " << m_exportFileName);
+        }
+      if (m_exportFormat == EXPORT_CSV)
+        {
+          m_exportStream << "time,flowId,txPackets,txBytes,rxPackets,rxBytes,lostPackets,delaySum\n";
+        }
+      Simulator::ScheduleDestroy (&FlowMonitor::CloseExport, Ptr<FlowMonitor> (this));
+    }
+  Simulator::Cancel (m_exportEvent);
+  m_exportEvent = Simulator::Schedule (m_exportInterval, &FlowMonitor::PeriodicExportFlowRecords, this);
 }
 
 
@@ -392,6 +651,120 @@ FlowMonitor::StopRightNow ()
     }
   m_enabled = false;
   CheckForLostPackets ();
+  if (m_exportStream.is_open ())
+    {
+      Simulator::Cancel (m_exportEvent);
+      ExportFlowRecords ();
+      m_exportStream.flush ();
+    }
+}
+
+void
+FlowMonitor::ExportFlowRecords ()
+{
+  if (!m_exportStream.is_open ())
+    {
+      return;
+    }
+  Time now = Simulator::Now ();
+  NS_LOG_DEBUG ("Exporting " << m_dirtyFlows.size () << " flow records at " << now.GetSeconds ());
+  for (std::vector<FlowId>::const_iterator iter = m_dirtyFlows.begin ();
+       iter != m_dirtyFlows.end (); iter++)
+    {
+      FlowEntry &entry = m_flowIndex[*iter];
+      entry.dirty = false;
+      if (entry.stats == 0)
+        {
+          continue;
+        }
+      const FlowStats &stats = *entry.stats;
+      ExportedCounters &exported = entry.exported;
+      uint32_t txPackets = stats.txPackets - exported.txPackets;
+      uint64_t txBytes = stats.txBytes - exported.txBytes;
+      uint32_t rxPackets = stats.rxPackets - exported.rxPackets;
+      uint64_t rxBytes = stats.rxBytes - exported.rxBytes;
+      uint32_t lostPackets = stats.lostPackets - exported.lostPackets;
+      Time delaySum = stats.delaySum - exported.delaySum;
+      if (m_exportFormat == EXPORT_CSV)
+        {
+          m_exportStream << now.GetSeconds () << ',' << *iter << ','
+                         << txPackets << ',' << txBytes << ','
+                         << rxPackets << ',' << rxBytes << ','
+                         << lostPackets << ',' << delaySum.GetSeconds () << '\n';
+        }
+      else
+        {
+          int64_t time = now.GetNanoSeconds ();
+          FlowId flowId = *iter;
+          int64_t delay = delaySum.GetNanoSeconds ();
+          m_exportStream.write (reinterpret_cast<const char *> (&time), sizeof (time));
+          m_exportStream.write (reinterpret_cast<const char *> (&flowId), sizeof (flowId));
+          m_exportStream.write (reinterpret_cast<const char *> (&txPackets), sizeof (txPackets));
+          m_exportStream.write (reinterpret_cast<const char *> (&txBytes), sizeof (txBytes));
+          m_exportStream.write (reinterpret_cast<const char *> (&rxPackets), sizeof (rxPackets));
+          m_exportStream.write (reinterpret_cast<const char *> (&lostPackets), sizeof (lostPackets));
+          m_exportStream.write (reinterpret_cast<const char *> (&rxBytes), sizeof (rxBytes));
+          m_exportStream.write (reinterpret_cast<const char *> (&delay), sizeof (delay));
+        }
+      exported.txPackets = stats.txPackets;
+      exported.txBytes = stats.txBytes;
+      exported.rxPackets = stats.rxPackets;
+      exported.rxBytes = stats.rxBytes;
+      exported.lostPackets = stats.lostPackets;
+      exported.delaySum = stats.delaySum;
+    }
+  m_dirtyFlows.clear ();
+}
+
+void
+FlowMonitor::RemoveIdleFlows ()
+{
+  Time now = Simulator::Now ();
+  for (FlowId flowId = 0; flowId < m_flowIndex.size (); flowId++)
+    {
+      FlowEntry &entry = m_flowIndex[flowId];
+      if (entry.stats == 0 || entry.dirty)
+        {
+          continue;
+        }
+      Time lastPacket = std::max (entry.stats->timeLastTxPacket, entry.stats->timeLastRxPacket);
+      if (now - lastPacket > m_flowIdleTimeout)
+        {
+          NS_LOG_DEBUG ("Removing the idle flow " << flowId);
+          m_flowStats.erase (flowId);
+          entry.stats = 0;
+          entry.exported.txBytes = 0;
+          entry.exported.rxBytes = 0;
+          entry.exported.txPackets = 0;
+          entry.exported.rxPackets = 0;
+          entry.exported.lostPackets = 0;
+          entry.exported.delaySum = Time (0);
+          entry.txBytesSquares = 0;
+          entry.rxBytesSquares = 0;
+          entry.delaySquares = 0;
+        }
+    }
+}
+
+void
+FlowMonitor::PeriodicExportFlowRecords ()
+{
+  ExportFlowRecords ();
+  if (m_flowIdleTimeout.IsStrictlyPositive ())
+    {
+      RemoveIdleFlows ();
+    }
+  m_exportEvent = Simulator::Schedule (m_exportInterval, &FlowMonitor::PeriodicExportFlowRecords, this);
+}
+
+void
+FlowMonitor::CloseExport ()
+{
+  if (m_exportStream.is_open ())
+    {
+      ExportFlowRecords ();
+      m_exportStream.close ();
+    }
 }
 
 void
@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <map>
+#include <fstream>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -31,6 +32,7 @@
 #include "ns3/histogram.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -46,6 +48,22 @@ namespace ns3 {
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * The per-packet lookups are hash based, and the packets in transit
+ * are kept in a pool of records that are reused once the packets are
+ * received, dropped or considered lost.  When the ExportInterval
+ * attribute is set, the monitor also streams, every interval, a
+ * record with the changes of the counters of each flow that was
+ * active in the interval to the ExportFileName file, in CSV or binary
+ * format (see ExportFormat).  Together with FlowIdleTimeout, this
+ * keeps the memory bounded in long simulations.
+ *
+ * The cost of the monitoring can be tuned with the SamplingRate
+ * attribute, which makes the probes track only one packet in N,
+ * chosen by a hash of the flow and packet identifiers, with the
+ * ProbeForwarding attribute, which disables the probing of the
+ * forwarding hops, and with the UsePacketTags attribute.  The
+ * counters of the FlowStats are then those of the tracked packets;
+ * EstimateFlowStats scales them and gives their confidence bounds.
  */
 class FlowMonitor : public Object
 {
@@ -137,6 +155,25 @@ public:
     Histogram flowInterruptionsHistogram; //!< histogram of durations of flow interruptions
   };
 
+  /// \brief Estimate of a flow metric from the tracked packets
+  struct Estimate
+  {
+    double value;      //!< estimated value
+    double lowerBound; //!< lower bound of the confidence interval
+    double upperBound; //!< upper bound of the confidence interval
+  };
+
+  /// \brief Estimates of the metrics of a flow, scaled by the sampling rate
+  struct FlowStatsEstimate
+  {
+    Estimate txPackets;   //!< transmitted packets
+    Estimate txBytes;     //!< transmitted bytes
+    Estimate rxPackets;   //!< received packets
+    Estimate rxBytes;     //!< received bytes
+    Estimate lostPackets; //!< lost packets
+    Estimate meanDelay;   //!< mean end-to-end delay, in seconds
+  };
+
   // --- basic methods ---
   /**
    * \brief Get the type ID.
@@ -204,6 +241,41 @@ public:
   /// Check right now for packets that appear to be lost
   void CheckForLostPackets ();
 
+  /// FlowProbe implementations call this method to know if a new
+  /// packet is to be tracked.  The choice depends only on the flow and
+  /// packet identifiers, so it is the same in all the probes.
+  /// \param flowId flow identification
+  /// \param packetId Packet ID
+  /// \returns true if the packet is tracked
+  bool IsSampled (FlowId flowId, FlowPacketId packetId) const;
+
+  /// \returns the sampling rate N: one packet in N is tracked
+  uint32_t GetSamplingRate () const;
+
+  /// \returns true if the probes monitor the forwarding hops
+  bool GetProbeForwarding () const;
+
+  /// \returns true if the probes identify the packets with byte tags
+  bool GetUsePacketTags () const;
+
+  /// Format of the records streamed to the ExportFileName file
+  enum ExportFormat
+  {
+    /// One line per record: "time,flowId,txPackets,txBytes,rxPackets,rxBytes,lostPackets,delaySum",
+    /// with the time and the delay sum in seconds
+    EXPORT_CSV,
+    /// One fixed-size record of 48 bytes in host byte order: time (int64,
+    /// nanoseconds), flowId (uint32), txPackets (uint32), txBytes (uint64),
+    /// rxPackets (uint32), lostPackets (uint32), rxBytes (uint64), delaySum
+    /// (int64, nanoseconds)
+    EXPORT_BINARY
+  };
+
+  /// Write right now a record for each flow whose counters changed
+  /// since the last export.  The counters of the records are the
+  /// changes since the last export.
+  void ExportFlowRecords ();
+
   /// Check right now for packets that appear to be lost, considering
   /// packets as lost if not seen in the network for a time larger
   /// than maxDelay
@@ -232,6 +304,19 @@ public:
   /// \returns the flows statistics
   const FlowStatsContainer& GetFlowStats () const;
 
+  /// Estimate the metrics of a flow from the tracked packets.  With a
+  /// SamplingRate of N, each packet is tracked with a probability of
+  /// 1/N: the counts are scaled by N, and their confidence interval is
+  /// the one of the normal approximation, of half-width z * sqrt (N (N - 1) k)
+  /// for k tracked packets.  The interval of the mean delay is the one
+  /// of the mean of the received tracked packets.  With a SamplingRate
+  /// of 1, the estimates are the exact counters.
+  /// \param flowId the Flow identification
+  /// \param z the quantile of the normal distribution of the confidence
+  /// level, e.g. 1.96 for 95%
+  /// \returns the estimates
+  FlowStatsEstimate EstimateFlowStats (FlowId flowId, double z = 1.96) const;
+
   /// Get a list of all FlowProbe's associated with this FlowMonitor
   /// \returns a list of all the probes
   const FlowProbeContainer& GetAllProbes () const;
@@ -270,14 +355,54 @@ private:
     Time firstSeenTime; //!< absolute time when the packet was first seen by a probe
     Time lastSeenTime; //!< absolute time when the packet was last seen by a probe
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+    FlowId flowId; //!< flow of the packet
+    FlowPacketId packetId; //!< identifier of the packet within the flow
+    bool inUse; //!< the record holds a packet in transit
+  };
+
+  /// Hash function class for the (FlowId,PacketId) pairs
+  struct TrackedPacketKeyHash
+  {
+    /// Hash a (FlowId,PacketId) pair
+    /// \param key the pair
+    /// \returns the hash value
+    size_t operator() (const std::pair<FlowId, FlowPacketId> &key) const;
+  };
+
+  /// Counters of a flow at the time of the last export
+  struct ExportedCounters
+  {
+    uint64_t txBytes; //!< transmitted bytes
+    uint64_t rxBytes; //!< received bytes
+    uint32_t txPackets; //!< transmitted packets
+    uint32_t rxPackets; //!< received packets
+    uint32_t lostPackets; //!< lost packets
+    Time delaySum; //!< sum of the delays
+  };
+
+  /// Index entry of a flow
+  struct FlowEntry
+  {
+    FlowStats *stats; //!< statistics of the flow in m_flowStats, or 0
+    ExportedCounters exported; //!< counters at the time of the last export
+    bool dirty; //!< the counters changed since the last export
+    double txBytesSquares; //!< sum of the squares of the transmitted packet sizes
+    double rxBytesSquares; //!< sum of the squares of the received packet sizes
+    double delaySquares; //!< sum of the squares of the delays, in seconds
   };
 
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
+  /// Index of m_flowStats by FlowId
+  std::vector<FlowEntry> m_flowIndex;
+  /// FlowIds whose counters changed since the last export
+  std::vector<FlowId> m_dirtyFlows;
 
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
+  /// (FlowId,PacketId) --> index of the record in m_trackedPacketPool
+  typedef sgi::hash_map<std::pair<FlowId, FlowPacketId>, uint32_t, TrackedPacketKeyHash> TrackedPacketMap;
   TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  std::vector<TrackedPacket> m_trackedPacketPool; //!< records of the tracked packets
+  std::vector<uint32_t> m_freeTrackedPackets; //!< indexes of the free records in m_trackedPacketPool
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -293,11 +418,50 @@ private:
   double m_flowInterruptionsBinWidth; //!< Flow interruptions bin width (for histograms)
   Time m_flowInterruptionsMinTime; //!< Flow interruptions minimum time
 
+  Time m_exportInterval;        //!< Interval between the exports, 0 to disable them
+  std::string m_exportFileName; //!< Name of the export file
+  ExportFormat m_exportFormat;  //!< Format of the export file
+  Time m_flowIdleTimeout;       //!< Time after which the exported idle flows are removed
+  uint32_t m_samplingRate;      //!< One packet in m_samplingRate is tracked
+  bool m_probeForwarding;       //!< The probes monitor the forwarding hops
+  bool m_usePacketTags;         //!< The probes identify the packets with byte tags
+  std::ofstream m_exportStream; //!< Export file
+  EventId m_exportEvent;        //!< Next export event
+
   /// Get the stats for a given flow
   /// \param flowId the Flow identification
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
+  /// Get the index entry of a flow, growing the index if needed
+  /// \param flowId the Flow identification
+  /// \returns the index entry of the flow
+  FlowEntry& GetFlowEntry (FlowId flowId);
+
+  /// Record that the counters of a flow changed since the last export
+  /// \param flowId the Flow identification
+  void MarkDirty (FlowId flowId);
+
+  /// Start tracking a packet in transit
+  /// \param flowId the Flow identification
+  /// \param packetId the packet identification
+  /// \returns the record of the packet
+  TrackedPacket& AddTrackedPacket (FlowId flowId, FlowPacketId packetId);
+
+  /// Stop tracking a packet, and return its record to the pool
+  /// \param iter the packet
+  void RemoveTrackedPacket (TrackedPacketMap::iterator iter);
+
+  /// Remove the flows that have been idle for longer than
+  /// FlowIdleTimeout and whose counters were all exported
+  void RemoveIdleFlows ();
+
+  /// Periodic function to export the flow records
+  void PeriodicExportFlowRecords ();
+
+  /// Export the last records and close the export file
+  void CloseExport ();
+
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
 };
@@ -23,6 +23,7 @@
 #include "ipv4-flow-classifier.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include "ns3/log.h"
 
 namespace ns3 {
 
@@ -99,6 +100,16 @@ Ipv4FlowClassifier::Ipv4FlowClassifier ()
 {
 }
 
+size_t
+Ipv4FlowClassifier::FiveTupleHash::operator() (const FiveTuple &tuple) const
+{
+  uint32_t h = tuple.sourceAddress.Get ();
+  h = h * 31 + tuple.destinationAddress.Get ();
+  h = h * 31 + ((static_cast<uint32_t> (tuple.sourcePort) << 16) | tuple.destinationPort);
+  h = h * 31 + tuple.protocol;
+  return h ^ (h >> 16);
+}
+
 bool
 Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
                               uint32_t *out_flowId, uint32_t *out_packetId)
@@ -147,7 +158,7 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
   tuple.destinationPort = dstPort;
 
   // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
+  std::pair<sgi::hash_map<FiveTuple, FlowId, FiveTupleHash>::iterator, bool> insert
     = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
 
   // if the insertion succeeded, we need to assign this tuple a new flow identifier
@@ -155,15 +166,17 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
     {
       FlowId newFlowId = GetNewFlowId ();
       insert.first->second = newFlowId;
-      m_flowPktIdMap[newFlowId] = 0;
+      NS_ASSERT (newFlowId == m_flows.size () + 1);
+      m_flowPktIdMap.push_back (0);
+      m_flows.push_back (tuple);
     }
   else
     {
-      m_flowPktIdMap[insert.first->second] ++;
+      m_flowPktIdMap[insert.first->second - 1] ++;
     }
 
   *out_flowId = insert.first->second;
-  *out_packetId = m_flowPktIdMap[*out_flowId];
+  *out_packetId = m_flowPktIdMap[*out_flowId - 1];
 
   return true;
 }
@@ -172,19 +185,81 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
 Ipv4FlowClassifier::FiveTuple
 Ipv4FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  if (flowId > 0 && flowId <= m_flows.size ())
     {
-      if (iter->second == flowId)
-        {
-          return iter->first;
-        }
+      return m_flows[flowId - 1];
     }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
   FiveTuple retval = { Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0, 0, 0 };
   return retval;
 }
 
+bool
+Ipv4FlowClassifier::PacketKey::operator== (const PacketKey &other) const
+{
+  return identification == other.identification && protocol == other.protocol
+         && sourceAddress == other.sourceAddress && destinationAddress == other.destinationAddress;
+}
+
+size_t
+Ipv4FlowClassifier::PacketKeyHash::operator() (const PacketKey &key) const
+{
+  uint32_t h = key.sourceAddress.Get ();
+  h = h * 31 + key.destinationAddress.Get ();
+  h = h * 31 + ((static_cast<uint32_t> (key.protocol) << 16) | key.identification);
+  return h ^ (h >> 16);
+}
+
+Ipv4FlowClassifier::PacketKey
+Ipv4FlowClassifier::GetPacketKey (const Ipv4Header &ipHeader)
+{
+  PacketKey key;
+  key.sourceAddress = ipHeader.GetSource ();
+  key.destinationAddress = ipHeader.GetDestination ();
+  key.protocol = ipHeader.GetProtocol ();
+  key.identification = ipHeader.GetIdentification ();
+  return key;
+}
+
+void
+Ipv4FlowClassifier::AddTrackedPacket (const Ipv4Header &ipHeader, FlowId flowId,
+                                      FlowPacketId packetId, uint32_t packetSize)
+{
+  PacketInfo &info = m_trackedPackets[GetPacketKey (ipHeader)];
+  info.flowId = flowId;
+  info.packetId = packetId;
+  info.packetSize = packetSize;
+}
+
+bool
+Ipv4FlowClassifier::FindTrackedPacket (const Ipv4Header &ipHeader, FlowId *out_flowId,
+                                       FlowPacketId *out_packetId, uint32_t *out_packetSize) const
+{
+  if (m_trackedPackets.empty ())
+    {
+      return false;
+    }
+  sgi::hash_map<PacketKey, PacketInfo, PacketKeyHash>::const_iterator iter =
+    m_trackedPackets.find (GetPacketKey (ipHeader));
+  if (iter == m_trackedPackets.end ())
+    {
+      return false;
+    }
+  *out_flowId = iter->second.flowId;
+  *out_packetId = iter->second.packetId;
+  *out_packetSize = iter->second.packetSize;
+  return true;
+}
+
+void
+Ipv4FlowClassifier::RemoveTrackedPacket (const Ipv4Header &ipHeader)
+{
+  if (!m_trackedPackets.empty ())
+    {
+      m_trackedPackets.erase (GetPacketKey (ipHeader));
+    }
+}
+
 void
 Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
 {
@@ -193,16 +268,15 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
   INDENT (indent); os << "<Ipv4FlowClassifier>\n";
 
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  for (uint32_t i = 0; i < m_flows.size (); i++)
     {
       INDENT (indent);
-      os << "<Flow flowId=\"" << iter->second << "\""
-         << " sourceAddress=\"" << iter->first.sourceAddress << "\""
-         << " destinationAddress=\"" << iter->first.destinationAddress << "\""
-         << " protocol=\"" << int(iter->first.protocol) << "\""
-         << " sourcePort=\"" << iter->first.sourcePort << "\""
-         << " destinationPort=\"" << iter->first.destinationPort << "\""
+      os << "<Flow flowId=\"" << i + 1 << "\""
+         << " sourceAddress=\"" << m_flows[i].sourceAddress << "\""
+         << " destinationAddress=\"" << m_flows[i].destinationAddress << "\""
+         << " protocol=\"" << int(m_flows[i].protocol) << "\""
+         << " sourcePort=\"" << m_flows[i].sourcePort << "\""
+         << " destinationPort=\"" << m_flows[i].destinationPort << "\""
          << " />\n";
     }
 
@@ -23,9 +23,11 @@
 
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -69,14 +71,87 @@ public:
   /// \returns the FiveTuple corresponding to flowId
   FiveTuple FindFlow (FlowId flowId) const;
 
+  /// \brief Record the identifiers of a packet in transit, so that the
+  /// next hops can find them from its IP header, without a tag
+  ///
+  /// The packet is identified by its source and destination addresses,
+  /// protocol and identification, which are unique while it is in
+  /// transit.  A later packet with the same header values replaces it.
+  /// \param ipHeader packet's IP header
+  /// \param flowId packet's FlowId
+  /// \param packetId packet's identifier
+  /// \param packetSize packet's size
+  void AddTrackedPacket (const Ipv4Header &ipHeader, FlowId flowId,
+                         FlowPacketId packetId, uint32_t packetSize);
+
+  /// \brief Find the identifiers of a packet recorded by AddTrackedPacket
+  /// \param ipHeader packet's IP header
+  /// \param out_flowId packet's FlowId
+  /// \param out_packetId packet's identifier
+  /// \param out_packetSize packet's size when it was recorded
+  /// \returns true if the packet was found
+  bool FindTrackedPacket (const Ipv4Header &ipHeader, FlowId *out_flowId,
+                          FlowPacketId *out_packetId, uint32_t *out_packetSize) const;
+
+  /// \brief Forget a packet recorded by AddTrackedPacket, if any
+  /// \param ipHeader packet's IP header
+  void RemoveTrackedPacket (const Ipv4Header &ipHeader);
+
   virtual void SerializeToXmlStream (std::ostream &os, int indent) const;
 
 private:
 
+  /// Hash function class for the five-tuples
+  struct FiveTupleHash
+  {
+    /// Hash a five-tuple
+    /// \param tuple the five-tuple
+    /// \returns the hash value
+    size_t operator() (const FiveTuple &tuple) const;
+  };
+
+  /// Header fields that identify a packet in transit
+  struct PacketKey
+  {
+    Ipv4Address sourceAddress;      //!< Source address
+    Ipv4Address destinationAddress; //!< Destination address
+    uint8_t protocol;               //!< Protocol
+    uint16_t identification;        //!< Identification
+
+    /// \param other the other key
+    /// \returns true if the keys are equal
+    bool operator== (const PacketKey &other) const;
+  };
+
+  /// Hash function class for the packet keys
+  struct PacketKeyHash
+  {
+    /// Hash a packet key
+    /// \param key the packet key
+    /// \returns the hash value
+    size_t operator() (const PacketKey &key) const;
+  };
+
+  /// Identifiers of a packet in transit
+  struct PacketInfo
+  {
+    FlowId flowId;           //!< FlowId
+    FlowPacketId packetId;   //!< packet identifier
+    uint32_t packetSize;     //!< packet size
+  };
+
+  /// \param ipHeader packet's IP header
+  /// \returns the key of the packet
+  static PacketKey GetPacketKey (const Ipv4Header &ipHeader);
+
   /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
+  sgi::hash_map<FiveTuple, FlowId, FiveTupleHash> m_flowMap;
+  /// Packets in transit tracked without a tag
+  sgi::hash_map<PacketKey, PacketInfo, PacketKeyHash> m_trackedPackets;
+  /// Last FlowPacketId of each flow, indexed by FlowId - 1
+  std::vector<FlowPacketId> m_flowPktIdMap;
+  /// FiveTuple of each flow, indexed by FlowId - 1
+  std::vector<FiveTuple> m_flows;
 
 };
 
@@ -193,7 +193,8 @@ Ipv4FlowProbe::Ipv4FlowProbe (Ptr<FlowMonitor> monitor,
                               Ptr<Ipv4FlowClassifier> classifier,
                               Ptr<Node> node)
   : FlowProbe (monitor),
-    m_classifier (classifier)
+    m_classifier (classifier),
+    m_usePacketTags (monitor->GetUsePacketTags ())
 {
   NS_LOG_FUNCTION (this << node->GetId ());
 
@@ -204,8 +205,9 @@ Ipv4FlowProbe::Ipv4FlowProbe (Ptr<FlowMonitor> monitor,
     {
       NS_FATAL_ERROR ("trace fail");
     }
-  if (!m_ipv4->TraceConnectWithoutContext ("UnicastForward",
-                                           MakeCallback (&Ipv4FlowProbe::ForwardLogger, Ptr<Ipv4FlowProbe> (this))))
+  if (monitor->GetProbeForwarding ()
+      && !m_ipv4->TraceConnectWithoutContext ("UnicastForward",
+                                              MakeCallback (&Ipv4FlowProbe::ForwardLogger, Ptr<Ipv4FlowProbe> (this))))
     {
       NS_FATAL_ERROR ("trace fail");
     }
@@ -221,10 +223,15 @@ Ipv4FlowProbe::Ipv4FlowProbe (Ptr<FlowMonitor> monitor,
       NS_FATAL_ERROR ("trace fail");
     }
 
-  // code copied from point-to-point-helper.cc
-  std::ostringstream oss;
-  oss << "/NodeList/" << node->GetId () << "/DeviceList/*/TxQueue/Drop";
-  Config::ConnectWithoutContext (oss.str (), MakeCallback (&Ipv4FlowProbe::QueueDropLogger, Ptr<Ipv4FlowProbe> (this)));
+  // the queues see the packets without their IPv4 header at hand: without
+  // the tags, their drops are accounted for as lost packets
+  if (m_usePacketTags)
+    {
+      // code copied from point-to-point-helper.cc
+      std::ostringstream oss;
+      oss << "/NodeList/" << node->GetId () << "/DeviceList/*/TxQueue/Drop";
+      Config::ConnectWithoutContext (oss.str (), MakeCallback (&Ipv4FlowProbe::QueueDropLogger, Ptr<Ipv4FlowProbe> (this)));
+    }
 }
 
 Ipv4FlowProbe::~Ipv4FlowProbe ()
@@ -266,29 +273,62 @@ Ipv4FlowProbe::SendOutgoingLogger (const Ipv4Header &ipHeader, Ptr<const Packet>
 
   if (m_classifier->Classify (ipHeader, ipPayload, &flowId, &packetId))
     {
+      if (!m_flowMonitor->IsSampled (flowId, packetId))
+        {
+          if (!m_usePacketTags)
+            {
+              // a packet with the same header values may still be recorded
+              m_classifier->RemoveTrackedPacket (ipHeader);
+            }
+          return;
+        }
+
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("ReportFirstTx ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<"); "
                                      << ipHeader << *ipPayload);
       m_flowMonitor->ReportFirstTx (this, flowId, packetId, size);
 
-      // tag the packet with the flow id and packet id, so that the packet can be identified even
-      // when Ipv4Header is not accessible at some non-IPv4 protocol layer
-      Ipv4FlowProbeTag fTag (flowId, packetId, size);
-      ipPayload->AddByteTag (fTag);
+      if (m_usePacketTags)
+        {
+          // tag the packet with the flow id and packet id, so that the packet can be identified even
+          // when Ipv4Header is not accessible at some non-IPv4 protocol layer
+          Ipv4FlowProbeTag fTag (flowId, packetId, size);
+          ipPayload->AddByteTag (fTag);
+        }
+      else
+        {
+          m_classifier->AddTrackedPacket (ipHeader, flowId, packetId, size);
+        }
+    }
+}
+
+bool
+Ipv4FlowProbe::FindTrackedPacket (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
+                                  FlowId *flowId, FlowPacketId *packetId) const
+{
+  if (!m_usePacketTags)
+    {
+      uint32_t size;
+      return m_classifier->FindTrackedPacket (ipHeader, flowId, packetId, &size);
+    }
+  Ipv4FlowProbeTag fTag;
+  if (!ipPayload->FindFirstMatchingByteTag (fTag))
+    {
+      return false;
     }
+  *flowId = fTag.GetFlowId ();
+  *packetId = fTag.GetPacketId ();
+  return true;
 }
 
 void
 Ipv4FlowProbe::ForwardLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface)
 {
-  Ipv4FlowProbeTag fTag;
-  bool found = ipPayload->FindFirstMatchingByteTag (fTag);
+  FlowId flowId;
+  FlowPacketId packetId;
 
-  if (found)
+  if (FindTrackedPacket (ipHeader, ipPayload, &flowId, &packetId))
     {
-      FlowId flowId = fTag.GetFlowId ();
-      FlowPacketId packetId = fTag.GetPacketId ();
-
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("ReportForwarding ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<");");
       m_flowMonitor->ReportForwarding (this, flowId, packetId, size);
@@ -298,17 +338,18 @@ Ipv4FlowProbe::ForwardLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
 void
 Ipv4FlowProbe::ForwardUpLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface)
 {
-  Ipv4FlowProbeTag fTag;
-  bool found = ipPayload->FindFirstMatchingByteTag (fTag);
+  FlowId flowId;
+  FlowPacketId packetId;
 
-  if (found)
+  if (FindTrackedPacket (ipHeader, ipPayload, &flowId, &packetId))
     {
-      FlowId flowId = fTag.GetFlowId ();
-      FlowPacketId packetId = fTag.GetPacketId ();
-
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("ReportLastRx ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<");");
       m_flowMonitor->ReportLastRx (this, flowId, packetId, size);
+      if (!m_usePacketTags)
+        {
+          m_classifier->RemoveTrackedPacket (ipHeader);
+        }
     }
 }
 
@@ -334,14 +375,11 @@ Ipv4FlowProbe::DropLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPaylo
     }
 #endif
 
-  Ipv4FlowProbeTag fTag;
-  bool found = ipPayload->FindFirstMatchingByteTag (fTag);
+  FlowId flowId;
+  FlowPacketId packetId;
 
-  if (found)
+  if (FindTrackedPacket (ipHeader, ipPayload, &flowId, &packetId))
     {
-      FlowId flowId = fTag.GetFlowId ();
-      FlowPacketId packetId = fTag.GetPacketId ();
-
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("Drop ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<", " << reason 
                             << ", destIp=" << ipHeader.GetDestination () << "); "
@@ -383,6 +421,10 @@ Ipv4FlowProbe::DropLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPaylo
         }
 
       m_flowMonitor->ReportDrop (this, flowId, packetId, size, myReason);
+      if (!m_usePacketTags)
+        {
+          m_classifier->RemoveTrackedPacket (ipHeader);
+        }
     }
 }
 
@@ -37,6 +37,11 @@ class Node;
 /// Ipv4FlowProbe is created to monitor that node.  Ipv4FlowProbe
 /// accomplishes this by connecting callbacks to trace sources in the
 /// Ipv4L3Protocol interface of the node.
+///
+/// The probe of the first hop tags the tracked packets, so that the
+/// probes of the next hops can identify them.  When the FlowMonitor
+/// UsePacketTags attribute is false, it records them in the classifier
+/// instead, and the next hops find them from their IPv4 header.
 class Ipv4FlowProbe : public FlowProbe
 {
 
@@ -108,9 +113,18 @@ private:
   /// Log a packet being dropped by a queue
   /// \param ipPayload IP payload
   void QueueDropLogger (Ptr<const Packet> ipPayload);
+  /// Find the identifiers of a tracked packet
+  /// \param ipHeader IP header
+  /// \param ipPayload IP payload
+  /// \param flowId the flow identifier
+  /// \param packetId the packet identifier
+  /// \returns true if the packet is tracked
+  bool FindTrackedPacket (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
+                          FlowId *flowId, FlowPacketId *packetId) const;
 
   Ptr<Ipv4FlowClassifier> m_classifier; //!< the Ipv4FlowClassifier this probe is associated with
   Ptr<Ipv4L3Protocol> m_ipv4; //!< the Ipv4L3Protocol this probe is bound to
+  bool m_usePacketTags; //!< identify the packets with a byte tag rather than with the classifier
 };
 
 
@@ -24,6 +24,7 @@
 #include "ipv6-flow-classifier.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include "ns3/log.h"
 
 namespace ns3 {
 
@@ -100,6 +101,17 @@ Ipv6FlowClassifier::Ipv6FlowClassifier ()
 {
 }
 
+size_t
+Ipv6FlowClassifier::FiveTupleHash::operator() (const FiveTuple &tuple) const
+{
+  Ipv6AddressHash addressHash;
+  size_t h = addressHash (tuple.sourceAddress);
+  h = h * 31 + addressHash (tuple.destinationAddress);
+  h = h * 31 + ((static_cast<uint32_t> (tuple.sourcePort) << 16) | tuple.destinationPort);
+  h = h * 31 + tuple.protocol;
+  return h;
+}
+
 bool
 Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPayload,
                               uint32_t *out_flowId, uint32_t *out_packetId)
@@ -148,7 +160,7 @@ Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPa
   tuple.destinationPort = dstPort;
 
   // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
+  std::pair<sgi::hash_map<FiveTuple, FlowId, FiveTupleHash>::iterator, bool> insert
     = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
 
   // if the insertion succeeded, we need to assign this tuple a new flow identifier
@@ -156,15 +168,17 @@ Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPa
     {
       FlowId newFlowId = GetNewFlowId ();
       insert.first->second = newFlowId;
-      m_flowPktIdMap[newFlowId] = 0;
+      NS_ASSERT (newFlowId == m_flows.size () + 1);
+      m_flowPktIdMap.push_back (0);
+      m_flows.push_back (tuple);
     }
   else
     {
-      m_flowPktIdMap[insert.first->second] ++;
+      m_flowPktIdMap[insert.first->second - 1] ++;
     }
 
   *out_flowId = insert.first->second;
-  *out_packetId = m_flowPktIdMap[*out_flowId];
+  *out_packetId = m_flowPktIdMap[*out_flowId - 1];
 
   return true;
 }
@@ -173,13 +187,9 @@ Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPa
 Ipv6FlowClassifier::FiveTuple
 Ipv6FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  if (flowId > 0 && flowId <= m_flows.size ())
     {
-      if (iter->second == flowId)
-        {
-          return iter->first;
-        }
+      return m_flows[flowId - 1];
     }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
   FiveTuple retval = { Ipv6Address::GetZero (), Ipv6Address::GetZero (), 0, 0, 0 };
@@ -194,16 +204,15 @@ Ipv6FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
   INDENT (indent); os << "<Ipv6FlowClassifier>\n";
 
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  for (uint32_t i = 0; i < m_flows.size (); i++)
     {
       INDENT (indent);
-      os << "<Flow flowId=\"" << iter->second << "\""
-         << " sourceAddress=\"" << iter->first.sourceAddress << "\""
-         << " destinationAddress=\"" << iter->first.destinationAddress << "\""
-         << " protocol=\"" << int(iter->first.protocol) << "\""
-         << " sourcePort=\"" << iter->first.sourcePort << "\""
-         << " destinationPort=\"" << iter->first.destinationPort << "\""
+      os << "<Flow flowId=\"" << i + 1 << "\""
+         << " sourceAddress=\"" << m_flows[i].sourceAddress << "\""
+         << " destinationAddress=\"" << m_flows[i].destinationAddress << "\""
+         << " protocol=\"" << int(m_flows[i].protocol) << "\""
+         << " sourcePort=\"" << m_flows[i].sourcePort << "\""
+         << " destinationPort=\"" << m_flows[i].destinationPort << "\""
          << " />\n";
     }
 
@@ -24,9 +24,11 @@
 
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 #include "ns3/ipv6-header.h"
 #include "ns3/flow-classifier.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -74,10 +76,21 @@ public:
 
 private:
 
+  /// Hash function class for the five-tuples
+  struct FiveTupleHash
+  {
+    /// Hash a five-tuple
+    /// \param tuple the five-tuple
+    /// \returns the hash value
+    size_t operator() (const FiveTuple &tuple) const;
+  };
+
   /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
+  sgi::hash_map<FiveTuple, FlowId, FiveTupleHash> m_flowMap;
+  /// Last FlowPacketId of each flow, indexed by FlowId - 1
+  std::vector<FlowPacketId> m_flowPktIdMap;
+  /// FiveTuple of each flow, indexed by FlowId - 1
+  std::vector<FiveTuple> m_flows;
 
 };
 
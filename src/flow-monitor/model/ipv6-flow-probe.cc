@@ -205,8 +205,9 @@ Ipv6FlowProbe::Ipv6FlowProbe (Ptr<FlowMonitor> monitor,
     {
       NS_FATAL_ERROR ("trace fail");
     }
-  if (!ipv6->TraceConnectWithoutContext ("UnicastForward",
-                                         MakeCallback (&Ipv6FlowProbe::ForwardLogger, Ptr<Ipv6FlowProbe> (this))))
+  if (monitor->GetProbeForwarding ()
+      && !ipv6->TraceConnectWithoutContext ("UnicastForward",
+                                            MakeCallback (&Ipv6FlowProbe::ForwardLogger, Ptr<Ipv6FlowProbe> (this))))
     {
       NS_FATAL_ERROR ("trace fail");
     }
@@ -259,6 +260,11 @@ Ipv6FlowProbe::SendOutgoingLogger (const Ipv6Header &ipHeader, Ptr<const Packet>
 
   if (m_classifier->Classify (ipHeader, ipPayload, &flowId, &packetId))
     {
+      if (!m_flowMonitor->IsSampled (flowId, packetId))
+        {
+          return;
+        }
+
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("ReportFirstTx ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<"); "
                                      << ipHeader << *ipPayload);
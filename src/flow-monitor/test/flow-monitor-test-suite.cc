@@ -0,0 +1,489 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/// A probe that reports the packet events it is told to
+class TestFlowProbe : public FlowProbe
+{
+public:
+  TestFlowProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+  void Tx (FlowId flowId, FlowPacketId packetId, uint32_t size)
+  {
+    m_flowMonitor->ReportFirstTx (this, flowId, packetId, size);
+  }
+  void Forward (FlowId flowId, FlowPacketId packetId, uint32_t size)
+  {
+    m_flowMonitor->ReportForwarding (this, flowId, packetId, size);
+  }
+  void Rx (FlowId flowId, FlowPacketId packetId, uint32_t size)
+  {
+    m_flowMonitor->ReportLastRx (this, flowId, packetId, size);
+  }
+  void Drop (FlowId flowId, FlowPacketId packetId, uint32_t size, uint32_t reasonCode)
+  {
+    m_flowMonitor->ReportDrop (this, flowId, packetId, size, reasonCode);
+  }
+};
+
+/// Read the lines of a file
+static std::vector<std::string>
+ReadLines (std::string fileName)
+{
+  std::vector<std::string> lines;
+  std::ifstream is (fileName.c_str ());
+  std::string line;
+  while (std::getline (is, line))
+    {
+      lines.push_back (line);
+    }
+  return lines;
+}
+
+
+class FlowMonitorStatsTestCase : public TestCase
+{
+public:
+  FlowMonitorStatsTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowMonitorStatsTestCase::FlowMonitorStatsTestCase ()
+  : TestCase ("Flow statistics and tracked packets")
+{
+}
+
+void
+FlowMonitorStatsTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<TestFlowProbe> probe = Create<TestFlowProbe> (monitor);
+
+  // flow 1: three packets, one received after a forward, one dropped, one lost
+  Simulator::Schedule (MilliSeconds (1000), &TestFlowProbe::Tx, probe, 1, 0, 100);
+  Simulator::Schedule (MilliSeconds (1000), &TestFlowProbe::Tx, probe, 1, 1, 100);
+  Simulator::Schedule (MilliSeconds (1000), &TestFlowProbe::Tx, probe, 1, 2, 100);
+  Simulator::Schedule (MilliSeconds (1100), &TestFlowProbe::Forward, probe, 1, 0, 100);
+  Simulator::Schedule (MilliSeconds (1200), &TestFlowProbe::Rx, probe, 1, 0, 100);
+  Simulator::Schedule (MilliSeconds (1300), &TestFlowProbe::Drop, probe, 1, 1, 100, 2);
+  // flow 7: the records of flow 1 are reused
+  Simulator::Schedule (MilliSeconds (2000), &TestFlowProbe::Tx, probe, 7, 0, 500);
+  Simulator::Schedule (MilliSeconds (2500), &TestFlowProbe::Rx, probe, 7, 0, 500);
+  // an unknown packet is ignored
+  Simulator::Schedule (MilliSeconds (2500), &TestFlowProbe::Rx, probe, 7, 1, 500);
+  Simulator::Stop (Seconds (20.0));
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), 2, "Two flows were seen");
+  const FlowMonitor::FlowStats &flow1 = stats.find (1)->second;
+  NS_TEST_EXPECT_MSG_EQ (flow1.txPackets, 3, "Transmitted packets of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (flow1.txBytes, 300, "Transmitted bytes of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (flow1.rxPackets, 1, "Received packets of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (flow1.timesForwarded, 1, "Forwards of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (flow1.delaySum, MilliSeconds (200), "Delay of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (flow1.packetsDropped.size (), 3, "Drop reason codes of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (flow1.packetsDropped[2], 1, "Dropped packets of flow 1");
+  // the periodic check considers the third packet lost after MaxPerHopDelay
+  NS_TEST_EXPECT_MSG_EQ (flow1.lostPackets, 2, "Lost packets of flow 1");
+  const FlowMonitor::FlowStats &flow7 = stats.find (7)->second;
+  NS_TEST_EXPECT_MSG_EQ (flow7.rxPackets, 1, "Received packets of flow 7");
+  NS_TEST_EXPECT_MSG_EQ (flow7.rxBytes, 500, "Received bytes of flow 7");
+  NS_TEST_EXPECT_MSG_EQ (flow7.delaySum, MilliSeconds (500), "Delay of flow 7");
+  NS_TEST_EXPECT_MSG_EQ (flow7.lostPackets, 0, "Lost packets of flow 7");
+
+  Simulator::Destroy ();
+  monitor->Dispose ();
+}
+
+
+class FlowMonitorCsvExportTestCase : public TestCase
+{
+public:
+  FlowMonitorCsvExportTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowMonitorCsvExportTestCase::FlowMonitorCsvExportTestCase ()
+  : TestCase ("Streaming export of the flow records in CSV")
+{
+}
+
+void
+FlowMonitorCsvExportTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flowmon-records.csv");
+  Ptr<FlowMonitor> monitor = CreateObjectWithAttributes<FlowMonitor>
+      ("ExportInterval", TimeValue (Seconds (1.0)),
+      "ExportFileName", StringValue (fileName));
+  Ptr<TestFlowProbe> probe = Create<TestFlowProbe> (monitor);
+
+  // first interval: flows 1 and 2 start, flow 1 delivers a packet
+  Simulator::Schedule (Seconds (0.5), &TestFlowProbe::Tx, probe, 1, 0, 100);
+  Simulator::Schedule (Seconds (0.5), &TestFlowProbe::Tx, probe, 2, 0, 200);
+  Simulator::Schedule (Seconds (0.75), &TestFlowProbe::Rx, probe, 1, 0, 100);
+  // second interval: flow 1 only
+  Simulator::Schedule (Seconds (1.5), &TestFlowProbe::Tx, probe, 1, 1, 100);
+  Simulator::Schedule (Seconds (1.5), &TestFlowProbe::Tx, probe, 1, 2, 100);
+  // after the last interval: flow 2 delivers its packet before the end
+  Simulator::Schedule (Seconds (3.5), &TestFlowProbe::Rx, probe, 2, 0, 200);
+  Simulator::Stop (Seconds (3.75));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::vector<std::string> lines = ReadLines (fileName);
+  NS_TEST_ASSERT_MSG_EQ (lines.size (), 5, "Header and four records");
+  NS_TEST_EXPECT_MSG_EQ (lines[0], "time,flowId,txPackets,txBytes,rxPackets,rxBytes,lostPackets,delaySum",
+                         "Header");
+  NS_TEST_EXPECT_MSG_EQ (lines[1], "1,1,1,100,1,100,0,0.25", "Flow 1 in the first interval");
+  NS_TEST_EXPECT_MSG_EQ (lines[2], "1,2,1,200,0,0,0,0", "Flow 2 in the first interval");
+  NS_TEST_EXPECT_MSG_EQ (lines[3], "2,1,2,200,0,0,0,0", "Flow 1 in the second interval");
+  NS_TEST_EXPECT_MSG_EQ (lines[4], "3.75,2,0,0,1,200,0,3", "Flow 2 at the end of the simulation");
+
+  monitor->Dispose ();
+}
+
+
+class FlowMonitorIdleFlowTestCase : public TestCase
+{
+public:
+  FlowMonitorIdleFlowTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowMonitorIdleFlowTestCase::FlowMonitorIdleFlowTestCase ()
+  : TestCase ("Removal of the idle flows with the binary export")
+{
+}
+
+void
+FlowMonitorIdleFlowTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flowmon-records.bin");
+  Ptr<FlowMonitor> monitor = CreateObjectWithAttributes<FlowMonitor>
+      ("ExportInterval", TimeValue (Seconds (1.0)),
+      "ExportFileName", StringValue (fileName),
+      "ExportFormat", EnumValue (FlowMonitor::EXPORT_BINARY),
+      "FlowIdleTimeout", TimeValue (Seconds (2.0)));
+  Ptr<TestFlowProbe> probe = Create<TestFlowProbe> (monitor);
+
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (Seconds (0.5), &TestFlowProbe::Tx, probe, 1 + i, 0, 100);
+      Simulator::Schedule (Seconds (0.6), &TestFlowProbe::Rx, probe, 1 + i, 0, 100);
+    }
+  // flow 1 stays active
+  for (uint32_t i = 1; i < 8; i++)
+    {
+      Simulator::Schedule (Seconds (0.5 + i), &TestFlowProbe::Tx, probe, 1, i, 100);
+      Simulator::Schedule (Seconds (0.6 + i), &TestFlowProbe::Rx, probe, 1, i, 100);
+    }
+  Simulator::Stop (Seconds (7.0));
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.size (), 1, "The idle flows were removed");
+  NS_TEST_EXPECT_MSG_EQ (stats.begin ()->first, 1, "The active flow was kept");
+  NS_TEST_EXPECT_MSG_EQ (stats.begin ()->second.rxPackets, 7, "The active flow kept its counters");
+
+  Simulator::Destroy ();
+
+  std::ifstream is (fileName.c_str (), std::ios::in | std::ios::binary);
+  is.seekg (0, std::ios::end);
+  // 10 flows in the first interval, then flow 1 in the next six
+  NS_TEST_EXPECT_MSG_EQ (static_cast<int64_t> (is.tellg ()), 16 * 48, "Size of the binary records");
+  is.seekg (48);
+  int64_t time;
+  uint32_t flowId, txPackets;
+  is.read (reinterpret_cast<char *> (&time), sizeof (time));
+  is.read (reinterpret_cast<char *> (&flowId), sizeof (flowId));
+  is.read (reinterpret_cast<char *> (&txPackets), sizeof (txPackets));
+  NS_TEST_EXPECT_MSG_EQ (time, 1000000000, "Time of the second record");
+  NS_TEST_EXPECT_MSG_EQ (flowId, 2, "Flow of the second record");
+  NS_TEST_EXPECT_MSG_EQ (txPackets, 1, "Transmitted packets of the second record");
+
+  monitor->Dispose ();
+}
+
+
+class FlowMonitorEstimateTestCase : public TestCase
+{
+public:
+  FlowMonitorEstimateTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowMonitorEstimateTestCase::FlowMonitorEstimateTestCase ()
+  : TestCase ("Scaled statistics of the sampled packets")
+{
+}
+
+void
+FlowMonitorEstimateTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObjectWithAttributes<FlowMonitor>
+      ("SamplingRate", UintegerValue (4));
+  Ptr<TestFlowProbe> probe = Create<TestFlowProbe> (monitor);
+
+  // 25 tracked packets of 100 bytes, with delays of 10 and 30 ms
+  for (uint32_t i = 0; i < 25; i++)
+    {
+      Simulator::Schedule (MilliSeconds (100 + i), &TestFlowProbe::Tx, probe, 1, i, 100);
+      Simulator::Schedule (MilliSeconds (110 + i + 20 * (i % 2)), &TestFlowProbe::Rx, probe, 1, i, 100);
+    }
+  Simulator::Stop (Seconds (1.0));
+  Simulator::Run ();
+
+  FlowMonitor::FlowStatsEstimate estimate = monitor->EstimateFlowStats (1, 2.0);
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.txPackets.value, 100, 1e-9, "Scaled transmitted packets");
+  // half-width: 2 * sqrt (4 * 3 * 25)
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.txPackets.lowerBound, 100 - 2 * std::sqrt (300.0), 1e-9, "Lower bound");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.txPackets.upperBound, 100 + 2 * std::sqrt (300.0), 1e-9, "Upper bound");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.rxBytes.value, 10000, 1e-9, "Scaled received bytes");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.rxBytes.upperBound - estimate.rxBytes.value,
+                             2 * std::sqrt (12 * 25 * 100.0 * 100), 1e-6, "Bytes interval");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.lostPackets.upperBound, 0, 1e-9, "No loss");
+  // 13 delays of 10 ms and 12 of 30 ms
+  double mean = (13 * 0.010 + 12 * 0.030) / 25;
+  double variance = (13 * (0.010 - mean) * (0.010 - mean) + 12 * (0.030 - mean) * (0.030 - mean)) / 24;
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.meanDelay.value, mean, 1e-9, "Mean delay is not scaled");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.meanDelay.upperBound - mean, 2 * std::sqrt (variance / 25), 1e-9,
+                             "Interval of the mean delay");
+  NS_TEST_EXPECT_MSG_EQ (monitor->EstimateFlowStats (2).rxPackets.value, 0, "Unknown flow");
+
+  Simulator::Destroy ();
+  monitor->Dispose ();
+}
+
+
+/**
+ * Send a UDP flow over a router and check the statistics collected by
+ * the IPv4 probes with a configuration of the monitor
+ */
+class FlowMonitorProbeTestCase : public TestCase
+{
+public:
+  /**
+   * \param samplingRate the SamplingRate attribute
+   * \param usePacketTags the UsePacketTags attribute
+   * \param probeForwarding the ProbeForwarding attribute
+   */
+  FlowMonitorProbeTestCase (uint32_t samplingRate, bool usePacketTags, bool probeForwarding);
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param samplingRate the SamplingRate attribute
+   * \param usePacketTags the UsePacketTags attribute
+   * \param probeForwarding the ProbeForwarding attribute
+   * \returns the name of the test case
+   */
+  static std::string Name (uint32_t samplingRate, bool usePacketTags, bool probeForwarding);
+  /// Send a packet
+  /// \param socket the sending socket
+  void Send (Ptr<Socket> socket);
+  /// Receive the packets
+  /// \param socket the receiving socket
+  void Receive (Ptr<Socket> socket);
+
+  uint32_t m_samplingRate;     //!< SamplingRate attribute
+  bool m_usePacketTags;        //!< UsePacketTags attribute
+  bool m_probeForwarding;      //!< ProbeForwarding attribute
+  uint32_t m_received;         //!< received packets
+  uint32_t m_tagged;           //!< received packets carrying a flow probe tag
+};
+
+FlowMonitorProbeTestCase::FlowMonitorProbeTestCase (uint32_t samplingRate, bool usePacketTags,
+                                                    bool probeForwarding)
+  : TestCase (Name (samplingRate, usePacketTags, probeForwarding)),
+    m_samplingRate (samplingRate),
+    m_usePacketTags (usePacketTags),
+    m_probeForwarding (probeForwarding),
+    m_received (0),
+    m_tagged (0)
+{
+}
+
+std::string
+FlowMonitorProbeTestCase::Name (uint32_t samplingRate, bool usePacketTags, bool probeForwarding)
+{
+  std::ostringstream oss;
+  oss << "IPv4 probes, sampling 1 in " << samplingRate
+      << (usePacketTags ? ", tags" : ", no tags")
+      << (probeForwarding ? ", forwarding probed" : ", forwarding not probed");
+  return oss.str ();
+}
+
+void
+FlowMonitorProbeTestCase::Send (Ptr<Socket> socket)
+{
+  socket->SendTo (Create<Packet> (100), 0, InetSocketAddress (Ipv4Address ("10.0.2.2"), 9));
+}
+
+void
+FlowMonitorProbeTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      m_received++;
+      ByteTagIterator tags = packet->GetByteTagIterator ();
+      while (tags.HasNext ())
+        {
+          if (tags.Next ().GetTypeId ().GetName () == "ns3::Ipv4FlowProbeTag")
+            {
+              m_tagged++;
+              break;
+            }
+        }
+    }
+}
+
+/**
+ * Add a device on a channel to a node, with an IPv4 address
+ * \param node the node
+ * \param channel the channel
+ * \param address the address of the interface
+ * \returns the index of the interface
+ */
+static uint32_t
+AddInterface (Ptr<Node> node, Ptr<SimpleChannel> channel, Ipv4Address address)
+{
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+  device->SetChannel (channel);
+  node->AddDevice (device);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+  return interface;
+}
+
+void
+FlowMonitorProbeTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  // sender -- router -- receiver
+  Ptr<SimpleChannel> channel1 = CreateObjectWithAttributes<SimpleChannel> ("Delay", TimeValue (MilliSeconds (1)));
+  Ptr<SimpleChannel> channel2 = CreateObjectWithAttributes<SimpleChannel> ("Delay", TimeValue (MilliSeconds (1)));
+  uint32_t interface = AddInterface (nodes.Get (0), channel1, Ipv4Address ("10.0.1.1"));
+  AddInterface (nodes.Get (1), channel1, Ipv4Address ("10.0.1.2"));
+  AddInterface (nodes.Get (1), channel2, Ipv4Address ("10.0.2.1"));
+  AddInterface (nodes.Get (2), channel2, Ipv4Address ("10.0.2.2"));
+  Ipv4StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (nodes.Get (0)->GetObject<Ipv4> ())
+  ->SetDefaultRoute (Ipv4Address ("10.0.1.2"), interface);
+
+  FlowMonitorHelper flowmon;
+  flowmon.SetMonitorAttribute ("SamplingRate", UintegerValue (m_samplingRate));
+  flowmon.SetMonitorAttribute ("UsePacketTags", BooleanValue (m_usePacketTags));
+  flowmon.SetMonitorAttribute ("ProbeForwarding", BooleanValue (m_probeForwarding));
+  Ptr<FlowMonitor> monitor = flowmon.Install (nodes);
+
+  Ptr<Socket> rxSocket = nodes.Get (2)->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  rxSocket->SetRecvCallback (MakeCallback (&FlowMonitorProbeTestCase::Receive, this));
+  Ptr<Socket> txSocket = nodes.Get (0)->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  const uint32_t packets = 1000;
+  // the first packet waits for the address resolutions on the way
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorProbeTestCase::Send, this, txSocket);
+  for (uint32_t i = 1; i < packets; i++)
+    {
+      Simulator::Schedule (MilliSeconds (300 + 5 * i), &FlowMonitorProbeTestCase::Send, this, txSocket);
+    }
+  Simulator::Stop (Seconds (6.0));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, packets, "All the packets were received");
+
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), 1, "One flow");
+  const FlowMonitor::FlowStats &flow = stats.begin ()->second;
+  NS_TEST_EXPECT_MSG_EQ (flow.txPackets, flow.rxPackets, "Every tracked packet was received");
+  NS_TEST_EXPECT_MSG_EQ (m_tagged, (m_usePacketTags ? flow.rxPackets : 0), "Tags on the tracked packets only");
+  NS_TEST_EXPECT_MSG_EQ (flow.lostPackets, 0, "No lost packets");
+  NS_TEST_EXPECT_MSG_EQ (flow.timesForwarded, (m_probeForwarding ? flow.rxPackets : 0), "Forwarding hops");
+  NS_TEST_EXPECT_MSG_EQ (flow.rxBytes, flow.rxPackets * 128, "Received bytes");
+  NS_TEST_EXPECT_MSG_EQ_TOL (flow.delaySum.GetSeconds () / flow.rxPackets, 0.002, 5e-5, "Mean delay");
+  if (m_samplingRate == 1)
+    {
+      NS_TEST_EXPECT_MSG_EQ (flow.rxPackets, packets, "All the packets were tracked");
+    }
+  else
+    {
+      FlowMonitor::FlowStatsEstimate estimate = monitor->EstimateFlowStats (stats.begin ()->first);
+      NS_TEST_EXPECT_MSG_GT (flow.rxPackets, packets / m_samplingRate / 2, "Sampled packets");
+      NS_TEST_EXPECT_MSG_LT (flow.rxPackets, packets / m_samplingRate * 2, "Sampled packets");
+      NS_TEST_EXPECT_MSG_LT (estimate.rxPackets.lowerBound, packets, "Lower bound of the received packets");
+      NS_TEST_EXPECT_MSG_GT (estimate.rxPackets.upperBound, packets, "Upper bound of the received packets");
+    }
+
+  Simulator::Destroy ();
+}
+
+
+static class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ()
+    : TestSuite ("flow-monitor", UNIT)
+  {
+    AddTestCase (new FlowMonitorStatsTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowMonitorCsvExportTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowMonitorIdleFlowTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowMonitorEstimateTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowMonitorProbeTestCase (1, true, true), TestCase::QUICK);
+    AddTestCase (new FlowMonitorProbeTestCase (4, true, true), TestCase::QUICK);
+    AddTestCase (new FlowMonitorProbeTestCase (1, false, true), TestCase::QUICK);
+    AddTestCase (new FlowMonitorProbeTestCase (4, false, false), TestCase::QUICK);
+  }
+} g_flowMonitorTestSuite;
@@ -49,24 +49,37 @@ operator<< (std::ostream& os, const SPFVertex::VertexType& t)
 std::ostream& 
 operator<< (std::ostream& os, const CandidateQueue& q)
 {
-  typedef CandidateQueue::CandidateList_t List_t;
+  typedef std::vector<CandidateQueue::HeapEntry> List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list;
+  for (CandidateQueue::CandidateHeap_t::const_iterator i = q.m_heap.begin (); i != q.m_heap.end (); i++)
+    {
+      CandidateQueue::CandidateSeq_t::const_iterator c = q.m_candidates.find (i->vertex);
+      if (c != q.m_candidates.end () && c->second == i->seq)
+        {
+          list.push_back (*i);
+        }
+    }
+  std::sort (list.begin (), list.end (), &CandidateQueue::CompareHeapEntry);
+  std::reverse (list.begin (), list.end ());
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_heap (),
+    m_candidates (),
+    m_ids (),
+    m_nextSeq (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -89,16 +102,42 @@ CandidateQueue::Clear (void)
     }
 }
 
+void
+CandidateQueue::PushEntry (SPFVertex *v)
+{
+  HeapEntry entry;
+  entry.vertex = v;
+  entry.distance = v->GetDistanceFromRoot ();
+  entry.network = (v->GetVertexType () == SPFVertex::VertexNetwork);
+  entry.seq = m_nextSeq++;
+  m_candidates[v] = entry.seq;
+  m_heap.push_back (entry);
+  std::push_heap (m_heap.begin (), m_heap.end (), &CandidateQueue::CompareHeapEntry);
+}
+
+void
+CandidateQueue::DiscardStaleEntries (void)
+{
+  while (!m_heap.empty ())
+    {
+      const HeapEntry &top = m_heap.front ();
+      CandidateSeq_t::const_iterator c = m_candidates.find (top.vertex);
+      if (c != m_candidates.end () && c->second == top.seq)
+        {
+          return;
+        }
+      std::pop_heap (m_heap.begin (), m_heap.end (), &CandidateQueue::CompareHeapEntry);
+      m_heap.pop_back ();
+    }
+}
+
 void
 CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
-
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  NS_ASSERT_MSG (m_candidates.find (vNew) == m_candidates.end (), "Vertex already in the queue");
+  m_ids.insert (std::make_pair (vNew->GetVertexId (), vNew));
+  PushEntry (vNew);
 }
 
 SPFVertex *
@@ -110,8 +149,20 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_heap.front ().vertex;
+  std::pop_heap (m_heap.begin (), m_heap.end (), &CandidateQueue::CompareHeapEntry);
+  m_heap.pop_back ();
+  m_candidates.erase (v);
+  std::pair<CandidateIds_t::iterator, CandidateIds_t::iterator> range = m_ids.equal_range (v->GetVertexId ());
+  for (CandidateIds_t::iterator i = range.first; i != range.second; i++)
+    {
+      if (i->second == v)
+        {
+          m_ids.erase (i);
+          break;
+        }
+    }
+  DiscardStaleEntries ();
   return v;
 }
 
@@ -124,7 +175,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_heap.front ().vertex;
 }
 
 bool
@@ -145,18 +196,32 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  std::pair<CandidateIds_t::const_iterator, CandidateIds_t::const_iterator> range = m_ids.equal_range (addr);
+  SPFVertex *found = 0;
+  uint64_t foundSeq = 0;
+  for (CandidateIds_t::const_iterator i = range.first; i != range.second; i++)
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
+      // on duplicate IDs, return the vertex that would be popped first
+      uint64_t seq = m_candidates.find (i->second)->second;
+      if (found == 0
+          || CompareSPFVertex (i->second, found)
+          || (!CompareSPFVertex (found, i->second) && seq < foundSeq))
         {
-          return v;
+          found = i->second;
+          foundSeq = seq;
         }
     }
 
-  return 0;
+  return found;
+}
+
+void
+CandidateQueue::Update (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+  NS_ASSERT_MSG (m_candidates.find (v) != m_candidates.end (), "Vertex not in the queue");
+  PushEntry (v);
+  DiscardStaleEntries ();
 }
 
 void
@@ -164,11 +229,38 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  CandidateHeap_t heap;
+  for (CandidateHeap_t::iterator i = m_heap.begin (); i != m_heap.end (); i++)
+    {
+      CandidateSeq_t::const_iterator c = m_candidates.find (i->vertex);
+      if (c != m_candidates.end () && c->second == i->seq)
+        {
+          HeapEntry entry = *i;
+          entry.distance = entry.vertex->GetDistanceFromRoot ();
+          heap.push_back (entry);
+        }
+    }
+  std::make_heap (heap.begin (), heap.end (), &CandidateQueue::CompareHeapEntry);
+  m_heap.swap (heap);
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+bool
+CandidateQueue::CompareHeapEntry (const HeapEntry &e1, const HeapEntry &e2)
+{
+  // std heaps keep the greatest element on top
+  if (e1.distance != e2.distance)
+    {
+      return e1.distance > e2.distance;
+    }
+  if (e1.network != e2.network)
+    {
+      return e2.network;
+    }
+  return e1.seq > e2.seq;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
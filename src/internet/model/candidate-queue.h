@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
+#include <map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -43,8 +44,15 @@ class SPFVertex;
  *
  * Although a STL priority_queue almost does what we want, the requirement
  * for a Find () operation, the dynamic nature of the data and the derived
- * requirement for a Reorder () operation led us to implement this simple 
+ * requirement for a decrease-key operation led us to implement this
  * enhanced priority queue.
+ *
+ * The vertices are held in a binary heap, so that Push and Pop take a
+ * logarithmic time.  A vertex whose distance decreased is moved with
+ * Update, which pushes a new heap entry for the vertex and leaves the
+ * previous one behind; such stale entries are discarded when they reach
+ * the top of the heap.  Vertices of equal priority are popped in the order
+ * in which they were pushed or last updated.
  */
 class CandidateQueue
 {
@@ -137,6 +145,18 @@ public:
  */
   SPFVertex* Find (const Ipv4Address addr) const;
 
+/**
+ * @brief Move a Shortest Path First Vertex pointer already in the queue
+ * after the value of its field m_distanceFromRoot changed.
+ *
+ * The vertex is placed after the other vertices of equal priority, as if it
+ * had been popped and pushed again.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance changed.
+ */
+  void Update (SPFVertex *v);
+
 /**
  * @brief Reorders the Candidate Queue according to the priority scheme.
  * 
@@ -182,8 +202,44 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  /**
+   * \brief An entry of the heap.
+   */
+  struct HeapEntry
+  {
+    SPFVertex *vertex;  //!< the vertex
+    uint32_t distance;  //!< distance of the vertex when the entry was pushed
+    bool network;       //!< whether the vertex is a network vertex
+    uint64_t seq;       //!< sequence number of the entry
+  };
+
+  /**
+   * \brief Heap order of the entries.
+   * \param e1 first operand
+   * \param e2 second operand
+   * \return True if e1 should be popped after e2; false otherwise
+   */
+  static bool CompareHeapEntry (const HeapEntry &e1, const HeapEntry &e2);
+
+  /**
+   * \brief Push a new heap entry for a vertex.
+   * \param v the vertex
+   */
+  void PushEntry (SPFVertex *v);
+
+  /**
+   * \brief Remove the stale entries from the top of the heap.
+   */
+  void DiscardStaleEntries (void);
+
+  typedef std::vector<HeapEntry> CandidateHeap_t; //!< heap of SPFVertex entries
+  typedef std::map<SPFVertex*, uint64_t> CandidateSeq_t; //!< SPFVertex candidates and their current entry
+  typedef std::multimap<Ipv4Address, SPFVertex*> CandidateIds_t; //!< SPFVertex candidates by vertex ID
+
+  CandidateHeap_t m_heap;       //!< heap of SPFVertex entries, possibly stale
+  CandidateSeq_t m_candidates;  //!< SPFVertex candidates and the sequence number of their current heap entry
+  CandidateIds_t m_ids;         //!< SPFVertex candidates by vertex ID
+  uint64_t m_nextSeq;           //!< sequence number of the next heap entry
 
   /**
    * \brief Stream insertion operator.
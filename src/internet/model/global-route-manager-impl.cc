@@ -423,7 +423,8 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
-    m_extdatabase ()
+    m_extdatabase (),
+    m_linkDataIndexValid (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -471,6 +472,7 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
   else
     {
       m_database.insert (LSDBPair_t (addr, lsa));
+      m_linkDataIndexValid = false;
     }
 }
 
@@ -488,6 +490,17 @@ GlobalRouteManagerLSDB::GetNumExtLSAs () const
   return m_extdatabase.size ();
 }
 
+void
+GlobalRouteManagerLSDB::GetLinkStateIds (std::vector<Ipv4Address> &ids) const
+{
+  NS_LOG_FUNCTION (this);
+  LSDBMap_t::const_iterator i;
+  for (i= m_database.begin (); i!= m_database.end (); i++)
+    {
+      ids.push_back (i->first);
+    }
+}
+
 GlobalRoutingLSA*
 GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 {
@@ -495,13 +508,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,22 +521,33 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by its address.  The transit link records of all the LSAs
+// are indexed on the first lookup following an insertion; the index keeps
+// the first LSA, in database order, for each link data.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  if (!m_linkDataIndexValid)
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
+      m_linkDataIndex.clear ();
+      LSDBMap_t::const_iterator i;
+      for (i= m_database.begin (); i!= m_database.end (); i++)
         {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
+          GlobalRoutingLSA* temp = i->second;
+// Iterate among temp's Link Records
+          for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
             {
-              return temp;
+              GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
+              if (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  m_linkDataIndex.insert (LSDBPair_t (lr->GetLinkData (), temp));
+                }
             }
         }
+      m_linkDataIndexValid = true;
+    }
+  LSDBMap_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
+    {
+      return i->second;
     }
   return 0;
 }
@@ -537,9 +558,133 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 //
 // ---------------------------------------------------------------------------
 
+namespace {
+
+//
+// A transit link of an LSA, as SPFNext follows it: a point-to-point or
+// transit network link record of a router-LSA, or a router attached to a
+// network-LSA.
+//
+struct TransitLink
+{
+  GlobalRoutingLinkRecord::LinkType type; // the type of the link
+  Ipv4Address id;                         // the link state ID at the other end
+  Ipv4Address data;                       // the link data
+  uint32_t metric;                        // the cost of the link
+};
+
+bool
+operator== (const TransitLink &a, const TransitLink &b)
+{
+  return a.type == b.type && a.id == b.id && a.data == b.data && a.metric == b.metric;
+}
+
+//
+// Append the transit links of <lsa> to <links>, in the order SPFNext
+// examines them.  The routers attached to a network are looked up in <lsdb>.
+//
+void
+GetTransitLinks (const GlobalRouteManagerLSDB* lsdb, const GlobalRoutingLSA* lsa,
+                 std::vector<TransitLink> &links)
+{
+  TransitLink link;
+  if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+    {
+      for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+              || l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              link.type = l->GetLinkType ();
+              link.id = l->GetLinkId ();
+              link.data = l->GetLinkData ();
+              link.metric = l->GetMetric ();
+              links.push_back (link);
+            }
+        }
+    }
+  else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+        {
+          GlobalRoutingLSA *w_lsa = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (i));
+          if (w_lsa)
+            {
+              link.type = GlobalRoutingLinkRecord::TransitNetwork;
+              link.id = w_lsa->GetLinkStateId ();
+              link.data = lsa->GetAttachedRouter (i);
+              link.metric = 0;
+              links.push_back (link);
+            }
+        }
+    }
+}
+
+//
+// Return true if the LSA <a> of <lsdbA> and the LSA <b> of <lsdbB> have the
+// same transit links, and so place their vertex alike in an SPF tree.
+//
+bool
+SameTransitLinks (const GlobalRouteManagerLSDB* lsdbA, const GlobalRoutingLSA* a,
+                  const GlobalRouteManagerLSDB* lsdbB, const GlobalRoutingLSA* b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ())
+    {
+      return false;
+    }
+  std::vector<TransitLink> linksA;
+  std::vector<TransitLink> linksB;
+  GetTransitLinks (lsdbA, a, linksA);
+  GetTransitLinks (lsdbB, b, linksB);
+  return linksA == linksB;
+}
+
+//
+// Return true if the LSAs <a> and <b> advertise the same.
+//
+bool
+SameLSA (const GlobalRoutingLSA* a, const GlobalRoutingLSA* b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // anonymous namespace
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_spfrootNode (0),
+    m_keepTrees (false)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -548,6 +693,7 @@ GlobalRouteManagerImpl::GlobalRouteManagerImpl ()
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION (this);
+  DeleteSPFTrees ();
   if (m_lsdb)
     {
       delete m_lsdb;
@@ -558,6 +704,7 @@ void
 GlobalRouteManagerImpl::DebugUseLsdb (GlobalRouteManagerLSDB* lsdb)
 {
   NS_LOG_FUNCTION (this << lsdb);
+  DeleteSPFTrees ();
   if (m_lsdb)
     {
       delete m_lsdb;
@@ -572,26 +719,9 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
-      Ptr<Node> node = *i;
-      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      if (router == 0)
-        {
-          continue;
-        }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteNodeRoutes (*i);
     }
+  DeleteSPFTrees ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -600,6 +730,41 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
     }
 }
 
+void
+GlobalRouteManagerImpl::DeleteNodeRoutes (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+}
+
+void
+GlobalRouteManagerImpl::DeleteSPFTrees (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (SPFTreeMap_t::iterator i = m_spfTrees.begin (); i != m_spfTrees.end (); i++)
+    {
+      delete i->second.root;
+    }
+  m_spfTrees.clear ();
+}
+
 //
 // In order to build the routing database, we need to walk the list of nodes
 // in the system and look for those that support the GlobalRouter interface.
@@ -724,12 +889,259 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
+          // spare SPFCalculate the lookup of the node
+          m_spfrootNode = node;
           SPFCalculate (rtr->GetRouterId ());
         }
     }
   NS_LOG_INFO ("Finished SPF calculation");
 }
 
+//
+// After a change of the topology, only the routers whose SPF tree changes
+// need the Dijkstra calculation.  Since the SPF calculation of a router only
+// writes the routes of that router, and is deterministic, a kept tree whose
+// shape did not change gives the routes of a new calculation when it is
+// walked again in the order its vertices entered it.
+//
+void
+GlobalRouteManagerImpl::UpdateRoutingTables ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_keepTrees)
+    {
+      m_keepTrees = true;
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+//
+// Build a new database, and compare it with the one the kept trees refer to.
+//
+  GlobalRouteManagerLSDB *oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+
+  std::vector<Ipv4Address> ids;
+  oldLsdb->GetLinkStateIds (ids);
+  m_lsdb->GetLinkStateIds (ids);
+  std::set<Ipv4Address> changed;
+  std::set<Ipv4Address> transitChanged;
+  for (std::vector<Ipv4Address>::const_iterator i = ids.begin (); i != ids.end (); i++)
+    {
+      GlobalRoutingLSA *oldLsa = oldLsdb->GetLSA (*i);
+      GlobalRoutingLSA *newLsa = m_lsdb->GetLSA (*i);
+      if (oldLsa == 0 || newLsa == 0 || !SameTransitLinks (oldLsdb, oldLsa, m_lsdb, newLsa))
+        {
+          changed.insert (*i);
+          transitChanged.insert (*i);
+        }
+      else if (!SameLSA (oldLsa, newLsa))
+        {
+          changed.insert (*i);
+        }
+    }
+  bool extChanged = oldLsdb->GetNumExtLSAs () != m_lsdb->GetNumExtLSAs ();
+  for (uint32_t i = 0; !extChanged && i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      extChanged = !SameLSA (oldLsdb->GetExtLSA (i), m_lsdb->GetExtLSA (i));
+    }
+  NS_LOG_LOGIC (changed.size () << " LSAs changed, " << transitChanged.size () <<
+                " of them in their transit links");
+
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (!rtr)
+        {
+          continue;
+        }
+      SPFTreeMap_t::iterator tree = m_spfTrees.find (node->GetId ());
+      if (node->GetSystemId () != systemId || !rtr->GetNumLSAs ())
+        {
+          // as InitializeRoutes, leave the node without routes
+          DeleteNodeRoutes (node);
+          if (tree != m_spfTrees.end ())
+            {
+              delete tree->second.root;
+              m_spfTrees.erase (tree);
+            }
+          continue;
+        }
+      if (tree == m_spfTrees.end () || IsSPFTreeAffected (tree->second, oldLsdb, transitChanged))
+        {
+          NS_LOG_LOGIC ("Recomputing the SPF tree of node " << node->GetId ());
+          DeleteNodeRoutes (node);
+          if (tree != m_spfTrees.end ())
+            {
+              delete tree->second.root;
+              m_spfTrees.erase (tree);
+            }
+          m_spfrootNode = node;
+          SPFCalculate (rtr->GetRouterId ());
+        }
+      else if (tree->second.root != 0)
+        {
+          UpdateSPFTree (node, tree->second, changed, extChanged);
+        }
+    }
+  delete oldLsdb;
+}
+
+bool
+GlobalRouteManagerImpl::IsSPFTreeAffected (const SPFTree &tree, const GlobalRouteManagerLSDB* oldLsdb,
+                                           const std::set<Ipv4Address> &transitChanged)
+{
+  NS_LOG_FUNCTION (this << oldLsdb);
+  if (tree.root == 0)
+    {
+      for (uint32_t i = 0; i < tree.links.size (); i++)
+        {
+          if (transitChanged.count (tree.links[i]))
+            {
+              return true;
+            }
+        }
+      return false;
+    }
+  if (transitChanged.count (tree.root->GetVertexId ()))
+    {
+      return true;
+    }
+  std::map<Ipv4Address, SPFVertex*> vertices;
+  vertices[tree.root->GetVertexId ()] = tree.root;
+  for (uint32_t i = 0; i < tree.order.size (); i++)
+    {
+      vertices[tree.order[i]->GetVertexId ()] = tree.order[i];
+    }
+  for (std::set<Ipv4Address>::const_iterator i = transitChanged.begin (); i != transitChanged.end (); i++)
+    {
+      std::map<Ipv4Address, SPFVertex*>::const_iterator vi = vertices.find (*i);
+      if (vi == vertices.end ())
+        {
+          // a vertex out of the tree only matters through the links to it
+          continue;
+        }
+      SPFVertex *v = vi->second;
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (*i);
+      if (lsa == 0)
+        {
+          return true;
+        }
+//
+// The exit directions of the vertices next to the root, or beyond a network
+// next to the root, are read from their links.
+//
+      for (uint32_t j = 0; v->GetParent (j) != 0; j++)
+        {
+          SPFVertex *parent = v->GetParent (j);
+          if (parent == tree.root)
+            {
+              return true;
+            }
+          for (uint32_t k = 0; parent->GetVertexType () == SPFVertex::VertexNetwork
+               && parent->GetParent (k) != 0; k++)
+            {
+              if (parent->GetParent (k) == tree.root)
+                {
+                  return true;
+                }
+            }
+        }
+//
+// Otherwise only the links on which the vertex gives the shortest distance
+// count, in order: they decide the parents and exit directions of the next
+// vertices, and the order of the vertices at the same distance.
+//
+      std::vector<TransitLink> links;
+      std::vector<Ipv4Address> oldShortest;
+      GetTransitLinks (oldLsdb, v->GetLSA (), links);
+      for (uint32_t j = 0; j < links.size (); j++)
+        {
+          std::map<Ipv4Address, SPFVertex*>::const_iterator w = vertices.find (links[j].id);
+          if (w != vertices.end ()
+              && v->GetDistanceFromRoot () + links[j].metric == w->second->GetDistanceFromRoot ())
+            {
+              oldShortest.push_back (links[j].id);
+            }
+        }
+      links.clear ();
+      std::vector<Ipv4Address> newShortest;
+      GetTransitLinks (m_lsdb, lsa, links);
+      for (uint32_t j = 0; j < links.size (); j++)
+        {
+          std::map<Ipv4Address, SPFVertex*>::const_iterator w = vertices.find (links[j].id);
+          if (w == vertices.end ()
+              || v->GetDistanceFromRoot () + links[j].metric < w->second->GetDistanceFromRoot ())
+            {
+              return true;
+            }
+          if (v->GetDistanceFromRoot () + links[j].metric == w->second->GetDistanceFromRoot ())
+            {
+              newShortest.push_back (links[j].id);
+            }
+        }
+      if (oldShortest != newShortest)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerImpl::UpdateSPFTree (Ptr<Node> node, SPFTree &tree,
+                                       const std::set<Ipv4Address> &changed, bool extChanged)
+{
+  NS_LOG_FUNCTION (this << node << extChanged);
+  bool replay = extChanged;
+  tree.root->SetLSA (m_lsdb->GetLSA (tree.root->GetVertexId ()));
+  replay |= changed.count (tree.root->GetVertexId ()) > 0;
+  for (uint32_t i = 0; i < tree.order.size (); i++)
+    {
+      SPFVertex *v = tree.order[i];
+      v->SetLSA (m_lsdb->GetLSA (v->GetVertexId ()));
+      replay |= changed.count (v->GetVertexId ()) > 0;
+    }
+  if (!replay)
+    {
+      return;
+    }
+//
+// Add the routes as SPFCalculate does: those to the vertices in the order
+// they entered the tree, then the stubs and the externals.
+//
+  NS_LOG_LOGIC ("Adding the routes of node " << node->GetId () << " again");
+  DeleteNodeRoutes (node);
+  m_spfroot = tree.root;
+  m_spfrootNode = node;
+  for (uint32_t i = 0; i < tree.order.size (); i++)
+    {
+      SPFVertex *v = tree.order[i];
+      if (v->GetVertexType () == SPFVertex::VertexRouter)
+        {
+          SPFIntraAddRouter (v);
+        }
+      else
+        {
+          SPFIntraAddTransit (v);
+        }
+    }
+  m_spfroot->ClearVertexProcessed ();
+  SPFProcessStubs (m_spfroot);
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      m_spfroot->ClearVertexProcessed ();
+      ProcessASExternals (m_spfroot, m_lsdb->GetExtLSA (i));
+    }
+  m_spfroot = 0;
+  m_spfrootNode = 0;
+}
+
 //
 // This method is derived from quagga ospf_spf_next ().  See RFC2328 Section 
 // 16.1 (2) for further details.
@@ -958,9 +1370,9 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
                 {
 //
 // If we've changed the cost to get to the vertex represented by <w>, we 
-// must reorder the priority queue keyed to that cost.
+// must move it in the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Update (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1124,7 +1536,8 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
         }
       else 
         {
-          w->SetRootExitDirection (v->GetRootExitDirection ());
+          // a network reached on equal cost paths has an exit per path
+          w->InheritAllRootExitDirections (v);
         }
     }
   else 
@@ -1368,6 +1781,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  m_spfOrder.clear ();
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
 
 //
@@ -1380,7 +1794,30 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      if (m_keepTrees && m_spfrootNode != 0)
+        {
+//
+// The default route depends on the transit links of the router and of
+// its neighbor only.
+//
+          SPFTree &tree = m_spfTrees[m_spfrootNode->GetId ()];
+          delete tree.root;
+          tree.root = 0;
+          tree.order.clear ();
+          tree.links.assign (1, root);
+          GlobalRoutingLSA *rlsa = m_spfroot->GetLSA ();
+          for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
+            {
+              GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
+              if (l->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork)
+                {
+                  tree.links.push_back (l->GetLinkId ());
+                }
+            }
+        }
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootNode = 0;
       return;
     }
 
@@ -1424,6 +1861,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
       NS_LOG_LOGIC (candidate);
       v = candidate.Pop ();
       NS_LOG_LOGIC ("Popped vertex " << v->GetVertexId ());
+      if (m_keepTrees)
+        {
+          m_spfOrder.push_back (v);
+        }
 //
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
@@ -1497,11 +1938,25 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 
 //
 // We're all done setting the routing information for the node at the root of
-// the SPF tree.  Delete all of the vertices and corresponding resources.  Go
-// possibly do it again for the next router.
+// the SPF tree.  Keep the tree for UpdateRoutingTables, or delete all of the
+// vertices and corresponding resources.  Go possibly do it again for the next
+// router.
 //
-  delete m_spfroot;
+  if (m_keepTrees && m_spfrootNode != 0)
+    {
+      SPFTree &tree = m_spfTrees[m_spfrootNode->GetId ()];
+      delete tree.root;
+      tree.root = m_spfroot;
+      tree.order.swap (m_spfOrder);
+      tree.links.clear ();
+    }
+  else
+    {
+      delete m_spfroot;
+    }
+  m_spfOrder.clear ();
   m_spfroot = 0;
+  m_spfrootNode = 0;
 }
 
 void
@@ -1560,58 +2015,37 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex is the one
+// we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetSpfRootNode ();
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1626,39 +2060,36 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1729,60 +2160,37 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex is the one
+// we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetSpfRootNode ();
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1797,39 +2205,36 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // which the packets should be send for forwarding.
 //
 
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1853,61 +2258,80 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// Find the node corresponding to the node at the root of the SPF tree.  This
+// is the node for which we are building the routing table.
+//
+  Ptr<Node> node = GetSpfRootNode ();
+  if (node == 0)
+    {
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
+      return -1;
+    }
+//
+// We're going to need the Ipv4 interface to look for the ipv4 interface
+// index.  Since this node is participating in routing IP version 4 packets,
+// it certainly must have an Ipv4 interface.
+//
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
+                 "GetObject for <Ipv4> interface failed");
+//
+// Look through the interfaces on this node for one that has the IP address
+// we're looking for.  If we find one, return the corresponding interface
+// index, or -1 if not found.
 //
+  int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+
+#if 0
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
+    }
+#endif 
+  return interface;
+}
+
+//
+// Return the node whose GlobalRouter has the router ID of the root of the SPF
+// tree.  The node is looked up once per SPF calculation.
+//
+Ptr<Node>
+GlobalRouteManagerImpl::GetSpfRootNode (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_spfroot, 
+                 "GlobalRouteManagerImpl::GetSpfRootNode (): Root pointer not set");
+  if (m_spfrootNode != 0)
+    {
+      return m_spfrootNode;
+    }
+  Ipv4Address routerId = m_spfroot->GetVertexId ();
   NodeList::Iterator i = NodeList::Begin (); 
   NodeList::Iterator listEnd = NodeList::End ();
   for (; i != listEnd; i++)
     {
       Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
 //
+// The router ID is accessible through the GlobalRouter interface, so we need
+// to GetObject for that interface.  If there's no GlobalRouter interface, 
+// the node in question cannot be the router we want, so we continue.
+// 
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
       if (rtr == 0)
         {
+          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
           continue;
         }
-
+      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
       if (rtr->GetRouterId () == routerId)
         {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
+          m_spfrootNode = node;
+          return node;
         }
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+  return 0;
 }
 
 //
@@ -1944,60 +2368,37 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex is the one
+// we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetSpfRootNode ();
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2407,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << node->GetId () <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,44 +2432,38 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-            }
-//
-// Done adding the routes for the selected node.
-//
-          return;
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      if (router == 0)
+        {
+          continue;
         }
+      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+      NS_ASSERT (gr);
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 void
@@ -2089,95 +2484,70 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex is the one
+// we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetSpfRootNode ();
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
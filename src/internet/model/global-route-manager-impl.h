@@ -26,6 +26,7 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -672,6 +673,15 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Get the link state IDs of the Link State Advertisements, other
+   * than the external ones.
+   *
+   * @param ids the vector the link state IDs are appended to, in increasing
+   * order
+   */
+  void GetLinkStateIds (std::vector<Ipv4Address> &ids) const;
+
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
@@ -679,6 +689,8 @@ private:
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  mutable LSDBMap_t m_linkDataIndex; //!< LSAs by link data of their transit link records
+  mutable bool m_linkDataIndexValid; //!< whether m_linkDataIndex is up to date
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -733,6 +745,22 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Update the routes after a change of the topology, recomputing
+ * only the SPF trees that the change affects.
+ *
+ * The first call computes all of the routes, as DeleteGlobalRoutes,
+ * BuildGlobalRoutingDatabase and InitializeRoutes do, and from then on
+ * the SPF tree of every router is kept.  The later calls build a new
+ * database and compare it with the previous one.  The tree of a router
+ * is recomputed if a link that it uses, or could now use, changed.  If
+ * only what the routers and networks of the tree advertise changed, the
+ * routes are added again from the kept tree.  Otherwise the routes of the
+ * router are left as they are.  The routes are in any case those that a
+ * complete recomputation would give, in the same order.
+ */
+  virtual void UpdateRoutingTables ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -764,8 +792,71 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /**
+   * \brief The SPF tree of a router, kept by UpdateRoutingTables
+   */
+  struct SPFTree
+  {
+    SPFVertex* root; //!< the root vertex, or 0 for a stub router
+    std::vector<SPFVertex*> order; //!< the other vertices, in the order they entered the tree
+    std::vector<Ipv4Address> links; //!< for a stub router, the link state IDs of the router and of its transit links
+  };
+  typedef std::map<uint32_t, SPFTree> SPFTreeMap_t; //!< SPF trees by node ID
+
   SPFVertex* m_spfroot; //!< the root node
+  Ptr<Node> m_spfrootNode; //!< the node of the root vertex, once looked up
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_keepTrees; //!< whether SPFCalculate keeps the SPF trees, once UpdateRoutingTables was called
+  SPFTreeMap_t m_spfTrees; //!< the kept SPF trees, by node ID
+  std::vector<SPFVertex*> m_spfOrder; //!< the vertices in the order they entered the SPF tree being calculated
+
+  /**
+   * \brief Delete the routes of a node
+   * \param node the node
+   */
+  void DeleteNodeRoutes (Ptr<Node> node);
+
+  /**
+   * \brief Delete the kept SPF trees
+   */
+  void DeleteSPFTrees (void);
+
+  /**
+   * \brief Test if a change of the database affects the shape of a kept
+   * SPF tree
+   *
+   * The tree is affected if the transit links of its root changed, if those
+   * of a router or network the root reaches directly changed, or if a
+   * changed router or network of the tree would now reach another one on a
+   * path at most as short as the one of the tree, or no longer reaches one
+   * of the tree by its shortest path.  A stub router is affected if the
+   * transit links of itself or of its neighbor changed.
+   *
+   * \param tree the SPF tree, still referring to the previous database
+   * \param oldLsdb the previous database
+   * \param transitChanged the link state IDs of the LSAs whose transit
+   * links changed, or that were added or removed
+   * \returns true if the tree must be recomputed
+   */
+  bool IsSPFTreeAffected (const SPFTree &tree, const GlobalRouteManagerLSDB* oldLsdb,
+                          const std::set<Ipv4Address> &transitChanged);
+
+  /**
+   * \brief Bring a kept SPF tree, whose shape is unchanged, up to date
+   *
+   * The vertices of the tree are given the LSAs of the current database.
+   * If one of them changed, or the external LSAs changed, the routes of
+   * the node are added again from the tree, in the order SPFCalculate adds
+   * them.
+   *
+   * \param node the node at the root of the tree
+   * \param tree the SPF tree
+   * \param changed the link state IDs of the LSAs that changed, or that
+   * were added or removed
+   * \param extChanged whether the external LSAs changed
+   */
+  void UpdateSPFTree (Ptr<Node> node, SPFTree &tree,
+                      const std::set<Ipv4Address> &changed, bool extChanged);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -944,6 +1035,17 @@ private:
    */
   int32_t FindOutgoingInterfaceId (Ipv4Address a, 
                                    Ipv4Mask amask = Ipv4Mask ("255.255.255.255"));
+
+  /**
+   * \brief Return the node at the root of the SPF tree
+   *
+   * The node is looked up in the node list on the first call of an SPF
+   * calculation, unless it was already given by InitializeRoutes.
+   *
+   * \return the node whose GlobalRouter has the router ID of the root
+   * vertex, or 0 if there is no such node
+   */
+  Ptr<Node> GetSpfRootNode (void);
 };
 
 } // namespace ns3
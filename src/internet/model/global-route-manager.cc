@@ -58,6 +58,14 @@ GlobalRouteManager::InitializeRoutes (void)
   InitializeRoutes ();
 }
 
+void
+GlobalRouteManager::UpdateRoutingTables (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  UpdateRoutingTables ();
+}
+
 uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
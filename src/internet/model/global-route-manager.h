@@ -62,6 +62,15 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Update the routes after a change of the topology, recomputing
+ * only the shortest path trees that the change affects.
+ *
+ * The first call computes all of the routes and keeps the shortest path
+ * tree of every router for the later ones.
+ */
+  static void UpdateRoutingTables ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
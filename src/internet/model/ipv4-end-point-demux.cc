@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
@@ -27,7 +28,8 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -38,33 +40,150 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_infos.clear ();
+  m_ports.clear ();
+  m_tuples.clear ();
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::Tuple::operator== (const Tuple &other) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t
+Ipv4EndPointDemux::TupleHash::operator() (const Tuple &tuple) const
+{
+  uint32_t h = tuple.localAddress.Get ();
+  h = h * 31 + tuple.peerAddress.Get ();
+  h = h * 31 + ((static_cast<uint32_t> (tuple.localPort) << 16) | tuple.peerPort);
+  return h ^ (h >> 16);
+}
+
+Ipv4EndPointDemux::Tuple
+Ipv4EndPointDemux::GetTuple (Ipv4EndPoint *endPoint)
+{
+  Tuple tuple;
+  tuple.localAddress = endPoint->GetLocalAddress ();
+  tuple.localPort = endPoint->GetLocalPort ();
+  tuple.peerAddress = endPoint->GetPeerAddress ();
+  tuple.peerPort = endPoint->GetPeerPort ();
+  return tuple;
+}
+
+bool
+Ipv4EndPointDemux::SequenceLess (const EndPointInfo *a, const EndPointInfo *b)
+{
+  return a->sequence < b->sequence;
+}
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPointInfo &info = m_infos[endPoint];
+  info.endPoint = endPoint;
+  info.sequence = m_sequence++;
+  info.all = m_endPoints.insert (m_endPoints.end (), endPoint);
+  AddToIndexes (&info);
+  endPoint->m_demux = this;
+}
+
+void
+Ipv4EndPointDemux::AddToIndexes (EndPointInfo *info)
+{
+  NS_LOG_FUNCTION (this << info->endPoint);
+  info->port = info->endPoint->GetLocalPort ();
+  Bucket &port = m_ports[info->port];
+  if (port.empty ())
     {
-      if ((*i)->GetLocalPort  () == port) 
+      SetEphemeralPortUsed (info->port, true);
+    }
+  // keep the bucket in allocation order; new endpoints go last
+  Bucket::iterator pos = port.end ();
+  while (pos != port.begin ())
+    {
+      Bucket::iterator prev = pos;
+      --prev;
+      if ((*prev)->sequence < info->sequence)
         {
-          return true;
+          break;
         }
+      pos = prev;
+    }
+  info->inPort = port.insert (pos, info);
+
+  info->tuple = GetTuple (info->endPoint);
+  Bucket &tuple = m_tuples[info->tuple];
+  info->inTuple = tuple.insert (tuple.end (), info);
+}
+
+void
+Ipv4EndPointDemux::RemoveFromIndexes (EndPointInfo *info)
+{
+  NS_LOG_FUNCTION (this << info->endPoint);
+  std::map<uint16_t, Bucket>::iterator port = m_ports.find (info->port);
+  NS_ASSERT (port != m_ports.end ());
+  port->second.erase (info->inPort);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+      SetEphemeralPortUsed (info->port, false);
+    }
+
+  sgi::hash_map<Tuple, Bucket, TupleHash>::iterator tuple = m_tuples.find (info->tuple);
+  NS_ASSERT (tuple != m_tuples.end ());
+  tuple->second.erase (info->inTuple);
+  if (tuple->second.empty ())
+    {
+      m_tuples.erase (tuple);
+    }
+}
+
+void
+Ipv4EndPointDemux::Reindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::map<Ipv4EndPoint *, EndPointInfo>::iterator i = m_infos.find (endPoint);
+  NS_ASSERT (i != m_infos.end ());
+  RemoveFromIndexes (&i->second);
+  AddToIndexes (&i->second);
+}
+
+void
+Ipv4EndPointDemux::GetTupleEndPoints (const Tuple &tuple, std::vector<EndPointInfo *> &infos)
+{
+  sgi::hash_map<Tuple, Bucket, TupleHash>::iterator i = m_tuples.find (tuple);
+  if (i != m_tuples.end ())
+    {
+      infos.insert (infos.end (), i->second.begin (), i->second.end ());
     }
-  return false;
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<uint16_t, Bucket>::iterator bucket = m_ports.find (port);
+  if (bucket == m_ports.end ())
+    {
+      return false;
+    }
+  for (Bucket::iterator i = bucket->second.begin (); i != bucket->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      if ((*i)->endPoint->GetLocalAddress () == addr) 
         {
           return true;
         }
@@ -83,7 +202,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -99,7 +218,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -122,7 +241,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -132,21 +251,20 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Tuple tuple;
+  tuple.localAddress = localAddress;
+  tuple.localPort = localPort;
+  tuple.peerAddress = peerAddress;
+  tuple.peerPort = peerPort;
+  if (m_tuples.find (tuple) != m_tuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -157,14 +275,14 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<Ipv4EndPoint *, EndPointInfo>::iterator i = m_infos.find (endPoint);
+  if (i != m_infos.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      RemoveFromIndexes (&i->second);
+      m_endPoints.erase (i->second.all);
+      m_infos.erase (i);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -204,9 +322,65 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (m_ports.find (dport) == m_ports.end ())
     {
-      Ipv4EndPoint* endP = *i;
+      NS_LOG_LOGIC ("No endpoint bound to port " << dport);
+      return retval1;
+    }
+
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // A matching endpoint has the destination, incoming interface or
+  // wildcard local address, and the source or wildcard peer address
+  // and port: only those four-tuples need to be looked at.
+  Ipv4Address localAddresses[3] = { daddr, incomingInterfaceAddr, Ipv4Address::GetAny () };
+  Ipv4Address peerAddresses[2] = { saddr, Ipv4Address::GetAny () };
+  uint16_t peerPorts[2] = { sport, 0 };
+  // the scratch vectors keep their storage from one lookup to the next
+  std::vector<Tuple> &tuples = m_lookupTuples;
+  tuples.clear ();
+  for (uint32_t l = 0; l < 3; l++)
+    {
+      for (uint32_t a = 0; a < 2; a++)
+        {
+          for (uint32_t p = 0; p < 2; p++)
+            {
+              Tuple tuple;
+              tuple.localAddress = localAddresses[l];
+              tuple.localPort = dport;
+              tuple.peerAddress = peerAddresses[a];
+              tuple.peerPort = peerPorts[p];
+              if (std::find (tuples.begin (), tuples.end (), tuple) == tuples.end ())
+                {
+                  tuples.push_back (tuple);
+                }
+            }
+        }
+    }
+  std::vector<EndPointInfo *> &candidates = m_lookupCandidates;
+  candidates.clear ();
+  for (std::vector<Tuple>::const_iterator t = tuples.begin (); t != tuples.end (); t++)
+    {
+      GetTupleEndPoints (*t, candidates);
+    }
+  std::sort (candidates.begin (), candidates.end (), &Ipv4EndPointDemux::SequenceLess);
+
+  for (std::vector<EndPointInfo *>::const_iterator i = candidates.begin (); i != candidates.end (); i++)
+    {
+      Ipv4EndPoint* endP = (*i)->endPoint;
 
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
@@ -239,20 +413,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -328,31 +488,33 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
   // function.
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<uint16_t, Bucket>::iterator bucket = m_ports.find (dport);
+  if (bucket == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
+      return 0;
+    }
+  for (Bucket::iterator j = bucket->second.begin (); j != bucket->second.end (); j++) 
+    {
+      Ipv4EndPoint *i = (*j)->endPoint;
+      if (i->GetLocalAddress () == daddr &&
+          i->GetPeerPort () == sport &&
+          i->GetPeerAddress () == saddr) 
         {
           /* this is an exact match. */
-          return *i;
+          return i;
         }
       uint32_t tmp = 0;
-      if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+      if (i->GetLocalAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
+      if (i->GetPeerAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
       if (tmp < genericity) 
         {
-          generic = (*i);
+          generic = i;
           genericity = tmp;
         }
     }
@@ -363,22 +525,63 @@ Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
   // Similar to counting up logic in netinet/in_pcb.c
   NS_LOG_FUNCTION (this);
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do 
+  uint32_t range = m_portLast - m_portFirst + 1;
+  uint16_t port = m_ephemeral + 1;
+  uint32_t start = 0;
+  if (port >= m_portFirst && port <= m_portLast)
+    {
+      start = port - m_portFirst;
+    }
+  // look for the first port not in use, starting right after the last
+  // allocated one and wrapping around the ephemeral range once
+  for (uint32_t count = 0; count < range; )
     {
-      if (count-- < 0)
+      uint32_t offset = (start + count) % range;
+      uint32_t word = offset / 32;
+      if (m_ephemeralPorts.empty ())
+        {
+          port = m_portFirst + offset;
+          m_ephemeral = port;
+          return port;
+        }
+      if (m_ephemeralPorts[word] == 0xffffffff)
         {
-          return 0;
+          // skip to the next word
+          count += 32 - offset % 32;
+          continue;
         }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
+      if ((m_ephemeralPorts[word] & (1U << (offset % 32))) == 0)
         {
-          port = m_portFirst;
+          port = m_portFirst + offset;
+          m_ephemeral = port;
+          return port;
         }
-    } while (LookupPortLocal (port));
-  m_ephemeral = port;
-  return port;
+      count++;
+    }
+  return 0;
+}
+
+void
+Ipv4EndPointDemux::SetEphemeralPortUsed (uint16_t port, bool used)
+{
+  NS_LOG_FUNCTION (this << port << used);
+  if (port < m_portFirst || port > m_portLast)
+    {
+      return;
+    }
+  uint32_t offset = port - m_portFirst;
+  if (m_ephemeralPorts.empty ())
+    {
+      m_ephemeralPorts.resize ((m_portLast - m_portFirst) / 32 + 1, 0);
+    }
+  if (used)
+    {
+      m_ephemeralPorts[offset / 32] |= (1U << (offset % 32));
+    }
+  else
+    {
+      m_ephemeralPorts[offset / 32] &= ~(1U << (offset % 32));
+    }
 }
 
 } // namespace ns3
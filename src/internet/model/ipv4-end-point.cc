@@ -19,6 +19,7 @@
  */
 
 #include "ipv4-end-point.h"
+#include "ipv4-end-point-demux.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -32,7 +33,8 @@ Ipv4EndPoint::Ipv4EndPoint (Ipv4Address address, uint16_t port)
     m_localPort (port),
     m_peerAddr (Ipv4Address::GetAny ()),
     m_peerPort (0),
-    m_rxEnabled (true)
+    m_rxEnabled (true),
+    m_demux (0)
 {
   NS_LOG_FUNCTION (this << address << port);
 }
@@ -61,6 +63,10 @@ Ipv4EndPoint::SetLocalAddress (Ipv4Address address)
 {
   NS_LOG_FUNCTION (this << address);
   m_localAddr = address;
+  if (m_demux != 0)
+    {
+      m_demux->Reindex (this);
+    }
 }
 
 uint16_t 
@@ -90,6 +96,10 @@ Ipv4EndPoint::SetPeer (Ipv4Address address, uint16_t port)
   NS_LOG_FUNCTION (this << address << port);
   m_peerAddr = address;
   m_peerPort = port;
+  if (m_demux != 0)
+    {
+      m_demux->Reindex (this);
+    }
 }
 
 void
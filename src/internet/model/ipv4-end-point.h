@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \brief A representation of an internet endpoint/connection
@@ -246,6 +247,16 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demux the EndPoint is registered in (if any).
+   *
+   * The demux indexes its end points by their addresses and ports, so it
+   * is notified when they change.
+   */
+  Ipv4EndPointDemux *m_demux;
+
+  friend class Ipv4EndPointDemux;
 };
 
 } // namespace ns3
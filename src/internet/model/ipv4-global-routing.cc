@@ -58,7 +58,8 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_indexesValid (false)
 {
   NS_LOG_FUNCTION (this);
 
@@ -79,6 +80,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_indexesValid = false;
 }
 
 void 
@@ -89,6 +91,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_indexesValid = false;
 }
 
 void 
@@ -104,6 +107,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_indexesValid = false;
 }
 
 void 
@@ -117,6 +121,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_indexesValid = false;
 }
 
 void 
@@ -132,111 +137,123 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_indexesValid = false;
 }
 
 
+void
+Ipv4GlobalRouting::UpdateIndexes (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_indexesValid)
+    {
+      return;
+    }
+  m_hostIndex.Clear ();
+  for (HostRoutesCI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
+    {
+      NS_ASSERT ((*i)->IsHost ());
+      m_hostIndex.Add (*i);
+    }
+  m_hostIndex.Build ();
+  m_networkIndex.Clear ();
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      m_networkIndex.Add (*j);
+    }
+  m_networkIndex.Build ();
+  m_ASexternalIndex.Clear ();
+  for (ASExternalRoutesCI k = m_ASexternalRoutes.begin (); k != m_ASexternalRoutes.end (); k++)
+    {
+      m_ASexternalIndex.Add (*k);
+    }
+  m_ASexternalIndex.Build ();
+  m_indexesValid = true;
+}
+
+void
+Ipv4GlobalRouting::FilterMatches (Ptr<NetDevice> oif)
+{
+  if (oif == 0)
+    {
+      return;
+    }
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < m_matches.size (); i++)
+    {
+      if (oif != m_ipv4->GetNetDevice (m_matches[i]->entry->GetInterface ()))
+        {
+          NS_LOG_LOGIC ("Not on requested interface, skipping");
+          continue;
+        }
+      m_matches[kept++] = m_matches[i];
+    }
+  m_matches.resize (kept);
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::GetSlotRoute (Ipv4RoutingTableIndex::Slot *slot)
+{
+  if (slot->route == 0)
+    {
+      Ipv4RoutingTableEntry* route = slot->entry;
+      // create a Ipv4Route object from the selected routing table entry
+      Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      /// \todo handle multi-address case
+      rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
+      rtentry->SetGateway (route->GetGateway ());
+      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+      slot->route = rtentry;
+    }
+  return slot->route;
+}
+
 Ptr<Ipv4Route>
 Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
-  Ptr<Ipv4Route> rtentry = 0;
+  UpdateIndexes ();
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  m_matches.clear ();
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
-    {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
-        {
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
-        }
-    }
-  if (allRoutes.size () == 0) // if no host route is found
+  m_hostIndex.Lookup (dest, m_matches);
+  FilterMatches (oif);
+  if (m_matches.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
-        {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
-            {
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
-            }
-        }
+      m_networkIndex.Lookup (dest, m_matches);
+      FilterMatches (oif);
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+  if (m_matches.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      m_ASexternalIndex.Lookup (dest, m_matches);
+      FilterMatches (oif);
+      if (m_matches.size () > 1)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
-            {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*k);
-              break;
-            }
+          // only the first matching external route is used
+          m_matches.resize (1);
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+  if (m_matches.size () > 0 ) // if route(s) is found
     {
+      NS_LOG_LOGIC ("Found " << m_matches.size () << " global routes");
       // pick up one of the routes uniformly at random if random
       // ECMP routing is enabled, or always select the first route
       // consistently if random ECMP routing is disabled
       uint32_t selectIndex;
       if (m_randomEcmpRouting)
         {
-          selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
+          selectIndex = m_rand->GetInteger (0, m_matches.size ()-1);
         }
       else 
         {
           selectIndex = 0;
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
-      // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
-      rtentry->SetDestination (route->GetDest ());
-      /// \todo handle multi-address case
-      rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
-      rtentry->SetGateway (route->GetGateway ());
-      uint32_t interfaceIdx = route->GetInterface ();
-      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-      return rtentry;
+      return GetSlotRoute (m_matches.at (selectIndex));
     }
   else 
     {
@@ -320,6 +337,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
               delete *i;
               m_hostRoutes.erase (i);
+              m_indexesValid = false;
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
               return;
             }
@@ -337,6 +355,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
           delete *j;
           m_networkRoutes.erase (j);
+          m_indexesValid = false;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -353,6 +372,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
           delete *k;
           m_ASexternalRoutes.erase (k);
+          m_indexesValid = false;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -391,6 +411,10 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostIndex.Clear ();
+  m_networkIndex.Clear ();
+  m_ASexternalIndex.Clear ();
+  m_indexesValid = false;
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -557,9 +581,8 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      // recompute only the routes the change of the links affects
+      GlobalRouteManager::UpdateRoutingTables ();
     }
 }
 
@@ -569,9 +592,8 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      // recompute only the routes the change of the links affects
+      GlobalRouteManager::UpdateRoutingTables ();
     }
 }
 
@@ -579,6 +601,8 @@ void
 Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  // the cached routes depend on the interface addresses
+  m_indexesValid = false;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -591,6 +615,8 @@ void
 Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  // the cached routes depend on the interface addresses
+  m_indexesValid = false;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -28,6 +28,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ipv4-routing-table-index.h"
 
 namespace ns3 {
 
@@ -260,10 +261,35 @@ private:
 
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Rebuild the route indexes if the routing table changed since
+   * they were last built.
+   */
+  void UpdateIndexes (void);
+
+  /**
+   * \brief Remove the matches that do not use a given output device.
+   * \param oif the output device, or 0 to keep all the matches
+   */
+  void FilterMatches (Ptr<NetDevice> oif);
+
+  /**
+   * \brief Get the route of an indexed entry, building it on first use.
+   * \param slot the indexed entry
+   * \return the route to the destination of the entry
+   */
+  Ptr<Ipv4Route> GetSlotRoute (Ipv4RoutingTableIndex::Slot *slot);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  Ipv4RoutingTableIndex m_hostIndex;       //!< Index of m_hostRoutes
+  Ipv4RoutingTableIndex m_networkIndex;    //!< Index of m_networkRoutes
+  Ipv4RoutingTableIndex m_ASexternalIndex; //!< Index of m_ASexternalRoutes
+  bool m_indexesValid;                     //!< Whether the indexes and cached routes are up to date
+  std::vector<Ipv4RoutingTableIndex::Slot *> m_matches; //!< Scratch vector of the routes found by a lookup
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
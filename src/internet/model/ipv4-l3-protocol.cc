@@ -39,6 +39,8 @@
 #include "icmpv4-l4-protocol.h"
 #include "ipv4-interface.h"
 #include "ipv4-raw-socket-impl.h"
+#include "tcp-header.h"
+#include "tcp-gso-tag.h"
 
 namespace ns3 {
 
@@ -635,6 +637,14 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
       tos = ipTosTag.GetTos ();
     }
 
+  // A TCP super-segment is split once routed
+  uint16_t gsoSegmentSize = 0;
+  TcpGsoTag gsoTag;
+  if (packet->RemovePacketTag (gsoTag))
+    {
+      gsoSegmentSize = gsoTag.GetSegmentSize ();
+    }
+
   // Handle a few cases:
   // 1) packet is destined to limited broadcast address
   // 2) packet is destined to a subnet-directed broadcast address
@@ -695,6 +705,11 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
     {
       NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 3:  passed in with route");
       ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+      if (gsoSegmentSize > 0)
+        {
+          SendSegments (route, packet, ipHeader, gsoSegmentSize);
+          return;
+        }
       int32_t interface = GetInterfaceForDevice (route->GetOutputDevice ());
       m_sendOutgoingTrace (ipHeader, packet, interface);
       SendRealOut (route, packet->Copy (), ipHeader);
@@ -723,7 +738,11 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
     {
       NS_LOG_ERROR ("Ipv4L3Protocol::Send: m_routingProtocol == 0");
     }
-  if (newRoute)
+  if (newRoute && gsoSegmentSize > 0)
+    {
+      SendSegments (newRoute, packet, ipHeader, gsoSegmentSize);
+    }
+  else if (newRoute)
     {
       int32_t interface = GetInterfaceForDevice (newRoute->GetOutputDevice ());
       m_sendOutgoingTrace (ipHeader, packet, interface);
@@ -866,6 +885,64 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
     }
 }
 
+// This function analogous to Linux tcp_gso_segment()
+void
+Ipv4L3Protocol::SendSegments (Ptr<Ipv4Route> route,
+                              Ptr<Packet> packet,
+                              Ipv4Header const &ipHeader,
+                              uint16_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << route << packet << &ipHeader << segmentSize);
+  NS_ASSERT (ipHeader.GetProtocol () == 6); // TCP
+  int32_t interface = GetInterfaceForDevice (route->GetOutputDevice ());
+  Ptr<Packet> payload = packet->Copy ();
+  TcpHeader tcpHeader;
+  payload->RemoveHeader (tcpHeader);
+  uint32_t size = payload->GetSize ();
+  uint8_t flags = tcpHeader.GetFlags ();
+
+  uint64_t srcDst = ipHeader.GetDestination ().Get () | (uint64_t (ipHeader.GetSource ().Get ()) << 32);
+  std::pair<uint64_t, uint8_t> key = std::make_pair (srcDst, ipHeader.GetProtocol ());
+
+  uint32_t offset = 0;
+  do
+    {
+      uint32_t length = std::min (size - offset, uint32_t (segmentSize));
+      Ptr<Packet> segment = payload->CreateFragment (offset, length);
+      TcpHeader segmentTcpHeader = tcpHeader;
+      segmentTcpHeader.SetSequenceNumber (tcpHeader.GetSequenceNumber () + SequenceNumber32 (offset));
+      uint8_t segmentFlags = flags;
+      if (offset > 0)
+        {
+          segmentFlags &= ~TcpHeader::CWR;
+        }
+      if (offset + length < size)
+        {
+          segmentFlags &= ~(TcpHeader::FIN | TcpHeader::PSH);
+        }
+      segmentTcpHeader.SetFlags (segmentFlags);
+      if (Node::ChecksumEnabled ())
+        {
+          segmentTcpHeader.EnableChecksums ();
+          segmentTcpHeader.InitializeChecksum (ipHeader.GetSource (), ipHeader.GetDestination (),
+                                               ipHeader.GetProtocol ());
+        }
+      segment->AddHeader (segmentTcpHeader);
+
+      Ipv4Header segmentIpHeader = ipHeader;
+      segmentIpHeader.SetPayloadSize (segment->GetSize ());
+      if (offset > 0)
+        {
+          segmentIpHeader.SetIdentification (m_identification[key]);
+          m_identification[key]++;
+        }
+      m_sendOutgoingTrace (segmentIpHeader, segment, interface);
+      SendRealOut (route, segment, segmentIpHeader);
+      offset += length;
+    }
+  while (offset < size);
+}
+
 // This function analogous to Linux ip_mr_forward()
 void
 Ipv4L3Protocol::IpMulticastForward (Ptr<Ipv4MulticastRoute> mrtentry, Ptr<const Packet> p, const Ipv4Header &header)
@@ -338,6 +338,23 @@ private:
                Ptr<Packet> packet,
                Ipv4Header const &ipHeader);
 
+  /**
+   * \brief Split a TCP super-segment and send the segments with route.
+   *
+   * Each segment gets a copy of the TCP header with its own sequence
+   * number, and an IPv4 header with its own identification. FIN and PSH
+   * are only kept on the last segment, CWR only on the first one.
+   *
+   * \param route route
+   * \param packet the super-segment, with its TCP header
+   * \param ipHeader IPv4 header of the super-segment
+   * \param segmentSize the payload size of each segment
+   */
+  void SendSegments (Ptr<Ipv4Route> route,
+                     Ptr<Packet> packet,
+                     Ipv4Header const &ipHeader,
+                     uint16_t segmentSize);
+
   /**
    * \brief Forward a packet.
    * \param rtentry route
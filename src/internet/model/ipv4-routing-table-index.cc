@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/net-device.h"
+#include "ipv4-routing-table-index.h"
+#include "ipv4-routing-table-entry.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RoutingTableIndex");
+
+Ipv4RoutingTableIndex::Ipv4RoutingTableIndex ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+Ipv4RoutingTableIndex::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_slots.clear ();
+  m_masks.clear ();
+}
+
+void
+Ipv4RoutingTableIndex::Add (Ipv4RoutingTableEntry *entry, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << entry << metric);
+  Slot slot;
+  Ipv4Mask mask = entry->GetDestNetworkMask ();
+  slot.mask = mask.Get ();
+  slot.prefixLength = mask.GetPrefixLength ();
+  slot.network = entry->GetDest ().Get () & slot.mask;
+  slot.order = m_slots.size ();
+  slot.metric = metric;
+  slot.entry = entry;
+  m_slots.push_back (slot);
+}
+
+bool
+Ipv4RoutingTableIndex::SlotLess (const Slot &a, const Slot &b)
+{
+  if (a.prefixLength != b.prefixLength)
+    {
+      return a.prefixLength > b.prefixLength;
+    }
+  if (a.mask != b.mask)
+    {
+      return a.mask > b.mask;
+    }
+  if (a.network != b.network)
+    {
+      return a.network < b.network;
+    }
+  return a.order < b.order;
+}
+
+bool
+Ipv4RoutingTableIndex::SlotOrderLess (const Slot *a, const Slot *b)
+{
+  return a->order < b->order;
+}
+
+void
+Ipv4RoutingTableIndex::Build (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::sort (m_slots.begin (), m_slots.end (), &Ipv4RoutingTableIndex::SlotLess);
+  m_masks.clear ();
+  for (uint32_t i = 0; i < m_slots.size (); i++)
+    {
+      if (m_masks.empty () || m_masks.back ().mask != m_slots[i].mask)
+        {
+          MaskGroup group;
+          group.mask = m_slots[i].mask;
+          group.prefixLength = m_slots[i].prefixLength;
+          group.begin = i;
+          group.end = i;
+          m_masks.push_back (group);
+        }
+      m_masks.back ().end = i + 1;
+    }
+  NS_LOG_LOGIC ("Indexed " << m_slots.size () << " entries under " << m_masks.size () << " masks");
+}
+
+uint32_t
+Ipv4RoutingTableIndex::GetNMasks (void) const
+{
+  return m_masks.size ();
+}
+
+uint16_t
+Ipv4RoutingTableIndex::GetPrefixLength (uint32_t i) const
+{
+  NS_ASSERT (i < m_masks.size ());
+  return m_masks[i].prefixLength;
+}
+
+void
+Ipv4RoutingTableIndex::Lookup (Ipv4Address dest, uint32_t i, std::vector<Slot *> &matches)
+{
+  NS_ASSERT (i < m_masks.size ());
+  const MaskGroup &group = m_masks[i];
+  uint32_t network = dest.Get () & group.mask;
+  // binary search of the first slot of the group whose network is not lower
+  uint32_t first = group.begin;
+  uint32_t count = group.end - group.begin;
+  while (count > 0)
+    {
+      uint32_t step = count / 2;
+      if (m_slots[first + step].network < network)
+        {
+          first += step + 1;
+          count -= step + 1;
+        }
+      else
+        {
+          count = step;
+        }
+    }
+  for (uint32_t j = first; j < group.end && m_slots[j].network == network; j++)
+    {
+      matches.push_back (&m_slots[j]);
+    }
+}
+
+void
+Ipv4RoutingTableIndex::Lookup (Ipv4Address dest, std::vector<Slot *> &matches)
+{
+  uint32_t start = matches.size ();
+  uint32_t nGroups = 0;
+  for (uint32_t i = 0; i < m_masks.size (); i++)
+    {
+      uint32_t before = matches.size ();
+      Lookup (dest, i, matches);
+      if (matches.size () > before)
+        {
+          nGroups++;
+        }
+    }
+  if (nGroups > 1)
+    {
+      std::sort (matches.begin () + start, matches.end (), &Ipv4RoutingTableIndex::SlotOrderLess);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTING_TABLE_INDEX_H
+#define IPV4_ROUTING_TABLE_INDEX_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup internet
+ *
+ * \brief Longest prefix match index over a list of Ipv4RoutingTableEntry.
+ *
+ * The entries are kept in a single array sorted by network mask (longest
+ * prefix first), then by destination network, then by their position in
+ * the routing table.  The entries sharing a mask thus form a contiguous
+ * partition in which the entries matching a destination are found by a
+ * binary search, and the entries sharing both the mask and the destination
+ * network (i.e., an ECMP group) are adjacent and in routing table order.
+ * A lookup costs one binary search per distinct mask in use, which is a
+ * handful in practice, and the index takes memory proportional to the
+ * number of entries, whatever the address layout.
+ *
+ * The index does not own the entries.  It is meant to be rebuilt by its
+ * owner with Clear, Add and Build whenever the routing table changes.
+ * Each slot can also hold the Ipv4Route built for its entry, so that
+ * lookups return the same route object until the index is rebuilt.
+ */
+class Ipv4RoutingTableIndex
+{
+public:
+  /**
+   * \brief An indexed routing table entry.
+   */
+  struct Slot
+  {
+    uint32_t mask;                 //!< network mask of the entry
+    uint16_t prefixLength;         //!< prefix length of the mask
+    uint32_t network;              //!< destination network of the entry
+    uint32_t order;                //!< position of the entry in the routing table
+    uint32_t metric;               //!< metric of the entry
+    Ipv4RoutingTableEntry *entry;  //!< the entry
+    Ptr<Ipv4Route> route;          //!< cached route built for the entry, if any
+  };
+
+  Ipv4RoutingTableIndex ();
+
+  /**
+   * \brief Remove all the entries and the cached routes.
+   */
+  void Clear (void);
+
+  /**
+   * \brief Add an entry.
+   *
+   * Entries must be added in routing table order, and Build must be
+   * called once all the entries are added.
+   *
+   * \param entry the routing table entry
+   * \param metric the metric of the entry
+   */
+  void Add (Ipv4RoutingTableEntry *entry, uint32_t metric = 0);
+
+  /**
+   * \brief Sort the entries added since the last Clear.
+   */
+  void Build (void);
+
+  /**
+   * \return the number of distinct network masks in the index
+   */
+  uint32_t GetNMasks (void) const;
+
+  /**
+   * \param i the mask index, masks being sorted by decreasing prefix length
+   * \return the prefix length of the i-th mask, as given by Ipv4Mask::GetPrefixLength
+   */
+  uint16_t GetPrefixLength (uint32_t i) const;
+
+  /**
+   * \brief Append the slots of the i-th mask matching a destination.
+   *
+   * The slots are appended in routing table order.
+   *
+   * \param dest the destination address
+   * \param i the mask index
+   * \param matches the vector the matching slots are appended to
+   */
+  void Lookup (Ipv4Address dest, uint32_t i, std::vector<Slot *> &matches);
+
+  /**
+   * \brief Append the slots of all masks matching a destination.
+   *
+   * The slots are appended in routing table order.
+   *
+   * \param dest the destination address
+   * \param matches the vector the matching slots are appended to
+   */
+  void Lookup (Ipv4Address dest, std::vector<Slot *> &matches);
+
+private:
+  /**
+   * \brief The partition of the slots sharing a network mask.
+   */
+  struct MaskGroup
+  {
+    uint32_t mask;          //!< the network mask
+    uint16_t prefixLength;  //!< prefix length of the mask
+    uint32_t begin;         //!< index of the first slot
+    uint32_t end;           //!< index past the last slot
+  };
+
+  /**
+   * \brief Sort order of the slots.
+   * \param a the first slot
+   * \param b the second slot
+   * \return true if a must be placed before b
+   */
+  static bool SlotLess (const Slot &a, const Slot &b);
+
+  /**
+   * \brief Sort order of the slots by routing table position.
+   * \param a the first slot
+   * \param b the second slot
+   * \return true if a is before b in the routing table
+   */
+  static bool SlotOrderLess (const Slot *a, const Slot *b);
+
+  std::vector<Slot> m_slots;       //!< the sorted slots
+  std::vector<MaskGroup> m_masks;  //!< partitions of m_slots, by decreasing prefix length
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTING_TABLE_INDEX_H */
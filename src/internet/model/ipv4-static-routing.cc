@@ -54,7 +54,8 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_indexValid (false),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -73,6 +74,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_indexValid = false;
 }
 
 void 
@@ -87,6 +89,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_indexValid = false;
 }
 
 void 
@@ -144,6 +147,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_indexValid = false;
 }
 
 uint32_t 
@@ -224,8 +228,6 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION (this << dest << " " << oif);
   Ptr<Ipv4Route> rtentry = 0;
-  uint16_t longest_mask = 0;
-  uint32_t shortest_metric = 0xffffffff;
   /* when sending on local multicast, there have to be interface specified */
   if (dest.IsLocalMulticast ())
     {
@@ -239,53 +241,44 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
       return rtentry;
     }
 
-
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
-       i++) 
+  UpdateIndex ();
+  Ipv4RoutingTableIndex::Slot *best = 0;
+  // masks are visited by decreasing prefix length, so that the search
+  // stops at the first prefix length with a usable route
+  for (uint32_t i = 0; i < m_index.GetNMasks (); i++)
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
-      Ipv4Mask mask = (j)->GetDestNetworkMask ();
-      uint16_t masklen = mask.GetPrefixLength ();
-      Ipv4Address entry = (j)->GetDestNetwork ();
-      NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
-      if (mask.IsMatch (dest, entry)) 
+      if (best != 0 && m_index.GetPrefixLength (i) < best->prefixLength)
         {
-          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
+          break;
+        }
+      m_matches.clear ();
+      m_index.Lookup (dest, i, m_matches);
+      for (uint32_t k = 0; k < m_matches.size (); k++)
+        {
+          Ipv4RoutingTableIndex::Slot *slot = m_matches[k];
+          NS_LOG_LOGIC ("Found global network route " << slot->entry << ", mask length " << slot->prefixLength << ", metric " << slot->metric);
           if (oif != 0)
             {
-              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
+              if (oif != m_ipv4->GetNetDevice (slot->entry->GetInterface ()))
                 {
                   NS_LOG_LOGIC ("Not on requested interface, skipping");
                   continue;
                 }
             }
-          if (masklen < longest_mask) // Not interested if got shorter mask
-            {
-              NS_LOG_LOGIC ("Previous match longer, skipping");
-              continue;
-            }
-          if (masklen > longest_mask) // Reset metric if longer masklen
-            {
-              shortest_metric = 0xffffffff;
-            }
-          longest_mask = masklen;
-          if (metric > shortest_metric)
+          // on equal metrics, the route added last wins
+          if (best != 0 && (slot->metric > best->metric
+                            || (slot->metric == best->metric && slot->order < best->order)))
             {
               NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
               continue;
             }
-          shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+          best = slot;
         }
     }
+  if (best != 0)
+    {
+      rtentry = GetSlotRoute (best);
+    }
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Matching route via " << rtentry->GetGateway () << " at the end");
@@ -445,6 +438,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
         {
           delete j->first;
           m_networkRoutes.erase (j);
+          m_indexValid = false;
           return;
         }
       tmp++;
@@ -593,6 +587,8 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_index.Clear ();
+  m_indexValid = false;
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -633,6 +629,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_indexValid = false;
         }
       else
         {
@@ -645,6 +642,8 @@ void
 Ipv4StaticRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << " " << address.GetLocal ());
+  // the cached routes depend on the interface addresses
+  m_indexValid = false;
   if (!m_ipv4->IsUp (interface))
     {
       return;
@@ -663,6 +662,8 @@ void
 Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << " " << address.GetLocal ());
+  // the cached routes depend on the interface addresses
+  m_indexValid = false;
   if (!m_ipv4->IsUp (interface))
     {
       return;
@@ -680,6 +681,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_indexValid = false;
         }
       else
         {
@@ -752,6 +754,40 @@ Ipv4StaticRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
         }
     }
 }
+void
+Ipv4StaticRouting::UpdateIndex (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_indexValid)
+    {
+      return;
+    }
+  m_index.Clear ();
+  for (NetworkRoutesCI i = m_networkRoutes.begin (); i != m_networkRoutes.end (); i++)
+    {
+      m_index.Add (i->first, i->second);
+    }
+  m_index.Build ();
+  m_indexValid = true;
+}
+
+Ptr<Ipv4Route>
+Ipv4StaticRouting::GetSlotRoute (Ipv4RoutingTableIndex::Slot *slot)
+{
+  if (slot->route == 0)
+    {
+      Ipv4RoutingTableEntry* route = slot->entry;
+      uint32_t interfaceIdx = route->GetInterface ();
+      Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetSource (SourceAddressSelection (interfaceIdx, route->GetDest ()));
+      rtentry->SetGateway (route->GetGateway ());
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+      slot->route = rtentry;
+    }
+  return slot->route;
+}
+
 Ipv4Address
 Ipv4StaticRouting::SourceAddressSelection (uint32_t interfaceIdx, Ipv4Address dest)
 {
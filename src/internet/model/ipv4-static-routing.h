@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ipv4-routing-table-index.h"
 
 namespace ns3 {
 
@@ -425,11 +426,39 @@ private:
    */
   Ipv4Address SourceAddressSelection (uint32_t interface, Ipv4Address dest);
 
+  /**
+   * \brief Rebuild the index of the forwarding table if the table changed
+   * since it was last built.
+   */
+  void UpdateIndex (void);
+
+  /**
+   * \brief Get the route of an indexed entry, building it on first use.
+   * \param slot the indexed entry
+   * \return the route to the destination of the entry
+   */
+  Ptr<Ipv4Route> GetSlotRoute (Ipv4RoutingTableIndex::Slot *slot);
+
   /**
    * \brief the forwarding table for network.
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief longest prefix match index of m_networkRoutes.
+   */
+  Ipv4RoutingTableIndex m_index;
+
+  /**
+   * \brief whether m_index and its cached routes are up to date.
+   */
+  bool m_indexValid;
+
+  /**
+   * \brief scratch vector of the routes found by a lookup.
+   */
+  std::vector<Ipv4RoutingTableIndex::Slot *> m_matches;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -18,6 +18,7 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <algorithm>
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
@@ -29,7 +30,8 @@ NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -40,31 +42,140 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_infos.clear ();
+  m_ports.clear ();
+  m_tuples.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+bool Ipv6EndPointDemux::Tuple::operator== (const Tuple &other) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t Ipv6EndPointDemux::TupleHash::operator() (const Tuple &tuple) const
+{
+  Ipv6AddressHash hash;
+  size_t h = hash (tuple.localAddress);
+  h = h * 31 + hash (tuple.peerAddress);
+  h = h * 31 + ((static_cast<uint32_t> (tuple.localPort) << 16) | tuple.peerPort);
+  return h;
+}
+
+Ipv6EndPointDemux::Tuple Ipv6EndPointDemux::GetTuple (Ipv6EndPoint *endPoint)
+{
+  Tuple tuple;
+  tuple.localAddress = endPoint->GetLocalAddress ();
+  tuple.localPort = endPoint->GetLocalPort ();
+  tuple.peerAddress = endPoint->GetPeerAddress ();
+  tuple.peerPort = endPoint->GetPeerPort ();
+  return tuple;
+}
+
+bool Ipv6EndPointDemux::SequenceLess (const EndPointInfo *a, const EndPointInfo *b)
+{
+  return a->sequence < b->sequence;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPointInfo &info = m_infos[endPoint];
+  info.endPoint = endPoint;
+  info.sequence = m_sequence++;
+  info.all = m_endPoints.insert (m_endPoints.end (), endPoint);
+  AddToIndexes (&info);
+  endPoint->m_demux = this;
+}
+
+void Ipv6EndPointDemux::AddToIndexes (EndPointInfo *info)
+{
+  NS_LOG_FUNCTION (this << info->endPoint);
+  info->port = info->endPoint->GetLocalPort ();
+  Bucket &port = m_ports[info->port];
+  if (port.empty ())
     {
-      if ((*i)->GetLocalPort  () == port)
+      SetEphemeralPortUsed (info->port, true);
+    }
+  /* keep the bucket in allocation order; new end points go last */
+  Bucket::iterator pos = port.end ();
+  while (pos != port.begin ())
+    {
+      Bucket::iterator prev = pos;
+      --prev;
+      if ((*prev)->sequence < info->sequence)
         {
-          return true;
+          break;
         }
+      pos = prev;
     }
-  return false;
+  info->inPort = port.insert (pos, info);
+
+  info->tuple = GetTuple (info->endPoint);
+  Bucket &tuple = m_tuples[info->tuple];
+  info->inTuple = tuple.insert (tuple.end (), info);
+}
+
+void Ipv6EndPointDemux::RemoveFromIndexes (EndPointInfo *info)
+{
+  NS_LOG_FUNCTION (this << info->endPoint);
+  std::map<uint16_t, Bucket>::iterator port = m_ports.find (info->port);
+  NS_ASSERT (port != m_ports.end ());
+  port->second.erase (info->inPort);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+      SetEphemeralPortUsed (info->port, false);
+    }
+
+  sgi::hash_map<Tuple, Bucket, TupleHash>::iterator tuple = m_tuples.find (info->tuple);
+  NS_ASSERT (tuple != m_tuples.end ());
+  tuple->second.erase (info->inTuple);
+  if (tuple->second.empty ())
+    {
+      m_tuples.erase (tuple);
+    }
+}
+
+void Ipv6EndPointDemux::Reindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::map<Ipv6EndPoint *, EndPointInfo>::iterator i = m_infos.find (endPoint);
+  NS_ASSERT (i != m_infos.end ());
+  RemoveFromIndexes (&i->second);
+  AddToIndexes (&i->second);
+}
+
+void Ipv6EndPointDemux::GetTupleEndPoints (const Tuple &tuple, std::vector<EndPointInfo *> &infos)
+{
+  sgi::hash_map<Tuple, Bucket, TupleHash>::iterator i = m_tuples.find (tuple);
+  if (i != m_tuples.end ())
+    {
+      infos.insert (infos.end (), i->second.begin (), i->second.end ());
+    }
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<uint16_t, Bucket>::iterator bucket = m_ports.find (port);
+  if (bucket == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      return false;
+    }
+  for (Bucket::iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
+    {
+      if ((*i)->endPoint->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -82,7 +193,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -97,7 +208,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -118,7 +229,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -127,21 +238,20 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  Tuple tuple;
+  tuple.localAddress = localAddress;
+  tuple.localPort = localPort;
+  tuple.peerAddress = peerAddress;
+  tuple.peerPort = peerPort;
+  if (m_tuples.find (tuple) != m_tuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -151,14 +261,14 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<Ipv6EndPoint *, EndPointInfo>::iterator i = m_infos.find (endPoint);
+  if (i != m_infos.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      RemoveFromIndexes (&i->second);
+      m_endPoints.erase (i->second.all);
+      m_infos.erase (i);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -179,9 +289,45 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  /* A matching end point has the destination or wildcard local address,
+     and the source or wildcard peer address and port: only those
+     four-tuples need to be looked at. */
+  Ipv6Address localAddresses[2] = { daddr, Ipv6Address::GetAny () };
+  Ipv6Address peerAddresses[2] = { saddr, Ipv6Address::GetAny () };
+  uint16_t peerPorts[2] = { sport, 0 };
+  // the scratch vectors keep their storage from one lookup to the next
+  std::vector<Tuple> &tuples = m_lookupTuples;
+  tuples.clear ();
+  for (uint32_t l = 0; l < 2; l++)
     {
-      Ipv6EndPoint* endP = *i;
+      for (uint32_t a = 0; a < 2; a++)
+        {
+          for (uint32_t p = 0; p < 2; p++)
+            {
+              Tuple tuple;
+              tuple.localAddress = localAddresses[l];
+              tuple.localPort = dport;
+              tuple.peerAddress = peerAddresses[a];
+              tuple.peerPort = peerPorts[p];
+              if (std::find (tuples.begin (), tuples.end (), tuple) == tuples.end ())
+                {
+                  tuples.push_back (tuple);
+                }
+            }
+        }
+    }
+  std::vector<EndPointInfo *> &candidates = m_lookupCandidates;
+  candidates.clear ();
+  for (std::vector<Tuple>::const_iterator t = tuples.begin (); t != tuples.end (); t++)
+    {
+      GetTupleEndPoints (*t, candidates);
+    }
+  std::sort (candidates.begin (), candidates.end (), &Ipv6EndPointDemux::SequenceLess);
+
+  for (std::vector<EndPointInfo *>::const_iterator i = candidates.begin (); i != candidates.end (); i++)
+    {
+      Ipv6EndPoint* endP = (*i)->endPoint;
 
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
@@ -296,35 +442,36 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<uint16_t, Bucket>::iterator bucket = m_ports.find (dport);
+  if (bucket == m_ports.end ())
+    {
+      return 0;
+    }
+  for (Bucket::iterator j = bucket->second.begin (); j != bucket->second.end (); j++)
     {
+      Ipv6EndPoint *i = (*j)->endPoint;
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
+      if (i->GetLocalAddress () == dst && i->GetPeerPort () == sport
+          && i->GetPeerAddress () == src)
         {
           /* this is an exact match. */
-          return *i;
+          return i;
         }
 
-      if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
+      if (i->GetLocalAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if ((*i)->GetPeerAddress () == Ipv6Address::GetAny ())
+      if (i->GetPeerAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
       if (tmp < genericity)
         {
-          generic = (*i);
+          generic = i;
           genericity = tmp;
         }
     }
@@ -334,25 +481,65 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
 uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do
+  uint32_t range = m_portLast - m_portFirst + 1;
+  uint16_t port = m_ephemeral + 1;
+  uint32_t start = 0;
+  if (port >= m_portFirst && port <= m_portLast)
     {
-      if (count-- < 0)
+      start = port - m_portFirst;
+    }
+  /* look for the first port not in use, starting right after the last
+     allocated one and wrapping around the ephemeral range once */
+  for (uint32_t count = 0; count < range; )
+    {
+      uint32_t offset = (start + count) % range;
+      uint32_t word = offset / 32;
+      if (m_ephemeralPorts.empty ())
+        {
+          port = m_portFirst + offset;
+          m_ephemeral = port;
+          return port;
+        }
+      if (m_ephemeralPorts[word] == 0xffffffff)
         {
-          return 0;
+          /* skip to the next word */
+          count += 32 - offset % 32;
+          continue;
         }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
+      if ((m_ephemeralPorts[word] & (1U << (offset % 32))) == 0)
         {
-          port = m_portFirst;
+          port = m_portFirst + offset;
+          m_ephemeral = port;
+          return port;
         }
+      count++;
     }
-  while (LookupPortLocal (port));
-  m_ephemeral = port;
-  return port;
+  return 0;
 }
 
+void Ipv6EndPointDemux::SetEphemeralPortUsed (uint16_t port, bool used)
+{
+  NS_LOG_FUNCTION (this << port << used);
+  if (port < m_portFirst || port > m_portLast)
+    {
+      return;
+    }
+  uint32_t offset = port - m_portFirst;
+  if (m_ephemeralPorts.empty ())
+    {
+      m_ephemeralPorts.resize ((m_portLast - m_portFirst) / 32 + 1, 0);
+    }
+  if (used)
+    {
+      m_ephemeralPorts[offset / 32] |= (1U << (offset % 32));
+    }
+  else
+    {
+      m_ephemeralPorts[offset / 32] &= ~(1U << (offset % 32));
+    }
+}
+
+
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
 {
   return m_endPoints;
@@ -23,7 +23,10 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv6-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv6-interface.h"
 
 namespace ns3 {
@@ -33,6 +36,11 @@ class Ipv6EndPoint;
 /**
  * \class Ipv6EndPointDemux
  * \brief Demultiplexor for end points.
+ *
+ * The end points are indexed by local port and by their full four-tuple
+ * (wildcards included), so that a lookup only visits the end points which
+ * can match the packet.  A bitmap of the ephemeral ports in use speeds up
+ * their allocation.
  */
 class Ipv6EndPointDemux
 {
@@ -146,6 +154,116 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The four-tuple an endpoint is indexed with.
+   */
+  struct Tuple
+  {
+    Ipv6Address localAddress; //!< local address
+    uint16_t localPort;       //!< local port
+    Ipv6Address peerAddress;  //!< peer address
+    uint16_t peerPort;        //!< peer port
+
+    /**
+     * \brief Equality operator.
+     * \param other the tuple to compare to
+     * \return true if the tuples are equal
+     */
+    bool operator== (const Tuple &other) const;
+  };
+
+  /**
+   * \brief Hash function class for the four-tuples.
+   */
+  struct TupleHash
+  {
+    /**
+     * \brief Hash a four-tuple.
+     * \param tuple the four-tuple
+     * \return the hash value
+     */
+    size_t operator() (const Tuple &tuple) const;
+  };
+
+  struct EndPointInfo;
+
+  /**
+   * \brief Container of the indexed endpoints sharing a key.
+   */
+  typedef std::list<EndPointInfo *> Bucket;
+
+  /**
+   * \brief Where an endpoint is stored in the indexes.
+   */
+  struct EndPointInfo
+  {
+    Ipv6EndPoint *endPoint;   //!< the endpoint
+    uint64_t sequence;        //!< allocation order of the endpoint
+    EndPointsI all;           //!< position in m_endPoints
+    uint16_t port;            //!< local port the endpoint is indexed with
+    Bucket::iterator inPort;  //!< position in the m_ports bucket
+    Tuple tuple;              //!< four-tuple the endpoint is indexed with
+    Bucket::iterator inTuple; //!< position in the m_tuples bucket
+  };
+
+  /**
+   * \brief Build the four-tuple of an endpoint.
+   * \param endPoint the endpoint
+   * \return the four-tuple
+   */
+  static Tuple GetTuple (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Insert a new endpoint in the list and the indexes.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the port and four-tuple indexes.
+   * \param info the endpoint information
+   */
+  void AddToIndexes (EndPointInfo *info);
+
+  /**
+   * \brief Remove an endpoint from the port and four-tuple indexes.
+   * \param info the endpoint information
+   */
+  void RemoveFromIndexes (EndPointInfo *info);
+
+  /**
+   * \brief Update the indexes after the addresses of an endpoint changed.
+   *
+   * Called by Ipv6EndPoint.
+   *
+   * \param endPoint the endpoint
+   */
+  void Reindex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Append the endpoints indexed with a four-tuple.
+   * \param tuple the four-tuple
+   * \param infos the vector the endpoints are appended to
+   */
+  void GetTupleEndPoints (const Tuple &tuple, std::vector<EndPointInfo *> &infos);
+
+  /**
+   * \brief Sort order of the endpoints by allocation.
+   * \param a the first endpoint
+   * \param b the second endpoint
+   * \return true if a was allocated before b
+   */
+  static bool SequenceLess (const EndPointInfo *a, const EndPointInfo *b);
+
+  /**
+   * \brief Mark an ephemeral port as used or unused.
+   * \param port the port, ignored if not in the ephemeral range
+   * \param used true if the port is used
+   */
+  void SetEphemeralPortUsed (uint16_t port, bool used);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -171,6 +289,41 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The index information of each endpoint.
+   */
+  std::map<Ipv6EndPoint *, EndPointInfo> m_infos;
+
+  /**
+   * \brief The endpoints by local port, in allocation order.
+   */
+  std::map<uint16_t, Bucket> m_ports;
+
+  /**
+   * \brief The endpoints by four-tuple.
+   */
+  sgi::hash_map<Tuple, Bucket, TupleHash> m_tuples;
+
+  /**
+   * \brief Bitmap of the ephemeral ports in use, allocated on first use.
+   */
+  std::vector<uint32_t> m_ephemeralPorts;
+
+  /**
+   * \brief The allocation order of the next endpoint.
+   */
+  uint64_t m_sequence;
+
+  /**
+   * \brief Scratch vector of the four-tuples probed by Lookup.
+   */
+  std::vector<Tuple> m_lookupTuples;
+
+  /**
+   * \brief Scratch vector of the endpoints found by Lookup.
+   */
+  std::vector<EndPointInfo *> m_lookupCandidates;
 };
 
 } /* namespace ns3 */
@@ -34,6 +34,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \brief A representation of an internet IPv6 endpoint/connection
@@ -254,6 +255,16 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demux the EndPoint is registered in (if any).
+   *
+   * The demux indexes its end points by their addresses and ports, so it
+   * is notified when they change.
+   */
+  Ipv6EndPointDemux *m_demux;
+
+  friend class Ipv6EndPointDemux;
 };
 
 } /* namespace ns3 */
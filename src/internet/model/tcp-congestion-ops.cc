@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "tcp-congestion-ops.h"
+#include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpCongestionOps");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpSocketState);
+
+const char* const
+TcpSocketState::TcpCongStateName[TcpSocketState::CA_LAST_STATE] = { "CA_OPEN", "CA_DISORDER",
+                                                                    "CA_CWR", "CA_RECOVERY",
+                                                                    "CA_LOSS" };
+
+TypeId
+TcpSocketState::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpSocketState")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpSocketState> ()
+    .AddTraceSource ("CongestionWindow",
+                     "The TCP connection's congestion window",
+                     MakeTraceSourceAccessor (&TcpSocketState::m_cWnd),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("SlowStartThreshold",
+                     "TCP slow start threshold (bytes)",
+                     MakeTraceSourceAccessor (&TcpSocketState::m_ssThresh),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("CongState",
+                     "TCP congestion control state",
+                     MakeTraceSourceAccessor (&TcpSocketState::m_congState),
+                     "ns3::TcpCongStatesTracedValueCallback")
+  ;
+  return tid;
+}
+
+TcpSocketState::TcpSocketState ()
+  : m_cWnd (0),
+    m_ssThresh (0),
+    m_initialCWnd (0),
+    m_initialSsThresh (0),
+    m_segmentSize (0),
+    m_congState (CA_OPEN),
+    m_lastAckedSeq (0),
+    m_highTxMark (0),
+    m_ecnEcho (false)
+{
+}
+
+TcpSocketState::TcpSocketState (const TcpSocketState &other)
+  : Object (other),
+    m_cWnd (other.m_cWnd),
+    m_ssThresh (other.m_ssThresh),
+    m_initialCWnd (other.m_initialCWnd),
+    m_initialSsThresh (other.m_initialSsThresh),
+    m_segmentSize (other.m_segmentSize),
+    m_congState (other.m_congState),
+    m_lastAckedSeq (other.m_lastAckedSeq),
+    m_highTxMark (other.m_highTxMark),
+    m_ecnEcho (false)
+{
+}
+
+uint32_t
+TcpSocketState::GetCwndInSegments (void) const
+{
+  return m_cWnd.Get () / m_segmentSize;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (TcpCongestionOps);
+
+TypeId
+TcpCongestionOps::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpCongestionOps")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpCongestionOps> ()
+  ;
+  return tid;
+}
+
+TcpCongestionOps::TcpCongestionOps ()
+  : Object ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpCongestionOps::TcpCongestionOps (const TcpCongestionOps &other)
+  : Object (other)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpCongestionOps::~TcpCongestionOps ()
+{
+}
+
+std::string
+TcpCongestionOps::GetName (void) const
+{
+  return "TcpCongestionOps";
+}
+
+uint32_t
+TcpCongestionOps::GetSsThresh (Ptr<const TcpSocketState> tcb,
+                               uint32_t bytesInFlight)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+  return std::max (2 * tcb->m_segmentSize, bytesInFlight / 2);
+}
+
+void
+TcpCongestionOps::IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked);
+  if (tcb->m_cWnd < tcb->m_ssThresh)
+    { // Slow start mode, add one segSize to cWnd (RFC2001, sec.1)
+      tcb->m_cWnd += tcb->m_segmentSize;
+      NS_LOG_INFO ("In SlowStart, updated to cwnd " << tcb->m_cWnd << " ssthresh " << tcb->m_ssThresh);
+    }
+  else
+    { // Congestion avoidance mode, increase by (segSize*segSize)/cwnd. (RFC2581, sec.3.1)
+      // To increase cwnd for one segSize per RTT, it should be (ackBytes*segSize)/cwnd
+      double adder = static_cast<double> (tcb->m_segmentSize * tcb->m_segmentSize) / tcb->m_cWnd.Get ();
+      adder = std::max (1.0, adder);
+      tcb->m_cWnd += static_cast<uint32_t> (adder);
+      NS_LOG_INFO ("In CongAvoid, updated to cwnd " << tcb->m_cWnd << " ssthresh " << tcb->m_ssThresh);
+    }
+}
+
+void
+TcpCongestionOps::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                             const Time &rtt)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked << rtt);
+}
+
+void
+TcpCongestionOps::CongestionStateSet (Ptr<TcpSocketState> tcb,
+                                      const TcpSocketState::TcpCongState_t newState)
+{
+  NS_LOG_FUNCTION (this << tcb << newState);
+}
+
+bool
+TcpCongestionOps::HasPerSegmentEcnEcho (void) const
+{
+  return false;
+}
+
+Ptr<TcpCongestionOps>
+TcpCongestionOps::Fork (void)
+{
+  return CopyObject<TcpCongestionOps> (this);
+}
+
+} // namespace ns3
@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_CONGESTION_OPS_H
+#define TCP_CONGESTION_OPS_H
+
+#include <string>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Congestion control state of a TCP connection
+ *
+ * The variables shared by a TcpSocketBase and its TcpCongestionOps: the
+ * windows, which both may change, and a few facts about the ACK being
+ * processed, which the socket updates before calling the congestion ops.
+ */
+class TcpSocketState : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpSocketState ();
+
+  /**
+   * \brief Copy constructor
+   * \param other the object to copy
+   */
+  TcpSocketState (const TcpSocketState &other);
+
+  /**
+   * \brief Congestion control states, as the ones of the Linux kernel
+   */
+  typedef enum
+  {
+    CA_OPEN = 0,  /**< No loss nor ECN-Echo, the window grows            */
+    CA_DISORDER,  /**< Duplicate ACKs or SACKs received, no loss deemed  */
+    CA_CWR,       /**< The window was reduced on an ECN-Echo             */
+    CA_RECOVERY,  /**< Fast retransmit and fast recovery of a loss       */
+    CA_LOSS,      /**< Retransmission timeout, back to slow start        */
+    CA_LAST_STATE /**< Last state, used only in debug messages           */
+  } TcpCongState_t;
+
+  /**
+   * \brief Literal names of the congestion control states for use in log messages
+   */
+  static const char* const TcpCongStateName[TcpSocketState::CA_LAST_STATE];
+
+  /**
+   * \brief Get the congestion window in segments
+   * \return the congestion window divided by the segment size
+   */
+  uint32_t GetCwndInSegments (void) const;
+
+  // Congestion control
+  TracedValue<uint32_t> m_cWnd;            //!< Congestion window
+  TracedValue<uint32_t> m_ssThresh;        //!< Slow start threshold
+  uint32_t              m_initialCWnd;     //!< Initial cWnd value, in segments
+  uint32_t              m_initialSsThresh; //!< Initial Slow Start Threshold value
+  uint32_t              m_segmentSize;     //!< Segment size
+
+  TracedValue<TcpCongState_t> m_congState; //!< Congestion control state
+
+  // The ACK being processed
+  SequenceNumber32 m_lastAckedSeq; //!< Its ACK number
+  SequenceNumber32 m_highTxMark;   //!< Highest seqno sent when it was received
+  bool             m_ecnEcho;      //!< It carries the ECN-Echo flag
+};
+
+/**
+ * \ingroup tcp
+ * TracedValue Callback signature for TcpCongState_t
+ *
+ * \param [in] oldValue original value of the traced variable
+ * \param [in] newValue new value of the traced variable
+ */
+typedef void (* TcpCongStatesTracedValueCallback)(const TcpSocketState::TcpCongState_t oldValue,
+                                                  const TcpSocketState::TcpCongState_t newValue);
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Congestion control algorithm of a TCP socket
+ *
+ * The congestion ops hold the state and the window update rules of a
+ * congestion control algorithm, while the socket keeps the loss recovery,
+ * the timers and the ECN signalling. They are called by the socket:
+ *
+ * - PktsAcked, on every ACK that acknowledges new data;
+ * - IncreaseWindow, on the same ACKs when the window may grow, that is
+ *   outside of the loss recovery and of the reduction on an ECN-Echo;
+ * - GetSsThresh, on a loss or an ECN-Echo, to get the new slow start
+ *   threshold, the window being then set by the socket;
+ * - CongestionStateSet, before the socket changes its congestion state.
+ *
+ * This class implements the window update of \RFC{5681} (i.e., Reno),
+ * and is the base of the other algorithms. Each socket owns its
+ * instance, which is copied with Fork when a listening socket accepts
+ * a connection. The variants built on TcpCongestionOps are used with
+ * TcpNewReno, see TcpSocketBase::SetCongestionControlAlgorithm, or by
+ * setting the ns3::TcpL4Protocol::SocketType attribute to their TypeId.
+ */
+class TcpCongestionOps : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpCongestionOps ();
+
+  /**
+   * \brief Copy constructor
+   * \param other the object to copy
+   */
+  TcpCongestionOps (const TcpCongestionOps &other);
+
+  virtual ~TcpCongestionOps ();
+
+  /**
+   * \brief Get the name of the congestion control algorithm
+   * \return A string identifying the name
+   */
+  virtual std::string GetName (void) const;
+
+  /**
+   * \brief Get the slow start threshold after a loss or an ECN-Echo
+   *
+   * The default is half of the data in flight, and at least two segments
+   * (\RFC{5681}, eq. 4).
+   *
+   * \param tcb the congestion control state
+   * \param bytesInFlight the amount of data in flight
+   * \return the new slow start threshold
+   */
+  virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
+                                uint32_t bytesInFlight);
+
+  /**
+   * \brief Increase the congestion window on an ACK
+   *
+   * The default adds one segment per ACK in slow start, and about one
+   * segment per window in congestion avoidance (\RFC{5681}, sec. 3.1),
+   * whatever the number of segments acknowledged.
+   *
+   * \param tcb the congestion control state
+   * \param segmentsAcked the number of segments acknowledged
+   */
+  virtual void IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
+
+  /**
+   * \brief Get information on the acknowledged segments
+   *
+   * The default does nothing.
+   *
+   * \param tcb the congestion control state
+   * \param segmentsAcked the number of segments acknowledged
+   * \param rtt the current estimate of the round trip time
+   */
+  virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                          const Time &rtt);
+
+  /**
+   * \brief Be notified of a change of the congestion state
+   *
+   * Called before tcb->m_congState is updated. The default does nothing.
+   *
+   * \param tcb the congestion control state
+   * \param newState the new congestion state
+   */
+  virtual void CongestionStateSet (Ptr<TcpSocketState> tcb,
+                                   const TcpSocketState::TcpCongState_t newState);
+
+  /**
+   * \brief Whether the receiver echoes the CE mark of every segment
+   *
+   * With \RFC{3168} ECN, which is the default, the receiver sets the
+   * ECN-Echo flag from the first CE marked segment until the sender
+   * signals the window reduction with CWR. An algorithm that needs to
+   * know the fraction of marked segments (e.g., DCTCP) returns true to
+   * have each ACK echo the CE mark of the segments it acknowledges.
+   *
+   * \return true if the CE mark of each segment is echoed
+   */
+  virtual bool HasPerSegmentEcnEcho (void) const;
+
+  /**
+   * \brief Copy the congestion control algorithm across sockets
+   *
+   * \return a pointer to a copy of this object
+   */
+  virtual Ptr<TcpCongestionOps> Fork (void);
+};
+
+} // namespace ns3
+
+#endif /* TCP_CONGESTION_OPS_H */
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "tcp-cubic.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpCubic");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpCubic);
+
+TypeId
+TcpCubic::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpCubic")
+    .SetParent<TcpCongestionOps> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpCubic> ()
+    .AddAttribute ("FastConvergence", "Enable or disable fast convergence",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TcpCubic::m_fastConvergence),
+                   MakeBooleanChecker ())
+    .AddAttribute ("TcpFriendliness", "Enable or disable the TCP friendly region",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TcpCubic::m_tcpFriendliness),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Beta", "Multiplicative decrease factor",
+                   DoubleValue (0.7),
+                   MakeDoubleAccessor (&TcpCubic::m_beta),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("C", "Scaling constant of the cubic function",
+                   DoubleValue (0.4),
+                   MakeDoubleAccessor (&TcpCubic::m_c),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+TcpCubic::TcpCubic ()
+  : TcpCongestionOps (),
+    m_fastConvergence (true),
+    m_tcpFriendliness (true),
+    m_beta (0.7),
+    m_c (0.4),
+    m_lastMaxCwnd (0),
+    m_originPoint (0),
+    m_k (0),
+    m_tcpCwnd (0),
+    m_epochStart (Time::Min ()),
+    m_delayMin (Time (0)),
+    m_cWndCnt (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpCubic::TcpCubic (const TcpCubic &sock)
+  : TcpCongestionOps (sock),
+    m_fastConvergence (sock.m_fastConvergence),
+    m_tcpFriendliness (sock.m_tcpFriendliness),
+    m_beta (sock.m_beta),
+    m_c (sock.m_c),
+    m_lastMaxCwnd (sock.m_lastMaxCwnd),
+    m_originPoint (sock.m_originPoint),
+    m_k (sock.m_k),
+    m_tcpCwnd (sock.m_tcpCwnd),
+    m_epochStart (sock.m_epochStart),
+    m_delayMin (sock.m_delayMin),
+    m_cWndCnt (sock.m_cWndCnt)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpCubic::~TcpCubic ()
+{
+}
+
+std::string
+TcpCubic::GetName (void) const
+{
+  return "TcpCubic";
+}
+
+void
+TcpCubic::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lastMaxCwnd = 0;
+  m_originPoint = 0;
+  m_k = 0;
+  m_tcpCwnd = 0;
+  m_epochStart = Time::Min ();
+  m_delayMin = Time (0);
+  m_cWndCnt = 0;
+}
+
+uint32_t
+TcpCubic::Update (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked);
+  double cWnd = tcb->GetCwndInSegments ();
+  Time now = Simulator::Now ();
+
+  if (m_epochStart == Time::Min ())
+    { // First ACK in congestion avoidance since the last reduction
+      m_epochStart = now;
+      if (cWnd < m_lastMaxCwnd)
+        {
+          m_k = std::pow ((m_lastMaxCwnd - cWnd) / m_c, 1.0 / 3.0);
+          m_originPoint = m_lastMaxCwnd;
+        }
+      else
+        {
+          m_k = 0;
+          m_originPoint = cWnd;
+        }
+      m_tcpCwnd = cWnd;
+      NS_LOG_INFO ("New epoch, K " << m_k << " origin point " << m_originPoint);
+    }
+
+  // Target of the window one minimum RTT ahead (RFC 8312, sec. 4.1)
+  double t = (now - m_epochStart + m_delayMin).GetSeconds ();
+  double target = m_originPoint + m_c * std::pow (t - m_k, 3.0);
+  double cnt;
+  if (target > cWnd)
+    {
+      cnt = cWnd / (target - cWnd);
+    }
+  else
+    { // Plateau: grow very slowly
+      cnt = 100 * cWnd;
+    }
+  if (m_lastMaxCwnd == 0 && cnt > 20)
+    { // No loss seen yet: grow at least by 5% per RTT
+      cnt = 20;
+    }
+
+  if (m_tcpFriendliness)
+    { // Window of Reno with the same average throughput (RFC 8312, sec. 4.2)
+      m_tcpCwnd += 3 * (1 - m_beta) / (1 + m_beta) * segmentsAcked / cWnd;
+      if (m_tcpCwnd > cWnd)
+        {
+          cnt = std::min (cnt, cWnd / (m_tcpCwnd - cWnd));
+        }
+    }
+
+  return std::max (static_cast<uint32_t> (cnt), 2U);
+}
+
+void
+TcpCubic::IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked);
+  if (tcb->m_cWnd < tcb->m_ssThresh)
+    { // Slow start: one segment per acknowledged segment, up to ssthresh
+      uint32_t segments = std::min (segmentsAcked,
+                                    (tcb->m_ssThresh.Get () - tcb->m_cWnd.Get () + tcb->m_segmentSize - 1)
+                                    / tcb->m_segmentSize);
+      tcb->m_cWnd += segments * tcb->m_segmentSize;
+      segmentsAcked -= segments;
+      NS_LOG_INFO ("In SlowStart, updated to cwnd " << tcb->m_cWnd << " ssthresh " << tcb->m_ssThresh);
+    }
+  if (segmentsAcked == 0)
+    {
+      return;
+    }
+
+  // Congestion avoidance: one segment every cnt acknowledged segments
+  uint32_t cnt = Update (tcb, segmentsAcked);
+  if (m_cWndCnt >= cnt)
+    {
+      m_cWndCnt = 0;
+      tcb->m_cWnd += tcb->m_segmentSize;
+    }
+  m_cWndCnt += segmentsAcked;
+  if (m_cWndCnt >= cnt)
+    {
+      uint32_t delta = m_cWndCnt / cnt;
+      m_cWndCnt -= delta * cnt;
+      tcb->m_cWnd += delta * tcb->m_segmentSize;
+    }
+  NS_LOG_INFO ("In CongAvoid, cnt " << cnt << " updated to cwnd " << tcb->m_cWnd);
+}
+
+uint32_t
+TcpCubic::GetSsThresh (Ptr<const TcpSocketState> tcb, uint32_t bytesInFlight)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+  double cWnd = tcb->GetCwndInSegments ();
+  m_epochStart = Time::Min ();
+  if (cWnd < m_lastMaxCwnd && m_fastConvergence)
+    { // Release some bandwidth to the new flows (RFC 8312, sec. 4.6)
+      m_lastMaxCwnd = cWnd * (1 + m_beta) / 2;
+    }
+  else
+    {
+      m_lastMaxCwnd = cWnd;
+    }
+  NS_LOG_INFO ("Window reduction, W_max " << m_lastMaxCwnd);
+  return std::max (static_cast<uint32_t> (tcb->m_cWnd.Get () * m_beta),
+                   2 * tcb->m_segmentSize);
+}
+
+void
+TcpCubic::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                     const Time &rtt)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked << rtt);
+  if (!rtt.IsZero () && (m_delayMin.IsZero () || rtt < m_delayMin))
+    {
+      m_delayMin = rtt;
+    }
+}
+
+void
+TcpCubic::CongestionStateSet (Ptr<TcpSocketState> tcb,
+                              const TcpSocketState::TcpCongState_t newState)
+{
+  NS_LOG_FUNCTION (this << tcb << newState);
+  if (newState == TcpSocketState::CA_LOSS)
+    { // After a timeout, start over as a new connection
+      Reset ();
+    }
+}
+
+Ptr<TcpCongestionOps>
+TcpCubic::Fork (void)
+{
+  return CopyObject<TcpCubic> (this);
+}
+
+} // namespace ns3
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_CUBIC_H
+#define TCP_CUBIC_H
+
+#include "tcp-congestion-ops.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief The CUBIC congestion control algorithm
+ *
+ * CUBIC (\RFC{8312}) grows the congestion window as a cubic function of
+ * the time elapsed since the last window reduction, whose plateau is the
+ * window at which the last loss happened. The growth thus depends on the
+ * time rather than on the round trip time, and the window quickly gets
+ * back to its previous size then probes carefully around it. The window is
+ * reduced by a factor Beta on a loss.
+ *
+ * As in the Linux kernel, the cubic window is computed one minimum RTT
+ * ahead, the window grows at least as fast as the one of Reno with the
+ * same average throughput (TCP friendly region), and the window at the
+ * last loss is lowered when the window shrinks (fast convergence). Hybrid
+ * slow start is not modelled: slow start is the one of \RFC{5681}, with
+ * one segment per acknowledged segment.
+ */
+class TcpCubic : public TcpCongestionOps
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpCubic ();
+
+  /**
+   * \brief Copy constructor
+   * \param sock the object to copy
+   */
+  TcpCubic (const TcpCubic &sock);
+
+  virtual ~TcpCubic ();
+
+  virtual std::string GetName (void) const;
+  virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
+                                uint32_t bytesInFlight);
+  virtual void IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
+  virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                          const Time &rtt);
+  virtual void CongestionStateSet (Ptr<TcpSocketState> tcb,
+                                   const TcpSocketState::TcpCongState_t newState);
+  virtual Ptr<TcpCongestionOps> Fork (void);
+
+private:
+  /**
+   * \brief Forget the window at the last loss and the current epoch
+   */
+  void Reset (void);
+
+  /**
+   * \brief Get the number of segments to acknowledge before the window
+   * grows by one segment in congestion avoidance
+   *
+   * \param tcb the congestion control state
+   * \param segmentsAcked the number of segments acknowledged
+   * \return the number of segments
+   */
+  uint32_t Update (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
+
+  bool   m_fastConvergence; //!< Enable fast convergence
+  bool   m_tcpFriendliness; //!< Enable the TCP friendly region
+  double m_beta;            //!< Multiplicative decrease factor
+  double m_c;               //!< Scaling constant of the cubic function
+
+  double   m_lastMaxCwnd;   //!< Window before the last reduction, in segments (W_max)
+  double   m_originPoint;   //!< Plateau of the cubic function, in segments
+  double   m_k;             //!< Time to reach the plateau, in seconds (K)
+  double   m_tcpCwnd;       //!< Window of Reno in the same conditions, in segments (W_est)
+  Time     m_epochStart;    //!< Start of the current epoch, Time::Min () if none
+  Time     m_delayMin;      //!< Minimum RTT seen
+  uint32_t m_cWndCnt;       //!< Segments acknowledged since the last window increase
+};
+
+} // namespace ns3
+
+#endif /* TCP_CUBIC_H */
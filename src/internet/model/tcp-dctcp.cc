@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "tcp-dctcp.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpDctcp");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpDctcp);
+
+TypeId
+TcpDctcp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpDctcp")
+    .SetParent<TcpCongestionOps> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpDctcp> ()
+    .AddAttribute ("DctcpShiftG", "Gain of the estimate of the fraction of marked data",
+                   DoubleValue (0.0625),
+                   MakeDoubleAccessor (&TcpDctcp::m_g),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("DctcpAlphaOnInit", "Initial estimate of the fraction of marked data",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&TcpDctcp::m_alpha),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+  ;
+  return tid;
+}
+
+TcpDctcp::TcpDctcp ()
+  : TcpCongestionOps (),
+    m_g (0.0625),
+    m_alpha (1.0),
+    m_ackedBytesEcn (0),
+    m_ackedBytesTotal (0),
+    m_nextSeq (0),
+    m_nextSeqValid (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::TcpDctcp (const TcpDctcp &sock)
+  : TcpCongestionOps (sock),
+    m_g (sock.m_g),
+    m_alpha (sock.m_alpha),
+    m_ackedBytesEcn (sock.m_ackedBytesEcn),
+    m_ackedBytesTotal (sock.m_ackedBytesTotal),
+    m_nextSeq (sock.m_nextSeq),
+    m_nextSeqValid (sock.m_nextSeqValid)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::~TcpDctcp ()
+{
+}
+
+std::string
+TcpDctcp::GetName (void) const
+{
+  return "TcpDctcp";
+}
+
+double
+TcpDctcp::GetAlpha (void) const
+{
+  return m_alpha;
+}
+
+uint32_t
+TcpDctcp::GetSsThresh (Ptr<const TcpSocketState> tcb, uint32_t bytesInFlight)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+  if (tcb->m_congState == TcpSocketState::CA_CWR)
+    { // ECN-Echo: reduce in proportion of the marked data (RFC 8257, sec. 3.3)
+      return std::max (static_cast<uint32_t> (tcb->m_cWnd.Get () * (1.0 - m_alpha / 2.0)),
+                       2 * tcb->m_segmentSize);
+    }
+  // Loss: as standard TCP
+  return std::max (tcb->m_cWnd.Get () / 2, 2 * tcb->m_segmentSize);
+}
+
+void
+TcpDctcp::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                     const Time &rtt)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked << rtt);
+  uint32_t bytesAcked = segmentsAcked * tcb->m_segmentSize;
+  if (!m_nextSeqValid)
+    {
+      m_nextSeq = tcb->m_highTxMark;
+      m_nextSeqValid = true;
+    }
+  m_ackedBytesTotal += bytesAcked;
+  if (tcb->m_ecnEcho)
+    {
+      m_ackedBytesEcn += bytesAcked;
+    }
+  if (tcb->m_lastAckedSeq >= m_nextSeq)
+    { // End of the observation window (RFC 8257, sec. 3.3)
+      double fraction = 0.0;
+      if (m_ackedBytesTotal > 0)
+        {
+          fraction = static_cast<double> (m_ackedBytesEcn) / m_ackedBytesTotal;
+        }
+      m_alpha = (1.0 - m_g) * m_alpha + m_g * fraction;
+      NS_LOG_INFO ("Fraction of marked data " << fraction << ", alpha " << m_alpha);
+      m_ackedBytesEcn = 0;
+      m_ackedBytesTotal = 0;
+      m_nextSeq = tcb->m_highTxMark;
+    }
+}
+
+bool
+TcpDctcp::HasPerSegmentEcnEcho (void) const
+{
+  return true;
+}
+
+Ptr<TcpCongestionOps>
+TcpDctcp::Fork (void)
+{
+  return CopyObject<TcpDctcp> (this);
+}
+
+} // namespace ns3
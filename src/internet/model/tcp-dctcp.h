@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_DCTCP_H
+#define TCP_DCTCP_H
+
+#include "tcp-congestion-ops.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief The Data Center TCP congestion control algorithm
+ *
+ * DCTCP (\RFC{8257}) estimates the fraction of the data that crossed a
+ * congested queue from the ECN marks, and reduces the congestion window
+ * in proportion: once per window of data, the estimate is updated as
+ * alpha = (1 - g) * alpha + g * F, where F is the fraction of the bytes
+ * acknowledged with the ECN-Echo flag, and an ECN-Echo reduces the window
+ * to cwnd * (1 - alpha / 2). A loss halves the window, and the window
+ * grows as the one of Reno.
+ *
+ * DCTCP requires ECN on both ends (ns3::TcpSocketBase::UseEcn) and queues
+ * that mark the packets as soon as their occupancy exceeds a threshold.
+ * The receiver echoes the CE mark of each segment (see
+ * TcpCongestionOps::HasPerSegmentEcnEcho), so both ends must use DCTCP.
+ */
+class TcpDctcp : public TcpCongestionOps
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpDctcp ();
+
+  /**
+   * \brief Copy constructor
+   * \param sock the object to copy
+   */
+  TcpDctcp (const TcpDctcp &sock);
+
+  virtual ~TcpDctcp ();
+
+  virtual std::string GetName (void) const;
+  virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
+                                uint32_t bytesInFlight);
+  virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                          const Time &rtt);
+  virtual bool HasPerSegmentEcnEcho (void) const;
+  virtual Ptr<TcpCongestionOps> Fork (void);
+
+  /**
+   * \brief Get the estimate of the fraction of marked data
+   * \return alpha
+   */
+  double GetAlpha (void) const;
+
+private:
+  double           m_g;              //!< Estimation gain
+  double           m_alpha;          //!< Estimate of the fraction of marked data
+  uint32_t         m_ackedBytesEcn;  //!< Bytes acknowledged with ECN-Echo in the window
+  uint32_t         m_ackedBytesTotal; //!< Bytes acknowledged in the window
+  SequenceNumber32 m_nextSeq;        //!< End of the observation window
+  bool             m_nextSeqValid;   //!< m_nextSeq was set
+};
+
+} // namespace ns3
+
+#endif /* TCP_DCTCP_H */
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_GSO_TAG_H
+#define TCP_GSO_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Marks a TCP super-segment, carrying several segments of data
+ * behind a single TCP header.
+ *
+ * TcpSocketBase sends several segments at once as one packet bearing this
+ * tag (generic segmentation offload). The packet crosses the IPv4 stack
+ * and the routing lookup once; Ipv4L3Protocol splits it into segments of
+ * the size given by the tag before the output traces and the interface.
+ */
+class TcpGsoTag : public Tag
+{
+public:
+  TcpGsoTag ();
+
+  /**
+   * \brief Set the size of the segments
+   * \param segmentSize the payload size of each segment, in bytes
+   */
+  void SetSegmentSize (uint16_t segmentSize);
+
+  /**
+   * \brief Get the size of the segments
+   * \returns the payload size of each segment, in bytes
+   */
+  uint16_t GetSegmentSize (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  // inherited function, no need to doc.
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  // inherited function, no need to doc.
+  virtual uint32_t GetSerializedSize (void) const;
+
+  // inherited function, no need to doc.
+  virtual void Serialize (TagBuffer i) const;
+
+  // inherited function, no need to doc.
+  virtual void Deserialize (TagBuffer i);
+
+  // inherited function, no need to doc.
+  virtual void Print (std::ostream &os) const;
+private:
+  uint16_t m_segmentSize; //!< the payload size of each segment
+};
+
+} // namespace ns3
+
+#endif /* TCP_GSO_TAG_H */
@@ -75,7 +75,8 @@ TcpL4Protocol::GetTypeId (void)
                    MakeTypeIdAccessor (&TcpL4Protocol::m_rttTypeId),
                    MakeTypeIdChecker ())
     .AddAttribute ("SocketType",
-                   "Socket type of TCP objects.",
+                   "Socket type of TCP objects, or congestion control algorithm "
+                   "(a TcpCongestionOps) of TcpNewReno sockets.",
                    TypeIdValue (TcpNewReno::GetTypeId ()),
                    MakeTypeIdAccessor (&TcpL4Protocol::m_socketTypeId),
                    MakeTypeIdChecker ())
@@ -178,9 +179,21 @@ TcpL4Protocol::CreateSocket (TypeId socketTypeId)
   ObjectFactory rttFactory;
   ObjectFactory socketFactory;
   rttFactory.SetTypeId (m_rttTypeId);
-  socketFactory.SetTypeId (socketTypeId);
   Ptr<RttEstimator> rtt = rttFactory.Create<RttEstimator> ();
-  Ptr<TcpSocketBase> socket = socketFactory.Create<TcpSocketBase> ();
+  Ptr<TcpSocketBase> socket;
+  if (socketTypeId == TcpCongestionOps::GetTypeId ()
+      || socketTypeId.IsChildOf (TcpCongestionOps::GetTypeId ()))
+    { // A congestion control algorithm, run by a TcpNewReno socket
+      ObjectFactory congestionFactory;
+      congestionFactory.SetTypeId (socketTypeId);
+      socket = CreateObject<TcpNewReno> ();
+      socket->SetCongestionControlAlgorithm (congestionFactory.Create<TcpCongestionOps> ());
+    }
+  else
+    {
+      socketFactory.SetTypeId (socketTypeId);
+      socket = socketFactory.Create<TcpSocketBase> ();
+    }
   socket->SetNode (m_node);
   socket->SetTcp (this);
   socket->SetRtt (rtt);
@@ -91,6 +91,9 @@ public:
   /**
    * \brief Create a TCP socket using the specified TypeId
    *
+   * The TypeId is either the one of a TcpSocketBase subclass, or the one
+   * of a TcpCongestionOps, which is then used by a TcpNewReno socket.
+   *
    * \return A smart Socket pointer to a TcpSocket allocated by this instance
    * of the TCP protocol
    *
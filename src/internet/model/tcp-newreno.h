@@ -32,6 +32,11 @@ namespace ns3 {
  * \brief An implementation of a stream socket using TCP.
  *
  * This class contains the NewReno implementation of TCP, as of \RFC{2582}.
+ *
+ * The loss recovery is the one of NewReno, while the window updates are
+ * delegated to a TcpCongestionOps: the default one keeps the behaviour
+ * of NewReno, TcpCubic or TcpDctcp can be set with
+ * TcpSocketBase::SetCongestionControlAlgorithm.
  */
 class TcpNewReno : public TcpSocketBase
 {
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_OPTION_SACK_H
+#define TCP_OPTION_SACK_H
+
+#include <list>
+#include "ns3/tcp-option.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * Defines the TCP option of kind 5 (selective acknowledgment option) as
+ * in \RFC{2018}
+ *
+ * Each block reports a contiguous range of data received and queued by
+ * the receiver above the cumulative acknowledgment, as the sequence number
+ * of its first byte and the sequence number following its last byte.
+ */
+
+class TcpOptionSack : public TcpOption
+{
+public:
+  /// A SACK block: [left edge, right edge)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  /// List of SACK blocks
+  typedef std::list<SackBlock> SackList;
+
+  /**
+   * The maximum number of blocks of a SACK option, given the size of the
+   * TCP option space
+   */
+  static const uint32_t MAX_SACK_BLOCKS = 4;
+
+  TcpOptionSack ();
+  virtual ~TcpOptionSack ();
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Append a block to the option
+   *
+   * At most MAX_SACK_BLOCKS blocks can be stored in the option.
+   *
+   * \param block the block
+   */
+  void AddSackBlock (SackBlock block);
+
+  /**
+   * \brief Get the number of blocks stored in the option
+   * \return the number of blocks
+   */
+  uint32_t GetNumSackBlocks (void) const;
+
+  /**
+   * \brief Remove all the blocks of the option
+   */
+  void ClearSackList (void);
+
+  /**
+   * \brief Get the blocks stored in the option, in the order they were added
+   * \return the list of blocks
+   */
+  const SackList& GetSackList (void) const;
+
+  /**
+   * \brief Get the number of blocks that fit in a given option space
+   * \param space the number of bytes left in the option space
+   * \return the number of blocks, at most MAX_SACK_BLOCKS
+   */
+  static uint32_t GetMaxSackBlocks (uint32_t space);
+
+protected:
+  SackList m_sackList; //!< the SACK blocks
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_SACK_H */
@@ -79,31 +79,31 @@ TcpReno::NewAck (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
   NS_LOG_LOGIC ("TcpReno receieved ACK for seq " << seq <<
-                " cwnd " << m_cWnd <<
-                " ssthresh " << m_ssThresh);
+                " cwnd " << m_tcb->m_cWnd <<
+                " ssthresh " << m_tcb->m_ssThresh);
 
   // Check for exit condition of fast recovery
   if (m_inFastRec)
     { // RFC2001, sec.4; RFC2581, sec.3.2
       // First new ACK after fast recovery: reset cwnd
-      m_cWnd = m_ssThresh;
+      m_tcb->m_cWnd = m_tcb->m_ssThresh;
       m_inFastRec = false;
-      NS_LOG_INFO ("Reset cwnd to " << m_cWnd);
+      NS_LOG_INFO ("Reset cwnd to " << m_tcb->m_cWnd);
     };
 
   // Increase of cwnd based on current phase (slow start or congestion avoidance)
-  if (m_cWnd < m_ssThresh)
+  if (m_tcb->m_cWnd < m_tcb->m_ssThresh)
     { // Slow start mode, add one segSize to cWnd. Default m_ssThresh is 65535. (RFC2001, sec.1)
-      m_cWnd += m_segmentSize;
-      NS_LOG_INFO ("In SlowStart, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+      m_tcb->m_cWnd += m_segmentSize;
+      NS_LOG_INFO ("In SlowStart, updated to cwnd " << m_tcb->m_cWnd << " ssthresh " << m_tcb->m_ssThresh);
     }
   else
     { // Congestion avoidance mode, increase by (segSize*segSize)/cwnd. (RFC2581, sec.3.1)
       // To increase cwnd for one segSize per RTT, it should be (ackBytes*segSize)/cwnd
-      double adder = static_cast<double> (m_segmentSize * m_segmentSize) / m_cWnd.Get ();
+      double adder = static_cast<double> (m_segmentSize * m_segmentSize) / m_tcb->m_cWnd.Get ();
       adder = std::max (1.0, adder);
-      m_cWnd += static_cast<uint32_t> (adder);
-      NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+      m_tcb->m_cWnd += static_cast<uint32_t> (adder);
+      NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_tcb->m_cWnd << " ssthresh " << m_tcb->m_ssThresh);
     }
 
   // Complete newAck processing
@@ -117,16 +117,16 @@ TcpReno::DupAck (const TcpHeader& t, uint32_t count)
   NS_LOG_FUNCTION (this << "t " << count);
   if (count == m_retxThresh && !m_inFastRec)
     { // triple duplicate ack triggers fast retransmit (RFC2581, sec.3.2)
-      m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
-      m_cWnd = m_ssThresh + 3 * m_segmentSize;
+      m_tcb->m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+      m_tcb->m_cWnd = m_tcb->m_ssThresh + 3 * m_segmentSize;
       m_inFastRec = true;
-      NS_LOG_INFO ("Triple dupack. Reset cwnd to " << m_cWnd << ", ssthresh to " << m_ssThresh);
+      NS_LOG_INFO ("Triple dupack. Reset cwnd to " << m_tcb->m_cWnd << ", ssthresh to " << m_tcb->m_ssThresh);
       DoRetransmit ();
     }
   else if (m_inFastRec)
     { // In fast recovery, inc cwnd for every additional dupack (RFC2581, sec.3.2)
-      m_cWnd += m_segmentSize;
-      NS_LOG_INFO ("Increased cwnd to " << m_cWnd);
+      m_tcb->m_cWnd += m_segmentSize;
+      NS_LOG_INFO ("Increased cwnd to " << m_tcb->m_cWnd);
       if (!m_sendPendingDataEvent.IsRunning ())
         {
           SendPendingData (m_connected);
@@ -149,11 +149,11 @@ void TcpReno::Retransmit (void)
   // According to RFC2581 sec.3.1, upon RTO, ssthresh is set to half of flight
   // size and cwnd is set to 1*MSS, then the lost packet is retransmitted and
   // TCP back to slow start
-  m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
-  m_cWnd = m_segmentSize;
+  m_tcb->m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+  m_tcb->m_cWnd = m_segmentSize;
   m_nextTxSequence = m_txBuffer->HeadSequence (); // Restart from highest Ack
-  NS_LOG_INFO ("RTO. Reset cwnd to " << m_cWnd <<
-               ", ssthresh to " << m_ssThresh << ", restart from seqnum " << m_nextTxSequence);
+  NS_LOG_INFO ("RTO. Reset cwnd to " << m_tcb->m_cWnd <<
+               ", ssthresh to " << m_tcb->m_ssThresh << ", restart from seqnum " << m_nextTxSequence);
   DoRetransmit ();                          // Retransmit the packet
 }
 
@@ -18,6 +18,8 @@
  * Author: Adrian Sai-wah Tam <adrian.sw.tam@gmail.com>
  */
 
+#include <algorithm>
+
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -156,8 +158,14 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. Buffered packets do not overlap,
+  // so only the last one starting before headSeq and the following ones
+  // can overlap the incoming packet.
+  BufIterator i = m_data.lower_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -199,19 +207,20 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  if (headSeq > m_nextRxSeq)
+    { // Out-of-order data
+      UpdateSackList (headSeq, tailSeq);
+    }
+  for (BufIterator i = m_data.lower_bound (m_nextRxSeq);
+       i != m_data.end () && i->first == m_nextRxSeq; ++i)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
       m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
       m_availBytes += i->second->GetSize ();
     }
+  if (!m_sackList.empty ())
+    {
+      ClearSackList ();
+    }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
     { // Account for the FIN packet
@@ -248,7 +257,8 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       else
         { // Partial is extracted and done
           outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
+          m_data.insert (i, std::make_pair (i->first + SequenceNumber32 (extractSize),
+                                            i->second->CreateFragment (extractSize, pktSize - extractSize)));
           m_data.erase (i);
           m_size -= extractSize;
           m_availBytes -= extractSize;
@@ -265,4 +275,56 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   return outPkt;
 }
 
+const TcpOptionSack::SackList&
+TcpRxBuffer::GetSackList (void) const
+{
+  return m_sackList;
+}
+
+uint32_t
+TcpRxBuffer::GetSackListSize (void) const
+{
+  return m_sackList.size ();
+}
+
+void
+TcpRxBuffer::UpdateSackList (const SequenceNumber32 &head, const SequenceNumber32 &tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+  TcpOptionSack::SackBlock current (head, tail);
+  TcpOptionSack::SackList::iterator it = m_sackList.begin ();
+  while (it != m_sackList.end ())
+    {
+      if (it->first <= current.second && current.first <= it->second)
+        { // Overlapping or contiguous: merge
+          current.first = std::min (current.first, it->first);
+          current.second = std::max (current.second, it->second);
+          it = m_sackList.erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+  m_sackList.push_front (current);
+}
+
+void
+TcpRxBuffer::ClearSackList (void)
+{
+  NS_LOG_FUNCTION (this);
+  TcpOptionSack::SackList::iterator it = m_sackList.begin ();
+  while (it != m_sackList.end ())
+    {
+      if (it->first < m_nextRxSeq)
+        { // Now in sequence
+          it = m_sackList.erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+}
+
 } //namepsace ns3
@@ -27,6 +27,7 @@
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
 #include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -124,6 +125,41 @@ public:
    * \returns a packet
    */
   Ptr<Packet> Extract (uint32_t maxSize);
+
+  /**
+   * \brief Get the blocks of out-of-order data held by the buffer
+   *
+   * The blocks are ordered as required by \RFC{2018}: the block holding
+   * the most recently received segment comes first, followed by the other
+   * blocks from the most to the least recently updated.
+   *
+   * \returns the list of SACK blocks
+   */
+  const TcpOptionSack::SackList& GetSackList (void) const;
+
+  /**
+   * \brief Get the number of blocks of out-of-order data held by the buffer
+   * \returns the number of SACK blocks
+   */
+  uint32_t GetSackListSize (void) const;
+
+private:
+  /**
+   * \brief Report a range of out-of-order data in the SACK blocks
+   *
+   * The blocks overlapping or touching the range are merged with it, and
+   * the resulting block is moved at the head of the list.
+   *
+   * \param head the sequence number of the first byte of the range
+   * \param tail the sequence number following the last byte of the range
+   */
+  void UpdateSackList (const SequenceNumber32 &head, const SequenceNumber32 &tail);
+
+  /**
+   * \brief Remove the SACK blocks of the data now in sequence
+   */
+  void ClearSackList (void);
+
 public:
   /// container for data stored in the buffer
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
@@ -134,6 +170,7 @@ public:
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  TcpOptionSack::SackList m_sackList;        //!< Blocks of out-of-order data, most recent first
 };
 
 } //namepsace ns3
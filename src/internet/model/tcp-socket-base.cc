@@ -49,7 +49,10 @@
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
 #include "rtt-estimator.h"
+#include "tcp-gso-tag.h"
 
 #include <math.h>
 #include <algorithm>
@@ -58,6 +61,12 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TcpSocketBase");
 
+/// The duplicate ACK threshold of the SACK based loss recovery (DupThresh of RFC 6675)
+static const uint32_t SACK_DUP_THRESH = 3;
+
+/// The largest payload of a super-segment, so that it fits in an IPv4 datagram with the largest TCP header
+static const uint32_t GSO_MAX_SIZE = 65535 - 20 - 60;
+
 NS_OBJECT_ENSURE_REGISTERED (TcpSocketBase);
 
 TypeId
@@ -96,6 +105,34 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_timestampEnabled),
                    MakeBooleanChecker ())
+    .AddAttribute ("Sack", "Enable or disable the SACK option and the SACK based loss recovery",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseEcn", "Enable or disable ECN (RFC 3168), for the variants using a TcpCongestionOps",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_ecnEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("GsoMaxSegments",
+                   "Maximum number of segments sent at once as a single super-segment "
+                   "through the IPv4 stack, 1 to disable segmentation offload",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_gsoMaxSegments),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Pacing", "Enable or disable the pacing of the new data",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_pacing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PacingSsRatio",
+                   "Pacing rate in slow start, in percent of the congestion window per smoothed RTT",
+                   UintegerValue (200),
+                   MakeUintegerAccessor (&TcpSocketBase::m_pacingSsRatio),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PacingCaRatio",
+                   "Pacing rate in congestion avoidance, in percent of the congestion window per smoothed RTT",
+                   UintegerValue (120),
+                   MakeUintegerAccessor (&TcpSocketBase::m_pacingCaRatio),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("MinRto",
                    "Minimum retransmit timeout value",
                    TimeValue (Seconds (1.0)), // RFC 6298 says min RTO=1 sec, but Linux uses 200ms. See http://www.postel.org/pipermail/end2end-interest/2004-November/004402.html
@@ -152,11 +189,11 @@ TcpSocketBase::GetTypeId (void)
                      "ns3::SequenceNumber32TracedValueCallback")
     .AddTraceSource ("CongestionWindow",
                      "The TCP connection's congestion window",
-                     MakeTraceSourceAccessor (&TcpSocketBase::m_cWnd),
+                     MakeTraceSourceAccessor (&TcpSocketBase::m_cWndTrace),
                      "ns3::TracedValueCallback::Uint32")
     .AddTraceSource ("SlowStartThreshold",
                      "TCP slow start threshold (bytes)",
-                     MakeTraceSourceAccessor (&TcpSocketBase::m_ssThresh),
+                     MakeTraceSourceAccessor (&TcpSocketBase::m_ssThTrace),
                      "ns3::TracedValueCallback::Uint32")
   ;
   return tid;
@@ -190,12 +227,31 @@ TcpSocketBase::TcpSocketBase (void)
     m_sndScaleFactor (0),
     m_rcvScaleFactor (0),
     m_timestampEnabled (true),
-    m_timestampToEcho (0)
+    m_timestampToEcho (0),
+    m_sackEnabled (false),
+    m_inSackRecovery (false),
+    m_recoveryPoint (0),
+    m_highRxt (0),
+    m_ecnEnabled (false),
+    m_ecnActive (false),
+    m_ecnEcho (false),
+    m_ecnCeReceived (false),
+    m_ecnCwrPending (false),
+    m_ecnCwrPoint (0),
+    m_gsoMaxSegments (1),
+    m_pacing (false),
+    m_pacingSsRatio (200),
+    m_pacingCaRatio (120)
 
 {
   NS_LOG_FUNCTION (this);
   m_rxBuffer = CreateObject<TcpRxBuffer> ();
   m_txBuffer = CreateObject<TcpTxBuffer> ();
+  m_tcb = CreateObject<TcpSocketState> ();
+  m_tcb->TraceConnectWithoutContext ("CongestionWindow",
+                                     MakeCallback (&TcpSocketBase::UpdateCwnd, this));
+  m_tcb->TraceConnectWithoutContext ("SlowStartThreshold",
+                                     MakeCallback (&TcpSocketBase::UpdateSsThresh, this));
 }
 
 TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
@@ -229,15 +285,25 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_rWnd (sock.m_rWnd),
     m_highRxMark (sock.m_highRxMark),
     m_highRxAckMark (sock.m_highRxAckMark),
-    m_cWnd (sock.m_cWnd),
-    m_ssThresh (sock.m_ssThresh),
-    m_initialCWnd (sock.m_initialCWnd),
-    m_initialSsThresh (sock.m_initialSsThresh),
     m_winScalingEnabled (sock.m_winScalingEnabled),
     m_sndScaleFactor (sock.m_sndScaleFactor),
     m_rcvScaleFactor (sock.m_rcvScaleFactor),
     m_timestampEnabled (sock.m_timestampEnabled),
-    m_timestampToEcho (sock.m_timestampToEcho)
+    m_timestampToEcho (sock.m_timestampToEcho),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_inSackRecovery (false),
+    m_recoveryPoint (sock.m_recoveryPoint),
+    m_highRxt (sock.m_highRxt),
+    m_ecnEnabled (sock.m_ecnEnabled),
+    m_ecnActive (sock.m_ecnActive),
+    m_ecnEcho (false),
+    m_ecnCeReceived (false),
+    m_ecnCwrPending (false),
+    m_ecnCwrPoint (sock.m_ecnCwrPoint),
+    m_gsoMaxSegments (sock.m_gsoMaxSegments),
+    m_pacing (sock.m_pacing),
+    m_pacingSsRatio (sock.m_pacingSsRatio),
+    m_pacingCaRatio (sock.m_pacingCaRatio)
 
 {
   NS_LOG_FUNCTION (this);
@@ -257,6 +323,15 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   SetRecvCallback (vPS);
   m_txBuffer = CopyObject (sock.m_txBuffer);
   m_rxBuffer = CopyObject (sock.m_rxBuffer);
+  m_tcb = CopyObject (sock.m_tcb);
+  m_tcb->TraceConnectWithoutContext ("CongestionWindow",
+                                     MakeCallback (&TcpSocketBase::UpdateCwnd, this));
+  m_tcb->TraceConnectWithoutContext ("SlowStartThreshold",
+                                     MakeCallback (&TcpSocketBase::UpdateSsThresh, this));
+  if (sock.m_congestionControl)
+    {
+      m_congestionControl = sock.m_congestionControl->Fork ();
+    }
 }
 
 TcpSocketBase::~TcpSocketBase (void)
@@ -288,6 +363,20 @@ TcpSocketBase::~TcpSocketBase (void)
   CancelAllTimers ();
 }
 
+void
+TcpSocketBase::SetCongestionControlAlgorithm (Ptr<TcpCongestionOps> algo)
+{
+  NS_LOG_FUNCTION (this << algo);
+  NS_ASSERT (algo != 0);
+  m_congestionControl = algo;
+}
+
+Ptr<TcpCongestionOps>
+TcpSocketBase::GetCongestionControlAlgorithm (void) const
+{
+  return m_congestionControl;
+}
+
 /* Associate a node with this TCP socket */
 void
 TcpSocketBase::SetNode (Ptr<Node> node)
@@ -439,8 +528,8 @@ TcpSocketBase::Bind (const Address &address)
 void
 TcpSocketBase::InitializeCwnd (void)
 {
-  m_cWnd = m_initialCWnd * m_segmentSize;
-  m_ssThresh = m_initialSsThresh;
+  m_tcb->m_cWnd = m_tcb->m_initialCWnd * m_segmentSize;
+  m_tcb->m_ssThresh = m_tcb->m_initialSsThresh;
 }
 
 void
@@ -449,13 +538,13 @@ TcpSocketBase::SetInitialSSThresh (uint32_t threshold)
   NS_ABORT_MSG_UNLESS (m_state == CLOSED,
     "TcpSocketBase::SetSSThresh() cannot change initial ssThresh after connection started.");
 
-  m_initialSsThresh = threshold;
+  m_tcb->m_initialSsThresh = threshold;
 }
 
 uint32_t
 TcpSocketBase::GetInitialSSThresh (void) const
 {
-  return m_initialSsThresh;
+  return m_tcb->m_initialSsThresh;
 }
 
 void
@@ -464,19 +553,19 @@ TcpSocketBase::SetInitialCwnd (uint32_t cwnd)
   NS_ABORT_MSG_UNLESS (m_state == CLOSED,
     "TcpSocketBase::SetInitialCwnd() cannot change initial cwnd after connection started.");
 
-  m_initialCWnd = cwnd;
+  m_tcb->m_initialCWnd = cwnd;
 }
 
 uint32_t
 TcpSocketBase::GetInitialCwnd (void) const
 {
-  return m_initialCWnd;
+  return m_tcb->m_initialCWnd;
 }
 
 void
 TcpSocketBase::ScaleSsThresh (uint8_t scaleFactor)
 {
-  m_ssThresh <<= scaleFactor;
+  m_tcb->m_ssThresh <<= scaleFactor;
 }
 
 /* Inherit from Socket class: Initiate connection to a remote address:port */
@@ -955,6 +1044,7 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
   Address toAddress = InetSocketAddress (header.GetDestination (),
                                          m_endPoint->GetLocalPort ());
 
+  m_ecnCeReceived = (header.GetEcn () == Ipv4Header::ECN_CE);
   DoForwardUp (packet, fromAddress, toAddress);
 }
 
@@ -972,6 +1062,8 @@ TcpSocketBase::ForwardUp6 (Ptr<Packet> packet, Ipv6Header header, uint16_t port,
   Address toAddress = Inet6SocketAddress (header.GetDestinationAddress (),
                                           m_endPoint6->GetLocalPort ());
 
+  // The ECN field is made of the two low order bits of the traffic class
+  m_ecnCeReceived = ((header.GetTrafficClass () & 0x3) == Ipv4Header::ECN_CE);
   DoForwardUp (packet, fromAddress, toAddress);
 }
 
@@ -1114,8 +1206,10 @@ TcpSocketBase::ProcessEstablished (Ptr<Packet> packet, const TcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are
+  // processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags ()
+    & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   // Different flags are different events
   if (tcpflags == TcpHeader::ACK)
@@ -1159,6 +1253,13 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
+  // Update the scoreboard with the SACK blocks, if any
+  if (m_sackEnabled && (tcpHeader.GetFlags () & TcpHeader::ACK)
+      && tcpHeader.HasOption (TcpOption::SACK))
+    {
+      ProcessOptionSack (tcpHeader.GetOption (TcpOption::SACK));
+    }
+
   // Received ACK. Compare the ACK number against highest unacked seqno
   if (0 == (tcpHeader.GetFlags () & TcpHeader::ACK))
     { // Ignore if no ACK flag
@@ -1172,7 +1273,19 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       if (tcpHeader.GetAckNumber () < m_nextTxSequence && packet->GetSize() == 0)
         {
           NS_LOG_LOGIC ("Dupack of " << tcpHeader.GetAckNumber ());
-          DupAck (tcpHeader, ++m_dupAckCount);
+          if (m_tcb->m_congState == TcpSocketState::CA_OPEN)
+            {
+              SetCongState (TcpSocketState::CA_DISORDER);
+            }
+          if (m_sackEnabled)
+            {
+              ++m_dupAckCount;
+              SackDupAck ();
+            }
+          else
+            {
+              DupAck (tcpHeader, ++m_dupAckCount);
+            }
         }
       // otherwise, the ACK is precisely equal to the nextTxSequence
       NS_ASSERT (tcpHeader.GetAckNumber () <= m_nextTxSequence);
@@ -1180,7 +1293,39 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
   else if (tcpHeader.GetAckNumber () > m_txBuffer->HeadSequence ())
     { // Case 3: New ACK, reset m_dupAckCount and update m_txBuffer
       NS_LOG_LOGIC ("New ack of " << tcpHeader.GetAckNumber ());
-      NewAck (tcpHeader.GetAckNumber ());
+      if (m_congestionControl)
+        {
+          m_tcb->m_lastAckedSeq = tcpHeader.GetAckNumber ();
+          m_tcb->m_highTxMark = m_highTxMark;
+          m_tcb->m_ecnEcho = m_ecnActive && (tcpHeader.GetFlags () & TcpHeader::ECE);
+          m_congestionControl->PktsAcked (m_tcb, GetSegmentsAcked (tcpHeader.GetAckNumber ()),
+                                          m_lastRtt);
+        }
+      if (m_tcb->m_congState == TcpSocketState::CA_DISORDER
+          || (m_tcb->m_congState == TcpSocketState::CA_CWR
+              && tcpHeader.GetAckNumber () >= m_ecnCwrPoint)
+          || (m_tcb->m_congState == TcpSocketState::CA_LOSS
+              && tcpHeader.GetAckNumber () >= m_recoveryPoint))
+        {
+          SetCongState (TcpSocketState::CA_OPEN);
+        }
+      if (m_ecnActive && (tcpHeader.GetFlags () & TcpHeader::ECE)
+          && m_tcb->m_congState == TcpSocketState::CA_OPEN)
+        { // At most one reduction per window (RFC 3168, sec. 6.1.2)
+          EnterCwr ();
+        }
+      if (m_inSackRecovery)
+        {
+          SackNewAck (tcpHeader.GetAckNumber ());
+        }
+      else
+        {
+          if (m_sackEnabled && tcpHeader.GetAckNumber () > m_recoveryPoint)
+            { // Past the recovery point, a new recovery may start
+              m_recoveryPoint = tcpHeader.GetAckNumber ();
+            }
+          NewAck (tcpHeader.GetAckNumber ());
+        }
       m_dupAckCount = 0;
     }
   // If there is any data piggybacked, store it into m_rxBuffer
@@ -1197,8 +1342,10 @@ TcpSocketBase::ProcessListen (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are
+  // processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags ()
+    & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   // Fork a socket if received a SYN. Do nothing otherwise.
   // C.f.: the LISTEN part in tcp_v4_do_rcv() in tcp_ipv4.c in Linux kernel
@@ -1226,8 +1373,10 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are
+  // processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags ()
+    & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0)
     { // Bare data, accept it and move to ESTABLISHED state. This is not a normal behaviour. Remove this?
@@ -1260,6 +1409,9 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       m_rxBuffer->SetNextRxSequence (tcpHeader.GetSequenceNumber () + SequenceNumber32 (1));
       m_highTxMark = ++m_nextTxSequence;
       m_txBuffer->SetHeadSequence (m_nextTxSequence);
+      // ECN-setup SYN-ACK (RFC 3168, sec. 6.1.1)
+      m_ecnActive = IsEcnCapable ()
+        && (tcpHeader.GetFlags () & (TcpHeader::ECE | TcpHeader::CWR)) == TcpHeader::ECE;
       SendEmptyPacket (TcpHeader::ACK);
       SendPendingData (m_connected);
       Simulator::ScheduleNow (&TcpSocketBase::ConnectionSucceeded, this);
@@ -1286,8 +1438,10 @@ TcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are
+  // processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags ()
+    & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0
       || (tcpflags == TcpHeader::ACK
@@ -1376,8 +1530,10 @@ TcpSocketBase::ProcessWait (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are
+  // processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags ()
+    & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (packet->GetSize () > 0 && tcpflags != TcpHeader::ACK)
     { // Bare data, accept it
@@ -1448,8 +1604,10 @@ TcpSocketBase::ProcessClosing (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are
+  // processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags ()
+    & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == TcpHeader::ACK)
     {
@@ -1480,8 +1638,10 @@ TcpSocketBase::ProcessLastAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are
+  // processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags ()
+    & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0)
     {
@@ -1673,6 +1833,21 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
     {
       ++s;
     }
+  if (flags & TcpHeader::SYN)
+    { // ECN-setup SYN and SYN-ACK (RFC 3168, sec. 6.1.1)
+      if (!(flags & TcpHeader::ACK) && IsEcnCapable ())
+        {
+          flags |= TcpHeader::ECE | TcpHeader::CWR;
+        }
+      else if ((flags & TcpHeader::ACK) && m_ecnActive)
+        {
+          flags |= TcpHeader::ECE;
+        }
+    }
+  else if ((flags & TcpHeader::ACK) && m_ecnActive && m_ecnEcho)
+    {
+      flags |= TcpHeader::ECE;
+    }
 
   header.SetFlags (flags);
   header.SetSequenceNumber (s);
@@ -1862,6 +2037,9 @@ TcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& h,
   SetupCallback ();
   // Set the sequence number and send SYN+ACK
   m_rxBuffer->SetNextRxSequence (h.GetSequenceNumber () + SequenceNumber32 (1));
+  // ECN-setup SYN (RFC 3168, sec. 6.1.1)
+  m_ecnActive = IsEcnCapable ()
+    && (h.GetFlags () & (TcpHeader::ECE | TcpHeader::CWR)) == (TcpHeader::ECE | TcpHeader::CWR);
 
   SendEmptyPacket (TcpHeader::SYN | TcpHeader::ACK);
 }
@@ -1892,11 +2070,30 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
     {
       isRetransmission = true;
     }
+  else if (m_inSackRecovery && seq < m_highTxMark)
+    { // Retransmission of a hole above the head
+      isRetransmission = true;
+    }
 
   Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
   uint32_t sz = p->GetSize (); // Size of packet
   uint8_t flags = withAck ? TcpHeader::ACK : 0;
   uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
+  // Retransmissions are not ECN-capable (RFC 3168, sec. 6.1.5)
+  bool ecnCapable = m_ecnActive && seq >= m_highTxMark;
+
+  if (m_ecnActive)
+    {
+      if (withAck && m_ecnEcho)
+        {
+          flags |= TcpHeader::ECE;
+        }
+      if (ecnCapable && m_ecnCwrPending)
+        { // Signal the window reduction to the receiver
+          flags |= TcpHeader::CWR;
+          m_ecnCwrPending = false;
+        }
+    }
 
   if (withAck)
     {
@@ -1910,17 +2107,27 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
    * if both options are set. Once the packet got to layer three, only
    * the corresponding tags will be read.
    */
-  if (IsManualIpTos ())
+  if (IsManualIpTos () || ecnCapable)
     {
       SocketIpTosTag ipTosTag;
-      ipTosTag.SetTos (GetIpTos ());
+      uint8_t tos = IsManualIpTos () ? GetIpTos () : 0;
+      if (ecnCapable)
+        {
+          tos = (tos & 0xfc) | Ipv4Header::ECN_ECT0;
+        }
+      ipTosTag.SetTos (tos);
       p->AddPacketTag (ipTosTag);
     }
 
-  if (IsManualIpv6Tclass ())
+  if (IsManualIpv6Tclass () || ecnCapable)
     {
       SocketIpv6TclassTag ipTclassTag;
-      ipTclassTag.SetTclass (GetIpv6Tclass ());
+      uint8_t tclass = IsManualIpv6Tclass () ? GetIpv6Tclass () : 0;
+      if (ecnCapable)
+        {
+          tclass = (tclass & 0xfc) | Ipv4Header::ECN_ECT0;
+        }
+      ipTclassTag.SetTclass (tclass);
       p->AddPacketTag (ipTclassTag);
     }
 
@@ -1986,6 +2193,12 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
                 TcpHeader::FlagsToString (flags));
   if (m_endPoint)
     {
+      if (sz > m_segmentSize)
+        { // Super-segment, split by the IPv4 stack
+          TcpGsoTag gsoTag;
+          gsoTag.SetSegmentSize (m_segmentSize);
+          p->AddPacketTag (gsoTag);
+        }
       m_tcp->SendPacket (p, header, m_endPoint->GetLocalAddress (),
                          m_endPoint->GetPeerAddress (), m_boundnetdevice);
     }
@@ -1997,8 +2210,13 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
 
   // update the history of sequence numbers used to calculate the RTT
   if (isRetransmission == false)
-    { // This is the next expected one, just log at end
-      m_history.push_back (RttHistory (seq, sz, Simulator::Now () ));
+    { // This is the next expected one, just log at end, one entry per segment
+      for (uint32_t offset = 0; offset < sz; offset += m_segmentSize)
+        {
+          m_history.push_back (RttHistory (seq + SequenceNumber32 (offset),
+                                           std::min (sz - offset, m_segmentSize),
+                                           Simulator::Now ()));
+        }
     }
   else
     { // This is a retransmit, find in list and mark as re-tx
@@ -2039,9 +2257,18 @@ TcpSocketBase::SendPendingData (bool withAck)
       NS_LOG_INFO ("TcpSocketBase::SendPendingData: No endpoint; m_shutdownSend=" << m_shutdownSend);
       return false; // Is this the right way to handle this condition?
     }
+  if (m_inSackRecovery)
+    {
+      return SendPendingDataInRecovery (withAck);
+    }
   uint32_t nPacketsSent = 0;
   while (m_txBuffer->SizeFromSequence (m_nextTxSequence))
     {
+      if (m_pacingEvent.IsRunning ())
+        {
+          NS_LOG_LOGIC ("Pacing. Wait to send.");
+          break;
+        }
       uint32_t w = AvailableWindow (); // Get available window size
       // Stop sending if we need to wait for a larger Tx window (prevent silly window syndrome)
       if (w < m_segmentSize && m_txBuffer->SizeFromSequence (m_nextTxSequence) > w)
@@ -2066,14 +2293,58 @@ TcpSocketBase::SendPendingData (bool withAck)
                     " pd->Size " << m_txBuffer->Size () <<
                     " pd->SFS " << m_txBuffer->SizeFromSequence (m_nextTxSequence));
       uint32_t s = std::min (w, m_segmentSize);  // Send no more than window
+      uint32_t gsoSegments = GetGsoSegments ();
+      if (gsoSegments > 1)
+        { // Batch whole segments only, a smaller tail is sent as usual
+          uint32_t batch = std::min (w, m_txBuffer->SizeFromSequence (m_nextTxSequence));
+          batch = std::min (batch, gsoSegments * m_segmentSize);
+          s = std::max (s, batch - batch % m_segmentSize);
+        }
       uint32_t sz = SendDataPacket (m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_nextTxSequence += sz;                     // Advance next tx sequence
+      DataRate pacingRate = GetPacingRate ();
+      if (pacingRate.GetBitRate () > 0)
+        { // Next departure once this one has been sent at the pacing rate
+          m_pacingEvent = Simulator::Schedule (pacingRate.CalculateBytesTxTime (sz),
+                                               &TcpSocketBase::SendPendingData, this, m_connected);
+        }
     }
   NS_LOG_LOGIC ("SendPendingData sent " << nPacketsSent << " packets");
   return (nPacketsSent > 0);
 }
 
+DataRate
+TcpSocketBase::GetPacingRate (void) const
+{
+  if (!m_pacing || m_rtt == 0 || m_rtt->GetNSamples () == 0
+      || m_rtt->GetEstimate ().IsZero ())
+    {
+      return DataRate (0);
+    }
+  // As Linux: faster during the first half of slow start
+  uint32_t ratio = (m_tcb->m_cWnd < m_tcb->m_ssThresh / 2) ? m_pacingSsRatio : m_pacingCaRatio;
+  double rate = 8.0 * m_tcb->m_cWnd.Get () * ratio / 100 / m_rtt->GetEstimate ().GetSeconds ();
+  return DataRate (static_cast<uint64_t> (rate));
+}
+
+uint32_t
+TcpSocketBase::GetGsoSegments (void) const
+{
+  if (m_gsoMaxSegments <= 1 || m_endPoint == 0 || m_segmentSize == 0)
+    {
+      return 1;
+    }
+  uint32_t segments = std::min (m_gsoMaxSegments, GSO_MAX_SIZE / m_segmentSize);
+  DataRate pacingRate = GetPacingRate ();
+  if (pacingRate.GetBitRate () > 0)
+    { // About 1 ms worth of data at the pacing rate, and at least 2 segments
+      uint64_t autosize = pacingRate.GetBitRate () / 8 / 1000 / m_segmentSize;
+      segments = std::min<uint64_t> (segments, std::max<uint64_t> (autosize, 2));
+    }
+  return std::max (segments, 1U);
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount ()
 {
@@ -2092,7 +2363,7 @@ uint32_t
 TcpSocketBase::Window (void)
 {
   NS_LOG_FUNCTION (this);
-  return std::min (m_rWnd.Get (), m_cWnd.Get ());
+  return std::min (m_rWnd.Get (), m_tcb->m_cWnd.Get ());
 }
 
 uint32_t
@@ -2130,6 +2401,8 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
                 " ack " << tcpHeader.GetAckNumber () <<
                 " pkt size " << p->GetSize () );
 
+  ProcessEcnMarks (tcpHeader);
+
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
   if (!m_rxBuffer->Add (p, tcpHeader))
@@ -2305,8 +2578,19 @@ TcpSocketBase::ReTxTimeout ()
     {
       return;
     }
+  if (m_sackEnabled)
+    { // Terminate the SACK based recovery, and do not start a new one before
+      // the data sent so far is acknowledged (RFC 6675, sec. 5.1). The
+      // scoreboard is forgotten as the receiver may have discarded the data
+      // it SACKed (RFC 2018, sec. 8).
+      m_inSackRecovery = false;
+      m_txBuffer->ResetScoreboard ();
+    }
+  // The loss state lasts until the data sent so far is acknowledged
+  m_recoveryPoint = m_highTxMark;
 
   Retransmit ();
+  SetCongState (TcpSocketState::CA_LOSS);
 }
 
 void
@@ -2415,6 +2699,217 @@ TcpSocketBase::DoRetransmit ()
 
 }
 
+uint32_t
+TcpSocketBase::GetSsThreshOnLoss (void)
+{
+  if (m_congestionControl)
+    {
+      return m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
+    }
+  return std::max (2 * m_segmentSize, BytesInFlight () / 2);
+}
+
+void
+TcpSocketBase::SetCongState (TcpSocketState::TcpCongState_t state)
+{
+  NS_LOG_FUNCTION (this << TcpSocketState::TcpCongStateName[state]);
+  if (m_tcb->m_congState == state)
+    {
+      return;
+    }
+  NS_LOG_INFO (TcpSocketState::TcpCongStateName[m_tcb->m_congState] << " -> " <<
+               TcpSocketState::TcpCongStateName[state]);
+  if (m_congestionControl)
+    {
+      m_congestionControl->CongestionStateSet (m_tcb, state);
+    }
+  m_tcb->m_congState = state;
+}
+
+uint32_t
+TcpSocketBase::GetSegmentsAcked (SequenceNumber32 const& ack)
+{
+  uint32_t bytesAcked = ack - m_txBuffer->HeadSequence ();
+  return (bytesAcked + m_segmentSize - 1) / m_segmentSize;
+}
+
+bool
+TcpSocketBase::IsEcnCapable (void) const
+{
+  return m_ecnEnabled && m_congestionControl != 0;
+}
+
+void
+TcpSocketBase::ProcessEcnMarks (const TcpHeader& tcpHeader)
+{
+  NS_LOG_FUNCTION (this << m_ecnCeReceived);
+  if (!m_ecnActive)
+    {
+      return;
+    }
+  if (m_congestionControl->HasPerSegmentEcnEcho ())
+    {
+      if (m_ecnCeReceived != m_ecnEcho)
+        { // The pending delayed ACK echoes the previous mark
+          if (m_delAckEvent.IsRunning ())
+            {
+              SendEmptyPacket (TcpHeader::ACK);
+            }
+          m_ecnEcho = m_ecnCeReceived;
+        }
+    }
+  else
+    {
+      if (tcpHeader.GetFlags () & TcpHeader::CWR)
+        {
+          m_ecnEcho = false;
+        }
+      if (m_ecnCeReceived)
+        {
+          m_ecnEcho = true;
+        }
+    }
+}
+
+void
+TcpSocketBase::EnterCwr (void)
+{
+  NS_LOG_FUNCTION (this);
+  SetCongState (TcpSocketState::CA_CWR);
+  m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
+  m_tcb->m_cWnd = m_tcb->m_ssThresh;
+  m_ecnCwrPoint = m_highTxMark;
+  m_ecnCwrPending = true;
+  NS_LOG_INFO ("ECN-Echo. Reset cwnd to " << m_tcb->m_cWnd << ", ssthresh to " <<
+               m_tcb->m_ssThresh << " until seqnum " << m_ecnCwrPoint);
+}
+
+void
+TcpSocketBase::UpdateCwnd (uint32_t oldValue, uint32_t newValue)
+{
+  m_cWndTrace (oldValue, newValue);
+}
+
+void
+TcpSocketBase::UpdateSsThresh (uint32_t oldValue, uint32_t newValue)
+{
+  m_ssThTrace (oldValue, newValue);
+}
+
+void
+TcpSocketBase::SackDupAck (void)
+{
+  NS_LOG_FUNCTION (this << m_dupAckCount);
+  if (m_inSackRecovery)
+    { // RFC 6675, sec. 5, step (C): send what the pipe allows
+      if (!m_sendPendingDataEvent.IsRunning ())
+        {
+          SendPendingData (m_connected);
+        }
+    }
+  else if (m_txBuffer->HeadSequence () >= m_recoveryPoint
+           && (m_dupAckCount >= SACK_DUP_THRESH
+               || m_txBuffer->IsLost (m_txBuffer->HeadSequence (), SACK_DUP_THRESH, m_segmentSize)))
+    { // RFC 6675, sec. 5, step (4)
+      EnterSackRecovery ();
+    }
+}
+
+void
+TcpSocketBase::SackNewAck (SequenceNumber32 const& ack)
+{
+  NS_LOG_FUNCTION (this << ack);
+  NS_ASSERT (m_inSackRecovery);
+  if (ack >= m_recoveryPoint)
+    { // Full ACK: leave the recovery with the reduced window
+      m_inSackRecovery = false;
+      m_recoveryPoint = ack;
+      SetCongState (TcpSocketState::CA_OPEN);
+      m_tcb->m_cWnd = m_tcb->m_ssThresh;
+      NS_LOG_INFO ("Full ACK. Leave SACK recovery, cwnd " << m_tcb->m_cWnd);
+      NewAck (ack);
+    }
+  else
+    { // Partial ACK: stay in recovery, the window does not change and
+      // TcpSocketBase::NewAck schedules the sending of what the pipe allows
+      NS_LOG_INFO ("Partial ACK of " << ack << " in SACK recovery");
+      TcpSocketBase::NewAck (ack);
+    }
+}
+
+void
+TcpSocketBase::EnterSackRecovery (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_inSackRecovery = true;
+  m_recoveryPoint = m_highTxMark;
+  m_tcb->m_ssThresh = GetSsThreshOnLoss ();
+  m_tcb->m_cWnd = m_tcb->m_ssThresh;
+  SetCongState (TcpSocketState::CA_RECOVERY);
+  m_highRxt = m_txBuffer->HeadSequence ();
+  NS_LOG_INFO ("Enter SACK recovery. Reset cwnd to " << m_tcb->m_cWnd << ", ssthresh to " <<
+               m_tcb->m_ssThresh << " at recovery point " << m_recoveryPoint);
+
+  // Retransmit the first segment not acknowledged, even if the scoreboard
+  // does not deem it lost yet
+  SequenceNumber32 seq;
+  uint32_t length;
+  if (m_txBuffer->NextSeg (m_highTxMark, m_highRxt, SACK_DUP_THRESH, m_segmentSize,
+                           false, seq, length))
+    {
+      uint32_t sz = SendDataPacket (seq, length, true);
+      m_highRxt = seq + sz;
+    }
+  SendPendingData (m_connected);
+}
+
+uint32_t
+TcpSocketBase::SackPipe (void) const
+{
+  return m_txBuffer->BytesInFlight (m_highTxMark, m_highRxt, SACK_DUP_THRESH, m_segmentSize);
+}
+
+bool
+TcpSocketBase::SendPendingDataInRecovery (bool withAck)
+{
+  NS_LOG_FUNCTION (this << withAck);
+  uint32_t nPacketsSent = 0;
+  uint32_t pipe = SackPipe ();
+  while (m_tcb->m_cWnd.Get () >= pipe + m_segmentSize)
+    {
+      SequenceNumber32 seq;
+      uint32_t length;
+      uint32_t sz = 0;
+      uint32_t rWndAvailable = (m_rWnd.Get () > UnAckDataCount ()) ? m_rWnd.Get () - UnAckDataCount () : 0;
+      uint32_t newData = std::min (m_txBuffer->SizeFromSequence (m_nextTxSequence), rWndAvailable);
+      if (m_txBuffer->NextSeg (m_highTxMark, m_highRxt, SACK_DUP_THRESH, m_segmentSize,
+                               true, seq, length))
+        { // Rule 1: retransmit lost data
+          sz = SendDataPacket (seq, length, withAck);
+          m_highRxt = seq + sz;
+        }
+      else if (newData > 0)
+        { // Rule 2: send new data
+          sz = SendDataPacket (m_nextTxSequence, std::min (newData, m_segmentSize), withAck);
+          m_nextTxSequence += sz;
+        }
+      else if (m_txBuffer->NextSeg (m_highTxMark, m_highRxt, SACK_DUP_THRESH, m_segmentSize,
+                                    false, seq, length))
+        { // Rule 3: retransmit data not SACKed yet
+          sz = SendDataPacket (seq, length, withAck);
+          m_highRxt = seq + sz;
+        }
+      if (sz == 0)
+        {
+          break;
+        }
+      nPacketsSent++;
+      pipe = SackPipe ();
+    }
+  NS_LOG_LOGIC ("SendPendingDataInRecovery sent " << nPacketsSent << " packets, pipe " << pipe);
+  return (nPacketsSent > 0);
+}
+
 void
 TcpSocketBase::CancelAllTimers ()
 {
@@ -2424,6 +2919,7 @@ TcpSocketBase::CancelAllTimers ()
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
+  m_pacingEvent.Cancel ();
 }
 
 /* Move TCP to Time_Wait state and schedule a transition to Closed state */
@@ -2469,6 +2965,7 @@ void
 TcpSocketBase::SetSegSize (uint32_t size)
 {
   m_segmentSize = size;
+  m_tcb->m_segmentSize = size;
   NS_ABORT_MSG_UNLESS (m_state == CLOSED, "Cannot change segment size dynamically.");
 }
 
@@ -2581,6 +3078,11 @@ TcpSocketBase::ReadOptions (const TcpHeader& header)
               ScaleSsThresh (m_sndScaleFactor);
             }
         }
+
+      if (m_sackEnabled)
+        {
+          m_sackEnabled = header.HasOption (TcpOption::SACKPERMITTED);
+        }
     }
 
   bool timestampAttribute = m_timestampEnabled;
@@ -2604,10 +3106,22 @@ TcpSocketBase::AddOptions (TcpHeader& header)
       AddOptionWScale (header);
     }
 
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::SYN))
+    {
+      AddOptionSackPermitted (header);
+    }
+
   if (m_timestampEnabled)
     {
       AddOptionTimestamp (header);
     }
+
+  // The SACK option goes last, to fill the remaining option space
+  if (m_sackEnabled && !(header.GetFlags () & TcpHeader::SYN)
+      && m_rxBuffer->GetSackListSize () > 0)
+    {
+      AddOptionSack (header);
+    }
 }
 
 void
@@ -2702,6 +3216,56 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
                option->GetTimestamp () << " echo=" << m_timestampToEcho);
 }
 
+void
+TcpSocketBase::AddOptionSackPermitted (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+  NS_ASSERT (header.GetFlags () & TcpHeader::SYN);
+
+  Ptr<TcpOptionSackPermitted> option = CreateObject<TcpOptionSackPermitted> ();
+  header.AppendOption (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK permitted");
+}
+
+uint32_t
+TcpSocketBase::ProcessOptionSack (const Ptr<const TcpOption> option)
+{
+  NS_LOG_FUNCTION (this << option);
+
+  Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (option);
+  uint32_t newlySacked = m_txBuffer->Update (sack->GetSackList ());
+
+  NS_LOG_INFO (m_node->GetId () << " Got " << sack->GetNumSackBlocks () <<
+               " SACK blocks, " << newlySacked << " bytes newly SACKed");
+  return newlySacked;
+}
+
+void
+TcpSocketBase::AddOptionSack (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  // Option space left, the header length being rounded to a word
+  uint32_t space = 40 - (header.GetLength () - 5) * 4;
+  uint32_t nBlocks = TcpOptionSack::GetMaxSackBlocks (space);
+  if (nBlocks == 0)
+    {
+      return;
+    }
+
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  const TcpOptionSack::SackList &list = m_rxBuffer->GetSackList ();
+  for (TcpOptionSack::SackList::const_iterator it = list.begin ();
+       it != list.end () && option->GetNumSackBlocks () < nBlocks; ++it)
+    {
+      option->AddSackBlock (*it);
+    }
+
+  header.AppendOption (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK, " <<
+               option->GetNumSackBlocks () << " blocks");
+}
+
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
 {
   NS_LOG_FUNCTION (this << header);
@@ -25,6 +25,7 @@
 #include <queue>
 #include "ns3/callback.h"
 #include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
 #include "ns3/tcp-socket.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
@@ -33,9 +34,11 @@
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-interface.h"
 #include "ns3/event-id.h"
+#include "ns3/data-rate.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
+#include "tcp-congestion-ops.h"
 
 namespace ns3 {
 
@@ -130,6 +133,23 @@ public:
    */
   virtual void SetRtt (Ptr<RttEstimator> rtt);
 
+  /**
+   * \brief Set the congestion control algorithm.
+   *
+   * The variants which delegate the window updates to a TcpCongestionOps
+   * (i.e., TcpNewReno) use it in place of their own. The algorithm can be
+   * changed during the connection, it then starts from the current window.
+   *
+   * \param algo the congestion control algorithm
+   */
+  void SetCongestionControlAlgorithm (Ptr<TcpCongestionOps> algo);
+
+  /**
+   * \brief Get the congestion control algorithm.
+   * \return the congestion control algorithm, or 0 if the variant has its own
+   */
+  Ptr<TcpCongestionOps> GetCongestionControlAlgorithm (void) const;
+
   /**
    * \brief Sets the Minimum RTO.
    * \param minRto The minimum RTO.
@@ -350,6 +370,29 @@ protected:
    */
   uint32_t SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck);
 
+  /**
+   * \brief Get the rate at which the new data is paced
+   *
+   * The rate is PacingSsRatio percent of the congestion window per
+   * smoothed RTT while the window is below half the slow start threshold,
+   * and PacingCaRatio percent otherwise.
+   *
+   * \returns the pacing rate, zero when pacing is disabled or no RTT has
+   * been measured yet
+   */
+  DataRate GetPacingRate (void) const;
+
+  /**
+   * \brief Get the number of segments to send at once as a super-segment
+   *
+   * At most GsoMaxSegments, within the largest IPv4 datagram; with pacing,
+   * about 1 ms worth of data at the pacing rate. Super-segments are only
+   * used over IPv4.
+   *
+   * \returns the number of segments
+   */
+  uint32_t GetGsoSegments (void) const;
+
   /**
    * \brief Send a empty packet that carries a flag, e.g. ACK
    *
@@ -614,6 +657,122 @@ protected:
    */
   virtual void DoRetransmit (void);
 
+  /**
+   * \brief Get the slow start threshold after a loss detected by SACK
+   *
+   * Called when entering the SACK based loss recovery.  The default asks
+   * the congestion control algorithm if any, and is otherwise half of the
+   * flight size, as in \RFC{5681}.
+   *
+   * \returns the new slow start threshold
+   */
+  virtual uint32_t GetSsThreshOnLoss (void);
+
+  /**
+   * \brief Change the congestion control state
+   *
+   * Notify the congestion control algorithm, if any, then update the state.
+   *
+   * \param state the new state
+   */
+  void SetCongState (TcpSocketState::TcpCongState_t state);
+
+  /**
+   * \brief Get the number of segments acknowledged by an ACK
+   * \param ack the acknowledgment number, above the head of the Tx buffer
+   * \returns the number of segments, rounded up
+   */
+  uint32_t GetSegmentsAcked (SequenceNumber32 const& ack);
+
+  /**
+   * \brief Whether this socket may negotiate ECN
+   *
+   * ECN requires the UseEcn attribute and a congestion control algorithm
+   * to react to the ECN-Echo flag.
+   *
+   * \returns true if ECN may be used
+   */
+  bool IsEcnCapable (void) const;
+
+  /**
+   * \brief Process the ECN marks of a received data segment
+   *
+   * Update the ECN-Echo flag of the next ACKs from the CE mark of the
+   * segment and the CWR flag of its header (\RFC{3168}, sec. 6.1.3). With
+   * the per segment echo of DCTCP, the pending delayed ACK is sent at
+   * once when the CE mark changes.
+   *
+   * \param tcpHeader the segment's TCP header
+   */
+  void ProcessEcnMarks (const TcpHeader& tcpHeader);
+
+  /**
+   * \brief Reduce the window on an ECN-Echo (\RFC{3168}, sec. 6.1.2)
+   *
+   * Enter the CA_CWR state until the data sent so far is acknowledged,
+   * take the slow start threshold given by the congestion control
+   * algorithm as congestion window, and set CWR in the next data segment.
+   */
+  void EnterCwr (void);
+
+  /**
+   * \brief Forward the changes of the congestion window of m_tcb
+   * \param oldValue the previous window
+   * \param newValue the new window
+   */
+  void UpdateCwnd (uint32_t oldValue, uint32_t newValue);
+
+  /**
+   * \brief Forward the changes of the slow start threshold of m_tcb
+   * \param oldValue the previous threshold
+   * \param newValue the new threshold
+   */
+  void UpdateSsThresh (uint32_t oldValue, uint32_t newValue);
+
+  /**
+   * \brief Process a duplicate ACK when SACK is in use
+   *
+   * Enters the loss recovery of \RFC{6675} on the DupThresh-th duplicate
+   * ACK or as soon as the head of the send buffer is deemed lost by the
+   * scoreboard, or sends what the pipe allows during the recovery.
+   */
+  void SackDupAck (void);
+
+  /**
+   * \brief Process a new ACK when SACK is in use and loss recovery is ongoing
+   *
+   * A partial ACK keeps the socket in recovery without changing the
+   * congestion window, an ACK covering the recovery point ends it.
+   *
+   * \param ack the acknowledgment number
+   */
+  void SackNewAck (SequenceNumber32 const& ack);
+
+  /**
+   * \brief Enter the SACK based loss recovery (\RFC{6675}, sec. 5)
+   *
+   * Set the recovery point, reduce the window, and retransmit the first
+   * segment not acknowledged.
+   */
+  void EnterSackRecovery (void);
+
+  /**
+   * \brief Send data during the SACK based loss recovery
+   *
+   * Send segments chosen as in the NextSeg routine of \RFC{6675} as long
+   * as the congestion window exceeds the pipe by a segment.
+   *
+   * \param withAck forces an ACK to be sent
+   * \returns true if some data have been sent
+   */
+  bool SendPendingDataInRecovery (bool withAck);
+
+  /**
+   * \brief Get the number of bytes in flight during the SACK based loss recovery
+   * \returns the pipe of \RFC{6675}
+   */
+  uint32_t SackPipe (void) const;
+
   /**
    * \brief Read TCP options from incoming packets
    *  
@@ -685,6 +844,32 @@ protected:
    */
   void AddOptionTimestamp (TcpHeader& header);
 
+  /**
+   * \brief Add the SACK permitted option to the header
+   * \param header TcpHeader to which add the option to
+   */
+  void AddOptionSackPermitted (TcpHeader& header);
+
+  /**
+   * \brief Process the SACK option from other side
+   *
+   * Update the scoreboard of the Tx buffer with the blocks of the option.
+   *
+   * \param option Option from the packet
+   * \returns the number of bytes newly SACKed
+   */
+  uint32_t ProcessOptionSack (const Ptr<const TcpOption> option);
+
+  /**
+   * \brief Add the SACK option to the header
+   *
+   * Report as many blocks of out-of-order data held by the Rx buffer as
+   * the remaining option space allows, the most recent first.
+   *
+   * \param header TcpHeader to which add the option to
+   */
+  void AddOptionSack (TcpHeader& header);
+
   /**
    * \brief Scale the initial SsThresh value to the correct one
    *
@@ -760,10 +945,10 @@ protected:
   TracedValue<SequenceNumber32> m_highRxAckMark;  //!< Highest ack received
 
   // Congestion control
-  TracedValue<uint32_t> m_cWnd;     //!< Congestion window
-  TracedValue<uint32_t> m_ssThresh; //!< Slow start threshold
-  uint32_t               m_initialCWnd;      //!< Initial cWnd value
-  uint32_t               m_initialSsThresh;  //!< Initial Slow Start Threshold value
+  Ptr<TcpSocketState>   m_tcb;               //!< Congestion control state (windows)
+  Ptr<TcpCongestionOps> m_congestionControl; //!< Congestion control algorithm, if any
+  TracedCallback<uint32_t, uint32_t> m_cWndTrace;   //!< Callback of the congestion window changes
+  TracedCallback<uint32_t, uint32_t> m_ssThTrace;   //!< Callback of the slow start threshold changes
 
   // Options
   bool    m_winScalingEnabled;    //!< Window Scale option enabled
@@ -773,6 +958,27 @@ protected:
   bool     m_timestampEnabled;    //!< Timestamp option enabled
   uint32_t m_timestampToEcho;     //!< Timestamp to echo
 
+  // SACK
+  bool             m_sackEnabled;    //!< SACK option enabled
+  bool             m_inSackRecovery; //!< In SACK based loss recovery
+  SequenceNumber32 m_recoveryPoint;  //!< Highest seqno sent when the recovery started (RecoveryPoint)
+  SequenceNumber32 m_highRxt;        //!< Highest seqno retransmitted during the recovery (HighRxt)
+
+  // ECN
+  bool             m_ecnEnabled;    //!< ECN requested (UseEcn attribute)
+  bool             m_ecnActive;     //!< ECN negotiated on this connection
+  bool             m_ecnEcho;       //!< Set ECN-Echo in the ACKs sent
+  bool             m_ecnCeReceived; //!< The packet being processed was CE marked
+  bool             m_ecnCwrPending; //!< Set CWR in the next data segment
+  SequenceNumber32 m_ecnCwrPoint;   //!< Highest seqno sent when the window was reduced on an ECN-Echo
+
+  // Segmentation offload and pacing
+  uint32_t m_gsoMaxSegments; //!< Maximum number of segments of a super-segment
+  bool     m_pacing;         //!< Pacing enabled
+  uint32_t m_pacingSsRatio;  //!< Pacing rate in slow start, in percent of cwnd per RTT
+  uint32_t m_pacingCaRatio;  //!< Pacing rate in congestion avoidance, in percent of cwnd per RTT
+  EventId  m_pacingEvent;    //!< Departure of the next paced segment
+
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
 };
 
@@ -57,7 +57,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_firstByteOffset (0), m_sackedBytes (0)
 {
 }
 
@@ -111,7 +111,10 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          BufItem item;
+          item.packet = p;
+          item.offset = m_firstByteOffset + m_size;
+          m_data.push_back (item);
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -133,6 +136,24 @@ TcpTxBuffer::SizeFromSequence (const SequenceNumber32& seq) const
   return lastSeq - seq;
 }
 
+bool
+TcpTxBuffer::OffsetLess (uint64_t offset, const BufItem &item)
+{
+  return offset < item.offset;
+}
+
+TcpTxBuffer::BufIterator
+TcpTxBuffer::Find (uint32_t offset)
+{
+  NS_LOG_FUNCTION (this << offset);
+  NS_ASSERT (offset < m_size);
+  // the last packet starting at or before the offset
+  BufIterator i = std::upper_bound (m_data.begin (), m_data.end (),
+                                    m_firstByteOffset + offset, &TcpTxBuffer::OffsetLess);
+  NS_ASSERT (i != m_data.begin ());
+  return --i;
+}
+
 Ptr<Packet>
 TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 {
@@ -149,53 +170,39 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 
   // Extract data from the buffer and return
   uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
   Ptr<Packet> outPacket;
   NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  BufIterator i = Find (offset);
+  // Offset of the first byte of the packet in the buffer
+  uint32_t count = i->offset - m_firstByteOffset;
+  uint32_t pktSize = i->packet->GetSize ();
+  NS_LOG_LOGIC ("First byte found in packet #" << i - m_data.begin () + 1 << " at buffer offset " << count
+                                               << ", packet len=" << pktSize);
+  uint32_t packetOffset = offset - count;
+  uint32_t fragmentLength = count + pktSize - offset;
+  if (fragmentLength >= s)
+    { // Data to be copied falls entirely in this packet
+      return i->packet->CreateFragment (packetOffset, s);
+    }
+  // This packet only fulfills part of the request
+  outPacket = i->packet->CreateFragment (packetOffset, fragmentLength);
+  NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+  for (count += pktSize, ++i; i != m_data.end (); count += pktSize, ++i)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
+      pktSize = i->packet->GetSize ();
+      if (count + pktSize >= offset + s)
         { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
+          NS_LOG_LOGIC ("Last byte found in packet #" << i - m_data.begin () + 1 << " at buffer offset " << count
                                                       << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
+          fragmentLength = offset + s - count;
+          Ptr<Packet> endFragment = i->packet->CreateFragment (0, fragmentLength);
           outPacket->AddAtEnd (endFragment);
           NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
           break;
         }
-      else
-        {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-        }
-      count += pktSize;
+      NS_LOG_LOGIC ("Appending to output the packet #" << i - m_data.begin () + 1 << " of offset " << count << " len=" << pktSize);
+      outPacket->AddAtEnd (i->packet);
+      NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
     }
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
@@ -206,6 +213,7 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
   m_firstByteSeq = seq;
+  ResetScoreboard ();
 }
 
 void
@@ -221,24 +229,27 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
   uint32_t pktSize;
   NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  while (!m_data.empty ())
     {
-      if (offset > (*i)->GetSize ())
+      BufItem &head = m_data.front ();
+      if (offset > head.packet->GetSize ())
         { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
+          pktSize = head.packet->GetSize ();
           m_size -= pktSize;
           offset -= pktSize;
           m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
+          m_firstByteOffset += pktSize;
+          m_data.pop_front ();
           NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
         }
       else if (offset > 0)
         { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
+          pktSize = head.packet->GetSize () - offset;
+          head.packet = head.packet->CreateFragment (offset, pktSize);
+          head.offset += offset;
           m_size -= offset;
           m_firstByteSeq += offset;
+          m_firstByteOffset += offset;
           NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
           break;
         }
@@ -248,9 +259,242 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
     {
       m_firstByteSeq = seq;
     }
+  // Forget the SACKed ranges now acknowledged
+  while (!m_sacked.empty () && m_sacked.begin ()->first < m_firstByteOffset)
+    {
+      Scoreboard::iterator i = m_sacked.begin ();
+      if (i->second <= m_firstByteOffset || m_size == 0)
+        {
+          m_sackedBytes -= i->second - i->first;
+          m_sacked.erase (i);
+        }
+      else
+        {
+          uint64_t end = i->second;
+          m_sackedBytes -= m_firstByteOffset - i->first;
+          m_sacked.erase (i);
+          m_sacked[m_firstByteOffset] = end;
+          break;
+        }
+    }
   NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
                         <<" numPkts="<< m_data.size ());
   NS_ASSERT (m_firstByteSeq == seq);
 }
 
+uint64_t
+TcpTxBuffer::GetOffset (const SequenceNumber32 &seq) const
+{
+  NS_ASSERT (seq >= m_firstByteSeq);
+  return m_firstByteOffset + static_cast<uint32_t> (seq - m_firstByteSeq.Get ());
+}
+
+uint32_t
+TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t newlySacked = 0;
+  SequenceNumber32 tailSeq = TailSequence ();
+  for (TcpOptionSack::SackList::const_iterator it = list.begin (); it != list.end (); ++it)
+    {
+      SequenceNumber32 left = std::max (it->first, m_firstByteSeq.Get ());
+      SequenceNumber32 right = std::min (it->second, tailSeq);
+      if (right <= left)
+        { // Already acknowledged, or not in the buffer at all
+          NS_LOG_LOGIC ("Ignored SACK block [" << it->first << ";" << it->second << ")");
+          continue;
+        }
+      uint64_t begin = GetOffset (left);
+      uint64_t end = GetOffset (right);
+      // Merge the block with the ranges it overlaps or touches
+      uint64_t added = end - begin;
+      Scoreboard::iterator i = m_sacked.upper_bound (begin);
+      if (i != m_sacked.begin ())
+        {
+          Scoreboard::iterator prev = i;
+          --prev;
+          if (prev->second >= begin)
+            {
+              i = prev;
+            }
+        }
+      uint64_t first = begin;
+      uint64_t last = end;
+      while (i != m_sacked.end () && i->first <= end)
+        {
+          uint64_t overlapBegin = std::max (begin, i->first);
+          uint64_t overlapEnd = std::min (end, i->second);
+          if (overlapEnd > overlapBegin)
+            {
+              added -= overlapEnd - overlapBegin;
+            }
+          first = std::min (first, i->first);
+          last = std::max (last, i->second);
+          m_sacked.erase (i++);
+        }
+      m_sacked[first] = last;
+      newlySacked += added;
+      NS_LOG_LOGIC ("SACKed [" << left << ";" << right << "), " << added << " new bytes");
+    }
+  m_sackedBytes += newlySacked;
+  NS_LOG_LOGIC ("Scoreboard holds " << m_sacked.size () << " ranges, " << m_sackedBytes << " bytes");
+  return newlySacked;
+}
+
+void
+TcpTxBuffer::ResetScoreboard (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sacked.clear ();
+  m_sackedBytes = 0;
+}
+
+uint32_t
+TcpTxBuffer::GetSacked (void) const
+{
+  return m_sackedBytes;
+}
+
+bool
+TcpTxBuffer::IsSacked (const SequenceNumber32 &seq) const
+{
+  if (m_sacked.empty () || seq < m_firstByteSeq)
+    {
+      return false;
+    }
+  uint64_t offset = GetOffset (seq);
+  Scoreboard::const_iterator i = m_sacked.upper_bound (offset);
+  if (i == m_sacked.begin ())
+    {
+      return false;
+    }
+  --i;
+  return offset < i->second;
+}
+
+uint64_t
+TcpTxBuffer::SackedBetween (uint64_t begin, uint64_t end) const
+{
+  uint64_t sacked = 0;
+  Scoreboard::const_iterator i = m_sacked.upper_bound (begin);
+  if (i != m_sacked.begin ())
+    {
+      --i;
+    }
+  for (; i != m_sacked.end () && i->first < end; ++i)
+    {
+      uint64_t overlapBegin = std::max (begin, i->first);
+      uint64_t overlapEnd = std::min (end, i->second);
+      if (overlapEnd > overlapBegin)
+        {
+          sacked += overlapEnd - overlapBegin;
+        }
+    }
+  return sacked;
+}
+
+uint64_t
+TcpTxBuffer::GetLostBoundary (uint32_t dupThresh, uint32_t segmentSize) const
+{
+  // The number of bytes and of ranges SACKed above a byte only grow as
+  // the byte goes down, so the bytes not SACKed under the start of the
+  // first range (from the top) meeting the criteria are all lost, and the
+  // ones above it are not.
+  uint64_t sackedAbove = 0;
+  uint32_t rangesAbove = 0;
+  for (Scoreboard::const_reverse_iterator i = m_sacked.rbegin (); i != m_sacked.rend (); ++i)
+    {
+      sackedAbove += i->second - i->first;
+      ++rangesAbove;
+      if (rangesAbove >= dupThresh
+          || sackedAbove > static_cast<uint64_t> (dupThresh - 1) * segmentSize)
+        {
+          return i->first;
+        }
+    }
+  return m_firstByteOffset;
+}
+
+bool
+TcpTxBuffer::IsLost (const SequenceNumber32 &seq, uint32_t dupThresh, uint32_t segmentSize) const
+{
+  if (seq < m_firstByteSeq || seq >= TailSequence () || IsSacked (seq))
+    {
+      return false;
+    }
+  return GetOffset (seq) < GetLostBoundary (dupThresh, segmentSize);
+}
+
+uint32_t
+TcpTxBuffer::BytesInFlight (const SequenceNumber32 &highTx, const SequenceNumber32 &highRxt,
+                            uint32_t dupThresh, uint32_t segmentSize) const
+{
+  if (highTx <= m_firstByteSeq)
+    {
+      return 0;
+    }
+  uint64_t head = m_firstByteOffset;
+  uint64_t highData = GetOffset (std::min (highTx, TailSequence ()));
+  uint64_t lost = std::min (GetLostBoundary (dupThresh, segmentSize), highData);
+  uint64_t retransmitted = head;
+  if (highRxt > m_firstByteSeq)
+    {
+      retransmitted = std::min (GetOffset (highRxt), highData);
+    }
+  // Every byte sent, minus the SACKed and the lost ones, plus the
+  // retransmitted ones which are not SACKed
+  uint64_t pipe = (highData - head) - SackedBetween (head, highData);
+  pipe -= (lost - head) - SackedBetween (head, lost);
+  pipe += (retransmitted - head) - SackedBetween (head, retransmitted);
+  return pipe;
+}
+
+bool
+TcpTxBuffer::NextSeg (const SequenceNumber32 &highTx, const SequenceNumber32 &highRxt,
+                      uint32_t dupThresh, uint32_t segmentSize, bool lostOnly,
+                      SequenceNumber32 &seq, uint32_t &length) const
+{
+  NS_LOG_FUNCTION (this << highTx << highRxt << dupThresh << segmentSize << lostOnly);
+  if (highTx <= m_firstByteSeq)
+    {
+      return false;
+    }
+  uint64_t limit = GetOffset (std::min (highTx, TailSequence ()));
+  if (lostOnly)
+    {
+      limit = std::min (limit, GetLostBoundary (dupThresh, segmentSize));
+    }
+  uint64_t offset = m_firstByteOffset;
+  if (highRxt > m_firstByteSeq)
+    {
+      offset = GetOffset (highRxt);
+    }
+  // Skip the SACKed range holding the byte, if any; the ranges being
+  // merged, the byte following it is not SACKed
+  Scoreboard::const_iterator i = m_sacked.upper_bound (offset);
+  if (i != m_sacked.begin ())
+    {
+      Scoreboard::const_iterator prev = i;
+      --prev;
+      if (prev->second > offset)
+        {
+          offset = prev->second;
+        }
+    }
+  if (offset >= limit)
+    {
+      return false;
+    }
+  uint64_t end = offset + segmentSize;
+  if (i != m_sacked.end ())
+    {
+      end = std::min (end, i->first);
+    }
+  end = std::min (end, GetOffset (std::min (highTx, TailSequence ())));
+  seq = m_firstByteSeq + SequenceNumber32 (static_cast<uint32_t> (offset - m_firstByteOffset));
+  length = static_cast<uint32_t> (end - offset);
+  NS_LOG_LOGIC ("Next segment to retransmit: " << seq << ", length " << length);
+  return true;
+}
+
 } // namepsace ns3
@@ -21,12 +21,14 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
+#include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +38,17 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets given by the application are kept along with the offset of
+ * their first byte in the stream, so that the packet holding a given
+ * sequence number is found by a binary search rather than by walking the
+ * buffer from its head, whatever the size of the window.
+ *
+ * The buffer also keeps the scoreboard of \RFC{6675}: the ranges of
+ * unacknowledged data reported as received by the SACK options of the
+ * peer.  The ranges are merged as they are reported, so that the
+ * scoreboard holds one entry per contiguous range whatever the number of
+ * segments, and the loss detection only visits the few highest ranges.
  */
 class TcpTxBuffer : public Object
 {
@@ -127,14 +140,145 @@ public:
    */
   void DiscardUpTo (const SequenceNumber32& seq);
 
+  /**
+   * \brief Update the scoreboard with the blocks of a SACK option
+   *
+   * The parts of the blocks outside of the buffer are ignored.
+   *
+   * \param list the SACK blocks received
+   * \returns the number of bytes newly marked as SACKed
+   */
+  uint32_t Update (const TcpOptionSack::SackList &list);
+
+  /**
+   * \brief Forget all the SACK information
+   */
+  void ResetScoreboard (void);
+
+  /**
+   * \brief Get the number of SACKed bytes in the buffer
+   * \returns the number of SACKed bytes
+   */
+  uint32_t GetSacked (void) const;
+
+  /**
+   * \brief Check if a byte has been SACKed
+   * \param seq the sequence number of the byte
+   * \returns true if the byte is marked as SACKed in the scoreboard
+   */
+  bool IsSacked (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Check if a byte is considered lost (IsLost of \RFC{6675})
+   *
+   * A byte which is not SACKed is lost when dupThresh discontiguous ranges,
+   * or more than (dupThresh - 1) * segmentSize bytes, have been SACKed
+   * above it.
+   *
+   * \param seq the sequence number of the byte
+   * \param dupThresh the duplicate ACK threshold
+   * \param segmentSize the segment size
+   * \returns true if the byte is considered lost
+   */
+  bool IsLost (const SequenceNumber32 &seq, uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief Estimate the number of bytes in flight (SetPipe of \RFC{6675})
+   *
+   * Every byte sent and not yet acknowledged counts once if it is neither
+   * SACKed nor lost, plus once if it has been retransmitted during the
+   * loss recovery.
+   *
+   * \param highTx the sequence number following the highest byte sent (HighData)
+   * \param highRxt the sequence number following the highest byte retransmitted (HighRxt)
+   * \param dupThresh the duplicate ACK threshold
+   * \param segmentSize the segment size
+   * \returns the number of bytes in flight
+   */
+  uint32_t BytesInFlight (const SequenceNumber32 &highTx, const SequenceNumber32 &highRxt,
+                          uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief Find the next data to retransmit (rules 1 and 3 of NextSeg of \RFC{6675})
+   *
+   * Look for the first byte not SACKed, sent and not retransmitted yet
+   * during the loss recovery, which must also be lost when lostOnly is
+   * true.  The segment returned is cut at the next SACKed range.
+   *
+   * \param highTx the sequence number following the highest byte sent (HighData)
+   * \param highRxt the sequence number following the highest byte retransmitted (HighRxt)
+   * \param dupThresh the duplicate ACK threshold
+   * \param segmentSize the segment size
+   * \param lostOnly only look for lost bytes
+   * \param seq the sequence number of the segment, if any
+   * \param length the length of the segment, if any
+   * \returns true if a segment to retransmit has been found
+   */
+  bool NextSeg (const SequenceNumber32 &highTx, const SequenceNumber32 &highRxt,
+                uint32_t dupThresh, uint32_t segmentSize, bool lostOnly,
+                SequenceNumber32 &seq, uint32_t &length) const;
+
 private:
+  /**
+   * \brief A packet stored in the buffer.
+   */
+  struct BufItem
+  {
+    Ptr<Packet> packet; //!< the data
+    uint64_t offset;    //!< offset of the first byte of the packet in the stream
+  };
+
   /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  typedef std::deque<BufItem>::iterator BufIterator;
+
+  /**
+   * \brief Find the packet holding a byte.
+   * \param offset offset of the byte from the head of the buffer
+   * \returns an iterator to the packet holding the byte
+   */
+  BufIterator Find (uint32_t offset);
+
+  /**
+   * \brief Compare the stream offset of a packet with an offset.
+   * \param offset the offset
+   * \param item the packet
+   * \returns true if offset is before the first byte of item
+   */
+  static bool OffsetLess (uint64_t offset, const BufItem &item);
+
+  /// SACKed ranges of the scoreboard, as [first offset, last offset + 1)
+  typedef std::map<uint64_t, uint64_t> Scoreboard;
+
+  /**
+   * \brief Get the stream offset of a byte of the buffer
+   * \param seq the sequence number of the byte, not lower than the head
+   * \returns the stream offset of the byte
+   */
+  uint64_t GetOffset (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Get the number of SACKed bytes in a range
+   * \param begin the stream offset of the first byte of the range
+   * \param end the stream offset following the last byte of the range
+   * \returns the number of SACKed bytes in [begin, end)
+   */
+  uint64_t SackedBetween (uint64_t begin, uint64_t end) const;
+
+  /**
+   * \brief Get the stream offset under which every byte not SACKed is lost
+   * \param dupThresh the duplicate ACK threshold
+   * \param segmentSize the segment size
+   * \returns the start of the highest SACKed range making the bytes below it lost
+   */
+  uint64_t GetLostBoundary (uint32_t dupThresh, uint32_t segmentSize) const;
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  uint64_t m_firstByteOffset;                   //!< Stream offset of the first byte in data
+  std::deque<BufItem> m_data;                   //!< Corresponding data (may be null)
+  Scoreboard m_sacked;                          //!< SACKed ranges
+  uint32_t m_sackedBytes;                       //!< Number of SACKed bytes
 };
 
 } // namepsace ns3
@@ -118,29 +118,29 @@ TcpWestwood::NewAck (const SequenceNumber32& seq)
 { // Same as Reno
   NS_LOG_FUNCTION (this << seq);
   NS_LOG_LOGIC ("TcpWestwood receieved ACK for seq " << seq <<
-                " cwnd " << m_cWnd <<
-                " ssthresh " << m_ssThresh);
+                " cwnd " << m_tcb->m_cWnd <<
+                " ssthresh " << m_tcb->m_ssThresh);
 
   // Check for exit condition of fast recovery
   if (m_inFastRec)
     {// First new ACK after fast recovery, reset cwnd as in Reno
-      m_cWnd = m_ssThresh;
+      m_tcb->m_cWnd = m_tcb->m_ssThresh;
       m_inFastRec = false;
-      NS_LOG_INFO ("Reset cwnd to " << m_cWnd);
+      NS_LOG_INFO ("Reset cwnd to " << m_tcb->m_cWnd);
     };
 
   // Increase of cwnd based on current phase (slow start or congestion avoidance)
-  if (m_cWnd < m_ssThresh)
+  if (m_tcb->m_cWnd < m_tcb->m_ssThresh)
     { // Slow start mode, add one segSize to cWnd as in Reno
-      m_cWnd += m_segmentSize;
-      NS_LOG_INFO ("In SlowStart, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+      m_tcb->m_cWnd += m_segmentSize;
+      NS_LOG_INFO ("In SlowStart, updated to cwnd " << m_tcb->m_cWnd << " ssthresh " << m_tcb->m_ssThresh);
     }
   else
     { // Congestion avoidance mode, increase by (segSize*segSize)/cwnd as in Reno
-      double adder = static_cast<double> (m_segmentSize * m_segmentSize) / m_cWnd.Get();
+      double adder = static_cast<double> (m_segmentSize * m_segmentSize) / m_tcb->m_cWnd.Get();
       adder = std::max(1.0, adder);
-      m_cWnd += static_cast<uint32_t>(adder);
-      NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+      m_tcb->m_cWnd += static_cast<uint32_t>(adder);
+      NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_tcb->m_cWnd << " ssthresh " << m_tcb->m_ssThresh);
     }
 
   // Complete newAck processing
@@ -241,24 +241,24 @@ TcpWestwood::UpdateAckedSegments (int acked)
 void
 TcpWestwood::DupAck (const TcpHeader& header, uint32_t count)
 {
-  NS_LOG_FUNCTION (this << count << m_cWnd);
+  NS_LOG_FUNCTION (this << count << m_tcb->m_cWnd);
 
   if (count == 3 && !m_inFastRec)
     {// Triple duplicate ACK triggers fast retransmit
      // Adjust cwnd and ssthresh based on the estimated BW
-      m_ssThresh = uint32_t(m_currentBW * static_cast<double> (m_minRtt.GetSeconds()));
-      if (m_cWnd > m_ssThresh)
+      m_tcb->m_ssThresh = uint32_t(m_currentBW * static_cast<double> (m_minRtt.GetSeconds()));
+      if (m_tcb->m_cWnd > m_tcb->m_ssThresh)
         {
-          m_cWnd = m_ssThresh;
+          m_tcb->m_cWnd = m_tcb->m_ssThresh;
         }
       m_inFastRec = true;
-      NS_LOG_INFO ("Triple dupack. Enter fast recovery mode. Reset cwnd to " << m_cWnd <<", ssthresh to " << m_ssThresh);
+      NS_LOG_INFO ("Triple dupack. Enter fast recovery mode. Reset cwnd to " << m_tcb->m_cWnd <<", ssthresh to " << m_tcb->m_ssThresh);
       DoRetransmit ();
     }
   else if (m_inFastRec)
     {// Increase cwnd for every additional DUPACK as in Reno
-      m_cWnd += m_segmentSize;
-      NS_LOG_INFO ("Dupack in fast recovery mode. Increase cwnd to " << m_cWnd);
+      m_tcb->m_cWnd += m_segmentSize;
+      NS_LOG_INFO ("Dupack in fast recovery mode. Increase cwnd to " << m_tcb->m_cWnd);
       if (!m_sendPendingDataEvent.IsRunning ())
         {
           SendPendingData (m_connected);
@@ -281,18 +281,25 @@ TcpWestwood::Retransmit (void)
     return;
 
   // Upon an RTO, adjust cwnd and ssthresh based on the estimated BW
-  m_ssThresh = std::max (static_cast<double> (2 * m_segmentSize), m_currentBW.Get () * static_cast<double> (m_minRtt.GetSeconds ()));
-  m_cWnd = m_segmentSize;
+  m_tcb->m_ssThresh = std::max (static_cast<double> (2 * m_segmentSize), m_currentBW.Get () * static_cast<double> (m_minRtt.GetSeconds ()));
+  m_tcb->m_cWnd = m_segmentSize;
 
   // Restart from highest ACK
   m_nextTxSequence = m_txBuffer->HeadSequence ();
-  NS_LOG_INFO ("RTO. Reset cwnd to " << m_cWnd <<
-      ", ssthresh to " << m_ssThresh << ", restart from seqnum " << m_nextTxSequence);
+  NS_LOG_INFO ("RTO. Reset cwnd to " << m_tcb->m_cWnd <<
+      ", ssthresh to " << m_tcb->m_ssThresh << ", restart from seqnum " << m_nextTxSequence);
 
   // Retransmit the packet
   DoRetransmit ();
 }
 
+uint32_t
+TcpWestwood::GetSsThreshOnLoss (void)
+{
+  // Adjust ssthresh based on the estimated BW
+  return static_cast<uint32_t> (std::max (static_cast<double> (2 * m_segmentSize), m_currentBW.Get () * static_cast<double> (m_minRtt.GetSeconds ())));
+}
+
 void
 TcpWestwood::EstimateRtt (const TcpHeader& tcpHeader)
 {
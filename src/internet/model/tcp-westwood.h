@@ -99,6 +99,7 @@ protected:
   virtual void NewAck (SequenceNumber32 const& seq); // Inc cwnd and call NewAck() of parent
   virtual void DupAck (const TcpHeader& t, uint32_t count);  // Treat 3 dupack as timeout
   virtual void Retransmit (void); // Retransmit time out
+  virtual uint32_t GetSsThreshOnLoss (void); // Estimated BW times min RTT
 
   /**
    * Process the newly received ACK
@@ -0,0 +1,508 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Check the indexed end point demultiplexers against a linear scan of
+// the end points, which is how they used to be implemented.
+
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-end-point-demux.h"
+#include "ns3/ipv6-end-point.h"
+#include "ns3/ipv6-interface.h"
+
+using namespace ns3;
+
+namespace {
+
+std::list<Ipv4EndPoint *>
+ReferenceLookup (std::list<Ipv4EndPoint *> &endPoints,
+                 Ipv4Address daddr, uint16_t dport,
+                 Ipv4Address saddr, uint16_t sport,
+                 Ptr<Ipv4Interface> incomingInterface)
+{
+  std::list<Ipv4EndPoint *> retval1, retval2, retval3, retval4;
+  for (std::list<Ipv4EndPoint *>::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      Ipv4EndPoint* endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      bool subnetDirected = false;
+      Ipv4Address incomingInterfaceAddr = daddr;
+      for (uint32_t j = 0; j < incomingInterface->GetNAddresses (); j++)
+        {
+          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (j);
+          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+            {
+              subnetDirected = true;
+              incomingInterfaceAddr = addr.GetLocal ();
+            }
+        }
+      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv4Address::GetAny ();
+      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+        {
+          localAddressMatchesExact = (endP->GetLocalAddress () == incomingInterfaceAddr);
+        }
+      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+        continue;
+      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+        continue;
+      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+        continue;
+      if (localAddressMatchesWildCard && remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        retval1.push_back (endP);
+      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard)) &&
+          remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        retval2.push_back (endP);
+      if (localAddressMatchesWildCard && remotePeerMatchesExact && remoteAddressMatchesExact)
+        retval3.push_back (endP);
+      if (localAddressMatchesExact && remotePeerMatchesExact && remoteAddressMatchesExact)
+        retval4.push_back (endP);
+    }
+  if (!retval4.empty ()) return retval4;
+  if (!retval3.empty ()) return retval3;
+  if (!retval2.empty ()) return retval2;
+  return retval1;
+}
+
+std::list<Ipv6EndPoint *>
+ReferenceLookup (std::list<Ipv6EndPoint *> &endPoints,
+                 Ipv6Address daddr, uint16_t dport,
+                 Ipv6Address saddr, uint16_t sport)
+{
+  std::list<Ipv6EndPoint *> retval1, retval2, retval3, retval4;
+  for (std::list<Ipv6EndPoint *>::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      Ipv6EndPoint* endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+      bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+        continue;
+      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+        continue;
+      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+        continue;
+      if (localAddressMatchesWildCard && remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        retval1.push_back (endP);
+      if ((localAddressMatchesExact || localAddressMatchesAllRouters) &&
+          remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        retval2.push_back (endP);
+      if (localAddressMatchesWildCard && remotePeerMatchesExact && remoteAddressMatchesExact)
+        retval3.push_back (endP);
+      if (localAddressMatchesExact && remotePeerMatchesExact && remoteAddressMatchesExact)
+        retval4.push_back (endP);
+    }
+  if (!retval4.empty ()) return retval4;
+  if (!retval3.empty ()) return retval3;
+  if (!retval2.empty ()) return retval2;
+  return retval1;
+}
+
+template <typename EndPoint, typename Address>
+EndPoint *
+ReferenceSimpleLookup (std::list<EndPoint *> &endPoints,
+                       Address daddr, uint16_t dport,
+                       Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  EndPoint *generic = 0;
+  for (typename std::list<EndPoint *>::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport &&
+          (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = 0;
+      if ((*i)->GetLocalAddress () == Address::GetAny ())
+        {
+          tmp++;
+        }
+      if ((*i)->GetPeerAddress () == Address::GetAny ())
+        {
+          tmp++;
+        }
+      if (tmp < genericity)
+        {
+          generic = (*i);
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+} // anonymous namespace
+
+/**
+ * \brief Ipv4EndPointDemux lookups and allocations against a linear scan.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Compare the demux lookups with the reference ones.
+   * \param demux the demux
+   * \param endPoints the reference end points, in allocation order
+   */
+  void Check (Ipv4EndPointDemux &demux, std::list<Ipv4EndPoint *> &endPoints);
+
+  Ptr<UniformRandomVariable> m_rng;  //!< random variable
+  Ptr<Ipv4Interface> m_interface;    //!< incoming interface
+  std::vector<Ipv4Address> m_addresses; //!< addresses used by the test
+  std::vector<uint16_t> m_ports;     //!< ports used by the test
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux matches a linear scan of its end points")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::Check (Ipv4EndPointDemux &demux, std::list<Ipv4EndPoint *> &endPoints)
+{
+  for (uint32_t d = 0; d < m_addresses.size (); d++)
+    {
+      for (uint32_t s = 0; s < m_addresses.size (); s++)
+        {
+          for (uint32_t dp = 0; dp < m_ports.size (); dp++)
+            {
+              for (uint32_t sp = 0; sp < m_ports.size (); sp++)
+                {
+                  std::list<Ipv4EndPoint *> expected = ReferenceLookup (endPoints, m_addresses[d], m_ports[dp],
+                                                                        m_addresses[s], m_ports[sp], m_interface);
+                  std::list<Ipv4EndPoint *> got = demux.Lookup (m_addresses[d], m_ports[dp],
+                                                                m_addresses[s], m_ports[sp], m_interface);
+                  NS_TEST_EXPECT_MSG_EQ ((got == expected), true, "Lookup (" << m_addresses[d] << ":" << m_ports[dp]
+                                         << ", " << m_addresses[s] << ":" << m_ports[sp] << ") differs");
+                  Ipv4EndPoint *simple = ReferenceSimpleLookup (endPoints, m_addresses[d], m_ports[dp],
+                                                                m_addresses[s], m_ports[sp]);
+                  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (m_addresses[d], m_ports[dp], m_addresses[s], m_ports[sp]),
+                                         simple, "SimpleLookup differs");
+                }
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ ((demux.GetAllEndPoints () == endPoints), true, "End point order differs");
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+  m_addresses.push_back (Ipv4Address::GetAny ());
+  m_addresses.push_back (Ipv4Address ("10.0.0.1"));
+  m_addresses.push_back (Ipv4Address ("10.0.0.2"));
+  m_addresses.push_back (Ipv4Address ("10.0.0.255"));
+  m_addresses.push_back (Ipv4Address ("10.0.1.1"));
+  m_addresses.push_back (Ipv4Address::GetBroadcast ());
+  m_ports.push_back (0);
+  m_ports.push_back (80);
+  m_ports.push_back (1234);
+
+  Ipv4EndPointDemux demux;
+  std::list<Ipv4EndPoint *> endPoints;
+  for (uint32_t step = 0; step < 300; step++)
+    {
+      Ipv4Address local = m_addresses[m_rng->GetInteger (0, m_addresses.size () - 2)];
+      Ipv4Address peer = m_addresses[m_rng->GetInteger (0, m_addresses.size () - 2)];
+      uint16_t localPort = m_ports[m_rng->GetInteger (1, m_ports.size () - 1)];
+      uint16_t peerPort = m_ports[m_rng->GetInteger (0, m_ports.size () - 1)];
+      Ipv4EndPoint *endPoint = 0;
+      switch (m_rng->GetInteger (0, 5))
+        {
+        case 0:
+          endPoint = demux.Allocate (local, localPort);
+          break;
+        case 1:
+        case 2:
+          endPoint = demux.Allocate (local, localPort, peer, peerPort);
+          break;
+        case 3:
+          if (!endPoints.empty ())
+            {
+              std::list<Ipv4EndPoint *>::iterator i = endPoints.begin ();
+              std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+              if (m_rng->GetInteger (0, 1))
+                {
+                  (*i)->SetPeer (peer, peerPort);
+                }
+              else
+                {
+                  (*i)->SetLocalAddress (local);
+                }
+            }
+          break;
+        case 4:
+          if (!endPoints.empty ())
+            {
+              std::list<Ipv4EndPoint *>::iterator i = endPoints.begin ();
+              std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+              (*i)->SetRxEnabled (!(*i)->IsRxEnabled ());
+            }
+          break;
+        case 5:
+          if (!endPoints.empty ())
+            {
+              std::list<Ipv4EndPoint *>::iterator i = endPoints.begin ();
+              std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+              Ipv4EndPoint *victim = *i;
+              endPoints.erase (i);
+              demux.DeAllocate (victim);
+            }
+          break;
+        }
+      if (endPoint != 0)
+        {
+          endPoints.push_back (endPoint);
+        }
+      for (uint32_t p = 0; p < m_ports.size (); p++)
+        {
+          bool used = false;
+          for (std::list<Ipv4EndPoint *>::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+            {
+              used |= (*i)->GetLocalPort () == m_ports[p];
+            }
+          NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (m_ports[p]), used, "LookupPortLocal differs");
+        }
+      if (step % 10 == 0)
+        {
+          Check (demux, endPoints);
+        }
+    }
+  Check (demux, endPoints);
+
+  // the ephemeral ports are handed out in sequence, wrap around, and
+  // freed ports are reused once the range is exhausted
+  Ipv4EndPointDemux ephemeral;
+  std::vector<Ipv4EndPoint *> allocated;
+  for (uint32_t port = 49153; port <= 65535; port++)
+    {
+      allocated.push_back (ephemeral.Allocate ());
+      NS_TEST_ASSERT_MSG_NE (allocated.back (), 0, "Allocation failed");
+      NS_TEST_ASSERT_MSG_EQ (allocated.back ()->GetLocalPort (), port, "Unexpected ephemeral port");
+    }
+  allocated.push_back (ephemeral.Allocate ());
+  NS_TEST_ASSERT_MSG_NE (allocated.back (), 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (allocated.back ()->GetLocalPort (), 49152, "Ephemeral port did not wrap around");
+  NS_TEST_EXPECT_MSG_EQ (ephemeral.Allocate (), 0, "Allocation succeeded with all ports used");
+  ephemeral.DeAllocate (allocated[50000 - 49153]);
+  ephemeral.DeAllocate (allocated[60000 - 49153]);
+  Ipv4EndPoint *reused = ephemeral.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (reused, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (reused->GetLocalPort (), 50000, "Freed port not reused");
+  reused = ephemeral.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (reused, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (reused->GetLocalPort (), 60000, "Freed port not reused");
+  NS_TEST_EXPECT_MSG_EQ (ephemeral.Allocate (), 0, "Allocation succeeded with all ports used");
+}
+
+/**
+ * \brief Ipv6EndPointDemux lookups and allocations against a linear scan.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Compare the demux lookups with the reference ones.
+   * \param demux the demux
+   * \param endPoints the reference end points, in allocation order
+   */
+  void Check (Ipv6EndPointDemux &demux, std::list<Ipv6EndPoint *> &endPoints);
+
+  Ptr<UniformRandomVariable> m_rng;  //!< random variable
+  std::vector<Ipv6Address> m_addresses; //!< addresses used by the test
+  std::vector<uint16_t> m_ports;     //!< ports used by the test
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Ipv6EndPointDemux matches a linear scan of its end points")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::Check (Ipv6EndPointDemux &demux, std::list<Ipv6EndPoint *> &endPoints)
+{
+  for (uint32_t d = 0; d < m_addresses.size (); d++)
+    {
+      for (uint32_t s = 0; s < m_addresses.size (); s++)
+        {
+          for (uint32_t dp = 0; dp < m_ports.size (); dp++)
+            {
+              for (uint32_t sp = 0; sp < m_ports.size (); sp++)
+                {
+                  std::list<Ipv6EndPoint *> expected = ReferenceLookup (endPoints, m_addresses[d], m_ports[dp],
+                                                                        m_addresses[s], m_ports[sp]);
+                  std::list<Ipv6EndPoint *> got = demux.Lookup (m_addresses[d], m_ports[dp],
+                                                                m_addresses[s], m_ports[sp], 0);
+                  NS_TEST_EXPECT_MSG_EQ ((got == expected), true, "Lookup (" << m_addresses[d] << ":" << m_ports[dp]
+                                         << ", " << m_addresses[s] << ":" << m_ports[sp] << ") differs");
+                  Ipv6EndPoint *simple = ReferenceSimpleLookup (endPoints, m_addresses[d], m_ports[dp],
+                                                                m_addresses[s], m_ports[sp]);
+                  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (m_addresses[d], m_ports[dp], m_addresses[s], m_ports[sp]),
+                                         simple, "SimpleLookup differs");
+                }
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ ((demux.GetEndPoints () == endPoints), true, "End point order differs");
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_addresses.push_back (Ipv6Address::GetAny ());
+  m_addresses.push_back (Ipv6Address ("2001:1::1"));
+  m_addresses.push_back (Ipv6Address ("2001:1::2"));
+  m_addresses.push_back (Ipv6Address ("fe80::1"));
+  m_addresses.push_back (Ipv6Address::GetAllRoutersMulticast ());
+  m_ports.push_back (0);
+  m_ports.push_back (80);
+  m_ports.push_back (1234);
+
+  Ipv6EndPointDemux demux;
+  std::list<Ipv6EndPoint *> endPoints;
+  for (uint32_t step = 0; step < 300; step++)
+    {
+      Ipv6Address local = m_addresses[m_rng->GetInteger (0, m_addresses.size () - 1)];
+      Ipv6Address peer = m_addresses[m_rng->GetInteger (0, m_addresses.size () - 2)];
+      uint16_t localPort = m_ports[m_rng->GetInteger (1, m_ports.size () - 1)];
+      uint16_t peerPort = m_ports[m_rng->GetInteger (0, m_ports.size () - 1)];
+      Ipv6EndPoint *endPoint = 0;
+      switch (m_rng->GetInteger (0, 5))
+        {
+        case 0:
+          endPoint = demux.Allocate (local, localPort);
+          break;
+        case 1:
+        case 2:
+          endPoint = demux.Allocate (local, localPort, peer, peerPort);
+          break;
+        case 3:
+          if (!endPoints.empty ())
+            {
+              std::list<Ipv6EndPoint *>::iterator i = endPoints.begin ();
+              std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+              switch (m_rng->GetInteger (0, 2))
+                {
+                case 0:
+                  (*i)->SetPeer (peer, peerPort);
+                  break;
+                case 1:
+                  (*i)->SetLocalAddress (local);
+                  break;
+                default:
+                  (*i)->SetLocalPort (localPort);
+                  break;
+                }
+            }
+          break;
+        case 4:
+          if (!endPoints.empty ())
+            {
+              std::list<Ipv6EndPoint *>::iterator i = endPoints.begin ();
+              std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+              (*i)->SetRxEnabled (!(*i)->IsRxEnabled ());
+            }
+          break;
+        case 5:
+          if (!endPoints.empty ())
+            {
+              std::list<Ipv6EndPoint *>::iterator i = endPoints.begin ();
+              std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+              Ipv6EndPoint *victim = *i;
+              endPoints.erase (i);
+              demux.DeAllocate (victim);
+            }
+          break;
+        }
+      if (endPoint != 0)
+        {
+          endPoints.push_back (endPoint);
+        }
+      for (uint32_t p = 0; p < m_ports.size (); p++)
+        {
+          bool used = false;
+          for (std::list<Ipv6EndPoint *>::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+            {
+              used |= (*i)->GetLocalPort () == m_ports[p];
+            }
+          NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (m_ports[p]), used, "LookupPortLocal differs");
+        }
+      if (step % 10 == 0)
+        {
+          Check (demux, endPoints);
+        }
+    }
+  Check (demux, endPoints);
+
+  Ipv6EndPointDemux ephemeral;
+  Ipv6EndPoint *first = ephemeral.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (first, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (first->GetLocalPort (), 49153, "Unexpected ephemeral port");
+  // a port taken explicitly is skipped
+  ephemeral.Allocate (49154);
+  Ipv6EndPoint *second = ephemeral.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (second, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (second->GetLocalPort (), 49155, "Used ephemeral port not skipped");
+}
+
+/**
+ * \brief End point demultiplexers TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite () : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+  }
+};
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite;
@@ -213,6 +213,93 @@ GlobalRouteManagerImplTestCase::DoRun (void)
   // does not crash
 }
 
+/**
+ * Check the priority order of the CandidateQueue: increasing distance,
+ * network vertices before router vertices at equal distance, then push
+ * order; and that Update moves a vertex whose distance decreased.
+ */
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * \param id the vertex ID
+   * \param type the vertex type
+   * \param distance the distance from the root
+   * \return a new vertex
+   */
+  static SPFVertex * MakeVertex (const char *id, SPFVertex::VertexType type, uint32_t distance);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("CandidateQueue priority order and decrease-key")
+{
+}
+
+SPFVertex *
+CandidateQueueTestCase::MakeVertex (const char *id, SPFVertex::VertexType type, uint32_t distance)
+{
+  SPFVertex *v = new SPFVertex;
+  v->SetVertexId (Ipv4Address (id));
+  v->SetVertexType (type);
+  v->SetDistanceFromRoot (distance);
+  return v;
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  candidate.Push (MakeVertex ("10.0.0.1", SPFVertex::VertexRouter, 5));
+  candidate.Push (MakeVertex ("10.0.0.2", SPFVertex::VertexRouter, 3));
+  candidate.Push (MakeVertex ("10.0.0.3", SPFVertex::VertexNetwork, 5));
+  candidate.Push (MakeVertex ("10.0.0.4", SPFVertex::VertexRouter, 3));
+  candidate.Push (MakeVertex ("10.0.0.5", SPFVertex::VertexRouter, 9));
+  candidate.Push (MakeVertex ("10.0.0.6", SPFVertex::VertexRouter, 1));
+  NS_TEST_ASSERT_MSG_EQ (candidate.Size (), 6, "Wrong queue size");
+
+  SPFVertex *v = candidate.Find (Ipv4Address ("10.0.0.5"));
+  NS_TEST_ASSERT_MSG_NE (v, 0, "Vertex not found");
+  NS_TEST_EXPECT_MSG_EQ (v->GetDistanceFromRoot (), 9, "Wrong vertex found");
+  NS_TEST_EXPECT_MSG_EQ (candidate.Find (Ipv4Address ("10.0.0.7")), 0, "Unexpected vertex found");
+  // a decreased vertex goes after the vertices already at its new distance
+  v->SetDistanceFromRoot (3);
+  candidate.Update (v);
+  NS_TEST_EXPECT_MSG_EQ (candidate.Size (), 6, "Wrong queue size after update");
+  // a decreased vertex can become the top
+  v = candidate.Find (Ipv4Address ("10.0.0.1"));
+  v->SetDistanceFromRoot (0);
+  candidate.Update (v);
+  NS_TEST_EXPECT_MSG_EQ (candidate.Top (), v, "Updated vertex not on top");
+
+  const char *expected[] = { "10.0.0.1", "10.0.0.6", "10.0.0.2", "10.0.0.4", "10.0.0.5", "10.0.0.3" };
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_NE (v, 0, "Queue empty too early");
+      NS_TEST_EXPECT_MSG_EQ (v->GetVertexId (), Ipv4Address (expected[i]), "Wrong pop order at " << i);
+      NS_TEST_EXPECT_MSG_EQ (candidate.Find (v->GetVertexId ()), 0, "Popped vertex still found");
+      delete v;
+    }
+  NS_TEST_EXPECT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+  NS_TEST_EXPECT_MSG_EQ (candidate.Pop (), 0, "Pop on an empty queue");
+
+  // random distances are popped in non-decreasing order
+  for (int i = 0; i < 100; ++i)
+    {
+      candidate.Push (MakeVertex ("10.0.1.1", SPFVertex::VertexRouter, std::rand () % 100));
+    }
+  uint32_t last = 0;
+  for (int i = 0; i < 100; ++i)
+    {
+      v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (v->GetDistanceFromRoot (), last, "Pop order not by distance");
+      last = v->GetDistanceFromRoot ();
+      delete v;
+    }
+}
 
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
@@ -221,5 +308,6 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
@@ -14,6 +14,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <sstream>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
@@ -21,6 +22,9 @@
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
@@ -419,6 +423,260 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check the host, network and AS external route precedence, ECMP and
+ * output interface rules of Ipv4GlobalRouting lookups, and that routes
+ * are cached until the routing table changes.
+ */
+class Ipv4GlobalRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param dest the destination
+   * \param oif the output device, or 0
+   * \return the route to dest
+   */
+  Ptr<Ipv4Route> GetRoute (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  /**
+   * \param dest the destination
+   * \param oif the output device, or 0
+   * \return the gateway of the route to dest, or 0.0.0.0 if none
+   */
+  Ipv4Address GetGateway (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+
+  Ptr<Ipv4GlobalRouting> m_routing;  //!< routing protocol under test
+};
+
+Ipv4GlobalRoutingLookupTestCase::Ipv4GlobalRoutingLookupTestCase ()
+  : TestCase ("Global routing lookup rules and route caching")
+{
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRoutingLookupTestCase::GetRoute (Ipv4Address dest, Ptr<NetDevice> oif)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  return m_routing->RouteOutput (Create<Packet> (), header, oif, sockerr);
+}
+
+Ipv4Address
+Ipv4GlobalRoutingLookupTestCase::GetGateway (Ipv4Address dest, Ptr<NetDevice> oif)
+{
+  Ptr<Ipv4Route> route = GetRoute (dest, oif);
+  if (route == 0)
+    {
+      return Ipv4Address::GetZero ();
+    }
+  return route->GetGateway ();
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+
+  // interfaces 1 to 3 on 10.0.1.0/24 to 10.0.3.0/24
+  std::vector<Ptr<NetDevice> > devices;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      int32_t ifIndex = ipv4->AddInterface (device);
+      std::ostringstream oss;
+      oss << "10.0." << i << ".1";
+      ipv4->AddAddress (ifIndex, Ipv4InterfaceAddress (Ipv4Address (oss.str ().c_str ()), Ipv4Mask ("/24")));
+      ipv4->SetUp (ifIndex);
+      devices.push_back (device);
+    }
+
+  // a stand-alone instance, not consulted by the node itself
+  m_routing = CreateObject<Ipv4GlobalRouting> ();
+  m_routing->SetIpv4 (ipv4);
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.0.1"), Ipv4Address ("10.0.1.2"), 1);
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.0.1"), Ipv4Address ("10.0.2.2"), 2);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.0.0.0"), Ipv4Mask ("/8"), Ipv4Address ("10.0.1.3"), 1);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.9.0.0"), Ipv4Mask ("/16"), Ipv4Address ("10.0.3.2"), 3);
+  m_routing->AddASExternalRouteTo (Ipv4Address ("172.16.0.0"), Ipv4Mask ("/12"), Ipv4Address ("10.0.2.5"), 2);
+  m_routing->AddASExternalRouteTo (Ipv4Address ("172.16.0.0"), Ipv4Mask ("/16"), Ipv4Address ("10.0.3.5"), 3);
+
+  // host routes first, the first route of an ECMP group being used
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("10.9.0.1")), Ipv4Address ("10.0.1.2"), "Host route not used");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("10.9.0.1"), devices[1]), Ipv4Address ("10.0.2.2"), "Output interface not honored");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("10.9.0.1"), devices[2]), Ipv4Address ("10.0.3.2"), "Network route not used");
+  // network routes are used in table order, whatever their prefix length
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("10.9.5.5")), Ipv4Address ("10.0.1.3"), "Network routes not in table order");
+  // the first matching AS external route is used
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("172.16.3.3")), Ipv4Address ("10.0.2.5"), "External route not used");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("172.16.3.3"), devices[2]), Ipv4Address ("10.0.3.5"), "Output interface not honored");
+  NS_TEST_EXPECT_MSG_EQ (GetRoute (Ipv4Address ("8.8.8.8")), 0, "Unexpected route");
+
+  Ptr<Ipv4Route> route = GetRoute (Ipv4Address ("10.9.0.1"));
+  NS_TEST_EXPECT_MSG_EQ (route->GetSource (), Ipv4Address ("10.0.1.1"), "Wrong source address");
+  NS_TEST_EXPECT_MSG_EQ (route->GetOutputDevice (), devices[0], "Wrong output device");
+  NS_TEST_EXPECT_MSG_EQ (GetRoute (Ipv4Address ("10.9.0.1")), route, "Route not cached");
+
+  m_routing->RemoveRoute (0);
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("10.9.0.1")), Ipv4Address ("10.0.2.2"), "Route removal not taken into account");
+
+  // both routes of an ECMP group are used with random ECMP routing
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.0.1"), Ipv4Address ("10.0.1.2"), 1);
+  m_routing->SetAttribute ("RandomEcmpRouting", BooleanValue (true));
+  m_routing->AssignStreams (1);
+  uint32_t viaFirst = 0;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      if (GetGateway (Ipv4Address ("10.9.0.1")) == Ipv4Address ("10.0.2.2"))
+        {
+          viaFirst++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (viaFirst, 0, "ECMP route not used");
+  NS_TEST_EXPECT_MSG_LT (viaFirst, 100, "ECMP route not used");
+
+  m_routing->Dispose ();
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that the routes updated incrementally after interface up and down
+ * events are those of a complete recomputation, on a topology of
+ * point-to-point and shared links with equal cost paths and stub routers.
+ */
+class Ipv4GlobalRoutingIncrementalTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \return the routing tables of all of the nodes
+   */
+  std::string GetRoutes (void) const;
+  /**
+   * Set an interface down, or up if it is down, then after every other
+   * event check the routes against a complete recomputation, which also
+   * restarts the incremental updates from fresh trees
+   * \param event the number of the event
+   */
+  void Toggle (uint32_t event);
+
+  NodeContainer m_nodes;                //!< the nodes
+  Ptr<UniformRandomVariable> m_random;  //!< picks the interfaces
+};
+
+Ipv4GlobalRoutingIncrementalTestCase::Ipv4GlobalRoutingIncrementalTestCase ()
+  : TestCase ("Incremental global routing updates")
+{
+}
+
+std::string
+Ipv4GlobalRoutingIncrementalTestCase::GetRoutes (void) const
+{
+  std::ostringstream oss;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = m_nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      oss << "node " << i << std::endl;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          oss << *routing->GetRoute (j) << std::endl;
+        }
+    }
+  return oss.str ();
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::Toggle (uint32_t event)
+{
+  Ptr<Ipv4> ipv4 = m_nodes.Get (m_random->GetInteger (0, m_nodes.GetN () - 1))->GetObject<Ipv4> ();
+  uint32_t ifIndex = m_random->GetInteger (1, ipv4->GetNInterfaces () - 1);
+  if (ipv4->IsUp (ifIndex))
+    {
+      ipv4->SetDown (ifIndex);
+    }
+  else
+    {
+      ipv4->SetUp (ifIndex);
+    }
+  if (event % 2 == 1)
+    {
+      std::string incremental = GetRoutes ();
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      NS_TEST_EXPECT_MSG_EQ (incremental, GetRoutes (), "Routes differ after event " << event);
+    }
+}
+
+//
+// Network topology, with random interface metrics from 1 to 3
+//
+//       n11 (stub)
+//        |
+//  n0 -- n1 -- n2 -- n3 -- n4 -- n5 -- n6 -- n7 -- n0
+//  and n0 -- n4, n1 -- n5, n2 -- n6 point-to-point,
+//  n3, n7, n8, n9 on a shared link and n5, n9, n10 on another
+//
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoRun (void)
+{
+  Config::SetDefault ("ns3::Ipv4GlobalRouting::RespondToInterfaceEvents", BooleanValue (true));
+  m_nodes.Create (12);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  devHelper.SetNetDevicePointToPointMode (true);
+  uint32_t links[12][2] = { { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 4 }, { 4, 5 }, { 5, 6 },
+                            { 6, 7 }, { 7, 0 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 1, 11 } };
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (links[i][0]), m_nodes.Get (links[i][1]))));
+      ipv4.NewNetwork ();
+    }
+  devHelper.SetNetDevicePointToPointMode (false);
+  NodeContainer shared1;
+  shared1.Add (m_nodes.Get (3));
+  shared1.Add (m_nodes.Get (7));
+  shared1.Add (m_nodes.Get (8));
+  shared1.Add (m_nodes.Get (9));
+  ipv4.Assign (devHelper.Install (shared1));
+  ipv4.NewNetwork ();
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (5), m_nodes.Get (9), m_nodes.Get (10))));
+
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4> nodeIpv4 = m_nodes.Get (i)->GetObject<Ipv4> ();
+      for (uint32_t j = 1; j < nodeIpv4->GetNInterfaces (); j++)
+        {
+          nodeIpv4->SetMetric (j, m_random->GetInteger (1, 3));
+        }
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  for (uint32_t event = 0; event < 60; event++)
+    {
+      Simulator::Schedule (Seconds (1 + event), &Ipv4GlobalRoutingIncrementalTestCase::Toggle, this, event);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_nodes = NodeContainer ();
+  m_random = 0;
+}
 
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
@@ -431,6 +689,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingLookupTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingIncrementalTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -22,6 +22,7 @@
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
 #include "ns3/packet.h"
@@ -179,6 +180,127 @@ Ipv4StaticRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check the longest prefix match, metric and output interface rules of
+ * Ipv4StaticRouting lookups, and that routes are cached until the routing
+ * table changes.
+ */
+class Ipv4StaticRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv4StaticRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param dest the destination
+   * \param oif the output device, or 0
+   * \return the gateway of the route to dest, or 0.0.0.0 if none
+   */
+  Ipv4Address GetGateway (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  /**
+   * \param dest the destination
+   * \return the route to dest
+   */
+  Ptr<Ipv4Route> GetRoute (Ipv4Address dest);
+
+  Ptr<Ipv4StaticRouting> m_routing;  //!< routing protocol under test
+};
+
+Ipv4StaticRoutingLookupTestCase::Ipv4StaticRoutingLookupTestCase ()
+  : TestCase ("Static routing lookup rules and route caching")
+{
+}
+
+Ptr<Ipv4Route>
+Ipv4StaticRoutingLookupTestCase::GetRoute (Ipv4Address dest)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  return m_routing->RouteOutput (Create<Packet> (), header, 0, sockerr);
+}
+
+Ipv4Address
+Ipv4StaticRoutingLookupTestCase::GetGateway (Ipv4Address dest, Ptr<NetDevice> oif)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (Create<Packet> (), header, oif, sockerr);
+  if (route == 0)
+    {
+      return Ipv4Address::GetZero ();
+    }
+  return route->GetGateway ();
+}
+
+void
+Ipv4StaticRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+
+  // interfaces 1 to 3 on 10.0.1.0/24 to 10.0.3.0/24
+  std::vector<Ptr<NetDevice> > devices;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      int32_t ifIndex = ipv4->AddInterface (device);
+      std::ostringstream oss;
+      oss << "10.0." << i << ".1";
+      ipv4->AddAddress (ifIndex, Ipv4InterfaceAddress (Ipv4Address (oss.str ().c_str ()), Ipv4Mask ("/24")));
+      ipv4->SetUp (ifIndex);
+      devices.push_back (device);
+    }
+
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  m_routing = ipv4RoutingHelper.GetStaticRouting (ipv4);
+  m_routing->SetDefaultRoute (Ipv4Address ("10.0.1.2"), 1);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("192.168.0.0"), Ipv4Mask ("/16"), Ipv4Address ("10.0.2.2"), 2);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.3.2"), 3, 5);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.2.3"), 2, 1);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.2.4"), 2, 1);
+  m_routing->AddHostRouteTo (Ipv4Address ("192.168.1.7"), Ipv4Address ("10.0.1.7"), 1);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("172.16.0.5"), Ipv4Mask ("255.255.0.255"), Ipv4Address ("10.0.3.5"), 3);
+
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("192.168.1.7")), Ipv4Address ("10.0.1.7"), "Host route not preferred");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("192.168.1.8")), Ipv4Address ("10.0.2.4"), "Lowest metric, last added route not chosen");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("192.168.1.8"), devices[2]), Ipv4Address ("10.0.3.2"), "Output interface not honored");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("192.168.2.1")), Ipv4Address ("10.0.2.2"), "Shorter prefix not used");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("8.8.8.8")), Ipv4Address ("10.0.1.2"), "Default route not used");
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("172.16.44.5")), Ipv4Address ("10.0.3.5"), "Non-contiguous mask not matched");
+  NS_TEST_EXPECT_MSG_EQ (GetRoute (Ipv4Address ("10.0.3.9"))->GetOutputDevice (), devices[2], "Interface route not used");
+
+  Ptr<Ipv4Route> route = GetRoute (Ipv4Address ("192.168.1.8"));
+  NS_TEST_EXPECT_MSG_EQ (route->GetSource (), Ipv4Address ("10.0.2.1"), "Wrong source address");
+  NS_TEST_EXPECT_MSG_EQ (GetRoute (Ipv4Address ("192.168.1.9")), route, "Route not cached");
+
+  // removing the chosen route falls back on the other route with the same metric
+  for (uint32_t i = 0; i < m_routing->GetNRoutes (); i++)
+    {
+      if (m_routing->GetRoute (i).GetGateway () == Ipv4Address ("10.0.2.4"))
+        {
+          m_routing->RemoveRoute (i);
+          break;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (GetGateway (Ipv4Address ("192.168.1.8")), Ipv4Address ("10.0.2.3"), "Route removal not taken into account");
+
+  // a new address adds a connected route with the lowest metric
+  ipv4->AddAddress (2, Ipv4InterfaceAddress (Ipv4Address ("192.168.1.1"), Ipv4Mask ("/24")));
+  route = GetRoute (Ipv4Address ("192.168.1.8"));
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address::GetZero (), "Connected route not used");
+  NS_TEST_EXPECT_MSG_EQ (route->GetSource (), Ipv4Address ("192.168.1.1"), "Wrong source address for on-link destination");
+
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
 class Ipv4StaticRoutingTestSuite : public TestSuite
 {
 public:
@@ -189,6 +311,7 @@ Ipv4StaticRoutingTestSuite::Ipv4StaticRoutingTestSuite ()
   : TestSuite ("ipv4-static-routing", UNIT)
 {
   AddTestCase (new Ipv4StaticRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4StaticRoutingLookupTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
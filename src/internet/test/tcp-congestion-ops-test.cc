@@ -0,0 +1,443 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-transfer-test-case.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/error-model.h"
+#include "ns3/node.h"
+#include "ns3/socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-newreno.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-cubic.h"
+#include "ns3/tcp-dctcp.h"
+#include "ns3/boolean.h"
+#include "ns3/type-id.h"
+
+#include <set>
+
+using namespace ns3;
+
+/**
+ * \brief The default congestion control reproduces the arithmetic of
+ * NewReno.
+ */
+class TcpRenoOpsTestCase : public TestCase
+{
+public:
+  TcpRenoOpsTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpRenoOpsTestCase::TcpRenoOpsTestCase ()
+  : TestCase ("Default congestion control operations")
+{
+}
+
+void
+TcpRenoOpsTestCase::DoRun (void)
+{
+  Ptr<TcpSocketState> tcb = CreateObject<TcpSocketState> ();
+  tcb->m_segmentSize = 1000;
+  tcb->m_cWnd = 2000;
+  tcb->m_ssThresh = 4000;
+  Ptr<TcpCongestionOps> ops = CreateObject<TcpCongestionOps> ();
+
+  ops->IncreaseWindow (tcb, 1);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_cWnd.Get (), 3000, "One segment per ACK in slow start");
+  tcb->m_cWnd = 10000;
+  ops->IncreaseWindow (tcb, 1);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_cWnd.Get (), 10100, "SMSS * SMSS / cwnd in congestion avoidance");
+
+  NS_TEST_ASSERT_MSG_EQ (ops->GetSsThresh (tcb, 9000), 4500, "Half of the flight size");
+  NS_TEST_ASSERT_MSG_EQ (ops->GetSsThresh (tcb, 1000), 2000, "At least two segments");
+}
+
+/**
+ * \brief CUBIC grows slowly around the window of the last loss, fast once
+ * the time to reach it elapsed, and reduces the window by Beta.
+ */
+class TcpCubicTestCase : public TestCase
+{
+public:
+  TcpCubicTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Acknowledge a window of segments one by one
+   * \param ops the congestion control
+   * \param tcb the congestion control state
+   * \param increase the increase of the window, in segments
+   */
+  void AckWindow (Ptr<TcpCongestionOps> ops, Ptr<TcpSocketState> tcb, uint32_t *increase);
+};
+
+TcpCubicTestCase::TcpCubicTestCase ()
+  : TestCase ("CUBIC window growth and reduction")
+{
+}
+
+void
+TcpCubicTestCase::AckWindow (Ptr<TcpCongestionOps> ops, Ptr<TcpSocketState> tcb, uint32_t *increase)
+{
+  uint32_t before = tcb->GetCwndInSegments ();
+  for (uint32_t i = 0; i < before; i++)
+    {
+      ops->PktsAcked (tcb, 1, MilliSeconds (100));
+      ops->IncreaseWindow (tcb, 1);
+    }
+  *increase = tcb->GetCwndInSegments () - before;
+}
+
+void
+TcpCubicTestCase::DoRun (void)
+{
+  Ptr<TcpSocketState> tcb = CreateObject<TcpSocketState> ();
+  tcb->m_segmentSize = 1000;
+  tcb->m_cWnd = 2000;
+  tcb->m_ssThresh = 2500;
+  Ptr<TcpCubic> ops = CreateObject<TcpCubic> ();
+
+  ops->IncreaseWindow (tcb, 2);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_cWnd.Get (), 3000, "Slow start must stop at ssthresh");
+
+  // Loss at 100 segments: the window is reduced to 70 segments
+  tcb->m_cWnd = 100000;
+  uint32_t ssThresh = ops->GetSsThresh (tcb, 100000);
+  NS_TEST_ASSERT_MSG_EQ (ssThresh, 70000, "Window must be reduced by Beta");
+  tcb->m_cWnd = ssThresh;
+  tcb->m_ssThresh = ssThresh;
+
+  // Right after the loss, the window is far below the cubic plateau but
+  // the cubic function is flat: the growth is the one of the TCP friendly
+  // region, less than one segment per RTT
+  uint32_t early = 0;
+  AckWindow (ops, tcb, &early);
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (early, 1, "Slow growth right after the reduction");
+
+  // K = cbrt (30 / 0.4) = 4.2 seconds after the reduction, the window
+  // grows fast toward the plateau
+  uint32_t late = 0;
+  Simulator::Schedule (Seconds (4.2), &TcpCubicTestCase::AckWindow, this, ops, tcb, &late);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_GT (late, 10, "Fast growth toward the window of the last loss");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (tcb->GetCwndInSegments (), 110, "Growth must slow down around the plateau");
+
+  // Loss below the previous maximum: fast convergence
+  tcb->m_cWnd = 80000;
+  NS_TEST_ASSERT_MSG_EQ (ops->GetSsThresh (tcb, 80000), 56000, "Window must be reduced by Beta");
+}
+
+/**
+ * \brief DCTCP updates its estimate once per window of data and reduces
+ * the window in proportion of the marked data.
+ */
+class TcpDctcpTestCase : public TestCase
+{
+public:
+  TcpDctcpTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpDctcpTestCase::TcpDctcpTestCase ()
+  : TestCase ("DCTCP estimate of the fraction of marked data")
+{
+}
+
+void
+TcpDctcpTestCase::DoRun (void)
+{
+  Ptr<TcpSocketState> tcb = CreateObject<TcpSocketState> ();
+  tcb->m_segmentSize = 1000;
+  tcb->m_cWnd = 10000;
+  tcb->m_ssThresh = 5000;
+  tcb->m_highTxMark = SequenceNumber32 (10000);
+  Ptr<TcpDctcp> ops = CreateObject<TcpDctcp> ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (ops->GetAlpha (), 1.0, 1e-9, "Wrong initial alpha");
+
+  // A window of ten segments, half of them marked
+  for (uint32_t i = 1; i <= 10; i++)
+    {
+      tcb->m_lastAckedSeq = SequenceNumber32 (i * 1000);
+      tcb->m_ecnEcho = (i % 2 == 0);
+      ops->PktsAcked (tcb, 1, MilliSeconds (1));
+      if (i < 10)
+        {
+          NS_TEST_ASSERT_MSG_EQ_TOL (ops->GetAlpha (), 1.0, 1e-9, "Alpha updated once per window");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (ops->GetAlpha (), 0.96875, 1e-9, "alpha = (1 - g) alpha + g F");
+
+  tcb->m_congState = TcpSocketState::CA_CWR;
+  NS_TEST_ASSERT_MSG_EQ (ops->GetSsThresh (tcb, 10000), 5156, "cwnd (1 - alpha / 2) on ECN-Echo");
+  tcb->m_congState = TcpSocketState::CA_LOSS;
+  NS_TEST_ASSERT_MSG_EQ (ops->GetSsThresh (tcb, 10000), 5000, "Half the window on loss");
+}
+
+/**
+ * \brief A congestion control TypeId as TcpL4Protocol::SocketType creates
+ * NewReno sockets using it.
+ */
+class TcpCongestionOpsSocketTypeTestCase : public TestCase
+{
+public:
+  TcpCongestionOpsSocketTypeTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpCongestionOpsSocketTypeTestCase::TcpCongestionOpsSocketTypeTestCase ()
+  : TestCase ("TcpL4Protocol::SocketType set to a congestion control")
+{
+}
+
+void
+TcpCongestionOpsSocketTypeTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<TcpL4Protocol> tcp = CreateObject<TcpL4Protocol> ();
+  node->AggregateObject (tcp);
+
+  Ptr<TcpNewReno> socket = DynamicCast<TcpNewReno> (tcp->CreateSocket ());
+  NS_TEST_ASSERT_MSG_NE (socket, 0, "NewReno socket expected");
+  NS_TEST_ASSERT_MSG_EQ (socket->GetCongestionControlAlgorithm ()->GetName (), "TcpCongestionOps",
+                         "Default congestion control expected");
+
+  socket = DynamicCast<TcpNewReno> (tcp->CreateSocket (TcpCubic::GetTypeId ()));
+  NS_TEST_ASSERT_MSG_NE (socket, 0, "NewReno socket expected");
+  NS_TEST_ASSERT_MSG_EQ (socket->GetCongestionControlAlgorithm ()->GetName (), "TcpCubic",
+                         "CUBIC expected");
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Error model setting the CE codepoint on some ECN-capable TCP
+ * segments, and counting the retransmissions.
+ */
+class TcpEcnMarkModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Constructor
+   * \param interval mark one ECN-capable segment every interval segments
+   */
+  TcpEcnMarkModel (uint32_t interval);
+
+  /**
+   * \returns the number of segments marked
+   */
+  uint32_t GetMarks (void) const;
+
+  /**
+   * \returns the number of data segments seen more than once
+   */
+  uint32_t GetRetransmissions (void) const;
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  uint32_t m_interval;                //!< marking interval
+  uint32_t m_ecnCapable;              //!< ECN-capable segments seen
+  uint32_t m_marks;                   //!< segments marked
+  std::set<SequenceNumber32> m_seen;  //!< segments seen
+  uint32_t m_retransmissions;         //!< segments seen more than once
+};
+
+TcpEcnMarkModel::TcpEcnMarkModel (uint32_t interval)
+  : m_interval (interval),
+    m_ecnCapable (0),
+    m_marks (0),
+    m_retransmissions (0)
+{
+}
+
+uint32_t
+TcpEcnMarkModel::GetMarks (void) const
+{
+  return m_marks;
+}
+
+uint32_t
+TcpEcnMarkModel::GetRetransmissions (void) const
+{
+  return m_retransmissions;
+}
+
+bool
+TcpEcnMarkModel::DoCorrupt (Ptr<Packet> p)
+{
+  uint8_t firstByte = 0;
+  p->CopyData (&firstByte, 1);
+  if ((firstByte >> 4) != 4)
+    { // Not IPv4, e.g., ARP
+      return false;
+    }
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  if (ipHeader.GetProtocol () != TcpL4Protocol::PROT_NUMBER)
+    {
+      return false;
+    }
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (copy->GetSize () > 0 && !m_seen.insert (tcpHeader.GetSequenceNumber ()).second)
+    {
+      m_retransmissions++;
+    }
+  if (ipHeader.GetEcn () == Ipv4Header::ECN_ECT0 && ++m_ecnCapable % m_interval == 0)
+    {
+      p->RemoveHeader (ipHeader);
+      ipHeader.SetEcn (Ipv4Header::ECN_CE);
+      p->AddHeader (ipHeader);
+      m_marks++;
+    }
+  return false;
+}
+
+void
+TcpEcnMarkModel::DoReset (void)
+{
+}
+
+/**
+ * \brief A DCTCP transfer through a marking bottleneck negotiates ECN,
+ * reduces its window without retransmitting and learns the fraction of
+ * marked data. Without ECN on the receiver, no segment is ECN-capable.
+ */
+class TcpDctcpTransferTestCase : public TcpTransferTestCase
+{
+public:
+  TcpDctcpTransferTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Run a transfer
+   * \param receiverEcn enable ECN on the receiver
+   * \param marks the number of marked segments
+   * \param retransmissions the number of retransmitted segments
+   * \returns the DCTCP estimate of the sender at the end of the transfer
+   */
+  double RunTransfer (bool receiverEcn, uint32_t &marks, uint32_t &retransmissions);
+
+  /**
+   * \brief Create a DCTCP socket
+   * \param node the node
+   * \param ecn enable ECN
+   * \returns the socket
+   */
+  Ptr<TcpSocketBase> CreateSocket (Ptr<Node> node, bool ecn);
+
+  /**
+   * \brief Count the window reductions
+   * \param oldValue the previous window
+   * \param newValue the new window
+   */
+  void CwndChange (uint32_t oldValue, uint32_t newValue);
+
+  uint32_t m_reductions; //!< window reductions of the sender
+};
+
+TcpDctcpTransferTestCase::TcpDctcpTransferTestCase ()
+  : TcpTransferTestCase ("DCTCP transfer through an ECN marking link", 500000),
+    m_reductions (0)
+{
+}
+
+Ptr<TcpSocketBase>
+TcpDctcpTransferTestCase::CreateSocket (Ptr<Node> node, bool ecn)
+{
+  Ptr<TcpSocketBase> socket = DynamicCast<TcpSocketBase> (node->GetObject<TcpSocketFactory> ()->CreateSocket ());
+  socket->SetCongestionControlAlgorithm (CreateObject<TcpDctcp> ());
+  socket->SetAttribute ("UseEcn", BooleanValue (ecn));
+  return socket;
+}
+
+void
+TcpDctcpTransferTestCase::CwndChange (uint32_t oldValue, uint32_t newValue)
+{
+  if (newValue < oldValue)
+    {
+      m_reductions++;
+    }
+}
+
+double
+TcpDctcpTransferTestCase::RunTransfer (bool receiverEcn, uint32_t &marks, uint32_t &retransmissions)
+{
+  CreateNodes ();
+  m_reductions = 0;
+
+  Ptr<TcpEcnMarkModel> markModel = CreateObject<TcpEcnMarkModel> (20);
+  m_receiverDev->SetReceiveErrorModel (markModel);
+
+  Ptr<TcpSocketBase> receiver = CreateSocket (m_receiverDev->GetNode (), receiverEcn);
+
+  Ptr<TcpSocketBase> sender = CreateSocket (m_senderDev->GetNode (), true);
+  sender->TraceConnectWithoutContext ("CongestionWindow",
+                                      MakeCallback (&TcpDctcpTransferTestCase::CwndChange, this));
+  Transfer (sender, receiver);
+
+  marks = markModel->GetMarks ();
+  retransmissions = markModel->GetRetransmissions ();
+  double alpha = DynamicCast<TcpDctcp> (sender->GetCongestionControlAlgorithm ())->GetAlpha ();
+  Simulator::Destroy ();
+  return alpha;
+}
+
+void
+TcpDctcpTransferTestCase::DoRun (void)
+{
+  uint32_t marks;
+  uint32_t retransmissions;
+
+  double alpha = RunTransfer (true, marks, retransmissions);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer with ECN incomplete");
+  NS_TEST_ASSERT_MSG_GT (marks, 0, "ECN not negotiated");
+  NS_TEST_ASSERT_MSG_EQ (retransmissions, 0, "Marks must not cause retransmissions");
+  NS_TEST_ASSERT_MSG_GT (m_reductions, 0, "Marks must reduce the window");
+  NS_TEST_ASSERT_MSG_LT (alpha, 1.0, "Estimate must converge toward the marked fraction");
+  NS_TEST_ASSERT_MSG_GT (alpha, 0.0, "Estimate must account for the marks");
+
+  RunTransfer (false, marks, retransmissions);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer without ECN on the receiver incomplete");
+  NS_TEST_ASSERT_MSG_EQ (marks, 0, "No segment must be ECN-capable when the peer does not use ECN");
+}
+
+static class TcpCongestionOpsTestSuite : public TestSuite
+{
+public:
+  TcpCongestionOpsTestSuite ()
+    : TestSuite ("tcp-congestion-ops", UNIT)
+  {
+    AddTestCase (new TcpRenoOpsTestCase, TestCase::QUICK);
+    AddTestCase (new TcpCubicTestCase, TestCase::QUICK);
+    AddTestCase (new TcpDctcpTestCase, TestCase::QUICK);
+    AddTestCase (new TcpCongestionOpsSocketTypeTestCase, TestCase::QUICK);
+    AddTestCase (new TcpDctcpTransferTestCase, TestCase::QUICK);
+  }
+} g_tcpCongestionOpsTestSuite;
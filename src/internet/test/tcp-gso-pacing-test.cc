@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-transfer-test-case.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/error-model.h"
+#include "ns3/node.h"
+#include "ns3/socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+
+#include <map>
+#include <set>
+
+using namespace ns3;
+
+/**
+ * \brief Error model inspecting the TCP data segments received: counts
+ * them, checks that they are neither IPv4 fragments nor larger than a
+ * segment, and records how many arrive at the same time.
+ */
+class TcpSegmentMonitor : public ErrorModel
+{
+public:
+  /**
+   * \brief Constructor
+   * \param segmentSize the TCP segment size
+   * \param from do not record the arrival times before this time
+   */
+  TcpSegmentMonitor (uint32_t segmentSize, Time from);
+
+  uint32_t m_segments;        //!< data segments received
+  uint32_t m_fragments;       //!< IPv4 fragments received
+  uint32_t m_oversized;       //!< data segments larger than a segment
+  uint32_t m_retransmissions; //!< data segments seen more than once
+  uint32_t m_maxBurst;        //!< largest number of segments received at the same time
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  uint32_t m_segmentSize;                 //!< TCP segment size
+  Time m_from;                            //!< start of the burst records
+  std::set<SequenceNumber32> m_seen;      //!< segments seen
+  std::map<Time, uint32_t> m_arrivals;    //!< number of segments received at each time
+};
+
+TcpSegmentMonitor::TcpSegmentMonitor (uint32_t segmentSize, Time from)
+  : m_segments (0),
+    m_fragments (0),
+    m_oversized (0),
+    m_retransmissions (0),
+    m_maxBurst (0),
+    m_segmentSize (segmentSize),
+    m_from (from)
+{
+}
+
+bool
+TcpSegmentMonitor::DoCorrupt (Ptr<Packet> p)
+{
+  uint8_t firstByte = 0;
+  p->CopyData (&firstByte, 1);
+  if ((firstByte >> 4) != 4)
+    { // Not IPv4, e.g., ARP
+      return false;
+    }
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  if (ipHeader.IsLastFragment () == false || ipHeader.GetFragmentOffset () != 0)
+    {
+      m_fragments++;
+      return false;
+    }
+  if (ipHeader.GetProtocol () != TcpL4Protocol::PROT_NUMBER)
+    {
+      return false;
+    }
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (copy->GetSize () == 0)
+    {
+      return false;
+    }
+  m_segments++;
+  if (copy->GetSize () > m_segmentSize)
+    {
+      m_oversized++;
+    }
+  if (!m_seen.insert (tcpHeader.GetSequenceNumber ()).second)
+    {
+      m_retransmissions++;
+    }
+  if (Simulator::Now () >= m_from)
+    {
+      m_maxBurst = std::max (m_maxBurst, ++m_arrivals[Simulator::Now ()]);
+    }
+  return false;
+}
+
+void
+TcpSegmentMonitor::DoReset (void)
+{
+}
+
+/**
+ * \brief Bulk transfers with super-segments and with pacing deliver the
+ * same segments as the usual transfer: the super-segments are split into
+ * segments instead of IPv4 fragments, and paced segments leave one by one.
+ */
+class TcpGsoPacingTestCase : public TcpTransferTestCase
+{
+public:
+  TcpGsoPacingTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Run a transfer
+   * \param gsoMaxSegments the GsoMaxSegments attribute of the sender
+   * \param pacing the Pacing attribute of the sender
+   * \param superSegments the number of super-segments sent
+   * \returns the segment monitor of the receiver
+   */
+  Ptr<TcpSegmentMonitor> RunTransfer (uint32_t gsoMaxSegments, bool pacing, uint32_t &superSegments);
+
+  /**
+   * \brief Count the super-segments from the advances of SND.NXT
+   * \param oldValue the previous SND.NXT
+   * \param newValue the new SND.NXT
+   */
+  void NextTxChange (SequenceNumber32 oldValue, SequenceNumber32 newValue);
+
+  uint32_t m_segmentSize;   //!< TCP segment size
+  uint32_t m_superSegments; //!< super-segments sent
+};
+
+TcpGsoPacingTestCase::TcpGsoPacingTestCase ()
+  : TcpTransferTestCase ("TCP transfers with segmentation offload and pacing", 1000000),
+    m_segmentSize (536),
+    m_superSegments (0)
+{
+}
+
+void
+TcpGsoPacingTestCase::NextTxChange (SequenceNumber32 oldValue, SequenceNumber32 newValue)
+{
+  if (newValue - oldValue > static_cast<int32_t> (m_segmentSize))
+    {
+      m_superSegments++;
+    }
+}
+
+Ptr<TcpSegmentMonitor>
+TcpGsoPacingTestCase::RunTransfer (uint32_t gsoMaxSegments, bool pacing, uint32_t &superSegments)
+{
+  // An MTU smaller than a super-segment, which IPv4 would fragment
+  CreateNodes (1500);
+  m_superSegments = 0;
+
+  Ptr<TcpSegmentMonitor> monitor = CreateObject<TcpSegmentMonitor> (m_segmentSize, MilliSeconds (200));
+  m_receiverDev->SetReceiveErrorModel (monitor);
+
+  Ptr<Socket> receiver = m_receiverDev->GetNode ()->GetObject<TcpSocketFactory> ()->CreateSocket ();
+
+  Ptr<Socket> sender = m_senderDev->GetNode ()->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  sender->SetAttribute ("SegmentSize", UintegerValue (m_segmentSize));
+  sender->SetAttribute ("GsoMaxSegments", UintegerValue (gsoMaxSegments));
+  sender->SetAttribute ("Pacing", BooleanValue (pacing));
+  sender->TraceConnectWithoutContext ("NextTxSequence",
+                                      MakeCallback (&TcpGsoPacingTestCase::NextTxChange, this));
+  Transfer (sender, receiver);
+  Simulator::Destroy ();
+  superSegments = m_superSegments;
+  return monitor;
+}
+
+void
+TcpGsoPacingTestCase::DoRun (void)
+{
+  uint32_t superSegments;
+  uint32_t expectedSegments = (m_totalBytes + m_segmentSize - 1) / m_segmentSize;
+
+  Ptr<TcpSegmentMonitor> plain = RunTransfer (1, false, superSegments);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer incomplete");
+  NS_TEST_ASSERT_MSG_EQ (superSegments, 0, "No super-segment expected");
+  NS_TEST_ASSERT_MSG_GT (plain->m_maxBurst, 1, "Without pacing, a window leaves at once");
+
+  Ptr<TcpSegmentMonitor> gso = RunTransfer (16, false, superSegments);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer with super-segments incomplete");
+  NS_TEST_ASSERT_MSG_GT (superSegments, 0, "Super-segments expected");
+  NS_TEST_ASSERT_MSG_EQ (gso->m_fragments, 0, "Super-segments must not be fragmented");
+  NS_TEST_ASSERT_MSG_EQ (gso->m_oversized, 0, "Super-segments must be split into segments");
+  NS_TEST_ASSERT_MSG_EQ (gso->m_retransmissions, 0, "No retransmission expected");
+  NS_TEST_ASSERT_MSG_EQ (gso->m_segments, expectedSegments, "Wrong number of segments");
+
+  Ptr<TcpSegmentMonitor> paced = RunTransfer (1, true, superSegments);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Paced transfer incomplete");
+  NS_TEST_ASSERT_MSG_EQ (paced->m_retransmissions, 0, "No retransmission expected");
+  NS_TEST_ASSERT_MSG_EQ (paced->m_maxBurst, 1, "Paced segments must leave one by one");
+
+  Ptr<TcpSegmentMonitor> pacedGso = RunTransfer (16, true, superSegments);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Paced transfer with super-segments incomplete");
+  NS_TEST_ASSERT_MSG_EQ (pacedGso->m_oversized, 0, "Super-segments must be split into segments");
+  NS_TEST_ASSERT_MSG_EQ (pacedGso->m_segments, expectedSegments, "Wrong number of segments");
+  NS_TEST_ASSERT_MSG_LT (pacedGso->m_maxBurst, plain->m_maxBurst, "Paced bursts must be smaller");
+}
+
+static class TcpGsoPacingTestSuite : public TestSuite
+{
+public:
+  TcpGsoPacingTestSuite ()
+    : TestSuite ("tcp-gso-pacing", UNIT)
+  {
+    AddTestCase (new TcpGsoPacingTestCase, TestCase::QUICK);
+  }
+} g_tcpGsoPacingTestSuite;
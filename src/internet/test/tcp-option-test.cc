@@ -22,6 +22,8 @@
 #include "ns3/tcp-option.h"
 #include "ns3/private/tcp-option-winscale.h"
 #include "ns3/private/tcp-option-ts.h"
+#include "ns3/tcp-option-sack-permitted.h"
+#include "ns3/tcp-option-sack.h"
 
 #include <string.h>
 
@@ -164,6 +166,61 @@ TcpOptionTSTestCase::DoTeardown ()
 {
 }
 
+class TcpOptionSackTestCase : public TestCase
+{
+public:
+  TcpOptionSackTestCase (std::string name);
+
+private:
+  virtual void DoRun (void);
+};
+
+
+TcpOptionSackTestCase::TcpOptionSackTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+TcpOptionSackTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+
+  TcpOptionSackPermitted permitted;
+  Buffer permittedBuffer;
+  permittedBuffer.AddAtStart (permitted.GetSerializedSize ());
+  permitted.Serialize (permittedBuffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (permittedBuffer.GetSize (), 2, "Wrong SACK permitted size");
+  NS_TEST_EXPECT_MSG_EQ (permittedBuffer.Begin ().PeekU8 (), TcpOption::SACKPERMITTED, "Different kind found");
+  NS_TEST_EXPECT_MSG_EQ (permitted.Deserialize (permittedBuffer.Begin ()), 2, "SACK permitted not deserialized");
+
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      TcpOptionSack opt;
+      uint32_t nBlocks = x->GetInteger (1, TcpOptionSack::MAX_SACK_BLOCKS);
+      for (uint32_t j = 0; j < nBlocks; ++j)
+        {
+          SequenceNumber32 left (x->GetInteger ());
+          opt.AddSackBlock (TcpOptionSack::SackBlock (left, left + SequenceNumber32 (x->GetInteger (1, 65535))));
+        }
+      NS_TEST_EXPECT_MSG_EQ (opt.GetSerializedSize (), 2 + 8 * nBlocks, "Wrong SACK size");
+
+      Buffer buffer;
+      buffer.AddAtStart (opt.GetSerializedSize ());
+      opt.Serialize (buffer.Begin ());
+      NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().PeekU8 (), TcpOption::SACK, "Different kind found");
+
+      TcpOptionSack read;
+      NS_TEST_EXPECT_MSG_EQ (read.Deserialize (buffer.Begin ()), opt.GetSerializedSize (), "SACK not deserialized");
+      NS_TEST_EXPECT_MSG_EQ (read.GetNumSackBlocks (), nBlocks, "Different number of blocks found");
+      NS_TEST_EXPECT_MSG_EQ ((read.GetSackList () == opt.GetSackList ()), true, "Different blocks found");
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (TcpOptionSack::GetMaxSackBlocks (40), 4, "Wrong number of blocks without other options");
+  NS_TEST_EXPECT_MSG_EQ (TcpOptionSack::GetMaxSackBlocks (28), 3, "Wrong number of blocks with timestamps");
+  NS_TEST_EXPECT_MSG_EQ (TcpOptionSack::GetMaxSackBlocks (8), 0, "Wrong number of blocks without room");
+}
+
 static class TcpOptionTestSuite : public TestSuite
 {
 public:
@@ -176,6 +233,7 @@ public:
                                               "scale value", i), TestCase::QUICK);
       }
     AddTestCase (new TcpOptionTSTestCase ("Testing serialization of random values for timestamp"), TestCase::QUICK);
+    AddTestCase (new TcpOptionSackTestCase ("Testing serialization of random SACK blocks"), TestCase::QUICK);
   }
 
 } g_TcpOptionTestSuite;
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/tcp-rx-buffer.h"
+
+using namespace ns3;
+
+/**
+ * \brief Out of order, overlapping and duplicate segments added to a
+ * TcpRxBuffer are delivered as the original byte stream.
+ */
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("TcpRxBuffer reassembles out of order and overlapping segments")
+{
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  SequenceNumber32 isn (0xfffff000);
+  Ptr<TcpRxBuffer> rxBuffer = CreateObject<TcpRxBuffer> (isn.GetValue ());
+  rxBuffer->SetMaxBufferSize (20000);
+
+  // byte i of the stream is (i % 251)
+  const uint32_t total = 200000;
+  std::vector<bool> received (total, false);
+  uint32_t next = 0;   // first byte not received in sequence
+  uint32_t read = 0;   // first byte not read by the application
+  while (read < total)
+    {
+      // a segment at most 8 kB past the next expected byte, possibly
+      // overlapping data already received or read
+      uint32_t start = next + rng->GetInteger (0, 8000);
+      if (start >= 1000 && rng->GetInteger (0, 3) == 0)
+        {
+          start -= rng->GetInteger (0, 1000);
+        }
+      start = std::min (start, total - 1);
+      uint32_t size = std::min (rng->GetInteger (1, 1500), total - start);
+      uint8_t data[1500];
+      for (uint32_t j = 0; j < size; j++)
+        {
+          data[j] = (start + j) % 251;
+        }
+      TcpHeader tcph;
+      tcph.SetSequenceNumber (isn + SequenceNumber32 (start));
+      rxBuffer->Add (Create<Packet> (data, size), tcph);
+      // the buffer stores what fits in the window
+      uint32_t windowEnd = read + rxBuffer->MaxBufferSize ();
+      for (uint32_t j = start; j < start + size && j < windowEnd; j++)
+        {
+          if (j >= next)
+            {
+              received[j] = true;
+            }
+        }
+      while (next < total && received[next])
+        {
+          next++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (rxBuffer->NextRxSequence (), isn + SequenceNumber32 (next), "Wrong next sequence");
+      NS_TEST_ASSERT_MSG_EQ (rxBuffer->Available (), next - read, "Wrong available size");
+
+      if (rng->GetInteger (0, 1) == 0)
+        {
+          Ptr<Packet> p = rxBuffer->Extract (rng->GetInteger (1, 6000));
+          if (p != 0)
+            {
+              std::vector<uint8_t> out (p->GetSize ());
+              p->CopyData (&out[0], p->GetSize ());
+              for (uint32_t j = 0; j < out.size (); j++)
+                {
+                  NS_TEST_ASSERT_MSG_EQ ((uint32_t) out[j], (read + j) % 251, "Wrong data at offset " << read + j);
+                }
+              read += p->GetSize ();
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (rxBuffer->Size (), 0, "Data left in the buffer");
+}
+
+/**
+ * \brief TcpRxBuffer TestSuite
+ */
+class TcpRxBufferTestSuite : public TestSuite
+{
+public:
+  TcpRxBufferTestSuite () : TestSuite ("tcp-rx-buffer", UNIT)
+  {
+    AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+  }
+};
+
+static TcpRxBufferTestSuite g_tcpRxBufferTestSuite;
@@ -0,0 +1,485 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-transfer-test-case.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/error-model.h"
+#include "ns3/node.h"
+#include "ns3/socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/config.h"
+
+#include <set>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief The scoreboard of TcpTxBuffer gives the same answers as a
+ * byte by byte implementation of the routines of RFC 6675.
+ */
+class TcpSackScoreboardTestCase : public TestCase
+{
+public:
+  TcpSackScoreboardTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Count the SACKed bytes and ranges above each byte
+   */
+  void CountAbove (void);
+
+  /**
+   * \brief Reference IsLost
+   * \param offset the offset of the byte from the head
+   * \returns true if the byte is lost
+   */
+  bool IsLost (uint32_t offset) const;
+
+  std::vector<bool> m_sacked;         //!< SACKed bytes, from the head of the buffer
+  std::vector<uint32_t> m_bytesAbove;  //!< SACKed bytes above each byte
+  std::vector<uint32_t> m_rangesAbove; //!< SACKed ranges above each byte
+  uint32_t m_dupThresh;       //!< DupThresh
+  uint32_t m_segmentSize;     //!< SMSS
+};
+
+TcpSackScoreboardTestCase::TcpSackScoreboardTestCase ()
+  : TestCase ("TcpTxBuffer scoreboard matches a byte by byte reference"),
+    m_dupThresh (3),
+    m_segmentSize (100)
+{
+}
+
+void
+TcpSackScoreboardTestCase::CountAbove (void)
+{
+  uint32_t size = m_sacked.size ();
+  m_bytesAbove.assign (size, 0);
+  m_rangesAbove.assign (size, 0);
+  for (uint32_t i = size - 1; i > 0; i--)
+    {
+      m_bytesAbove[i - 1] = m_bytesAbove[i] + m_sacked[i];
+      m_rangesAbove[i - 1] = m_rangesAbove[i] + (m_sacked[i] && !m_sacked[i - 1]);
+    }
+}
+
+bool
+TcpSackScoreboardTestCase::IsLost (uint32_t offset) const
+{
+  if (m_sacked[offset])
+    {
+      return false;
+    }
+  return m_rangesAbove[offset] >= m_dupThresh
+         || m_bytesAbove[offset] > (m_dupThresh - 1) * m_segmentSize;
+}
+
+void
+TcpSackScoreboardTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  SequenceNumber32 head (0xfffff000);
+  Ptr<TcpTxBuffer> txBuffer = CreateObject<TcpTxBuffer> (head.GetValue ());
+  txBuffer->SetMaxBufferSize (8000);
+
+  for (uint32_t round = 0; round < 300; round++)
+    {
+      // Fill the buffer
+      while (txBuffer->Available () > 0)
+        {
+          uint32_t size = std::min (rng->GetInteger (1, 700), txBuffer->Available ());
+          txBuffer->Add (Create<Packet> (size));
+          m_sacked.resize (m_sacked.size () + size, false);
+        }
+      uint32_t size = txBuffer->Size ();
+      NS_TEST_ASSERT_MSG_EQ (m_sacked.size (), size, "Wrong reference size");
+
+      // Report random blocks, some of them partly outside of the buffer
+      TcpOptionSack::SackList list;
+      uint32_t nBlocks = rng->GetInteger (0, 4);
+      for (uint32_t k = 0; k < nBlocks; k++)
+        {
+          int32_t left = rng->GetInteger (0, size + 200) - 100;
+          int32_t right = left + rng->GetInteger (1, 500);
+          list.push_back (TcpOptionSack::SackBlock (head + SequenceNumber32 (left),
+                                                    head + SequenceNumber32 (right)));
+        }
+      uint32_t newlySacked = 0;
+      for (TcpOptionSack::SackList::iterator it = list.begin (); it != list.end (); ++it)
+        {
+          int32_t left = it->first - head;
+          int32_t right = it->second - head;
+          for (int32_t i = std::max (left, 0); i < std::min (right, (int32_t) size); i++)
+            {
+              if (!m_sacked[i])
+                {
+                  m_sacked[i] = true;
+                  newlySacked++;
+                }
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (txBuffer->Update (list), newlySacked, "Wrong number of newly SACKed bytes");
+
+      uint32_t sacked = 0;
+      for (uint32_t i = 0; i < size; i++)
+        {
+          sacked += m_sacked[i];
+        }
+      NS_TEST_ASSERT_MSG_EQ (txBuffer->GetSacked (), sacked, "Wrong number of SACKed bytes");
+      CountAbove ();
+
+      // Check the routines of RFC 6675 for random HighData and HighRxt
+      uint32_t highData = rng->GetInteger (0, size);
+      uint32_t highRxt = rng->GetInteger (0, highData);
+      for (uint32_t k = 0; k < 20; k++)
+        {
+          uint32_t offset = rng->GetInteger (0, size - 1);
+          SequenceNumber32 seq = head + SequenceNumber32 (offset);
+          NS_TEST_ASSERT_MSG_EQ (txBuffer->IsSacked (seq), m_sacked[offset], "Wrong IsSacked at " << offset);
+          NS_TEST_ASSERT_MSG_EQ (txBuffer->IsLost (seq, m_dupThresh, m_segmentSize), IsLost (offset),
+                                 "Wrong IsLost at " << offset);
+        }
+      uint32_t pipe = 0;
+      for (uint32_t i = 0; i < highData; i++)
+        {
+          if (!m_sacked[i] && !IsLost (i))
+            {
+              pipe++;
+            }
+          if (!m_sacked[i] && i < highRxt)
+            {
+              pipe++;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (txBuffer->BytesInFlight (head + SequenceNumber32 (highData),
+                                                      head + SequenceNumber32 (highRxt),
+                                                      m_dupThresh, m_segmentSize),
+                             pipe, "Wrong pipe");
+      for (uint32_t lostOnly = 0; lostOnly < 2; lostOnly++)
+        {
+          bool found = false;
+          uint32_t expectedOffset = 0;
+          uint32_t expectedLength = 0;
+          for (uint32_t i = highRxt; i < highData; i++)
+            {
+              if (!m_sacked[i] && (!lostOnly || IsLost (i)))
+                {
+                  found = true;
+                  expectedOffset = i;
+                  while (i < highData && !m_sacked[i] && expectedLength < m_segmentSize)
+                    {
+                      expectedLength++;
+                      i++;
+                    }
+                  break;
+                }
+            }
+          SequenceNumber32 seq;
+          uint32_t length = 0;
+          bool ret = txBuffer->NextSeg (head + SequenceNumber32 (highData),
+                                        head + SequenceNumber32 (highRxt),
+                                        m_dupThresh, m_segmentSize, lostOnly, seq, length);
+          NS_TEST_ASSERT_MSG_EQ (ret, found, "Wrong NextSeg result, lostOnly " << lostOnly);
+          if (found)
+            {
+              NS_TEST_ASSERT_MSG_EQ (seq, head + SequenceNumber32 (expectedOffset), "Wrong NextSeg sequence");
+              NS_TEST_ASSERT_MSG_EQ (length, expectedLength, "Wrong NextSeg length");
+            }
+        }
+
+      // Acknowledge some data
+      uint32_t acked = rng->GetInteger (0, std::min (size, 1500u));
+      head += acked;
+      txBuffer->DiscardUpTo (head);
+      m_sacked.erase (m_sacked.begin (), m_sacked.begin () + acked);
+      if (rng->GetInteger (0, 50) == 0)
+        {
+          txBuffer->ResetScoreboard ();
+          m_sacked.assign (m_sacked.size (), false);
+        }
+    }
+}
+
+/**
+ * \brief TcpRxBuffer reports its out-of-order data in SACK blocks, the
+ * block of the latest segment first.
+ */
+class TcpSackRxBufferTestCase : public TestCase
+{
+public:
+  TcpSackRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Add a segment to the buffer
+   * \param rxBuffer the buffer
+   * \param seq the sequence number of the segment
+   * \param size the size of the segment
+   */
+  void Add (Ptr<TcpRxBuffer> rxBuffer, uint32_t seq, uint32_t size);
+
+  /**
+   * \brief Check a block of the SACK list
+   * \param rxBuffer the buffer
+   * \param index the index of the block in the list
+   * \param left the expected left edge
+   * \param right the expected right edge
+   */
+  void CheckBlock (Ptr<TcpRxBuffer> rxBuffer, uint32_t index, uint32_t left, uint32_t right);
+};
+
+TcpSackRxBufferTestCase::TcpSackRxBufferTestCase ()
+  : TestCase ("TcpRxBuffer SACK blocks")
+{
+}
+
+void
+TcpSackRxBufferTestCase::Add (Ptr<TcpRxBuffer> rxBuffer, uint32_t seq, uint32_t size)
+{
+  TcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (seq));
+  rxBuffer->Add (Create<Packet> (size), header);
+}
+
+void
+TcpSackRxBufferTestCase::CheckBlock (Ptr<TcpRxBuffer> rxBuffer, uint32_t index, uint32_t left, uint32_t right)
+{
+  TcpOptionSack::SackList::const_iterator it = rxBuffer->GetSackList ().begin ();
+  for (uint32_t i = 0; i < index; i++)
+    {
+      ++it;
+    }
+  NS_TEST_EXPECT_MSG_EQ (it->first, SequenceNumber32 (left), "Wrong left edge of block " << index);
+  NS_TEST_EXPECT_MSG_EQ (it->second, SequenceNumber32 (right), "Wrong right edge of block " << index);
+}
+
+void
+TcpSackRxBufferTestCase::DoRun (void)
+{
+  Ptr<TcpRxBuffer> rxBuffer = CreateObject<TcpRxBuffer> (1000);
+  rxBuffer->SetMaxBufferSize (100000);
+
+  Add (rxBuffer, 1000, 100);
+  NS_TEST_ASSERT_MSG_EQ (rxBuffer->GetSackListSize (), 0, "In sequence data is not SACKed");
+
+  Add (rxBuffer, 1200, 100);
+  Add (rxBuffer, 1400, 100);
+  Add (rxBuffer, 1600, 100);
+  NS_TEST_ASSERT_MSG_EQ (rxBuffer->GetSackListSize (), 3, "Three holes");
+  CheckBlock (rxBuffer, 0, 1600, 1700);
+  CheckBlock (rxBuffer, 1, 1400, 1500);
+  CheckBlock (rxBuffer, 2, 1200, 1300);
+
+  // Fill the hole between the first two blocks, which are merged
+  Add (rxBuffer, 1300, 100);
+  NS_TEST_ASSERT_MSG_EQ (rxBuffer->GetSackListSize (), 2, "Two holes");
+  CheckBlock (rxBuffer, 0, 1200, 1500);
+  CheckBlock (rxBuffer, 1, 1600, 1700);
+
+  // Overlapping data extends a block
+  Add (rxBuffer, 1650, 100);
+  CheckBlock (rxBuffer, 0, 1600, 1750);
+  CheckBlock (rxBuffer, 1, 1200, 1500);
+
+  // Fill the first hole, the in sequence data is not reported anymore
+  Add (rxBuffer, 1100, 100);
+  NS_TEST_ASSERT_MSG_EQ (rxBuffer->NextRxSequence (), SequenceNumber32 (1500), "Wrong next sequence");
+  NS_TEST_ASSERT_MSG_EQ (rxBuffer->GetSackListSize (), 1, "One hole");
+  CheckBlock (rxBuffer, 0, 1600, 1750);
+
+  Add (rxBuffer, 1500, 100);
+  NS_TEST_ASSERT_MSG_EQ (rxBuffer->GetSackListSize (), 0, "No hole");
+  NS_TEST_ASSERT_MSG_EQ (rxBuffer->NextRxSequence (), SequenceNumber32 (1750), "Wrong next sequence");
+}
+
+/**
+ * \brief Error model dropping the first transmission of a set of TCP
+ * segments, and counting the retransmissions.
+ */
+class TcpSackDropModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Constructor
+   * \param drops the sequence numbers of the segments to drop
+   */
+  TcpSackDropModel (const std::set<SequenceNumber32> &drops);
+
+  /**
+   * \returns the number of data segments seen more than once
+   */
+  uint32_t GetRetransmissions (void) const;
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  std::set<SequenceNumber32> m_drops; //!< segments to drop
+  std::set<SequenceNumber32> m_seen;  //!< segments seen
+  uint32_t m_retransmissions;         //!< segments seen more than once
+};
+
+TcpSackDropModel::TcpSackDropModel (const std::set<SequenceNumber32> &drops)
+  : m_drops (drops),
+    m_retransmissions (0)
+{
+}
+
+uint32_t
+TcpSackDropModel::GetRetransmissions (void) const
+{
+  return m_retransmissions;
+}
+
+bool
+TcpSackDropModel::DoCorrupt (Ptr<Packet> p)
+{
+  uint8_t firstByte = 0;
+  p->CopyData (&firstByte, 1);
+  if ((firstByte >> 4) != 4)
+    { // Not IPv4, e.g., ARP
+      return false;
+    }
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  if (ipHeader.GetProtocol () != TcpL4Protocol::PROT_NUMBER)
+    {
+      return false;
+    }
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (copy->GetSize () == 0)
+    {
+      return false;
+    }
+  SequenceNumber32 seq = tcpHeader.GetSequenceNumber ();
+  if (!m_seen.insert (seq).second)
+    {
+      m_retransmissions++;
+      return false;
+    }
+  return m_drops.count (seq) > 0;
+}
+
+void
+TcpSackDropModel::DoReset (void)
+{
+}
+
+/**
+ * \brief A bulk transfer losing several segments of a window completes,
+ * and with SACK the lost segments are retransmitted once each, without
+ * waiting for a timeout, and sooner than without SACK.
+ */
+class TcpSackTransferTestCase : public TcpTransferTestCase
+{
+public:
+  TcpSackTransferTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Run a transfer
+   * \param senderSack enable SACK on the sender
+   * \param receiverSack enable SACK on the receiver
+   * \param retransmissions the number of retransmitted segments
+   * \param negotiated whether SACK has been negotiated
+   * \returns the time the receiver got the last byte
+   */
+  Time RunTransfer (bool senderSack, bool receiverSack, uint32_t &retransmissions, bool &negotiated);
+};
+
+TcpSackTransferTestCase::TcpSackTransferTestCase ()
+  : TcpTransferTestCase ("TCP transfer with several losses per window, with and without SACK", 500000)
+{
+}
+
+Time
+TcpSackTransferTestCase::RunTransfer (bool senderSack, bool receiverSack,
+                                      uint32_t &retransmissions, bool &negotiated)
+{
+  CreateNodes ();
+
+  // Drop several segments of the same window
+  std::set<SequenceNumber32> drops;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      drops.insert (SequenceNumber32 (1 + (100 + 3 * i) * 536));
+    }
+  Ptr<TcpSackDropModel> dropModel = CreateObject<TcpSackDropModel> (drops);
+  m_receiverDev->SetReceiveErrorModel (dropModel);
+
+  Ptr<Socket> receiver = m_receiverDev->GetNode ()->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  receiver->SetAttribute ("Sack", BooleanValue (receiverSack));
+
+  Ptr<Socket> sender = m_senderDev->GetNode ()->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  sender->SetAttribute ("Sack", BooleanValue (senderSack));
+  Transfer (sender, receiver);
+
+  BooleanValue sack;
+  sender->GetAttribute ("Sack", sack);
+  negotiated = sack.Get ();
+  retransmissions = dropModel->GetRetransmissions ();
+  Simulator::Destroy ();
+  return m_completion;
+}
+
+void
+TcpSackTransferTestCase::DoRun (void)
+{
+  uint32_t retransmissions;
+  bool negotiated;
+
+  Time noSack = RunTransfer (false, false, retransmissions, negotiated);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer without SACK incomplete");
+  NS_TEST_ASSERT_MSG_EQ (negotiated, false, "SACK not expected");
+
+  RunTransfer (true, false, retransmissions, negotiated);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer with SACK on one side incomplete");
+  NS_TEST_ASSERT_MSG_EQ (negotiated, false, "SACK must not be used when the peer does not permit it");
+
+  Time sack = RunTransfer (true, true, retransmissions, negotiated);
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer with SACK incomplete");
+  NS_TEST_ASSERT_MSG_EQ (negotiated, true, "SACK not negotiated");
+  NS_TEST_ASSERT_MSG_EQ (retransmissions, 5, "Each lost segment must be retransmitted once");
+  NS_TEST_ASSERT_MSG_LT (sack, noSack, "SACK recovery must be faster");
+}
+
+static class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ()
+    : TestSuite ("tcp-sack", UNIT)
+  {
+    AddTestCase (new TcpSackScoreboardTestCase, TestCase::QUICK);
+    AddTestCase (new TcpSackRxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpSackTransferTestCase, TestCase::QUICK);
+  }
+} g_tcpSackTestSuite;
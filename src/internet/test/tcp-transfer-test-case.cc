@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-transfer-test-case.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/node.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/arp-l3-protocol.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/icmpv4-l4-protocol.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
+
+namespace ns3 {
+
+TcpTransferTestCase::TcpTransferTestCase (std::string name, uint32_t totalBytes)
+  : TestCase (name),
+    m_totalBytes (totalBytes),
+    m_sent (0),
+    m_received (0)
+{
+}
+
+void
+TcpTransferTestCase::DoTeardown (void)
+{
+  m_senderDev = 0;
+  m_receiverDev = 0;
+}
+
+Ptr<SimpleNetDevice>
+TcpTransferTestCase::CreateNode (Ptr<SimpleChannel> channel, Ipv4Address address, uint16_t mtu)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AggregateObject (CreateObject<ArpL3Protocol> ());
+  Ptr<Ipv4L3Protocol> ipv4 = CreateObject<Ipv4L3Protocol> ();
+  Ptr<Ipv4ListRouting> ipv4Routing = CreateObject<Ipv4ListRouting> ();
+  ipv4->SetRoutingProtocol (ipv4Routing);
+  ipv4Routing->AddRoutingProtocol (CreateObject<Ipv4StaticRouting> (), 0);
+  node->AggregateObject (ipv4);
+  node->AggregateObject (CreateObject<Icmpv4L4Protocol> ());
+  node->AggregateObject (CreateObject<UdpL4Protocol> ());
+  node->AggregateObject (CreateObject<TcpL4Protocol> ());
+
+  Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+  dev->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+  dev->SetMtu (mtu);
+  node->AddDevice (dev);
+  dev->SetChannel (channel);
+  uint32_t ndid = ipv4->AddInterface (dev);
+  ipv4->AddAddress (ndid, Ipv4InterfaceAddress (address, Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (ndid);
+  return dev;
+}
+
+void
+TcpTransferTestCase::CreateNodes (uint16_t mtu)
+{
+  m_sent = 0;
+  m_received = 0;
+  m_completion = Time (0);
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  m_senderDev = CreateNode (channel, Ipv4Address ("10.0.0.1"), mtu);
+  m_receiverDev = CreateNode (channel, Ipv4Address ("10.0.0.2"), mtu);
+}
+
+void
+TcpTransferTestCase::Transfer (Ptr<Socket> sender, Ptr<Socket> receiver)
+{
+  receiver->Bind (InetSocketAddress (Ipv4Address::GetAny (), 5000));
+  receiver->Listen ();
+  receiver->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&TcpTransferTestCase::ReceiverAccept, this));
+
+  sender->SetSendCallback (MakeCallback (&TcpTransferTestCase::SenderSend, this));
+  sender->Connect (InetSocketAddress (Ipv4Address ("10.0.0.2"), 5000));
+
+  Simulator::Stop (Seconds (60));
+  Simulator::Run ();
+}
+
+void
+TcpTransferTestCase::SenderSend (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sent < m_totalBytes && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (std::min (m_totalBytes - m_sent, socket->GetTxAvailable ()), 1000u);
+      int sent = socket->Send (Create<Packet> (size));
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_sent += sent;
+    }
+}
+
+void
+TcpTransferTestCase::ReceiverAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpTransferTestCase::ReceiverRecv, this));
+}
+
+void
+TcpTransferTestCase::ReceiverRecv (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()) && p->GetSize () > 0)
+    {
+      m_received += p->GetSize ();
+      if (m_received == m_totalBytes)
+        {
+          m_completion = Simulator::Now ();
+        }
+    }
+}
+
+} // namespace ns3
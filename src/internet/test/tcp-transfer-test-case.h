@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TCP_TRANSFER_TEST_CASE_H
+#define TCP_TRANSFER_TEST_CASE_H
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/socket.h"
+
+#include <string>
+
+namespace ns3 {
+
+class SimpleChannel;
+
+/**
+ * \brief Base of the test cases running a bulk TCP transfer between two
+ * nodes of a SimpleChannel.
+ *
+ * The sender fills its Tx buffer until the given number of bytes has
+ * been written, and the receiver reads and counts the data.  A test case
+ * creates the nodes with CreateNodes, the sockets with the attributes and
+ * trace sinks it checks, and runs the transfer with Transfer.
+ */
+class TcpTransferTestCase : public TestCase
+{
+protected:
+  /**
+   * \brief Constructor
+   * \param name the name of the test case
+   * \param totalBytes the number of bytes to transfer
+   */
+  TcpTransferTestCase (std::string name, uint32_t totalBytes);
+
+  /**
+   * \brief Create the sender, 10.0.0.1, and the receiver, 10.0.0.2, with
+   * an IPv4 stack and a SimpleNetDevice on a channel with a 10 ms delay,
+   * and reset the counters of the transfer
+   * \param mtu the MTU of the devices
+   */
+  void CreateNodes (uint16_t mtu = 0xffff);
+
+  /**
+   * \brief Connect the sender to the receiver and run the simulation,
+   * for 60 seconds at most
+   * \param sender the socket of the sender
+   * \param receiver the socket of the receiver
+   *
+   * The simulator is not destroyed, so that the sockets can still be
+   * inspected.
+   */
+  void Transfer (Ptr<Socket> sender, Ptr<Socket> receiver);
+
+  uint32_t m_totalBytes;               //!< bytes to transfer
+  uint32_t m_sent;                     //!< bytes given to the sender
+  uint32_t m_received;                 //!< bytes read by the receiver
+  Time m_completion;                   //!< time the last byte was read
+  Ptr<SimpleNetDevice> m_senderDev;    //!< device of the sender
+  Ptr<SimpleNetDevice> m_receiverDev;  //!< device of the receiver
+
+private:
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Create a node with an IPv4 stack and a SimpleNetDevice
+   * \param channel the channel to attach the device to
+   * \param address the address of the device
+   * \param mtu the MTU of the device
+   * \returns the device
+   */
+  Ptr<SimpleNetDevice> CreateNode (Ptr<SimpleChannel> channel, Ipv4Address address, uint16_t mtu);
+
+  /**
+   * \brief Send data until the Tx buffer is full
+   * \param socket the sending socket
+   * \param available the available space in the Tx buffer
+   */
+  void SenderSend (Ptr<Socket> socket, uint32_t available);
+
+  /**
+   * \brief Accept a connection
+   * \param socket the new socket
+   * \param from the address of the peer
+   */
+  void ReceiverAccept (Ptr<Socket> socket, const Address &from);
+
+  /**
+   * \brief Read the received data
+   * \param socket the receiving socket
+   */
+  void ReceiverRecv (Ptr<Socket> socket);
+};
+
+} // namespace ns3
+
+#endif /* TCP_TRANSFER_TEST_CASE_H */
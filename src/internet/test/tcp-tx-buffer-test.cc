@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/tcp-tx-buffer.h"
+
+using namespace ns3;
+
+/**
+ * \brief Segments copied out of a TcpTxBuffer hold the bytes written at
+ * their sequence numbers, whatever the packets the data was written with.
+ */
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("TcpTxBuffer segments hold the data at their sequence numbers")
+{
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  // start close to the wrap around of the sequence numbers
+  SequenceNumber32 isn (0xffff0000);
+  Ptr<TcpTxBuffer> txBuffer = CreateObject<TcpTxBuffer> (isn.GetValue ());
+  txBuffer->SetMaxBufferSize (64000);
+
+  // byte i of the stream is (i % 251)
+  uint32_t written = 0;
+  uint32_t acked = 0;
+  for (uint32_t round = 0; round < 2000; round++)
+    {
+      uint32_t size = rng->GetInteger (1, 1500);
+      if (size <= txBuffer->Available ())
+        {
+          uint8_t data[1500];
+          for (uint32_t j = 0; j < size; j++)
+            {
+              data[j] = (written + j) % 251;
+            }
+          NS_TEST_ASSERT_MSG_EQ (txBuffer->Add (Create<Packet> (data, size)), true, "Add failed");
+          written += size;
+        }
+      NS_TEST_ASSERT_MSG_EQ (txBuffer->Size (), written - acked, "Wrong buffer size");
+      NS_TEST_ASSERT_MSG_EQ (txBuffer->TailSequence (), isn + SequenceNumber32 (written), "Wrong tail");
+
+      for (uint32_t k = 0; k < 4 && written > acked; k++)
+        {
+          uint32_t start = rng->GetInteger (acked, written - 1);
+          uint32_t length = rng->GetInteger (1, 4000);
+          Ptr<Packet> segment = txBuffer->CopyFromSequence (length, isn + SequenceNumber32 (start));
+          uint32_t expected = std::min (length, written - start);
+          NS_TEST_ASSERT_MSG_EQ (segment->GetSize (), expected, "Wrong segment size");
+          uint8_t out[4000];
+          segment->CopyData (out, expected);
+          for (uint32_t j = 0; j < expected; j++)
+            {
+              NS_TEST_ASSERT_MSG_EQ ((uint32_t) out[j], (start + j) % 251, "Wrong data at offset " << start + j);
+            }
+        }
+
+      if (rng->GetInteger (0, 2) == 0 && written > acked)
+        {
+          acked = rng->GetInteger (acked, written);
+          txBuffer->DiscardUpTo (isn + SequenceNumber32 (acked));
+          NS_TEST_ASSERT_MSG_EQ (txBuffer->HeadSequence (), isn + SequenceNumber32 (acked), "Wrong head");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (txBuffer->CopyFromSequence (100, isn + SequenceNumber32 (written))->GetSize (), 0,
+                         "Data returned past the tail");
+}
+
+/**
+ * \brief TcpTxBuffer TestSuite
+ */
+class TcpTxBufferTestSuite : public TestSuite
+{
+public:
+  TcpTxBufferTestSuite () : TestSuite ("tcp-tx-buffer", UNIT)
+  {
+    AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+  }
+};
+
+static TcpTxBufferTestSuite g_tcpTxBufferTestSuite;
@@ -22,6 +22,7 @@
 #include "ns3/position-allocator.h"
 #include "ns3/hierarchical-mobility-model.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/pointer.h"
 #include "ns3/config.h"
 #include "ns3/simulator.h"
@@ -288,4 +289,18 @@ MobilityHelper::GetDistanceSquaredBetween (Ptr<Node> n1, Ptr<Node> n2)
   return distSq;
 }
 
+void
+MobilityHelper::GetPositions (NodeContainer c, std::vector<Vector> &positions)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  positions.resize (c.GetN ());
+  uint32_t j = 0;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i, ++j)
+    {
+      Ptr<MobilityModel> mobility = (*i)->GetObject<MobilityModel> ();
+      NS_ABORT_MSG_IF (mobility == 0, "Node " << (*i)->GetId () << " has no MobilityModel");
+      positions[j] = mobility->GetPosition ();
+    }
+}
+
 } // namespace ns3
@@ -267,6 +267,18 @@ public:
    */
   static double GetDistanceSquaredBetween (Ptr<Node> n1, Ptr<Node> n2);
 
+  /**
+   * \param c the nodes whose position is requested
+   * \param positions filled with the current position of each node,
+   *        in the order of the container
+   *
+   * Gather the positions of a set of nodes at the current simulation time
+   * into a contiguous array, e.g., for a channel or a propagation model
+   * which needs the position of every receiver of a transmission.  Every
+   * node must have a MobilityModel aggregated.
+   */
+  static void GetPositions (NodeContainer c, std::vector<Vector> &positions);
+
 private:
 
   /**
@@ -22,6 +22,7 @@
 
 #include "mobility-model.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/simulator.h"
 
 namespace ns3 {
 
@@ -53,6 +54,8 @@ MobilityModel::GetTypeId (void)
 }
 
 MobilityModel::MobilityModel ()
+  : m_positionCached (false),
+    m_velocityCached (false)
 {
 }
 
@@ -63,25 +66,50 @@ MobilityModel::~MobilityModel ()
 Vector
 MobilityModel::GetPosition (void) const
 {
-  return DoGetPosition ();
+  Time now = Simulator::Now ();
+  if (now != m_cacheTime)
+    {
+      m_cacheTime = now;
+      m_positionCached = false;
+      m_velocityCached = false;
+    }
+  if (!m_positionCached)
+    {
+      m_cachedPosition = DoGetPosition ();
+      m_positionCached = true;
+    }
+  return m_cachedPosition;
 }
 Vector
 MobilityModel::GetVelocity (void) const
 {
-  return DoGetVelocity ();
+  Time now = Simulator::Now ();
+  if (now != m_cacheTime)
+    {
+      m_cacheTime = now;
+      m_positionCached = false;
+      m_velocityCached = false;
+    }
+  if (!m_velocityCached)
+    {
+      m_cachedVelocity = DoGetVelocity ();
+      m_velocityCached = true;
+    }
+  return m_cachedVelocity;
 }
 
 void 
 MobilityModel::SetPosition (const Vector &position)
 {
   DoSetPosition (position);
+  InvalidateCache ();
 }
 
 double 
 MobilityModel::GetDistanceFrom (Ptr<const MobilityModel> other) const
 {
-  Vector oPosition = other->DoGetPosition ();
-  Vector position = DoGetPosition ();
+  Vector oPosition = other->GetPosition ();
+  Vector position = GetPosition ();
   return CalculateDistance (position, oPosition);
 }
 
@@ -97,9 +125,17 @@ MobilityModel::GetRelativeSpeed (Ptr<const MobilityModel> other) const
 void
 MobilityModel::NotifyCourseChange (void) const
 {
+  InvalidateCache ();
   m_courseChangeTrace (this);
 }
 
+void
+MobilityModel::InvalidateCache (void) const
+{
+  m_positionCached = false;
+  m_velocityCached = false;
+}
+
 int64_t
 MobilityModel::AssignStreams (int64_t start)
 {
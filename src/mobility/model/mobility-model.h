@@ -22,6 +22,7 @@
 
 #include "ns3/vector.h"
 #include "ns3/object.h"
+#include "ns3/nstime.h"
 #include "ns3/traced-callback.h"
 
 namespace ns3 {
@@ -35,6 +36,12 @@ namespace ns3 {
  * metric international units.
  *
  * This is a base class for all specific mobility models.
+ *
+ * The position and velocity returned by the subclass are memoized for
+ * the current simulation time, so that the many lookups done by the
+ * channels for a single transmission evaluate the trajectory only once.
+ * The memoized values are discarded when time advances, when
+ * SetPosition is called and when the subclass calls NotifyCourseChange.
  */
 class MobilityModel : public Object
 {
@@ -92,6 +99,12 @@ protected:
    * position changes to notify course change listeners.
    */
   void NotifyCourseChange (void) const;
+  /**
+   * Discard the position and velocity memoized for the current time.
+   * Subclasses must invoke it when their position or velocity changes
+   * without a call to NotifyCourseChange.
+   */
+  void InvalidateCache (void) const;
 private:
   /**
    * \return the current position.
@@ -129,6 +142,11 @@ private:
    */
   ns3::TracedCallback<Ptr<const MobilityModel> > m_courseChangeTrace;
 
+  mutable Time m_cacheTime;         //!< time at which the cached values were computed
+  mutable Vector m_cachedPosition;  //!< position at m_cacheTime
+  mutable Vector m_cachedVelocity;  //!< velocity at m_cacheTime
+  mutable bool m_positionCached;    //!< whether m_cachedPosition is valid
+  mutable bool m_velocityCached;    //!< whether m_cachedVelocity is valid
 };
 
 } // namespace ns3
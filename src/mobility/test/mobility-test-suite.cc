@@ -30,6 +30,7 @@
 #include "ns3/vector.h"
 #include "ns3/mobility-model.h"
 #include "ns3/waypoint-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/mobility-helper.h"
 
 using namespace ns3;
@@ -354,6 +355,81 @@ WaypointMobilityModelViaHelper::DoRun (void)
   Simulator::Destroy ();
 }
 
+// Test that positions memoized for the current time are discarded when
+// the course changes, and that the batch lookup matches GetPosition ()
+class ConstantVelocityPositionCache : public TestCase
+{
+public:
+  ConstantVelocityPositionCache ();
+  virtual ~ConstantVelocityPositionCache ();
+
+private:
+  void ChangeCourse (Ptr<ConstantVelocityMobilityModel> mob);
+  void CheckPositions (NodeContainer c);
+  virtual void DoRun (void);
+};
+
+ConstantVelocityPositionCache::ConstantVelocityPositionCache ()
+  : TestCase ("Test position caching and batch position lookup")
+{
+}
+
+ConstantVelocityPositionCache::~ConstantVelocityPositionCache ()
+{
+}
+
+void
+ConstantVelocityPositionCache::ChangeCourse (Ptr<ConstantVelocityMobilityModel> mob)
+{
+  // t = 2s: the node moved from (0,0,0) at 1 m/s along x
+  Vector pos = mob->GetPosition ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (pos.x, 2.0, 0.001, "Position not equal");
+  NS_TEST_EXPECT_MSG_EQ_TOL (mob->GetVelocity ().x, 1.0, 0.001, "Velocity not equal");
+  mob->SetPosition (Vector (5.0, 0.0, 0.0));
+  NS_TEST_EXPECT_MSG_EQ_TOL (mob->GetPosition ().x, 5.0, 0.001, "Cached position not discarded on SetPosition");
+  NS_TEST_EXPECT_MSG_EQ_TOL (mob->GetVelocity ().x, 0.0, 0.001, "Cached velocity not discarded on SetPosition");
+  mob->SetVelocity (Vector (0.0, 3.0, 0.0));
+  NS_TEST_EXPECT_MSG_EQ_TOL (mob->GetVelocity ().y, 3.0, 0.001, "Cached velocity not discarded on course change");
+}
+
+void
+ConstantVelocityPositionCache::CheckPositions (NodeContainer c)
+{
+  std::vector<Vector> positions;
+  MobilityHelper::GetPositions (c, positions);
+  NS_TEST_ASSERT_MSG_EQ (positions.size (), c.GetN (), "Wrong number of positions");
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Vector expected = c.Get (i)->GetObject<MobilityModel> ()->GetPosition ();
+      NS_TEST_EXPECT_MSG_EQ_TOL (positions[i].x, expected.x, 1e-9, "Position not equal");
+      NS_TEST_EXPECT_MSG_EQ_TOL (positions[i].y, expected.y, 1e-9, "Position not equal");
+    }
+  // t = 4s: the first node moved from (5,0,0) at 3 m/s along y
+  NS_TEST_EXPECT_MSG_EQ_TOL (positions[0].x, 5.0, 0.001, "Position not equal");
+  NS_TEST_EXPECT_MSG_EQ_TOL (positions[0].y, 6.0, 0.001, "Position not equal");
+}
+
+void
+ConstantVelocityPositionCache::DoRun (void)
+{
+  NodeContainer c;
+  c.Create (3);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantVelocityMobilityModel");
+  mobility.Install (c);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<ConstantVelocityMobilityModel> mob = c.Get (i)->GetObject<ConstantVelocityMobilityModel> ();
+      mob->SetPosition (Vector (0.0, 10.0 * i, 0.0));
+      mob->SetVelocity (Vector (1.0, 0.0, 0.0));
+    }
+  Ptr<ConstantVelocityMobilityModel> mob = c.Get (0)->GetObject<ConstantVelocityMobilityModel> ();
+  Simulator::Schedule (Seconds (2), &ConstantVelocityPositionCache::ChangeCourse, this, mob);
+  Simulator::Schedule (Seconds (4), &ConstantVelocityPositionCache::CheckPositions, this, c);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
 class MobilityTestSuite : public TestSuite
 {
 public:
@@ -367,6 +443,7 @@ MobilityTestSuite::MobilityTestSuite ()
   AddTestCase (new WaypointLazyNotifyTrue, TestCase::QUICK);
   AddTestCase (new WaypointInitialPositionIsWaypoint, TestCase::QUICK);
   AddTestCase (new WaypointMobilityModelViaHelper, TestCase::QUICK);
+  AddTestCase (new ConstantVelocityPositionCache, TestCase::QUICK);
 }
 
 static MobilityTestSuite mobilityTestSuite;
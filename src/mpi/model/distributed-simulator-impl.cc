@@ -385,7 +385,10 @@ DistributedSimulatorImpl::Run (void)
       if (nextTime > m_grantedTime || IsLocalFinished () )
         {
           // Can't process next event, calculate a new LBTS
-          // First receive any pending messages
+          // First send the messages batched during this window, so
+          // that they are received before the next one is granted
+          GrantedTimeWindowMpiInterface::FlushMessages ();
+          // Then receive any pending messages
           GrantedTimeWindowMpiInterface::ReceiveMessages ();
           // reset next time
           nextTime = Next ();
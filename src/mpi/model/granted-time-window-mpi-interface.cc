@@ -44,44 +44,14 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GrantedTimeWindowMpiInterface");
 
-SentBuffer::SentBuffer ()
-{
-  m_buffer = 0;
-  m_request = 0;
-}
-
-SentBuffer::~SentBuffer ()
-{
-  delete [] m_buffer;
-}
-
-uint8_t*
-SentBuffer::GetBuffer ()
-{
-  return m_buffer;
-}
-
-void
-SentBuffer::SetBuffer (uint8_t* buffer)
-{
-  m_buffer = buffer;
-}
-
-#ifdef NS3_MPI
-MPI_Request*
-SentBuffer::GetRequest ()
-{
-  return &m_request;
-}
-#endif
-
 uint32_t              GrantedTimeWindowMpiInterface::m_sid = 0;
 uint32_t              GrantedTimeWindowMpiInterface::m_size = 1;
 bool                  GrantedTimeWindowMpiInterface::m_initialized = false;
 bool                  GrantedTimeWindowMpiInterface::m_enabled = false;
 uint32_t              GrantedTimeWindowMpiInterface::m_rxCount = 0;
 uint32_t              GrantedTimeWindowMpiInterface::m_txCount = 0;
-std::list<SentBuffer> GrantedTimeWindowMpiInterface::m_pendingTx;
+MpiFrameBuffer        GrantedTimeWindowMpiInterface::m_frames;
+MpiSharedMemory       GrantedTimeWindowMpiInterface::m_sharedMemory;
 
 #ifdef NS3_MPI
 MPI_Request* GrantedTimeWindowMpiInterface::m_requests;
@@ -106,12 +76,15 @@ GrantedTimeWindowMpiInterface::Destroy ()
 #ifdef NS3_MPI
   for (uint32_t i = 0; i < GetSize (); ++i)
     {
+      MPI_Cancel (&m_requests[i]);
+      MPI_Request_free (&m_requests[i]);
       delete [] m_pRxBuffers[i];
     }
   delete [] m_pRxBuffers;
   delete [] m_requests;
 
-  m_pendingTx.clear ();
+  m_frames.Clear ();
+  m_sharedMemory.Clear ();
 #endif
 }
 
@@ -173,15 +146,19 @@ GrantedTimeWindowMpiInterface::Enable (int* pargc, char*** pargv)
   MPI_Comm_size (MPI_COMM_WORLD, reinterpret_cast <int *> (&m_size));
   m_enabled = true;
   m_initialized = true;
-  // Post a non-blocking receive for all peers
+  m_frames.Initialize (m_size);
+  uint32_t frameSize = m_frames.GetFrameSize ();
+  // Post a persistent non-blocking receive for all peers
   m_pRxBuffers = new char*[m_size];
   m_requests = new MPI_Request[m_size];
   for (uint32_t i = 0; i < GetSize (); ++i)
     {
-      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
-      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[i]);
+      m_pRxBuffers[i] = new char[frameSize];
+      MPI_Recv_init (m_pRxBuffers[i], frameSize, MPI_CHAR, MPI_ANY_SOURCE, 0,
+                     MPI_COMM_WORLD, &m_requests[i]);
+      MPI_Start (&m_requests[i]);
     }
+  m_sharedMemory.Initialize (m_sid, m_size);
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -193,13 +170,18 @@ GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, ui
   NS_LOG_FUNCTION (this << p << rxTime.GetTimeStep () << node << dev);
 
 #ifdef NS3_MPI
-  SentBuffer sendBuf;
-  m_pendingTx.push_back (sendBuf);
-  std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
+  // Find the system id for the destination node
+  Ptr<Node> destNode = NodeList::GetNode (node);
+  uint32_t nodeSysId = destNode->GetSystemId ();
 
   uint32_t serializedSize = p->GetSerializedSize ();
-  uint8_t* buffer =  new uint8_t[serializedSize + 16];
-  i->SetBuffer (buffer);
+  // write the packet in place in shared memory, if the rank is on this host
+  uint8_t* buffer = m_sharedMemory.Reserve (nodeSysId, serializedSize + 16);
+  bool shared = buffer != 0;
+  if (!shared)
+    {
+      buffer = m_frames.Reserve (nodeSysId, serializedSize + 16);
+    }
   // Add the time, dest node and dest device
   uint64_t t = rxTime.GetInteger ();
   uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
@@ -210,18 +192,32 @@ GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, ui
   // Serialize the packet
   p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
 
-  // Find the system id for the destination node
-  Ptr<Node> destNode = NodeList::GetNode (node);
-  uint32_t nodeSysId = destNode->GetSystemId ();
-
-  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (i->GetRequest ()));
+  if (shared)
+    {
+      m_sharedMemory.Commit (nodeSysId);
+    }
+  else
+    {
+      m_frames.Commit (nodeSysId);
+    }
   m_txCount++;
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
 }
 
+void
+GrantedTimeWindowMpiInterface::FlushMessages ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+#ifdef NS3_MPI
+  m_frames.FlushAll ();
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
 void
 GrantedTimeWindowMpiInterface::ReceiveMessages ()
 { 
@@ -240,50 +236,78 @@ GrantedTimeWindowMpiInterface::ReceiveMessages ()
         {
           break;        // No more messages
         }
-      int count;
-      MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
+      int frameSize;
+      MPI_Get_count (&status, MPI_CHAR, &frameSize);
+
+      // Process each message of the frame
+      const uint8_t* frame = reinterpret_cast<uint8_t *> (m_pRxBuffers[index]);
+      uint32_t offset = 0;
+      uint32_t count;
+      const uint8_t* message;
+      while ((message = MpiFrameBuffer::NextMessage (frame, frameSize, &offset, &count)) != 0)
+        {
+          ReceiveMessage (message, count);
+        }
+
+      // Re-queue the next read
+      MPI_Start (&m_requests[index]);
+    }
+
+  // Poll the rings from the ranks of this host
+  for (uint32_t i = 0; i < m_sharedMemory.GetNPeers (); ++i)
+    {
+      uint32_t count;
+      const uint8_t* message;
+      while ((message = m_sharedMemory.Receive (i, &count)) != 0)
+        {
+          ReceiveMessage (message, count);
+          m_sharedMemory.Release (i);
+        }
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+GrantedTimeWindowMpiInterface::ReceiveMessage (const uint8_t* message, uint32_t count)
+{
+  NS_LOG_FUNCTION (message << count);
+
+  m_rxCount++; // Count this receive
 
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t time = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
+  // Get the meta data first
+  const uint64_t* pTime = reinterpret_cast<const uint64_t *> (message);
+  uint64_t time = *pTime++;
+  const uint32_t* pData = reinterpret_cast<const uint32_t *> (pTime);
+  uint32_t node = *pData++;
+  uint32_t dev  = *pData++;
 
-      Time rxTime (time);
+  Time rxTime (time);
 
-      count -= sizeof (time) + sizeof (node) + sizeof (dev);
+  count -= sizeof (time) + sizeof (node) + sizeof (dev);
 
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+  Ptr<Packet> p = Create<Packet> (reinterpret_cast<const uint8_t *> (pData), count, true);
 
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      Ptr<MpiReceiver> pMpiRec = 0;
-      uint32_t nDevices = pNode->GetNDevices ();
-      for (uint32_t i = 0; i < nDevices; ++i)
+  // Find the correct node/device to schedule receive event
+  Ptr<Node> pNode = NodeList::GetNode (node);
+  Ptr<MpiReceiver> pMpiRec = 0;
+  uint32_t nDevices = pNode->GetNDevices ();
+  for (uint32_t i = 0; i < nDevices; ++i)
+    {
+      Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+      if (pThisDev->GetIfIndex () == dev)
         {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
-            {
-              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-              break;
-            }
+          pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+          break;
         }
+    }
 
-      NS_ASSERT (pNode && pMpiRec);
-
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &MpiReceiver::Receive, pMpiRec, p);
+  NS_ASSERT (pNode && pMpiRec);
 
-      // Re-queue the next read
-      MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[index]);
-    }
-#else
-  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
-#endif
+  // Schedule the rx event
+  Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                  &MpiReceiver::Receive, pMpiRec, p);
 }
 
 void
@@ -292,19 +316,7 @@ GrantedTimeWindowMpiInterface::TestSendComplete ()
   NS_LOG_FUNCTION_NOARGS ();
 
 #ifdef NS3_MPI
-  std::list<SentBuffer>::iterator i = m_pendingTx.begin ();
-  while (i != m_pendingTx.end ())
-    {
-      MPI_Status status;
-      int flag = 0;
-      MPI_Test (i->GetRequest (), &flag, &status);
-      std::list<SentBuffer>::iterator current = i; // Save current for erasing
-      i++;                                    // Advance to next
-      if (flag)
-        { // This message is complete
-          m_pendingTx.erase (current);
-        }
-    }
+  m_frames.TestSendComplete ();
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -30,53 +30,11 @@
 #include "ns3/buffer.h"
 
 #include "parallel-communication-interface.h"
-
-#ifdef NS3_MPI
-#include "mpi.h"
-#else
-typedef void* MPI_Request;
-#endif
+#include "mpi-frame-buffer.h"
+#include "mpi-shared-memory.h"
 
 namespace ns3 {
 
-/**
- * maximum MPI message size for easy
- * buffer creation
- */
-const uint32_t MAX_MPI_MSG_SIZE = 2000;
-
-/**
- * \ingroup mpi
- *
- * \brief Tracks non-blocking sends
- *
- * This class is used to keep track of the asynchronous non-blocking
- * sends that have been posted.
- */
-class SentBuffer
-{
-public:
-  SentBuffer ();
-  ~SentBuffer ();
-
-  /**
-   * \return pointer to sent buffer
-   */
-  uint8_t* GetBuffer ();
-  /**
-   * \param buffer pointer to sent buffer
-   */
-  void SetBuffer (uint8_t* buffer);
-  /**
-   * \return MPI request
-   */
-  MPI_Request* GetRequest ();
-
-private:
-  uint8_t* m_buffer;
-  MPI_Request m_request;
-};
-
 class Packet;
 
 /**
@@ -129,8 +87,16 @@ public:
    * \param dev destination device
    *
    * Serialize and send a packet to the specified node and net device
+   *
+   * The packet is batched with the other packets to the same rank,
+   * and sent by FlushMessages () at the latest.  The packets to the
+   * ranks of the same host are written to shared memory instead.
    */
   virtual void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+  /**
+   * Send the messages batched since the last call
+   */
+  static void FlushMessages ();
   /**
    * Check for received messages complete
    */
@@ -149,6 +115,14 @@ public:
   static uint32_t GetTxCount ();
 
 private:
+  /**
+   * \param message a received message
+   * \param size size of the message, in bytes
+   *
+   * Schedule the reception of the packet of the message
+   */
+  static void ReceiveMessage (const uint8_t *message, uint32_t size);
+
   static uint32_t m_sid;
   static uint32_t m_size;
 
@@ -166,8 +140,11 @@ private:
   // Data buffers for non-blocking reads
   static char**   m_pRxBuffers;
 
-  // List of pending non-blocking sends
-  static std::list<SentBuffer> m_pendingTx;
+  // Frames batching the messages to the other ranks
+  static MpiFrameBuffer m_frames;
+
+  // Rings to and from the ranks of the same host
+  static MpiSharedMemory m_sharedMemory;
 };
 
 } // namespace ns3
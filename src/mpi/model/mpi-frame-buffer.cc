@@ -0,0 +1,298 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "mpi-frame-buffer.h"
+
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+
+#include <cstring>
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpiFrameBuffer");
+
+/**
+ * \ingroup mpi
+ * The size of the frames sent to the other ranks, and of the receive buffers.
+ */
+static GlobalValue g_mpiFrameSize ("MpiFrameSize",
+                                   "The size in bytes of the frames batching the messages sent to "
+                                   "another rank, and of the receive buffers; a packet sent to another "
+                                   "rank must fit in a frame with its headers.  Must be the same on "
+                                   "all the ranks.",
+                                   UintegerValue (65536),
+                                   MakeUintegerChecker<uint32_t> (256));
+
+/**
+ * \ingroup mpi
+ * Whether to batch the messages sent to the other ranks.
+ */
+static GlobalValue g_mpiSendAggregation ("MpiSendAggregation",
+                                         "Batch the messages sent to another rank into frames sent "
+                                         "when full and at the synchronization points, rather than "
+                                         "sending each message on its own.",
+                                         BooleanValue (true),
+                                         MakeBooleanChecker ());
+
+MpiFrameBuffer::MpiFrameBuffer ()
+  : m_frameSize (0),
+    m_aggregate (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MpiFrameBuffer::~MpiFrameBuffer ()
+{
+  // no logging: the interfaces hold their frame buffer in a static
+  DoClear ();
+}
+
+void
+MpiFrameBuffer::Initialize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  Clear ();
+  UintegerValue frameSize;
+  g_mpiFrameSize.GetValue (frameSize);
+  BooleanValue aggregate;
+  g_mpiSendAggregation.GetValue (aggregate);
+  // keep the frames a multiple of the alignment of the messages
+  m_frameSize = frameSize.Get () & ~7U;
+  m_aggregate = aggregate.Get ();
+  m_current.assign (size, 0);
+}
+
+uint32_t
+MpiFrameBuffer::GetFrameSize (void) const
+{
+  return m_frameSize;
+}
+
+uint32_t
+MpiFrameBuffer::GetRecordSize (uint32_t size)
+{
+  return HEADER_SIZE + ((size + 7) & ~7U);
+}
+
+MpiFrameBuffer::Frame *
+MpiFrameBuffer::AllocateFrame (void)
+{
+  NS_LOG_FUNCTION (this);
+  Frame *frame;
+  if (!m_free.empty ())
+    {
+      frame = m_free.back ();
+      m_free.pop_back ();
+    }
+  else
+    {
+      frame = new Frame;
+      frame->buffer = new uint8_t[m_frameSize];
+    }
+  frame->size = 0;
+  return frame;
+}
+
+uint8_t*
+MpiFrameBuffer::Reserve (uint32_t rank, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << rank << size);
+  NS_ASSERT (rank < m_current.size ());
+
+  uint32_t recordSize = GetRecordSize (size);
+  if (recordSize > m_frameSize)
+    {
+      NS_FATAL_ERROR ("A message of " << size << " bytes to rank " << rank <<
+                      " does not fit in the frames of MpiFrameSize=" << m_frameSize << " bytes");
+    }
+  Frame *frame = m_current[rank];
+  if (frame != 0 && frame->size + recordSize > m_frameSize)
+    {
+      Send (rank);
+      frame = 0;
+    }
+  if (frame == 0)
+    {
+      frame = AllocateFrame ();
+      m_current[rank] = frame;
+    }
+
+  uint8_t *record = frame->buffer + frame->size;
+  // clear the padding, which is sent too
+  std::memset (record + recordSize - 8, 0, 8);
+  uint32_t header[2] = { size, 0 };
+  std::memcpy (record, header, HEADER_SIZE);
+  frame->size += recordSize;
+  return record + HEADER_SIZE;
+}
+
+void
+MpiFrameBuffer::Commit (uint32_t rank)
+{
+  NS_LOG_FUNCTION (this << rank);
+  if (!m_aggregate)
+    {
+      Send (rank);
+    }
+}
+
+void
+MpiFrameBuffer::Flush (uint32_t rank)
+{
+  NS_LOG_FUNCTION (this << rank);
+  if (m_current[rank] != 0)
+    {
+      Send (rank);
+    }
+}
+
+void
+MpiFrameBuffer::FlushAll (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t rank = 0; rank < m_current.size (); ++rank)
+    {
+      if (m_current[rank] != 0)
+        {
+          Send (rank);
+        }
+    }
+}
+
+void
+MpiFrameBuffer::Send (uint32_t rank)
+{
+  NS_LOG_FUNCTION (this << rank);
+  Frame *frame = m_current[rank];
+  m_current[rank] = 0;
+  NS_LOG_LOGIC ("sending " << frame->size << " bytes to rank " << rank);
+  if (!m_send.IsNull ())
+    {
+      m_send (rank, frame->buffer, frame->size);
+      m_free.push_back (frame);
+      return;
+    }
+#ifdef NS3_MPI
+  MPI_Isend (reinterpret_cast<void *> (frame->buffer), frame->size, MPI_CHAR, rank,
+             0, MPI_COMM_WORLD, &frame->request);
+  m_pending.push_back (frame);
+#else
+  m_free.push_back (frame);
+#endif
+}
+
+void
+MpiFrameBuffer::TestSendComplete (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef NS3_MPI
+  std::list<Frame *>::iterator i = m_pending.begin ();
+  while (i != m_pending.end ())
+    {
+      MPI_Status status;
+      int flag = 0;
+      MPI_Test (&(*i)->request, &flag, &status);
+      std::list<Frame *>::iterator current = i; // Save current for erasing
+      ++i;                                      // Advance to next
+      if (flag)
+        { // This frame is sent, reuse it
+          m_free.push_back (*current);
+          m_pending.erase (current);
+        }
+    }
+#endif
+}
+
+void
+MpiFrameBuffer::Cancel (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef NS3_MPI
+  for (std::list<Frame *>::iterator i = m_pending.begin (); i != m_pending.end (); ++i)
+    {
+      MPI_Cancel (&(*i)->request);
+      MPI_Request_free (&(*i)->request);
+      m_free.push_back (*i);
+    }
+  m_pending.clear ();
+#endif
+}
+
+void
+MpiFrameBuffer::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  DoClear ();
+}
+
+void
+MpiFrameBuffer::SetSendCallback (Callback<void, uint32_t, const uint8_t *, uint32_t> send)
+{
+  NS_LOG_FUNCTION (this);
+  m_send = send;
+}
+
+void
+MpiFrameBuffer::DoClear (void)
+{
+  for (std::vector<Frame *>::iterator i = m_current.begin (); i != m_current.end (); ++i)
+    {
+      if (*i != 0)
+        {
+          m_free.push_back (*i);
+          *i = 0;
+        }
+    }
+  m_free.insert (m_free.end (), m_pending.begin (), m_pending.end ());
+  m_pending.clear ();
+  for (std::vector<Frame *>::iterator i = m_free.begin (); i != m_free.end (); ++i)
+    {
+      delete [] (*i)->buffer;
+      delete *i;
+    }
+  m_free.clear ();
+}
+
+const uint8_t*
+MpiFrameBuffer::NextMessage (const uint8_t *frame, uint32_t frameSize,
+                             uint32_t *offset, uint32_t *size)
+{
+  if (*offset + HEADER_SIZE > frameSize)
+    {
+      return 0;
+    }
+  uint32_t header[2];
+  std::memcpy (header, frame + *offset, HEADER_SIZE);
+  uint32_t recordSize = GetRecordSize (header[0]);
+  if (*offset + recordSize > frameSize)
+    {
+      NS_LOG_ERROR ("truncated message of " << header[0] << " bytes at offset " << *offset);
+      return 0;
+    }
+  const uint8_t *message = frame + *offset + HEADER_SIZE;
+  *size = header[0];
+  *offset += recordSize;
+  return message;
+}
+
+} // namespace ns3
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MPI_FRAME_BUFFER_H
+#define NS3_MPI_FRAME_BUFFER_H
+
+#include <stdint.h>
+#include <list>
+#include <vector>
+
+#include "ns3/callback.h"
+
+#ifdef NS3_MPI
+#include "mpi.h"
+#else
+typedef void* MPI_Request;
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Batches the messages sent to the other ranks into frames
+ *
+ * The messages to a rank are appended to the current frame of that
+ * rank, which is sent with a single non-blocking send when it is
+ * full or when it is flushed.  In a frame, each message is preceded
+ * by its size and padded to 8 bytes, so that the next one stays
+ * aligned.
+ *
+ * The frames have the size of the receive buffers, given by the
+ * MpiFrameSize global value, and are reused once their send is
+ * complete, so that the steady state allocates no memory.  With the
+ * MpiSendAggregation global value set to false, each message is
+ * sent in a frame of its own, as soon as it is committed.
+ */
+class MpiFrameBuffer
+{
+public:
+  MpiFrameBuffer ();
+  ~MpiFrameBuffer ();
+
+  /**
+   * \param size number of ranks
+   *
+   * Reads the frame size and the aggregation mode from the global
+   * values, which must be the same on all the ranks.
+   */
+  void Initialize (uint32_t size);
+  /**
+   * \return the size of the frames, and of the receive buffers, in bytes
+   */
+  uint32_t GetFrameSize (void) const;
+  /**
+   * \brief Reserve space for a message in the current frame of a rank
+   * \param rank destination rank
+   * \param size size of the message, in bytes
+   * \return where to write the message, aligned on 8 bytes
+   *
+   * The current frame is sent first if the message does not fit in it.
+   */
+  uint8_t* Reserve (uint32_t rank, uint32_t size);
+  /**
+   * \brief Complete the message last reserved for a rank
+   * \param rank destination rank
+   */
+  void Commit (uint32_t rank);
+  /**
+   * \brief Send the current frame of a rank, if not empty
+   * \param rank destination rank
+   */
+  void Flush (uint32_t rank);
+  /**
+   * \brief Send the current frames of all the ranks
+   */
+  void FlushAll (void);
+  /**
+   * \brief Recycle the frames whose send is complete
+   */
+  void TestSendComplete (void);
+  /**
+   * \brief Cancel the sends which are not complete
+   */
+  void Cancel (void);
+  /**
+   * \brief Free all the frames
+   */
+  void Clear (void);
+  /**
+   * \brief Hand the frames to a callback rather than to MPI
+   * \param send called with the destination rank, the frame and its size
+   * in bytes, in place of the send of the frame
+   *
+   * The frame is reused as soon as the callback returns.  This lets the
+   * frames be checked without another rank.
+   */
+  void SetSendCallback (Callback<void, uint32_t, const uint8_t *, uint32_t> send);
+
+  /**
+   * \brief Get the next message of a received frame
+   * \param frame the received frame
+   * \param frameSize number of bytes received
+   * \param [in,out] offset offset of the next message in the frame,
+   * moved past the message
+   * \param [out] size size of the message, in bytes
+   * \return the message, or 0 at the end of the frame
+   */
+  static const uint8_t* NextMessage (const uint8_t *frame, uint32_t frameSize,
+                                     uint32_t *offset, uint32_t *size);
+
+private:
+  /// A frame and the request of its send
+  struct Frame
+  {
+    uint8_t *buffer;      //!< the frame
+    uint32_t size;        //!< number of bytes used
+    MPI_Request request;  //!< request of the send
+  };
+
+  /// Size of the header preceding each message in a frame
+  static const uint32_t HEADER_SIZE = 8;
+
+  /**
+   * \param size size of a message
+   * \return size of the message padded to 8 bytes, with its header
+   */
+  static uint32_t GetRecordSize (uint32_t size);
+  /**
+   * \return an empty frame, reused if possible
+   */
+  Frame* AllocateFrame (void);
+  /**
+   * \brief Send the current frame of a rank
+   * \param rank destination rank
+   */
+  void Send (uint32_t rank);
+  /**
+   * \brief Free all the frames
+   */
+  void DoClear (void);
+
+  uint32_t m_frameSize;               //!< size of the frames
+  bool m_aggregate;                   //!< batch the messages to a rank
+  std::vector<Frame *> m_current;     //!< frame being filled, per rank
+  std::list<Frame *> m_pending;       //!< frames being sent
+  std::vector<Frame *> m_free;        //!< frames ready for reuse
+  /// replaces the sends, if set
+  Callback<void, uint32_t, const uint8_t *, uint32_t> m_send;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MPI_FRAME_BUFFER_H */
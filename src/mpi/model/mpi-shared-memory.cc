@@ -0,0 +1,393 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "mpi-shared-memory.h"
+
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include <cstring>
+#include <sstream>
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpiSharedMemory");
+
+/**
+ * \ingroup mpi
+ * Whether the ranks on the same host communicate through shared memory.
+ */
+static GlobalValue g_mpiSharedMemory ("MpiSharedMemory",
+                                      "Pass the messages between the ranks of a host through "
+                                      "shared memory rings rather than MPI.  Must be the same "
+                                      "on all the ranks.",
+                                      BooleanValue (true),
+                                      MakeBooleanChecker ());
+
+/**
+ * \ingroup mpi
+ * The size of the shared memory rings.
+ */
+static GlobalValue g_mpiSharedMemoryRingSize ("MpiSharedMemoryRingSize",
+                                              "The size in bytes of the shared memory ring from "
+                                              "a rank to another rank of the same host; the "
+                                              "messages which do not fit are sent through MPI.  "
+                                              "Must be the same on all the ranks.",
+                                              UintegerValue (4 * 1024 * 1024),
+                                              MakeUintegerChecker<uint32_t> (4096));
+
+MpiSharedMemoryRing::MpiSharedMemoryRing ()
+  : m_control (0),
+    m_data (0),
+    m_dataSize (0),
+    m_tail (0),
+    m_head (0)
+{
+}
+
+uint32_t
+MpiSharedMemoryRing::GetMemorySize (uint32_t dataSize)
+{
+  return sizeof (Control) + dataSize;
+}
+
+void
+MpiSharedMemoryRing::Attach (void *memory, uint32_t dataSize, bool initialize)
+{
+  NS_ASSERT (dataSize % 8 == 0);
+  m_control = static_cast<Control *> (memory);
+  m_data = static_cast<uint8_t *> (memory) + sizeof (Control);
+  m_dataSize = dataSize;
+  if (initialize)
+    {
+      std::memset (m_control, 0, sizeof (Control));
+    }
+  m_tail = __atomic_load_n (&m_control->tail, __ATOMIC_ACQUIRE);
+  m_head = __atomic_load_n (&m_control->head, __ATOMIC_ACQUIRE);
+}
+
+uint8_t*
+MpiSharedMemoryRing::Reserve (uint32_t size)
+{
+  uint32_t recordSize = HEADER_SIZE + ((size + 7) & ~7U);
+  if (recordSize > m_dataSize / 2)
+    {
+      return 0;
+    }
+  uint64_t head = __atomic_load_n (&m_control->head, __ATOMIC_ACQUIRE);
+  uint32_t position = m_tail % m_dataSize;
+  // a record is never split: skip the end of the messages area
+  uint32_t skip = position + recordSize > m_dataSize ? m_dataSize - position : 0;
+  if (m_tail - head + skip + recordSize > m_dataSize)
+    {
+      return 0;
+    }
+  uint32_t header[2] = { WRAP, 0 };
+  if (skip != 0)
+    {
+      std::memcpy (m_data + position, header, HEADER_SIZE);
+      m_tail += skip;
+      position = 0;
+    }
+  header[0] = size;
+  std::memcpy (m_data + position, header, HEADER_SIZE);
+  m_tail += recordSize;
+  return m_data + position + HEADER_SIZE;
+}
+
+void
+MpiSharedMemoryRing::Commit (void)
+{
+  __atomic_store_n (&m_control->tail, m_tail, __ATOMIC_RELEASE);
+}
+
+const uint8_t*
+MpiSharedMemoryRing::Peek (uint32_t *size)
+{
+  uint64_t tail = __atomic_load_n (&m_control->tail, __ATOMIC_ACQUIRE);
+  while (m_head != tail)
+    {
+      uint32_t position = m_head % m_dataSize;
+      uint32_t header[2];
+      std::memcpy (header, m_data + position, HEADER_SIZE);
+      if (header[0] == WRAP)
+        {
+          m_head += m_dataSize - position;
+          continue;
+        }
+      *size = header[0];
+      return m_data + position + HEADER_SIZE;
+    }
+  return 0;
+}
+
+void
+MpiSharedMemoryRing::Release (void)
+{
+  uint32_t header[2];
+  std::memcpy (header, m_data + m_head % m_dataSize, HEADER_SIZE);
+  m_head += HEADER_SIZE + ((header[0] + 7) & ~7U);
+  __atomic_store_n (&m_control->head, m_head, __ATOMIC_RELEASE);
+}
+
+MpiSharedMemory::MpiSharedMemory ()
+  : m_dataSize (0),
+    m_jobId (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MpiSharedMemory::~MpiSharedMemory ()
+{
+  // no logging: the interfaces hold their shared memory in a static
+  DoClear ();
+}
+
+std::string
+MpiSharedMemory::GetSegmentName (uint32_t owner) const
+{
+  std::ostringstream oss;
+  oss << "/ns3-mpi-" << m_jobId << "-" << owner;
+  return oss.str ();
+}
+
+void
+MpiSharedMemory::Initialize (uint32_t rank, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << rank << size);
+  Clear ();
+  m_outbound.assign (size, 0);
+#ifdef NS3_MPI
+  BooleanValue enabled;
+  g_mpiSharedMemory.GetValue (enabled);
+  if (!enabled.Get ())
+    {
+      return;
+    }
+  UintegerValue dataSize;
+  g_mpiSharedMemoryRingSize.GetValue (dataSize);
+  m_dataSize = dataSize.Get () & ~7U;
+  uint32_t ringSize = MpiSharedMemoryRing::GetMemorySize (m_dataSize);
+
+  // find the ranks on the same host
+  std::vector<char> names (size * MPI_MAX_PROCESSOR_NAME, 0);
+  char name[MPI_MAX_PROCESSOR_NAME] = { 0 };
+  int length;
+  MPI_Get_processor_name (name, &length);
+  MPI_Allgather (name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+                 &names[0], MPI_MAX_PROCESSOR_NAME, MPI_CHAR, MPI_COMM_WORLD);
+  std::vector<uint32_t> local;
+  uint32_t localIndex = 0;
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      if (std::strncmp (&names[i * MPI_MAX_PROCESSOR_NAME], name, MPI_MAX_PROCESSOR_NAME) == 0)
+        {
+          if (i == rank)
+            {
+              localIndex = local.size ();
+            }
+          local.push_back (i);
+        }
+    }
+  // the segments are named after the process id of the first rank
+  int jobId = getpid ();
+  MPI_Bcast (&jobId, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  m_jobId = jobId;
+
+  // create the segment of the rings written by the other local ranks
+  for (uint32_t i = 0; i < local.size (); ++i)
+    {
+      if (local[i] != rank)
+        {
+          m_peers.push_back (local[i]);
+        }
+    }
+  int ok = 1;
+  if (!m_peers.empty ())
+    {
+      uint32_t segmentSize = m_peers.size () * ringSize;
+      std::string segmentName = GetSegmentName (rank);
+      // remove a segment left by a crashed simulation
+      shm_unlink (segmentName.c_str ());
+      int fd = shm_open (segmentName.c_str (), O_CREAT | O_EXCL | O_RDWR, 0600);
+      void *segment = MAP_FAILED;
+      if (fd >= 0)
+        {
+          if (ftruncate (fd, segmentSize) == 0)
+            {
+              segment = mmap (0, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+          close (fd);
+        }
+      if (segment != MAP_FAILED)
+        {
+          m_segments.push_back (segment);
+          m_segmentSizes.push_back (segmentSize);
+          m_inbound.resize (m_peers.size ());
+          for (uint32_t i = 0; i < m_peers.size (); ++i)
+            {
+              m_inbound[i].Attach (static_cast<uint8_t *> (segment) + i * ringSize, m_dataSize, true);
+            }
+        }
+      else
+        {
+          NS_LOG_WARN ("cannot create the shared memory segment " << segmentName);
+          ok = 0;
+        }
+    }
+  int allOk;
+  MPI_Allreduce (&ok, &allOk, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  // map the rings to the other local ranks, in their segments
+  if (allOk)
+    {
+      m_rings.resize (m_peers.size ());
+      for (uint32_t i = 0; i < m_peers.size () && ok; ++i)
+        {
+          uint32_t owner = m_peers[i];
+          // the index of the ring of this rank, among the peers of the owner
+          uint32_t index = rank < owner ? localIndex : localIndex - 1;
+          uint32_t segmentSize = m_peers.size () * ringSize;
+          int fd = shm_open (GetSegmentName (owner).c_str (), O_RDWR, 0600);
+          void *segment = MAP_FAILED;
+          if (fd >= 0)
+            {
+              segment = mmap (0, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+              close (fd);
+            }
+          if (segment == MAP_FAILED)
+            {
+              NS_LOG_WARN ("cannot map the shared memory segment of rank " << owner);
+              ok = 0;
+              break;
+            }
+          m_segments.push_back (segment);
+          m_segmentSizes.push_back (segmentSize);
+          m_rings[i].Attach (static_cast<uint8_t *> (segment) + index * ringSize, m_dataSize, false);
+          m_outbound[owner] = &m_rings[i];
+        }
+      MPI_Allreduce (&ok, &allOk, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    }
+
+  // the segments stay mapped, and go away with the processes
+  if (!m_peers.empty () && !m_inbound.empty ())
+    {
+      shm_unlink (GetSegmentName (rank).c_str ());
+    }
+  if (!allOk)
+    {
+      NS_LOG_WARN ("the ranks of this host communicate through MPI");
+      DoClear ();
+      m_outbound.assign (size, 0);
+      return;
+    }
+  NS_LOG_LOGIC (m_peers.size () << " other ranks on this host");
+#endif
+}
+
+void
+MpiSharedMemory::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  DoClear ();
+}
+
+void
+MpiSharedMemory::DoClear (void)
+{
+#ifdef NS3_MPI
+  for (uint32_t i = 0; i < m_segments.size (); ++i)
+    {
+      munmap (m_segments[i], m_segmentSizes[i]);
+    }
+#endif
+  m_segments.clear ();
+  m_segmentSizes.clear ();
+  m_peers.clear ();
+  m_inbound.clear ();
+  m_outbound.clear ();
+  m_rings.clear ();
+}
+
+bool
+MpiSharedMemory::IsLocal (uint32_t rank) const
+{
+  return rank < m_outbound.size () && m_outbound[rank] != 0;
+}
+
+uint8_t*
+MpiSharedMemory::Reserve (uint32_t rank, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << rank << size);
+  if (!IsLocal (rank))
+    {
+      return 0;
+    }
+  uint8_t *message = m_outbound[rank]->Reserve (size);
+  if (message == 0)
+    {
+      // the messages must reach the rank in the order they are sent: it
+      // empties the ring before handling a frame received through MPI
+      NS_LOG_WARN ("ring to rank " << rank << " full, the following messages "
+                   "go through MPI; consider a larger MpiSharedMemoryRingSize");
+      m_outbound[rank] = 0;
+    }
+  return message;
+}
+
+void
+MpiSharedMemory::Commit (uint32_t rank)
+{
+  NS_LOG_FUNCTION (this << rank);
+  m_outbound[rank]->Commit ();
+}
+
+uint32_t
+MpiSharedMemory::GetNPeers (void) const
+{
+  return m_inbound.size ();
+}
+
+uint32_t
+MpiSharedMemory::GetPeer (uint32_t i) const
+{
+  return m_peers[i];
+}
+
+const uint8_t*
+MpiSharedMemory::Receive (uint32_t i, uint32_t *size)
+{
+  return m_inbound[i].Peek (size);
+}
+
+void
+MpiSharedMemory::Release (uint32_t i)
+{
+  m_inbound[i].Release ();
+}
+
+} // namespace ns3
@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MPI_SHARED_MEMORY_H
+#define NS3_MPI_SHARED_MEMORY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief A single-producer single-consumer ring of messages, in memory
+ * shared by two processes
+ *
+ * The producer and the consumer each attach their own instance to the
+ * same memory.  The memory starts with the positions of the producer
+ * and of the consumer, on separate cache lines, followed by the
+ * messages, each preceded by its size and padded to 8 bytes.  A
+ * message is published by storing the position of the producer with
+ * release semantics, and consumed by storing the position of the
+ * consumer, so that no lock is needed.
+ */
+class MpiSharedMemoryRing
+{
+public:
+  MpiSharedMemoryRing ();
+
+  /**
+   * \param dataSize the size of the messages area, in bytes
+   * \return the size of the memory of a ring
+   */
+  static uint32_t GetMemorySize (uint32_t dataSize);
+  /**
+   * \param memory the memory of the ring, aligned on 8 bytes
+   * \param dataSize the size of the messages area, a multiple of 8
+   * \param initialize whether to initialize the memory, by its owner
+   */
+  void Attach (void *memory, uint32_t dataSize, bool initialize);
+
+  /**
+   * \brief Reserve space for a message, on the producer side
+   * \param size size of the message, in bytes
+   * \return where to write the message, aligned on 8 bytes, or 0 if
+   * the ring is full
+   */
+  uint8_t* Reserve (uint32_t size);
+  /**
+   * \brief Publish the messages reserved so far
+   */
+  void Commit (void);
+
+  /**
+   * \brief Get the next message, on the consumer side
+   * \param [out] size size of the message, in bytes
+   * \return the message, or 0 if the ring is empty
+   */
+  const uint8_t* Peek (uint32_t *size);
+  /**
+   * \brief Consume the message returned by Peek ()
+   */
+  void Release (void);
+
+private:
+  /// The positions shared by the producer and the consumer
+  struct Control
+  {
+    uint64_t tail;        //!< bytes written by the producer
+    uint8_t pad1[56];     //!< keep the positions on separate cache lines
+    uint64_t head;        //!< bytes consumed by the consumer
+    uint8_t pad2[56];     //!< keep the messages on separate cache lines
+  };
+
+  /// Size of the header preceding each message
+  static const uint32_t HEADER_SIZE = 8;
+  /// Size in the header of the record marking the end of the ring
+  static const uint32_t WRAP = 0xffffffff;
+
+  Control *m_control;     //!< the shared positions
+  uint8_t *m_data;        //!< the shared messages
+  uint32_t m_dataSize;    //!< the size of the messages area
+  uint64_t m_tail;        //!< position of the producer, not yet published
+  uint64_t m_head;        //!< position of the consumer, not yet published
+};
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Passes the messages between the ranks of a host through
+ * shared memory
+ *
+ * Each rank owns a POSIX shared memory segment holding one
+ * MpiSharedMemoryRing per other rank on the same host, in which that
+ * rank writes its messages.  The messages are written in place and
+ * read in place, so that they are neither copied by MPI nor staged in
+ * frames.  When a message does not fit in its ring, it is left to the
+ * caller, which sends it through MPI, and so are all the following
+ * messages to the same rank: before handling a frame received through
+ * MPI, the receiver empties the ring of its sender, so that the
+ * messages of a rank are still received in the order they were sent.
+ *
+ * The MpiSharedMemory global value enables the rings, and
+ * MpiSharedMemoryRingSize sets their size.
+ */
+class MpiSharedMemory
+{
+public:
+  MpiSharedMemory ();
+  ~MpiSharedMemory ();
+
+  /**
+   * \brief Find the ranks on the same host, and map the rings
+   * \param rank the rank of this process
+   * \param size the number of ranks
+   *
+   * A collective operation, which must be called by all the ranks.
+   */
+  void Initialize (uint32_t rank, uint32_t size);
+  /**
+   * \brief Unmap the rings
+   */
+  void Clear (void);
+
+  /**
+   * \param rank a rank
+   * \return whether the messages to the rank go through shared memory
+   */
+  bool IsLocal (uint32_t rank) const;
+  /**
+   * \brief Reserve space for a message to a rank
+   * \param rank destination rank
+   * \param size size of the message, in bytes
+   * \return where to write the message, or 0 if the rank is not on
+   * this host or its ring is full, in which case the ring is no longer
+   * used
+   */
+  uint8_t* Reserve (uint32_t rank, uint32_t size);
+  /**
+   * \brief Publish the message last reserved for a rank
+   * \param rank destination rank
+   */
+  void Commit (uint32_t rank);
+
+  /**
+   * \return the number of ranks which write to this rank
+   */
+  uint32_t GetNPeers (void) const;
+  /**
+   * \param i index of a peer
+   * \return the rank of the peer
+   */
+  uint32_t GetPeer (uint32_t i) const;
+  /**
+   * \brief Get the next message from a peer
+   * \param i index of the peer
+   * \param [out] size size of the message, in bytes
+   * \return the message, or 0 if there is none
+   */
+  const uint8_t* Receive (uint32_t i, uint32_t *size);
+  /**
+   * \brief Consume the message returned by Receive ()
+   * \param i index of the peer
+   */
+  void Release (uint32_t i);
+
+private:
+  /**
+   * \param owner the rank owning a segment
+   * \return the name of the segment
+   */
+  std::string GetSegmentName (uint32_t owner) const;
+  /**
+   * \brief Unmap the rings
+   */
+  void DoClear (void);
+
+  uint32_t m_dataSize;                          //!< size of the messages area of a ring
+  uint32_t m_jobId;                             //!< identifies the segments of this simulation
+  std::vector<uint32_t> m_peers;                //!< the other ranks on this host
+  std::vector<MpiSharedMemoryRing> m_inbound;   //!< the rings written by each peer
+  std::vector<MpiSharedMemoryRing *> m_outbound; //!< the ring to each rank, or 0
+  std::vector<MpiSharedMemoryRing> m_rings;     //!< storage of the outbound rings
+  std::vector<void *> m_segments;               //!< the mapped segments
+  std::vector<uint32_t> m_segmentSizes;         //!< the size of the mapped segments
+};
+
+} // namespace ns3
+
+#endif /* NS3_MPI_SHARED_MEMORY_H */
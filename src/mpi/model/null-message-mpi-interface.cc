@@ -45,49 +45,13 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("NullMessageMpiInterface");
 
-/**
- * maximum MPI message size for easy
- * buffer creation
- */
-#ifdef NS3_MPI
-const uint32_t NULL_MESSAGE_MAX_MPI_MSG_SIZE = 2000;
-#endif
-
-NullMessageSentBuffer::NullMessageSentBuffer ()
-{
-  m_buffer = 0;
-  m_request = 0;
-}
-
-NullMessageSentBuffer::~NullMessageSentBuffer ()
-{
-  delete [] m_buffer;
-}
-
-uint8_t*
-NullMessageSentBuffer::GetBuffer ()
-{
-  return m_buffer;
-}
-
-void
-NullMessageSentBuffer::SetBuffer (uint8_t* buffer)
-{
-  m_buffer = buffer;
-}
-
-MPI_Request*
-NullMessageSentBuffer::GetRequest ()
-{
-  return &m_request;
-}
-
 uint32_t              NullMessageMpiInterface::g_sid = 0;
 uint32_t              NullMessageMpiInterface::g_size = 1;
 uint32_t              NullMessageMpiInterface::g_numNeighbors = 0;
 bool                  NullMessageMpiInterface::g_initialized = false;
 bool                  NullMessageMpiInterface::g_enabled = false;
-std::list<NullMessageSentBuffer> NullMessageMpiInterface::g_pendingTx;
+MpiFrameBuffer        NullMessageMpiInterface::g_frames;
+MpiSharedMemory       NullMessageMpiInterface::g_sharedMemory;
 
 MPI_Request* NullMessageMpiInterface::g_requests;
 char**       NullMessageMpiInterface::g_pRxBuffers;
@@ -175,7 +139,10 @@ NullMessageMpiInterface::InitializeSendReceiveBuffers(void)
 
   g_numNeighbors = RemoteChannelBundleManager::Size();
 
-  // Post a non-blocking receive for all peers
+  g_frames.Initialize (g_size);
+  uint32_t frameSize = g_frames.GetFrameSize ();
+
+  // Post a persistent non-blocking receive for all peers
   g_requests = new MPI_Request[g_numNeighbors];
   g_pRxBuffers = new char*[g_numNeighbors];
   int index = 0;
@@ -184,12 +151,14 @@ NullMessageMpiInterface::InitializeSendReceiveBuffers(void)
       Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find(rank);
       if (bundle) 
         {
-          g_pRxBuffers[index] = new char[NULL_MESSAGE_MAX_MPI_MSG_SIZE];
-          MPI_Irecv (g_pRxBuffers[index], NULL_MESSAGE_MAX_MPI_MSG_SIZE, MPI_CHAR, rank, 0,
-                     MPI_COMM_WORLD, &g_requests[index]);
+          g_pRxBuffers[index] = new char[frameSize];
+          MPI_Recv_init (g_pRxBuffers[index], frameSize, MPI_CHAR, rank, 0,
+                         MPI_COMM_WORLD, &g_requests[index]);
+          MPI_Start (&g_requests[index]);
           ++index;
         }
     }
+  g_sharedMemory.Initialize (g_sid, g_size);
 #endif
 }
 
@@ -206,14 +175,15 @@ NullMessageMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t
   Ptr<Node> destNode = NodeList::GetNode (node);
   uint32_t nodeSysId = destNode->GetSystemId ();
 
-  NullMessageSentBuffer sendBuf;
-  g_pendingTx.push_back (sendBuf);
-  std::list<NullMessageSentBuffer>::reverse_iterator iter = g_pendingTx.rbegin (); // Points to the last element
-
   uint32_t serializedSize = p->GetSerializedSize ();
   uint32_t bufferSize = serializedSize + ( 2 * sizeof (uint64_t) ) + ( 2 * sizeof (uint32_t) );
-  uint8_t* buffer =  new uint8_t[bufferSize];
-  iter->SetBuffer (buffer);
+  // write the packet in place in shared memory, if the task is on this host
+  uint8_t* buffer = g_sharedMemory.Reserve (nodeSysId, bufferSize);
+  bool shared = buffer != 0;
+  if (!shared)
+    {
+      buffer = g_frames.Reserve (nodeSysId, bufferSize);
+    }
   // Add the time, dest node and dest device
   uint64_t t = rxTime.GetInteger ();
   uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
@@ -228,8 +198,14 @@ NullMessageMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t
   // Serialize the packet
   p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
 
-  MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (iter->GetRequest ()));
+  if (shared)
+    {
+      g_sharedMemory.Commit (nodeSysId);
+    }
+  else
+    {
+      g_frames.Commit (nodeSysId);
+    }
 
   NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (nodeSysId);
 
@@ -245,13 +221,16 @@ NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<Remo
 
 #ifdef NS3_MPI
 
-  NullMessageSentBuffer sendBuf;
-  g_pendingTx.push_back (sendBuf);
-  std::list<NullMessageSentBuffer>::reverse_iterator iter = g_pendingTx.rbegin (); // Points to the last element
+  // Find the system id for the destination MPI rank
+  uint32_t nodeSysId = bundle->GetSystemId ();
 
   uint32_t bufferSize = 2 * sizeof (uint64_t) + 2 * sizeof (uint32_t);
-  uint8_t* buffer =  new uint8_t[bufferSize];
-  iter->SetBuffer (buffer);
+  uint8_t* buffer = g_sharedMemory.Reserve (nodeSysId, bufferSize);
+  bool shared = buffer != 0;
+  if (!shared)
+    {
+      buffer = g_frames.Reserve (nodeSysId, bufferSize);
+    }
   // Add the time, dest node and dest device
   uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
   *pTime++ = 0;
@@ -260,11 +239,16 @@ NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<Remo
   *pData++ = 0;
   *pData++ = 0;
 
-  // Find the system id for the destination MPI rank
-  uint32_t nodeSysId = bundle->GetSystemId ();
-
-  MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (iter->GetRequest ()));
+  if (shared)
+    {
+      g_sharedMemory.Commit (nodeSysId);
+    }
+  else
+    {
+      // Send the batched packets along with the Null Message
+      g_frames.Commit (nodeSysId);
+      g_frames.Flush (nodeSysId);
+    }
 #endif
 }
 
@@ -273,6 +257,10 @@ NullMessageMpiInterface::ReceiveMessagesBlocking ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+#ifdef NS3_MPI
+  // The other tasks may be waiting for the batched messages
+  g_frames.FlushAll ();
+#endif
   ReceiveMessages(true);
 }
 
@@ -295,96 +283,160 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
 
 #ifdef NS3_MPI
 
-  // stop flag set to true when no more messages are found to
-  // process.
-  bool stop = false;
-
-
   if (!g_numNeighbors) {
     // Not communicating with anyone.
     return;
   }
 
+  // The rings from the tasks of this host cannot be waited on, so poll
+  // them along with MPI when blocking.
+  bool waitMpi = blocking && g_sharedMemory.GetNPeers () == 0;
+  bool received = false;
   do
     {
-      int messageReceived = 0;
-      int index = 0;
-      MPI_Status status;
-
-      if (blocking)
-        {
-          MPI_Waitany (g_numNeighbors, g_requests, &index, &status);
-          messageReceived = 1; /* Wait always implies message was received */
-          stop = true;
-        }
-      else
-        {
-          MPI_Testany (g_numNeighbors, g_requests, &index, &messageReceived, &status);
-        }
+      // stop flag set to true when no more messages are found to
+      // process.
+      bool stop = false;
 
-      if (messageReceived)
+      do
         {
-          int count;
-          MPI_Get_count (&status, MPI_CHAR, &count);
+          int messageReceived = 0;
+          int index = 0;
+          MPI_Status status;
 
-          // Get the meta data first
-          uint64_t* pTime = reinterpret_cast<uint64_t *> (g_pRxBuffers[index]);
-          uint64_t time = *pTime++;
-          uint64_t guaranteeUpdate = *pTime++;
-
-          uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-          uint32_t node = *pData++;
-          uint32_t dev  = *pData++;
-
-          Time rxTime (time);
-
-          // rxtime == 0 means this is a Null Message
-          if (rxTime > Time (0))
+          if (waitMpi)
             {
-              count -= sizeof (time) + sizeof (guaranteeUpdate) + sizeof (node) + sizeof (dev);
-
-              Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+              MPI_Waitany (g_numNeighbors, g_requests, &index, &status);
+              messageReceived = 1; /* Wait always implies message was received */
+              stop = true;
+            }
+          else
+            {
+              MPI_Testany (g_numNeighbors, g_requests, &index, &messageReceived, &status);
+            }
 
-              // Find the correct node/device to schedule receive event
-              Ptr<Node> pNode = NodeList::GetNode (node);
-              Ptr<MpiReceiver> pMpiRec = 0;
-              uint32_t nDevices = pNode->GetNDevices ();
-              for (uint32_t i = 0; i < nDevices; ++i)
+          if (messageReceived)
+            {
+              int frameSize;
+              MPI_Get_count (&status, MPI_CHAR, &frameSize);
+
+              Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (status.MPI_SOURCE);
+              NS_ASSERT (bundle);
+
+              // A task of this host sends through MPI only once its ring
+              // is full, so its messages still in the ring were sent
+              // before those of the frame
+              ReceiveSharedMessages (status.MPI_SOURCE);
+
+              // Process each message of the frame, in the order they were sent
+              const uint8_t* frame = reinterpret_cast<uint8_t *> (g_pRxBuffers[index]);
+              uint32_t offset = 0;
+              uint32_t count;
+              const uint8_t* message;
+              while ((message = MpiFrameBuffer::NextMessage (frame, frameSize, &offset, &count)) != 0)
                 {
-                  Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-                  if (pThisDev->GetIfIndex () == dev)
-                    {
-                      pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-                      break;
-                    }
+                  ReceiveMessage (bundle, message, count);
                 }
-              NS_ASSERT (pNode && pMpiRec);
 
-              // Schedule the rx event
-              Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                              &MpiReceiver::Receive, pMpiRec, p);
+              // Re-queue the next read
+              MPI_Start (&g_requests[index]);
+              received = true;
+            }
+          else
+            {
+              // if non-blocking and no message received in testany then stop message loop
+              stop = true;
+            }
+        }
+      while (!stop);
 
+      for (uint32_t i = 0; i < g_sharedMemory.GetNPeers (); ++i)
+        {
+          if (ReceiveSharedMessages (g_sharedMemory.GetPeer (i)))
+            {
+              received = true;
             }
+        }
+    }
+  while (blocking && !received);
+#endif
+}
+
+bool
+NullMessageMpiInterface::ReceiveSharedMessages (uint32_t rank)
+{
+  NS_LOG_FUNCTION (rank);
 
-          // Update guarantee time for both packet receives and Null Messages.
-          Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (status.MPI_SOURCE);
+  bool received = false;
+#ifdef NS3_MPI
+  for (uint32_t i = 0; i < g_sharedMemory.GetNPeers (); ++i)
+    {
+      if (g_sharedMemory.GetPeer (i) != rank)
+        {
+          continue;
+        }
+      Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (rank);
+      uint32_t count;
+      const uint8_t* message;
+      while ((message = g_sharedMemory.Receive (i, &count)) != 0)
+        {
           NS_ASSERT (bundle);
+          ReceiveMessage (bundle, message, count);
+          g_sharedMemory.Release (i);
+          received = true;
+        }
+      break;
+    }
+#endif
+  return received;
+}
+
+void
+NullMessageMpiInterface::ReceiveMessage (Ptr<RemoteChannelBundle> bundle, const uint8_t* message, uint32_t count)
+{
+  NS_LOG_FUNCTION (bundle << message << count);
 
-          bundle->SetGuaranteeTime (Time (guaranteeUpdate));
+  // Get the meta data first
+  const uint64_t* pTime = reinterpret_cast<const uint64_t *> (message);
+  uint64_t time = *pTime++;
+  uint64_t guaranteeUpdate = *pTime++;
 
-          // Re-queue the next read
-          MPI_Irecv (g_pRxBuffers[index], NULL_MESSAGE_MAX_MPI_MSG_SIZE, MPI_CHAR, status.MPI_SOURCE, 0,
-                     MPI_COMM_WORLD, &g_requests[index]);
+  const uint32_t* pData = reinterpret_cast<const uint32_t *> (pTime);
+  uint32_t node = *pData++;
+  uint32_t dev  = *pData++;
 
-        }
-      else
+  Time rxTime (time);
+
+  // rxtime == 0 means this is a Null Message
+  if (rxTime > Time (0))
+    {
+      count -= sizeof (time) + sizeof (guaranteeUpdate) + sizeof (node) + sizeof (dev);
+
+      Ptr<Packet> p = Create<Packet> (reinterpret_cast<const uint8_t *> (pData), count, true);
+
+      // Find the correct node/device to schedule receive event
+      Ptr<Node> pNode = NodeList::GetNode (node);
+      Ptr<MpiReceiver> pMpiRec = 0;
+      uint32_t nDevices = pNode->GetNDevices ();
+      for (uint32_t i = 0; i < nDevices; ++i)
         {
-          // if non-blocking and no message received in testany then stop message loop
-          stop = true;
+          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+          if (pThisDev->GetIfIndex () == dev)
+            {
+              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+              break;
+            }
         }
+      NS_ASSERT (pNode && pMpiRec);
+
+      // Schedule the rx event
+      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                      &MpiReceiver::Receive, pMpiRec, p);
+
     }
-  while (!stop);
-#endif
+
+  // Update guarantee time for both packet receives and Null Messages.
+  bundle->SetGuaranteeTime (Time (guaranteeUpdate));
 }
 
 void
@@ -395,19 +447,7 @@ NullMessageMpiInterface::TestSendComplete ()
   NS_ASSERT (g_enabled);
 
 #ifdef NS3_MPI
-  std::list<NullMessageSentBuffer>::iterator iter = g_pendingTx.begin ();
-  while (iter != g_pendingTx.end ())
-    {
-      MPI_Status status;
-      int flag = 0;
-      MPI_Test (iter->GetRequest (), &flag, &status);
-      std::list<NullMessageSentBuffer>::iterator current = iter; // Save current for erasing
-      ++iter; // Advance to next
-      if (flag)
-        { // This message is complete
-          g_pendingTx.erase (current);
-        }
-    }
+  g_frames.TestSendComplete ();
 #endif
 }
 
@@ -422,13 +462,7 @@ NullMessageMpiInterface::Disable ()
   if (flag)
     {
 
-      for (std::list<NullMessageSentBuffer>::iterator iter = g_pendingTx.begin ();
-           iter != g_pendingTx.end ();
-           ++iter)
-        {
-          MPI_Cancel (iter->GetRequest ());
-          MPI_Request_free (iter->GetRequest ());
-        }
+      g_frames.Cancel ();
 
       for (uint32_t i = 0; i < g_numNeighbors; ++i)
         {
@@ -445,7 +479,8 @@ NullMessageMpiInterface::Disable ()
       delete [] g_pRxBuffers;
       delete [] g_requests;
 
-      g_pendingTx.clear ();
+      g_frames.Clear ();
+      g_sharedMemory.Clear ();
 
       g_enabled = false;
       g_initialized = false;
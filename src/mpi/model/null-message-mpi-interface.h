@@ -23,16 +23,12 @@
 #define NS3_NULLMESSAGE_MPI_INTERFACE_H
 
 #include "parallel-communication-interface.h"
+#include "mpi-frame-buffer.h"
+#include "mpi-shared-memory.h"
 
 #include <ns3/nstime.h>
 #include <ns3/buffer.h>
 
-#ifdef NS3_MPI
-#include "mpi.h"
-#else
-typedef void* MPI_Request;
-#endif
-
 #include <list>
 
 namespace ns3 {
@@ -40,45 +36,6 @@ namespace ns3 {
 class RemoteChannelBundle;
 class Packet;
 
-/**
- * \ingroup mpi
- *
- * \brief Non-blocking send buffers for Null Message implementation.
- * 
- * One buffer is allocated for each non-blocking send.
- */
-class NullMessageSentBuffer
-{
-public:
-  NullMessageSentBuffer ();
-  ~NullMessageSentBuffer ();
-
-  /**
-   * \return pointer to sent buffer
-   */
-  uint8_t* GetBuffer ();
-  /**
-   * \param buffer pointer to sent buffer
-   */
-  void SetBuffer (uint8_t* buffer);
-  /**
-   * \return MPI request
-   */
-  MPI_Request* GetRequest ();
-
-private:
-
-  /**
-   * Buffer for send.
-   */
-  uint8_t* m_buffer;
-
-  /**
-   * MPI request posted for the send.
-   */
-  MPI_Request m_request;
-};
-
 /**
  * \ingroup mpi
  *
@@ -129,6 +86,9 @@ public:
    * \param dev destination device
    *
    * Serialize and send a packet to the specified node and net device.
+   * The packet is batched with the other messages to the same rank,
+   * and sent with the next Null Message to that rank, or before
+   * blocking for messages, at the latest.
    *
    * \internal
    * The MPI buffer format packs a delivery information and the serialized packet.
@@ -152,7 +112,9 @@ public:
    *
    * Null Messages are sent when a packet has not been sent across
    * this bundle in order to allow time advancement on the remote
-   * MPI task.
+   * MPI task.  The Null Message is sent at once, with the packets
+   * batched for the remote MPI task, or written to shared memory if
+   * the remote MPI task is on the same host.
    *
    * \internal
    * The Null Message MPI buffer format is based on the format for sending a packet with
@@ -172,7 +134,9 @@ public:
   static void ReceiveMessagesNonBlocking ();
   /**
    * Blocking message receive.  Will block until at least one message
-   * has been received.
+   * has been received, after sending the batched messages.  When
+   * tasks of the same host communicate through shared memory, polls
+   * until a message is received.
    */
   static void ReceiveMessagesBlocking ();
   /**
@@ -198,6 +162,23 @@ private:
    * receive all messages that are queued up locally.
    */
   static void ReceiveMessages (bool blocking = false);
+  /**
+   * \param bundle the bundle of the sending task
+   * \param message a received message
+   * \param size size of the message, in bytes
+   *
+   * Schedule the reception of the packet of the message, if any, and
+   * update the guarantee time of the bundle.
+   */
+  static void ReceiveMessage (Ptr<RemoteChannelBundle> bundle, const uint8_t *message, uint32_t size);
+  /**
+   * \param rank the sending task
+   * \return whether a message was received
+   *
+   * Receive the messages waiting in the shared memory ring of a task of
+   * this host, if any.
+   */
+  static bool ReceiveSharedMessages (uint32_t rank);
 
   // System ID (rank) for this task
   static uint32_t g_sid;
@@ -217,8 +198,11 @@ private:
   // Data buffers for non-blocking receives
   static char**   g_pRxBuffers;
 
-  // List of pending non-blocking sends
-  static std::list<NullMessageSentBuffer> g_pendingTx;
+  // Frames batching the messages to the other tasks
+  static MpiFrameBuffer g_frames;
+
+  // Rings to and from the tasks of the same host
+  static MpiSharedMemory g_sharedMemory;
 };
 
 } // namespace ns3
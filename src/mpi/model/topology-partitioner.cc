@@ -0,0 +1,547 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "topology-partitioner.h"
+
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TopologyPartitioner");
+
+/**
+ * \ingroup mpi
+ * The number of vertices per part below which the graph is not coarsened.
+ */
+static const uint32_t COARSEN_VERTICES_PER_PART = 15;
+
+/**
+ * \ingroup mpi
+ * The number of refinement passes at each level of the coarsening.
+ */
+static const uint32_t REFINE_PASSES = 8;
+
+/**
+ * \ingroup mpi
+ * \param parent the parent of each element in a union-find forest
+ * \param i an element
+ * \return the root of the tree of the element
+ */
+static uint32_t
+FindRoot (std::vector<uint32_t> &parent, uint32_t i)
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+TopologyPartitioner::TopologyPartitioner ()
+  : m_maxImbalance (1.05),
+    m_minLookahead (Seconds (0)),
+    m_nParts (0),
+    m_random (1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TopologyPartitioner::SetMaxImbalance (double imbalance)
+{
+  NS_LOG_FUNCTION (this << imbalance);
+  NS_ASSERT_MSG (imbalance >= 1.0, "The imbalance of the parts is at least 1");
+  m_maxImbalance = imbalance;
+}
+
+void
+TopologyPartitioner::SetMinLookahead (Time lookahead)
+{
+  NS_LOG_FUNCTION (this << lookahead);
+  m_minLookahead = lookahead;
+}
+
+uint32_t
+TopologyPartitioner::GetIndex (Ptr<Node> node)
+{
+  std::map<uint32_t, uint32_t>::const_iterator i = m_indexes.find (node->GetId ());
+  if (i != m_indexes.end ())
+    {
+      return i->second;
+    }
+  uint32_t index = m_nodes.size ();
+  m_indexes[node->GetId ()] = index;
+  m_nodes.push_back (node);
+  m_loads.push_back (1.0);
+  return index;
+}
+
+void
+TopologyPartitioner::Add (Ptr<Node> node, double load)
+{
+  NS_LOG_FUNCTION (this << node << load);
+  m_loads[GetIndex (node)] = load;
+}
+
+void
+TopologyPartitioner::Add (NodeContainer nodes, double load)
+{
+  NS_LOG_FUNCTION (this << load);
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Add (*i, load);
+    }
+}
+
+void
+TopologyPartitioner::AddLink (Ptr<Node> a, Ptr<Node> b, Time delay, double traffic)
+{
+  NS_LOG_FUNCTION (this << a << b << delay << traffic);
+  Link link;
+  link.a = GetIndex (a);
+  link.b = GetIndex (b);
+  link.delay = delay;
+  link.traffic = traffic;
+  m_links.push_back (link);
+}
+
+uint32_t
+TopologyPartitioner::NextRandom (void)
+{
+  m_random = m_random * 1103515245 + 12345;
+  return m_random >> 16;
+}
+
+void
+TopologyPartitioner::Contract (const Graph &graph, const std::vector<uint32_t> &map,
+                               uint32_t n, Graph *coarse)
+{
+  std::vector<std::map<uint32_t, double> > edges (n);
+  coarse->weight.assign (n, 0.0);
+  for (uint32_t v = 0; v < graph.weight.size (); ++v)
+    {
+      uint32_t cv = map[v];
+      coarse->weight[cv] += graph.weight[v];
+      for (uint32_t e = 0; e < graph.adj[v].size (); ++e)
+        {
+          uint32_t cu = map[graph.adj[v][e].first];
+          if (cu != cv)
+            {
+              edges[cv][cu] += graph.adj[v][e].second;
+            }
+        }
+    }
+  coarse->adj.assign (n, std::vector<std::pair<uint32_t, double> > ());
+  for (uint32_t cv = 0; cv < n; ++cv)
+    {
+      coarse->adj[cv].assign (edges[cv].begin (), edges[cv].end ());
+    }
+}
+
+uint32_t
+TopologyPartitioner::Match (const Graph &graph, double maxWeight, std::vector<uint32_t> *map)
+{
+  uint32_t n = graph.weight.size ();
+  std::vector<uint32_t> order (n);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      order[v] = v;
+    }
+  // visit the vertices in a random order, the same on all the ranks
+  for (uint32_t i = n; i > 1; --i)
+    {
+      std::swap (order[i - 1], order[NextRandom () % i]);
+    }
+
+  const uint32_t unmatched = n;
+  map->assign (n, unmatched);
+  uint32_t coarse = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t v = order[i];
+      if ((*map)[v] != unmatched)
+        {
+          continue;
+        }
+      uint32_t best = unmatched;
+      double bestWeight = 0.0;
+      for (uint32_t e = 0; e < graph.adj[v].size (); ++e)
+        {
+          uint32_t u = graph.adj[v][e].first;
+          if ((*map)[u] == unmatched
+              && graph.weight[v] + graph.weight[u] <= maxWeight
+              && graph.adj[v][e].second > bestWeight)
+            {
+              best = u;
+              bestWeight = graph.adj[v][e].second;
+            }
+        }
+      (*map)[v] = coarse;
+      if (best != unmatched)
+        {
+          (*map)[best] = coarse;
+        }
+      ++coarse;
+    }
+  return coarse;
+}
+
+void
+TopologyPartitioner::GrowParts (const Graph &graph, uint32_t nParts, std::vector<uint32_t> *part) const
+{
+  uint32_t n = graph.weight.size ();
+  double total = 0.0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      total += graph.weight[v];
+    }
+  double target = total / nParts;
+
+  const uint32_t unassigned = nParts;
+  part->assign (n, unassigned);
+  uint32_t remaining = n;
+  for (uint32_t p = 0; p + 1 < nParts && remaining > 0; ++p)
+    {
+      // connection of the unassigned vertices to the part being grown
+      std::map<uint32_t, double> frontier;
+      double weight = 0.0;
+      uint32_t next = 0;
+      while (weight < target && remaining > 0)
+        {
+          uint32_t v = unassigned;
+          double best = -1.0;
+          for (std::map<uint32_t, double>::const_iterator i = frontier.begin (); i != frontier.end (); ++i)
+            {
+              if (i->second > best)
+                {
+                  v = i->first;
+                  best = i->second;
+                }
+            }
+          if (v == unassigned)
+            {
+              // start the part, or continue it in another component
+              while ((*part)[next] != unassigned)
+                {
+                  ++next;
+                }
+              v = next;
+            }
+          if (weight > 0.0 && weight + graph.weight[v] > target * m_maxImbalance)
+            {
+              break;
+            }
+          (*part)[v] = p;
+          weight += graph.weight[v];
+          --remaining;
+          frontier.erase (v);
+          for (uint32_t e = 0; e < graph.adj[v].size (); ++e)
+            {
+              uint32_t u = graph.adj[v][e].first;
+              if ((*part)[u] == unassigned)
+                {
+                  frontier[u] += graph.adj[v][e].second;
+                }
+            }
+        }
+    }
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      if ((*part)[v] == unassigned)
+        {
+          (*part)[v] = nParts - 1;
+        }
+    }
+}
+
+void
+TopologyPartitioner::Refine (const Graph &graph, uint32_t nParts, std::vector<uint32_t> *part) const
+{
+  uint32_t n = graph.weight.size ();
+  std::vector<double> partWeight (nParts, 0.0);
+  std::vector<uint32_t> partSize (nParts, 0);
+  double total = 0.0;
+  double heaviest = 0.0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      partWeight[(*part)[v]] += graph.weight[v];
+      ++partSize[(*part)[v]];
+      total += graph.weight[v];
+      heaviest = std::max (heaviest, graph.weight[v]);
+    }
+  // a coarse vertex cannot be split, so allow one more of the heaviest
+  double maxWeight = std::max (m_maxImbalance * total / nParts, total / nParts + heaviest);
+
+  std::vector<double> conn (nParts, 0.0);
+  for (uint32_t pass = 0; pass < REFINE_PASSES; ++pass)
+    {
+      uint32_t moves = 0;
+      for (uint32_t v = 0; v < n; ++v)
+        {
+          uint32_t from = (*part)[v];
+          if (partSize[from] == 1)
+            {
+              continue;
+            }
+          bool overweight = partWeight[from] > maxWeight;
+          bool boundary = false;
+          for (uint32_t e = 0; e < graph.adj[v].size (); ++e)
+            {
+              uint32_t p = (*part)[graph.adj[v][e].first];
+              conn[p] += graph.adj[v][e].second;
+              boundary = boundary || p != from;
+            }
+          if (boundary || overweight)
+            {
+              uint32_t to = nParts;
+              double bestGain = 0.0;
+              for (uint32_t p = 0; p < nParts; ++p)
+                {
+                  if (p == from || partWeight[p] + graph.weight[v] > maxWeight)
+                    {
+                      continue;
+                    }
+                  double gain = conn[p] - conn[from];
+                  bool better;
+                  if (to == nParts)
+                    {
+                      // a move must reduce the cut, or keep it and
+                      // improve the balance, unless the part is too heavy
+                      better = overweight || gain > 0.0
+                        || (gain == 0.0 && conn[p] > 0.0
+                            && partWeight[p] + graph.weight[v] < partWeight[from]);
+                    }
+                  else
+                    {
+                      better = gain > bestGain
+                        || (gain == bestGain && partWeight[p] < partWeight[to]);
+                    }
+                  if (better)
+                    {
+                      to = p;
+                      bestGain = gain;
+                    }
+                }
+              if (to != nParts)
+                {
+                  (*part)[v] = to;
+                  partWeight[from] -= graph.weight[v];
+                  partWeight[to] += graph.weight[v];
+                  --partSize[from];
+                  ++partSize[to];
+                  ++moves;
+                }
+            }
+          for (uint32_t e = 0; e < graph.adj[v].size (); ++e)
+            {
+              conn[(*part)[graph.adj[v][e].first]] = 0.0;
+            }
+          conn[from] = 0.0;
+        }
+      NS_LOG_LOGIC ("refinement pass " << pass << " of " << n << " vertices: " << moves << " moves");
+      if (moves == 0)
+        {
+          break;
+        }
+    }
+}
+
+void
+TopologyPartitioner::Partition (uint32_t nParts)
+{
+  NS_LOG_FUNCTION (this << nParts);
+  NS_ASSERT (nParts > 0);
+  m_nParts = nParts;
+  m_random = 1;
+  uint32_t n = m_nodes.size ();
+  m_parts.assign (n, 0);
+  if (nParts == 1 || n == 0)
+    {
+      return;
+    }
+
+  // the cost of cutting a link grows as its delay, and the lookahead, shrink
+  double maxDelay = 1.0;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      maxDelay = std::max (maxDelay, i->delay.GetDouble ());
+    }
+  Graph graph;
+  graph.weight = m_loads;
+  graph.adj.resize (n);
+  std::vector<uint32_t> parent (n);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      parent[v] = v;
+    }
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (i->a == i->b)
+        {
+          continue;
+        }
+      double weight = i->traffic * maxDelay / std::max (1.0, i->delay.GetDouble ());
+      graph.adj[i->a].push_back (std::make_pair (i->b, weight));
+      graph.adj[i->b].push_back (std::make_pair (i->a, weight));
+      if (i->delay < m_minLookahead)
+        {
+          parent[FindRoot (parent, i->a)] = FindRoot (parent, i->b);
+        }
+    }
+
+  // merge the nodes of the links which must not be cut
+  std::vector<uint32_t> component (n, n);
+  uint32_t nComponents = 0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      uint32_t root = FindRoot (parent, v);
+      if (component[root] == n)
+        {
+          component[root] = nComponents++;
+        }
+      component[v] = component[root];
+    }
+  std::vector<Graph> levels (1);
+  Contract (graph, component, nComponents, &levels[0]);
+  NS_LOG_LOGIC (n << " nodes merged into " << nComponents << " vertices");
+
+  // coarsen
+  double total = 0.0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      total += m_loads[v];
+    }
+  uint32_t coarsest = COARSEN_VERTICES_PER_PART * nParts;
+  double maxVertexWeight = 1.5 * total / coarsest;
+  std::vector<std::vector<uint32_t> > maps;
+  while (levels.back ().weight.size () > coarsest)
+    {
+      std::vector<uint32_t> map;
+      uint32_t size = levels.back ().weight.size ();
+      uint32_t coarse = Match (levels.back (), maxVertexWeight, &map);
+      if (coarse > size - size / 20)
+        {
+          break;
+        }
+      Graph next;
+      Contract (levels.back (), map, coarse, &next);
+      levels.push_back (next);
+      maps.push_back (map);
+      NS_LOG_LOGIC ("coarsened " << size << " vertices into " << coarse);
+    }
+
+  // partition the coarsest graph, then refine while uncoarsening
+  std::vector<uint32_t> part;
+  GrowParts (levels.back (), nParts, &part);
+  Refine (levels.back (), nParts, &part);
+  for (uint32_t level = maps.size (); level > 0; --level)
+    {
+      const std::vector<uint32_t> &map = maps[level - 1];
+      std::vector<uint32_t> finer (map.size ());
+      for (uint32_t v = 0; v < map.size (); ++v)
+        {
+          finer[v] = part[map[v]];
+        }
+      part.swap (finer);
+      Refine (levels[level - 1], nParts, &part);
+    }
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      m_parts[v] = part[component[v]];
+    }
+  NS_LOG_LOGIC ("cut traffic " << GetCutTraffic () << ", lookahead " << GetLookahead ()
+                << ", imbalance " << GetImbalance ());
+}
+
+void
+TopologyPartitioner::Assign (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_parts.size () == m_nodes.size (), "Partition () must be called first");
+  for (uint32_t v = 0; v < m_nodes.size (); ++v)
+    {
+      m_nodes[v]->SetAttribute ("SystemId", UintegerValue (m_parts[v]));
+    }
+}
+
+uint32_t
+TopologyPartitioner::GetSystemId (Ptr<Node> node) const
+{
+  NS_ASSERT_MSG (m_parts.size () == m_nodes.size (), "Partition () must be called first");
+  std::map<uint32_t, uint32_t>::const_iterator i = m_indexes.find (node->GetId ());
+  NS_ASSERT_MSG (i != m_indexes.end (), "Node " << node->GetId () << " is not in the topology");
+  return m_parts[i->second];
+}
+
+Time
+TopologyPartitioner::GetLookahead (void) const
+{
+  NS_ASSERT_MSG (m_parts.size () == m_nodes.size (), "Partition () must be called first");
+  Time lookahead = Time::Max ();
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (m_parts[i->a] != m_parts[i->b] && i->delay < lookahead)
+        {
+          lookahead = i->delay;
+        }
+    }
+  return lookahead;
+}
+
+double
+TopologyPartitioner::GetCutTraffic (void) const
+{
+  NS_ASSERT_MSG (m_parts.size () == m_nodes.size (), "Partition () must be called first");
+  double traffic = 0.0;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (m_parts[i->a] != m_parts[i->b])
+        {
+          traffic += i->traffic;
+        }
+    }
+  return traffic;
+}
+
+double
+TopologyPartitioner::GetImbalance (void) const
+{
+  NS_ASSERT_MSG (m_parts.size () == m_nodes.size (), "Partition () must be called first");
+  if (m_nodes.empty ())
+    {
+      return 1.0;
+    }
+  std::vector<double> loads (m_nParts, 0.0);
+  double total = 0.0;
+  for (uint32_t v = 0; v < m_nodes.size (); ++v)
+    {
+      loads[m_parts[v]] += m_loads[v];
+      total += m_loads[v];
+    }
+  if (total <= 0.0)
+    {
+      return 1.0;
+    }
+  return *std::max_element (loads.begin (), loads.end ()) * m_nParts / total;
+}
+
+} // namespace ns3
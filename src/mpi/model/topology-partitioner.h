@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_TOPOLOGY_PARTITIONER_H
+#define NS3_TOPOLOGY_PARTITIONER_H
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include <ns3/nstime.h>
+#include <ns3/ptr.h>
+#include <ns3/node-container.h>
+
+namespace ns3 {
+
+class Node;
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Assigns the nodes of a topology to the ranks of a distributed
+ * simulation
+ *
+ * The topology is described before its channels are created: the
+ * nodes, with an estimate of their processing load, and the links
+ * which will connect them, with their delay and an estimate of their
+ * traffic.  Partition () then splits the nodes into balanced parts, one
+ * per rank, minimizing the traffic between the parts and avoiding the
+ * links with short delays, which bound the lookahead of the
+ * synchronization; Assign () sets the SystemId attribute of the nodes.
+ * The links can then be installed with PointToPointHelper, which
+ * creates remote channels between the ranks.
+ *
+ * The partitioning is multilevel, in the style of METIS: the links
+ * shorter than the minimum lookahead are never cut, and their nodes
+ * are merged first; the graph is then coarsened by merging the nodes
+ * along the heaviest links, partitioned by growing the parts from
+ * seed nodes, and refined at each level while uncoarsening by moving
+ * the boundary nodes which reduce the cut.  The cost of cutting a link
+ * is its traffic, scaled by the ratio of the longest delay to its
+ * delay.
+ *
+ * The computation is deterministic, so that all the ranks compute the
+ * same partition from the same description.
+ *
+ * \code
+ *   NodeContainer nodes;
+ *   nodes.Create (n);
+ *   TopologyPartitioner partitioner;
+ *   partitioner.Add (nodes);
+ *   for (...)
+ *     {
+ *       partitioner.AddLink (nodes.Get (i), nodes.Get (j), MilliSeconds (5));
+ *     }
+ *   partitioner.Partition (MpiInterface::GetSize ());
+ *   partitioner.Assign ();
+ *   // install the point-to-point links
+ * \endcode
+ */
+class TopologyPartitioner
+{
+public:
+  TopologyPartitioner ();
+
+  /**
+   * \param imbalance the largest ratio of the load of a part to the
+   * average load of the parts, at least 1 (default 1.05)
+   */
+  void SetMaxImbalance (double imbalance);
+  /**
+   * \param lookahead the links with a shorter delay are never cut
+   * (default 0)
+   */
+  void SetMinLookahead (Time lookahead);
+
+  /**
+   * \param node a node of the topology
+   * \param load estimate of the processing load of the node
+   */
+  void Add (Ptr<Node> node, double load = 1.0);
+  /**
+   * \param nodes nodes of the topology
+   * \param load estimate of the processing load of each node
+   */
+  void Add (NodeContainer nodes, double load = 1.0);
+  /**
+   * \param a a node of the topology
+   * \param b another node of the topology
+   * \param delay delay of the link
+   * \param traffic estimate of the traffic on the link
+   *
+   * The nodes which were not added yet are added with a load of 1.
+   */
+  void AddLink (Ptr<Node> a, Ptr<Node> b, Time delay, double traffic = 1.0);
+
+  /**
+   * \brief Compute the partition
+   * \param nParts the number of parts, usually the number of ranks
+   */
+  void Partition (uint32_t nParts);
+  /**
+   * \brief Set the SystemId attribute of the nodes to their part
+   */
+  void Assign (void) const;
+
+  /**
+   * \param node a node of the topology
+   * \return the part of the node
+   */
+  uint32_t GetSystemId (Ptr<Node> node) const;
+  /**
+   * \return the smallest delay of the links between parts, which bounds
+   * the lookahead, or Time::Max () if no link is cut
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \return the traffic of the links between parts
+   */
+  double GetCutTraffic (void) const;
+  /**
+   * \return the ratio of the load of the heaviest part to the average
+   * load of the parts
+   */
+  double GetImbalance (void) const;
+
+private:
+  /// A link of the topology
+  struct Link
+  {
+    uint32_t a;       //!< index of a node
+    uint32_t b;       //!< index of the other node
+    Time delay;       //!< delay of the link
+    double traffic;   //!< traffic of the link
+  };
+
+  /// A weighted graph, at one level of the coarsening
+  struct Graph
+  {
+    std::vector<double> weight;                                  //!< weight of the vertices
+    std::vector<std::vector<std::pair<uint32_t, double> > > adj; //!< weighted edges of the vertices
+  };
+
+  /**
+   * \param node a node
+   * \return the index of the node, added if needed
+   */
+  uint32_t GetIndex (Ptr<Node> node);
+  /**
+   * \brief Merge vertices into the vertices of a coarser graph
+   * \param graph the graph
+   * \param map the coarse vertex of each vertex
+   * \param n the number of coarse vertices
+   * \param [out] coarse the coarser graph
+   */
+  static void Contract (const Graph &graph, const std::vector<uint32_t> &map,
+                        uint32_t n, Graph *coarse);
+  /**
+   * \brief Match the vertices along the heaviest edges
+   * \param graph the graph
+   * \param maxWeight the largest weight of a coarse vertex
+   * \param [out] map the coarse vertex of each vertex
+   * \return the number of coarse vertices
+   */
+  uint32_t Match (const Graph &graph, double maxWeight, std::vector<uint32_t> *map);
+  /**
+   * \brief Partition a graph by growing the parts from seed vertices
+   * \param graph the graph
+   * \param nParts the number of parts
+   * \param [out] part the part of each vertex
+   */
+  void GrowParts (const Graph &graph, uint32_t nParts, std::vector<uint32_t> *part) const;
+  /**
+   * \brief Move the boundary vertices which reduce the cut, or restore
+   * the balance
+   * \param graph the graph
+   * \param nParts the number of parts
+   * \param [in,out] part the part of each vertex
+   */
+  void Refine (const Graph &graph, uint32_t nParts, std::vector<uint32_t> *part) const;
+  /**
+   * \return the next number of a deterministic pseudo-random sequence
+   */
+  uint32_t NextRandom (void);
+
+  double m_maxImbalance;                    //!< largest imbalance of the parts
+  Time m_minLookahead;                      //!< the shorter links are not cut
+  std::vector<Ptr<Node> > m_nodes;          //!< the nodes
+  std::vector<double> m_loads;              //!< the load of the nodes
+  std::map<uint32_t, uint32_t> m_indexes;   //!< the index of the nodes, by node id
+  std::vector<Link> m_links;                //!< the links
+  std::vector<uint32_t> m_parts;            //!< the part of the nodes
+  uint32_t m_nParts;                        //!< the number of parts
+  uint32_t m_random;                        //!< state of the pseudo-random sequence
+};
+
+} // namespace ns3
+
+#endif /* NS3_TOPOLOGY_PARTITIONER_H */
@@ -0,0 +1,329 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/mpi-frame-buffer.h"
+#include "ns3/boolean.h"
+#include "ns3/config.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi
+ * Base class of the MpiFrameBuffer tests: the frames are handed to the
+ * test instead of being sent, and the global values are restored after
+ * the test.
+ */
+class MpiFrameBufferTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param name the name of the test case
+   */
+  MpiFrameBufferTestCase (std::string name);
+
+protected:
+  /**
+   * \brief Set up a frame buffer
+   * \param frameSize the MpiFrameSize global value
+   * \param aggregate the MpiSendAggregation global value
+   * \param ranks the number of ranks
+   */
+  void Setup (uint32_t frameSize, bool aggregate, uint32_t ranks);
+  /**
+   * \brief Record a frame handed over by the frame buffer
+   * \param rank the destination rank
+   * \param frame the frame
+   * \param size the size of the frame
+   */
+  void Sent (uint32_t rank, const uint8_t *frame, uint32_t size);
+  /**
+   * \brief Check a message written by WriteMessage
+   * \param frame a frame received
+   * \param [in,out] offset the offset of the message in the frame
+   * \param size the expected size of the message
+   * \return the offset of the message in the frame, or -1 if it is wrong
+   */
+  int32_t CheckMessage (const std::vector<uint8_t> &frame, uint32_t *offset, uint32_t size);
+  /**
+   * \brief Write a message of a given size
+   * \param rank the destination rank
+   * \param size the size of the message
+   */
+  void WriteMessage (uint32_t rank, uint32_t size);
+
+  MpiFrameBuffer m_frames;                   //!< The frame buffer tested
+  std::vector<uint32_t> m_ranks;             //!< The destination rank of each frame handed over
+  std::vector<std::vector<uint8_t> > m_sent; //!< The frames handed over
+  std::vector<const uint8_t *> m_buffers;    //!< The buffers of the frames handed over
+
+private:
+  virtual void DoTeardown (void);
+
+  UintegerValue m_frameSize; //!< MpiFrameSize before the test
+  BooleanValue m_aggregate;  //!< MpiSendAggregation before the test
+};
+
+MpiFrameBufferTestCase::MpiFrameBufferTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+MpiFrameBufferTestCase::Setup (uint32_t frameSize, bool aggregate, uint32_t ranks)
+{
+  GlobalValue::GetValueByName ("MpiFrameSize", m_frameSize);
+  GlobalValue::GetValueByName ("MpiSendAggregation", m_aggregate);
+  Config::SetGlobal ("MpiFrameSize", UintegerValue (frameSize));
+  Config::SetGlobal ("MpiSendAggregation", BooleanValue (aggregate));
+  m_frames.SetSendCallback (MakeCallback (&MpiFrameBufferTestCase::Sent, this));
+  m_frames.Initialize (ranks);
+}
+
+void
+MpiFrameBufferTestCase::DoTeardown (void)
+{
+  m_frames.Clear ();
+  Config::SetGlobal ("MpiFrameSize", m_frameSize);
+  Config::SetGlobal ("MpiSendAggregation", m_aggregate);
+}
+
+void
+MpiFrameBufferTestCase::Sent (uint32_t rank, const uint8_t *frame, uint32_t size)
+{
+  m_ranks.push_back (rank);
+  m_sent.push_back (std::vector<uint8_t> (frame, frame + size));
+  m_buffers.push_back (frame);
+}
+
+void
+MpiFrameBufferTestCase::WriteMessage (uint32_t rank, uint32_t size)
+{
+  uint8_t *message = m_frames.Reserve (rank, size);
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      message[i] = static_cast<uint8_t> (size + i);
+    }
+  m_frames.Commit (rank);
+}
+
+int32_t
+MpiFrameBufferTestCase::CheckMessage (const std::vector<uint8_t> &frame, uint32_t *offset, uint32_t size)
+{
+  uint32_t messageSize;
+  const uint8_t *message = MpiFrameBuffer::NextMessage (&frame[0], frame.size (), offset, &messageSize);
+  if (message == 0 || messageSize != size)
+    {
+      return -1;
+    }
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      if (message[i] != static_cast<uint8_t> (size + i))
+        {
+          return -1;
+        }
+    }
+  // the padding is cleared
+  for (const uint8_t *i = message + size; i < &frame[0] + *offset; ++i)
+    {
+      if (*i != 0)
+        {
+          return -1;
+        }
+    }
+  return message - &frame[0];
+}
+
+/**
+ * \ingroup mpi
+ * Check that the messages to a rank are batched in a frame, aligned on
+ * 8 bytes, and that a new frame is started when the message does not
+ * fit.
+ */
+class FrameAggregationTestCase : public MpiFrameBufferTestCase
+{
+public:
+  FrameAggregationTestCase ();
+  virtual void DoRun (void);
+};
+
+FrameAggregationTestCase::FrameAggregationTestCase ()
+  : MpiFrameBufferTestCase ("Batch the messages to a rank into frames")
+{
+}
+
+void
+FrameAggregationTestCase::DoRun (void)
+{
+  // the frames are kept a multiple of 8 bytes
+  Setup (260, true, 3);
+  NS_TEST_ASSERT_MSG_EQ (m_frames.GetFrameSize (), 256, "wrong frame size");
+
+  // 16, 24 and 208 bytes with the headers and the padding
+  WriteMessage (1, 5);
+  WriteMessage (1, 16);
+  WriteMessage (2, 1);
+  WriteMessage (1, 200);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 0, "a frame was sent before it was full");
+
+  // 248 bytes used: 16 more do not fit
+  WriteMessage (1, 1);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "the full frame was not sent");
+  NS_TEST_ASSERT_MSG_EQ (m_ranks[0], 1, "the full frame was sent to the wrong rank");
+  NS_TEST_ASSERT_MSG_EQ (m_sent[0].size (), 248, "wrong size of the full frame");
+  uint32_t offset = 0;
+  NS_TEST_ASSERT_MSG_EQ (CheckMessage (m_sent[0], &offset, 5), 8, "wrong first message");
+  NS_TEST_ASSERT_MSG_EQ (CheckMessage (m_sent[0], &offset, 16), 24, "wrong second message");
+  NS_TEST_ASSERT_MSG_EQ (CheckMessage (m_sent[0], &offset, 200), 48, "wrong third message");
+  uint32_t size;
+  NS_TEST_ASSERT_MSG_EQ (MpiFrameBuffer::NextMessage (&m_sent[0][0], m_sent[0].size (), &offset, &size), 0,
+                         "a message past the end of the frame");
+
+  m_frames.FlushAll ();
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 3, "wrong number of frames flushed");
+  NS_TEST_ASSERT_MSG_EQ (m_ranks[1], 1, "wrong rank of the first frame flushed");
+  NS_TEST_ASSERT_MSG_EQ (m_ranks[2], 2, "wrong rank of the second frame flushed");
+  offset = 0;
+  NS_TEST_ASSERT_MSG_EQ (CheckMessage (m_sent[1], &offset, 1), 8, "wrong message of the second frame");
+  NS_TEST_ASSERT_MSG_EQ (offset, m_sent[1].size (), "wrong size of the second frame");
+  offset = 0;
+  NS_TEST_ASSERT_MSG_EQ (CheckMessage (m_sent[2], &offset, 1), 8, "wrong message to rank 2");
+  NS_TEST_ASSERT_MSG_EQ (offset, m_sent[2].size (), "wrong size of the frame to rank 2");
+
+  // nothing left to send
+  m_frames.FlushAll ();
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 3, "an empty frame was sent");
+
+  // the frames sent are reused
+  WriteMessage (0, 8);
+  m_frames.Flush (0);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 4, "the frame to rank 0 was not flushed");
+  bool reused = false;
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      reused = reused || m_buffers[3] == m_buffers[i];
+    }
+  NS_TEST_ASSERT_MSG_EQ (reused, true, "a new frame was allocated");
+}
+
+/**
+ * \ingroup mpi
+ * Check that each message is sent in a frame of its own when
+ * MpiSendAggregation is false.
+ */
+class NoAggregationTestCase : public MpiFrameBufferTestCase
+{
+public:
+  NoAggregationTestCase ();
+  virtual void DoRun (void);
+};
+
+NoAggregationTestCase::NoAggregationTestCase ()
+  : MpiFrameBufferTestCase ("Send each message on its own without aggregation")
+{
+}
+
+void
+NoAggregationTestCase::DoRun (void)
+{
+  Setup (256, false, 3);
+
+  uint8_t *message = m_frames.Reserve (2, 10);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 0, "a message was sent before its commit");
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      message[i] = static_cast<uint8_t> (10 + i);
+    }
+  m_frames.Commit (2);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "the message was not sent at its commit");
+  NS_TEST_ASSERT_MSG_EQ (m_ranks[0], 2, "the message was sent to the wrong rank");
+  uint32_t offset = 0;
+  NS_TEST_ASSERT_MSG_EQ (CheckMessage (m_sent[0], &offset, 10), 8, "wrong message");
+  NS_TEST_ASSERT_MSG_EQ (m_sent[0].size (), 24, "wrong size of the frame");
+
+  WriteMessage (0, 3);
+  WriteMessage (0, 4);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 3, "the messages to rank 0 were batched");
+  NS_TEST_ASSERT_MSG_EQ (m_sent[1].size (), 16, "wrong size of the first frame to rank 0");
+  NS_TEST_ASSERT_MSG_EQ (m_sent[2].size (), 16, "wrong size of the second frame to rank 0");
+
+  m_frames.FlushAll ();
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 3, "an empty frame was sent");
+}
+
+/**
+ * \ingroup mpi
+ * Check that a truncated frame ends at its last complete message.
+ */
+class TruncatedFrameTestCase : public TestCase
+{
+public:
+  TruncatedFrameTestCase ();
+  virtual void DoRun (void);
+};
+
+TruncatedFrameTestCase::TruncatedFrameTestCase ()
+  : TestCase ("Stop at the end of a truncated frame")
+{
+}
+
+void
+TruncatedFrameTestCase::DoRun (void)
+{
+  // a message of 3 bytes, then the header of a message of 20 bytes
+  uint64_t frame[4] = { 0, 0, 0, 0 };
+  uint32_t header[2] = { 3, 0 };
+  std::memcpy (&frame[0], header, 8);
+  header[0] = 20;
+  std::memcpy (&frame[2], header, 8);
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *> (frame);
+
+  uint32_t offset = 0;
+  uint32_t size = 0;
+  NS_TEST_ASSERT_MSG_EQ (MpiFrameBuffer::NextMessage (bytes, 32, &offset, &size), bytes + 8,
+                         "the first message was not found");
+  NS_TEST_ASSERT_MSG_EQ (size, 3, "wrong size of the first message");
+  NS_TEST_ASSERT_MSG_EQ (offset, 16, "wrong offset of the second message");
+  NS_TEST_ASSERT_MSG_EQ (MpiFrameBuffer::NextMessage (bytes, 32, &offset, &size), 0,
+                         "a truncated message was returned");
+  NS_TEST_ASSERT_MSG_EQ (offset, 16, "the offset moved past a truncated message");
+}
+
+/**
+ * \ingroup mpi
+ * MpiFrameBuffer test suite
+ */
+class MpiFrameBufferTestSuite : public TestSuite
+{
+public:
+  MpiFrameBufferTestSuite ();
+};
+
+MpiFrameBufferTestSuite::MpiFrameBufferTestSuite ()
+  : TestSuite ("mpi-frame-buffer", UNIT)
+{
+  AddTestCase (new FrameAggregationTestCase, TestCase::QUICK);
+  AddTestCase (new NoAggregationTestCase, TestCase::QUICK);
+  AddTestCase (new TruncatedFrameTestCase, TestCase::QUICK);
+}
+
+static MpiFrameBufferTestSuite g_mpiFrameBufferTestSuite;
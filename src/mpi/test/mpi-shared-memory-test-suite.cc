@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/mpi-shared-memory.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi
+ * Check that the messages of a ring are received in order and intact,
+ * across the end of the messages area.
+ */
+class RingOrderTestCase : public TestCase
+{
+public:
+  RingOrderTestCase ();
+  virtual void DoRun (void);
+};
+
+RingOrderTestCase::RingOrderTestCase ()
+  : TestCase ("Receive the messages of a ring in order, across its end")
+{
+}
+
+void
+RingOrderTestCase::DoRun (void)
+{
+  const uint32_t dataSize = 256;
+  std::vector<uint64_t> memory (MpiSharedMemoryRing::GetMemorySize (dataSize) / 8);
+  MpiSharedMemoryRing consumer;
+  consumer.Attach (&memory[0], dataSize, true);
+  MpiSharedMemoryRing producer;
+  producer.Attach (&memory[0], dataSize, false);
+
+  uint32_t sent = 0;
+  uint32_t received = 0;
+  while (received < 200)
+    {
+      // keep a few messages in the ring
+      while (sent < 200 && sent < received + 3)
+        {
+          uint32_t size = sent % 41;
+          uint8_t *message = producer.Reserve (size);
+          NS_TEST_ASSERT_MSG_NE (message, 0, "ring full at message " << sent);
+          for (uint32_t i = 0; i < size; ++i)
+            {
+              message[i] = static_cast<uint8_t> (sent + i);
+            }
+          producer.Commit ();
+          ++sent;
+        }
+      uint32_t size;
+      const uint8_t *message = consumer.Peek (&size);
+      NS_TEST_ASSERT_MSG_NE (message, 0, "message " << received << " not received");
+      NS_TEST_ASSERT_MSG_EQ (size, received % 41, "wrong size of message " << received);
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (message[i]),
+                                 static_cast<uint8_t> (received + i),
+                                 "wrong byte " << i << " of message " << received);
+        }
+      consumer.Release ();
+      ++received;
+    }
+  uint32_t size;
+  NS_TEST_ASSERT_MSG_EQ (consumer.Peek (&size), 0, "the ring is not empty");
+}
+
+/**
+ * \ingroup mpi
+ * Check that a full ring refuses the messages, and that the messages
+ * are visible only once committed.
+ */
+class RingFullTestCase : public TestCase
+{
+public:
+  RingFullTestCase ();
+  virtual void DoRun (void);
+};
+
+RingFullTestCase::RingFullTestCase ()
+  : TestCase ("Refuse the messages when the ring is full")
+{
+}
+
+void
+RingFullTestCase::DoRun (void)
+{
+  const uint32_t dataSize = 256;
+  std::vector<uint64_t> memory (MpiSharedMemoryRing::GetMemorySize (dataSize) / 8);
+  MpiSharedMemoryRing consumer;
+  consumer.Attach (&memory[0], dataSize, true);
+  MpiSharedMemoryRing producer;
+  producer.Attach (&memory[0], dataSize, false);
+
+  NS_TEST_ASSERT_MSG_EQ (producer.Reserve (dataSize), 0, "a message larger than half the ring was accepted");
+
+  // each message takes 32 bytes with its header
+  uint32_t count = 0;
+  while (producer.Reserve (24) != 0)
+    {
+      ++count;
+    }
+  NS_TEST_ASSERT_MSG_EQ (count, dataSize / 32, "wrong number of messages in a full ring");
+  uint32_t size;
+  NS_TEST_ASSERT_MSG_EQ (consumer.Peek (&size), 0, "a message is visible before its commit");
+
+  producer.Commit ();
+  NS_TEST_ASSERT_MSG_NE (consumer.Peek (&size), 0, "a committed message is not visible");
+  consumer.Release ();
+  NS_TEST_ASSERT_MSG_NE (producer.Reserve (24), 0, "no room after a release");
+  producer.Commit ();
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      NS_TEST_ASSERT_MSG_NE (consumer.Peek (&size), 0, "message " << i << " lost");
+      consumer.Release ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (consumer.Peek (&size), 0, "the ring is not empty");
+}
+
+/**
+ * \ingroup mpi
+ * MpiSharedMemory test suite
+ */
+class MpiSharedMemoryTestSuite : public TestSuite
+{
+public:
+  MpiSharedMemoryTestSuite ();
+};
+
+MpiSharedMemoryTestSuite::MpiSharedMemoryTestSuite ()
+  : TestSuite ("mpi-shared-memory", UNIT)
+{
+  AddTestCase (new RingOrderTestCase, TestCase::QUICK);
+  AddTestCase (new RingFullTestCase, TestCase::QUICK);
+}
+
+static MpiSharedMemoryTestSuite g_mpiSharedMemoryTestSuite;
@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/topology-partitioner.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi
+ * Check that two clusters joined by a single long link are split along it.
+ */
+class ClustersPartitionTestCase : public TestCase
+{
+public:
+  ClustersPartitionTestCase ();
+  virtual void DoRun (void);
+};
+
+ClustersPartitionTestCase::ClustersPartitionTestCase ()
+  : TestCase ("Split two clusters along the link joining them")
+{
+}
+
+void
+ClustersPartitionTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (16);
+  TopologyPartitioner partitioner;
+  partitioner.Add (nodes);
+  for (uint32_t cluster = 0; cluster < 2; ++cluster)
+    {
+      for (uint32_t i = 0; i < 8; ++i)
+        {
+          for (uint32_t j = i + 1; j < 8; ++j)
+            {
+              partitioner.AddLink (nodes.Get (cluster * 8 + i), nodes.Get (cluster * 8 + j),
+                                   MilliSeconds (1));
+            }
+        }
+    }
+  partitioner.AddLink (nodes.Get (3), nodes.Get (12), MilliSeconds (10));
+  partitioner.Partition (2);
+
+  for (uint32_t i = 0; i < 16; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (partitioner.GetSystemId (nodes.Get (i)),
+                             partitioner.GetSystemId (nodes.Get (i < 8 ? 0 : 8)),
+                             "node " << i << " not in the part of its cluster");
+    }
+  NS_TEST_ASSERT_MSG_NE (partitioner.GetSystemId (nodes.Get (0)),
+                         partitioner.GetSystemId (nodes.Get (8)),
+                         "the clusters are in the same part");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetCutTraffic (), 1.0, "only the long link is cut");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetLookahead (), MilliSeconds (10), "wrong lookahead");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetImbalance (), 1.0, "the parts are not balanced");
+
+  partitioner.Assign ();
+  for (uint32_t i = 0; i < 16; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (nodes.Get (i)->GetSystemId (), partitioner.GetSystemId (nodes.Get (i)),
+                             "SystemId of node " << i << " not assigned");
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup mpi
+ * Check that the links shorter than the minimum lookahead are not cut.
+ */
+class MinLookaheadPartitionTestCase : public TestCase
+{
+public:
+  MinLookaheadPartitionTestCase ();
+  virtual void DoRun (void);
+};
+
+MinLookaheadPartitionTestCase::MinLookaheadPartitionTestCase ()
+  : TestCase ("Keep the links shorter than the minimum lookahead")
+{
+}
+
+void
+MinLookaheadPartitionTestCase::DoRun (void)
+{
+  // a chain where cutting the middle link carries the most traffic
+  NodeContainer nodes;
+  nodes.Create (4);
+  TopologyPartitioner partitioner;
+  partitioner.SetMinLookahead (MilliSeconds (2));
+  partitioner.Add (nodes);
+  partitioner.AddLink (nodes.Get (0), nodes.Get (1), MilliSeconds (1));
+  partitioner.AddLink (nodes.Get (1), nodes.Get (2), MilliSeconds (10), 100.0);
+  partitioner.AddLink (nodes.Get (2), nodes.Get (3), MilliSeconds (1));
+  partitioner.Partition (2);
+
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetLookahead (), MilliSeconds (10), "a short link is cut");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetCutTraffic (), 100.0, "wrong cut");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetSystemId (nodes.Get (0)),
+                         partitioner.GetSystemId (nodes.Get (1)), "link 0-1 is cut");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetSystemId (nodes.Get (2)),
+                         partitioner.GetSystemId (nodes.Get (3)), "link 2-3 is cut");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup mpi
+ * Check the balance and the cut of a large ring, coarsened over
+ * several levels, and that the partition is deterministic.
+ */
+class RingPartitionTestCase : public TestCase
+{
+public:
+  RingPartitionTestCase ();
+  virtual void DoRun (void);
+};
+
+RingPartitionTestCase::RingPartitionTestCase ()
+  : TestCase ("Partition a large ring into balanced arcs")
+{
+}
+
+void
+RingPartitionTestCase::DoRun (void)
+{
+  const uint32_t n = 1000;
+  const uint32_t parts = 4;
+  NodeContainer nodes;
+  nodes.Create (n);
+  TopologyPartitioner partitioner;
+  TopologyPartitioner other;
+  partitioner.Add (nodes);
+  other.Add (nodes);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      partitioner.AddLink (nodes.Get (i), nodes.Get ((i + 1) % n), MilliSeconds (1));
+      other.AddLink (nodes.Get (i), nodes.Get ((i + 1) % n), MilliSeconds (1));
+    }
+  partitioner.Partition (parts);
+  other.Partition (parts);
+
+  std::vector<uint32_t> sizes (parts, 0);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t part = partitioner.GetSystemId (nodes.Get (i));
+      NS_TEST_ASSERT_MSG_LT (part, parts, "node " << i << " in no part");
+      NS_TEST_ASSERT_MSG_EQ (part, other.GetSystemId (nodes.Get (i)),
+                             "the partition of node " << i << " is not deterministic");
+      ++sizes[part];
+    }
+  for (uint32_t p = 0; p < parts; ++p)
+    {
+      NS_TEST_ASSERT_MSG_GT (sizes[p], 0, "part " << p << " is empty");
+    }
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (partitioner.GetImbalance (), 1.05 + 1e-9, "the parts are not balanced");
+  // the optimal cut of a ring into arcs is one link per part
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (partitioner.GetCutTraffic (), 3.0 * parts, "the cut is too large");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup mpi
+ * TopologyPartitioner test suite
+ */
+class TopologyPartitionerTestSuite : public TestSuite
+{
+public:
+  TopologyPartitionerTestSuite ();
+};
+
+TopologyPartitionerTestSuite::TopologyPartitionerTestSuite ()
+  : TestSuite ("topology-partitioner", UNIT)
+{
+  AddTestCase (new ClustersPartitionTestCase, TestCase::QUICK);
+  AddTestCase (new MinLookaheadPartitionTestCase, TestCase::QUICK);
+  AddTestCase (new RingPartitionTestCase, TestCase::QUICK);
+}
+
+static TopologyPartitionerTestSuite g_topologyPartitionerTestSuite;
@@ -28,6 +28,9 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/compressed-stream.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
 
 #include "trace-helper.h"
 
@@ -35,6 +38,33 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 
+/**
+ * \brief Whether the trace files created by the helpers are compressed
+ */
+static GlobalValue g_compressTraces = GlobalValue ("CompressTraces",
+                                                   "Compress the pcap and ascii trace files created by "
+                                                   "the helpers, appending \".gz\" to their names",
+                                                   BooleanValue (false),
+                                                   MakeBooleanChecker ());
+
+/**
+ * \brief Append the suffix of compressed files to a trace file name if
+ * the trace files are compressed
+ * \param filename the file name
+ * \returns the name of the file to create
+ */
+static std::string
+GetTraceFilename (std::string filename)
+{
+  BooleanValue compress;
+  g_compressTraces.GetValue (compress);
+  if (compress.Get () && !CompressedStreamBuf::IsCompressedFilename (filename))
+    {
+      filename += ".gz";
+    }
+  return filename;
+}
+
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -55,6 +85,7 @@ PcapHelper::CreateFile (
 {
   NS_LOG_FUNCTION (filename << filemode << dataLinkType << snapLen << tzCorrection);
 
+  filename = GetTraceFilename (filename);
   Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
   file->Open (filename, filemode);
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
@@ -192,7 +223,7 @@ AsciiTraceHelper::CreateFileStream (std::string filename, std::ios::openmode fil
 {
   NS_LOG_FUNCTION (filename << filemode);
 
-  Ptr<OutputStreamWrapper> StreamWrapper = Create<OutputStreamWrapper> (filename, filemode);
+  Ptr<OutputStreamWrapper> StreamWrapper = Create<OutputStreamWrapper> (GetTraceFilename (filename), filemode);
 
   //
   // Note that the ascii trace helper promptly forgets all about the trace file.
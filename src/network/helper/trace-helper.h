@@ -94,6 +94,9 @@ public:
   /**
    * @brief Create and initialize a pcap file.
    * 
+   * When the CompressTraces global value is true, ".gz" is appended to
+   * the file name, and the file is written compressed.
+   *
    * @param filename file name
    * @param filemode file mode
    * @param dataLinkType data link type of packet data
@@ -209,6 +212,9 @@ public:
    * that can solve the problem so we use one of those to carry the stream
    * around and deal with the lifetime issues.
    * 
+   * When the CompressTraces global value is true, ".gz" is appended to
+   * the file name, and the file is written compressed.
+   *
    * @param filename file name
    * @param filemode file mode
    * @returns a smart pointer to the output stream
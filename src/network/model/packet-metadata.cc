@@ -1157,18 +1157,8 @@ PacketMetadata::GetSerializedSize (void) const
   while (current != 0xffff)
     {
       ReadItems (current, &item, &extraItem);
-      uint32_t uid = (item.typeUid & 0xfffffffe) >> 1;
-      if (uid == 0)
-        {
-          totalSize += 4;
-        }
-      else
-        {
-          TypeId tid;
-          tid.SetUid (uid);
-          totalSize += 4 + tid.GetName ().size ();
-        }
-      totalSize += 1 + 4 + 2 + 4 + 4 + 8;
+      // the type is identified by the hash of its name, or 0 for the payload
+      totalSize += 4 + 1 + 4 + 2 + 4 + 4 + 8;
       if (current == m_tail)
         {
           break;
@@ -1202,32 +1192,20 @@ PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
                     ", fragmentStart="<<extraItem.fragmentStart<<", fragmentEnd="<<
                     extraItem.fragmentEnd<< ", packetUid="<<extraItem.packetUid);
 
+      // write the hash of the type name rather than the name itself:
+      // the hashes are the same in all the processes of a simulation
       uint32_t uid = (item.typeUid & 0xfffffffe) >> 1;
+      TypeId::hash_t hash = 0;
       if (uid != 0)
         {
           TypeId tid;
           tid.SetUid (uid);
-          std::string uidString = tid.GetName ();
-          uint32_t uidStringSize = uidString.size ();
-          buffer = AddToRawU32 (uidStringSize, start, buffer, maxSize);
-          if (buffer == 0) 
-            {
-              return 0;
-            }
-          buffer = AddToRaw (reinterpret_cast<const uint8_t *> (uidString.c_str ()), 
-                             uidStringSize, start, buffer, maxSize);
-          if (buffer == 0) 
-            {
-              return 0;
-            }
+          hash = tid.GetHash ();
         }
-      else
+      buffer = AddToRawU32 (hash, start, buffer, maxSize);
+      if (buffer == 0) 
         {
-          buffer = AddToRawU32 (0, start, buffer, maxSize);
-          if (buffer == 0) 
-            {
-              return 0;
-            }
+          return 0;
         }
 
       uint8_t isBig = item.typeUid & 0x1;
@@ -1294,26 +1272,18 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
   struct PacketMetadata::ExtraItem extraItem = {0};
   while (desSize > 0)
     {
-      uint32_t uidStringSize = 0;
-      buffer = ReadFromRawU32 (uidStringSize, start, buffer, size);
+      uint32_t hash = 0;
+      buffer = ReadFromRawU32 (hash, start, buffer, size);
       desSize -= 4;
       uint32_t uid;
-      if (uidStringSize == 0)
+      if (hash == 0)
         {
           // uid zero for payload.
           uid = 0;
         }
       else
         {
-          std::string uidString;
-          for (uint32_t j = 0; j < uidStringSize; j++)
-            {
-              uint8_t ch = 0;
-              buffer = ReadFromRawU8 (ch, start, buffer, size);
-              uidString.push_back (ch);
-              desSize--;
-            }
-          TypeId tid = TypeId::LookupByName (uidString);
+          TypeId tid = TypeId::LookupByHash (hash);
           uid = tid.GetUid ();
         }
       uint8_t isBig = 0;
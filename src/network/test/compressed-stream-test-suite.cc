@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/pcap-file.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/compressed-stream.h"
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+using namespace ns3;
+
+#ifdef HAVE_ZLIB_H
+
+/**
+ * \brief Read a whole file
+ * \param filename the name of the file
+ * \returns the content of the file
+ */
+static std::string
+ReadFile (std::string const &filename)
+{
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream os;
+  os << file.rdbuf ();
+  return os.str ();
+}
+
+/**
+ * \brief Decompress a whole gzip file with zlib
+ * \param filename the name of the file
+ * \returns the decompressed content of the file
+ */
+static std::string
+ReadCompressedFile (std::string const &filename)
+{
+  std::string data;
+  gzFile file = gzopen (filename.c_str (), "rb");
+  if (file == 0)
+    {
+      return data;
+    }
+  char buffer[16384];
+  int n;
+  while ((n = gzread (file, buffer, sizeof (buffer))) > 0)
+    {
+      data.append (buffer, n);
+    }
+  gzclose (file);
+  return data;
+}
+
+/**
+ * \ingroup network-test
+ * \brief Check that ascii traces are compressed in independent blocks
+ */
+class CompressedAsciiTestCase : public TestCase
+{
+public:
+  CompressedAsciiTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_filename; //!< compressed file
+};
+
+CompressedAsciiTestCase::CompressedAsciiTestCase ()
+  : TestCase ("Check that ascii traces are written compressed in BGZF blocks")
+{
+}
+
+void
+CompressedAsciiTestCase::DoTeardown (void)
+{
+  remove (m_filename.c_str ());
+}
+
+void
+CompressedAsciiTestCase::DoRun (void)
+{
+  std::stringstream filename;
+  filename << rand ();
+  m_filename = CreateTempDirFilename (filename.str () + ".tr.gz");
+
+  // enough lines for a few dozen blocks, so that the background thread
+  // gets behind the writer
+  std::ostringstream expected;
+  {
+    Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (m_filename, std::ios::out);
+    std::ostream *os = stream->GetStream ();
+    for (uint32_t i = 0; i < 100000; ++i)
+      {
+        *os << "+ " << i * 0.001 << " /NodeList/" << i % 7 << "/DeviceList/0 " << i * i << std::endl;
+        expected << "+ " << i * 0.001 << " /NodeList/" << i % 7 << "/DeviceList/0 " << i * i << std::endl;
+      }
+    NS_TEST_ASSERT_MSG_EQ (os->good (), true, "Write must not fail");
+  }
+
+  std::string data = ReadCompressedFile (m_filename);
+  NS_TEST_ASSERT_MSG_EQ ((data == expected.str ()), true, "Decompressed trace differs from the written one");
+
+  // walk the blocks with the sizes given by their headers, and decompress
+  // each one on its own
+  std::string file = ReadFile (m_filename);
+  std::string blocks;
+  uint32_t nBlocks = 0;
+  uint32_t offset = 0;
+  bool eofBlock = false;
+  while (offset < file.size ())
+    {
+      NS_TEST_ASSERT_MSG_EQ ((offset + 18 <= file.size ()), true, "Truncated block header at " << offset);
+      uint8_t const *header = (uint8_t const *)file.data () + offset;
+      NS_TEST_ASSERT_MSG_EQ ((header[0] == 0x1f && header[1] == 0x8b && header[3] == 0x04), true,
+                             "Wrong gzip header at " << offset);
+      NS_TEST_ASSERT_MSG_EQ ((header[12] == 'B' && header[13] == 'C'), true, "Missing BGZF field at " << offset);
+      uint32_t size = (header[16] | (header[17] << 8)) + 1;
+      NS_TEST_ASSERT_MSG_EQ ((offset + size <= file.size ()), true, "Truncated block at " << offset);
+
+      z_stream stream;
+      std::memset (&stream, 0, sizeof (stream));
+      NS_TEST_ASSERT_MSG_EQ (inflateInit2 (&stream, -15), Z_OK, "inflateInit2 failed");
+      std::vector<char> out (65536);
+      stream.next_in = (Bytef *)file.data () + offset + 18;
+      stream.avail_in = size - 18 - 8;
+      stream.next_out = (Bytef *)&out[0];
+      stream.avail_out = out.size ();
+      int ret = inflate (&stream, Z_FINISH);
+      uint32_t n = stream.total_out;
+      inflateEnd (&stream);
+      NS_TEST_ASSERT_MSG_EQ (ret, Z_STREAM_END, "Block at " << offset << " does not decompress on its own");
+      blocks.append (&out[0], n);
+      eofBlock = (n == 0);
+      offset += size;
+      nBlocks++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (eofBlock, true, "Missing end of file block");
+  NS_TEST_ASSERT_MSG_GT (nBlocks, 10, "Too few blocks");
+  NS_TEST_ASSERT_MSG_EQ ((blocks == expected.str ()), true, "Decompressed blocks differ from the written trace");
+}
+
+/**
+ * \ingroup network-test
+ * \brief Check that pcap files are compressed
+ */
+class CompressedPcapTestCase : public TestCase
+{
+public:
+  CompressedPcapTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Write a pcap file
+   * \param filename the name of the file
+   */
+  void WriteFile (std::string const &filename);
+
+  std::string m_filename;           //!< file written uncompressed
+  std::string m_compressedFilename; //!< file written compressed
+};
+
+CompressedPcapTestCase::CompressedPcapTestCase ()
+  : TestCase ("Check that pcap files are written compressed")
+{
+}
+
+void
+CompressedPcapTestCase::DoTeardown (void)
+{
+  remove (m_filename.c_str ());
+  remove (m_compressedFilename.c_str ());
+}
+
+void
+CompressedPcapTestCase::WriteFile (std::string const &filename)
+{
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.Init (1, 128);
+  uint8_t data[512];
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      uint32_t size = 1 + (i * 37) % sizeof (data);
+      for (uint32_t j = 0; j < size; ++j)
+        {
+          data[j] = i + j;
+        }
+      f.Write (i, i * 1000, Create<Packet> (data, size));
+    }
+  f.Flush ();
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+}
+
+void
+CompressedPcapTestCase::DoRun (void)
+{
+  std::stringstream filename;
+  filename << rand ();
+  m_filename = CreateTempDirFilename (filename.str () + ".pcap");
+  m_compressedFilename = m_filename + ".gz";
+
+  WriteFile (m_filename);
+  WriteFile (m_compressedFilename);
+
+  std::string expected = ReadFile (m_filename);
+  std::string data = ReadCompressedFile (m_compressedFilename);
+  NS_TEST_ASSERT_MSG_GT (expected.size (), 65280, "Pcap file too small for several blocks");
+  NS_TEST_ASSERT_MSG_EQ (data.size (), expected.size (), "Decompressed pcap file has the wrong size");
+  NS_TEST_ASSERT_MSG_EQ ((data == expected), true, "Decompressed pcap file differs from the uncompressed one");
+}
+
+#endif /* HAVE_ZLIB_H */
+
+/**
+ * \ingroup network-test
+ * \brief Compressed trace files test suite
+ */
+class CompressedStreamTestSuite : public TestSuite
+{
+public:
+  CompressedStreamTestSuite ();
+};
+
+CompressedStreamTestSuite::CompressedStreamTestSuite ()
+  : TestSuite ("compressed-stream", UNIT)
+{
+#ifdef HAVE_ZLIB_H
+  AddTestCase (new CompressedAsciiTestCase, TestCase::QUICK);
+  AddTestCase (new CompressedPcapTestCase, TestCase::QUICK);
+#endif
+}
+
+static CompressedStreamTestSuite g_compressedStreamTestSuite;
@@ -21,10 +21,15 @@
 #include <cstdlib>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/packet.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 
 using namespace ns3;
 
@@ -1121,6 +1126,121 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that the records written through the write buffer,
+// possibly by the background thread, are the same as the ones written
+// directly to the file.
+// ===========================================================================
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  BufferedWriteTestCase (uint32_t bufferSize, bool async);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Write records of various sizes, some larger than the snap length
+   * and some larger than the write buffer.
+   */
+  void WriteFile (std::string filename, uint32_t bufferSize, bool async);
+
+  uint32_t m_bufferSize;          //!< size of the write buffer
+  bool m_async;                   //!< write from the background thread
+  std::string m_directFilename;   //!< file written directly
+  std::string m_bufferedFilename; //!< file written through the buffer
+};
+
+static const uint32_t N_BUFFERED_PACKETS = 200;
+static const uint32_t BUFFERED_SNAPLEN = 128;
+
+BufferedWriteTestCase::BufferedWriteTestCase (uint32_t bufferSize, bool async)
+  : TestCase ("Check to see that PcapFile writes the same records through a write buffer"),
+    m_bufferSize (bufferSize),
+    m_async (async)
+{
+}
+
+void
+BufferedWriteTestCase::DoTeardown (void)
+{
+  remove (m_directFilename.c_str ());
+  remove (m_bufferedFilename.c_str ());
+}
+
+void
+BufferedWriteTestCase::WriteFile (std::string filename, uint32_t bufferSize, bool async)
+{
+  UintegerValue oldBufferSize;
+  BooleanValue oldAsync;
+  GlobalValue::GetValueByName ("PcapWriteBufferSize", oldBufferSize);
+  GlobalValue::GetValueByName ("PcapWriteAsync", oldAsync);
+  GlobalValue::Bind ("PcapWriteBufferSize", UintegerValue (bufferSize));
+  GlobalValue::Bind ("PcapWriteAsync", BooleanValue (async));
+
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.Init (1, BUFFERED_SNAPLEN);
+
+  uint8_t data[4 * BUFFERED_SNAPLEN];
+  for (uint32_t i = 0; i < N_BUFFERED_PACKETS; ++i)
+    {
+      uint32_t size = 1 + (i * 37) % sizeof (data);
+      for (uint32_t j = 0; j < size; ++j)
+        {
+          data[j] = i + j;
+        }
+      if (i % 2)
+        {
+          f.Write (i, i * 1000, data, size);
+        }
+      else
+        {
+          f.Write (i, i * 1000, Create<Packet> (data, size));
+        }
+    }
+  f.Flush ();
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+
+  GlobalValue::Bind ("PcapWriteBufferSize", oldBufferSize);
+  GlobalValue::Bind ("PcapWriteAsync", oldAsync);
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+  std::stringstream filename;
+  filename << rand ();
+  m_directFilename = CreateTempDirFilename (filename.str () + "-direct.pcap");
+  m_bufferedFilename = CreateTempDirFilename (filename.str () + "-buffered.pcap");
+
+  WriteFile (m_directFilename, 0, false);
+  WriteFile (m_bufferedFilename, m_bufferSize, m_async);
+
+  uint32_t sec (0), usec (0), packets (0);
+  bool diff = PcapFile::Diff (m_directFilename, m_bufferedFilename, sec, usec, packets, BUFFERED_SNAPLEN);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Buffered records differ from " << sec << "." << usec << " seconds");
+  NS_TEST_EXPECT_MSG_EQ (packets, N_BUFFERED_PACKETS, "Wrong number of buffered records");
+
+  // the records are truncated to the snap length
+  PcapFile f;
+  f.Open (m_bufferedFilename, std::ios::in);
+  uint8_t data[BUFFERED_SNAPLEN];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  for (uint32_t i = 0; i < N_BUFFERED_PACKETS; ++i)
+    {
+      f.Read (data, BUFFERED_SNAPLEN, tsSec, tsUsec, inclLen, origLen, readLen);
+      uint32_t size = 1 + (i * 37) % (4 * BUFFERED_SNAPLEN);
+      NS_TEST_ASSERT_MSG_EQ (origLen, size, "Wrong original length of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (inclLen, std::min (size, BUFFERED_SNAPLEN), "Wrong included length of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (data[inclLen - 1]), ((i + inclLen - 1) & 0xff), "Wrong data of record " << i);
+    }
+  f.Close ();
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1138,6 +1258,9 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (65536, false), TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (300, false), TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (300, true), TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
@@ -0,0 +1,584 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <deque>
+#include "ns3/core-config.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "compressed-stream.h"
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CompressedStream");
+
+/// Largest number of bytes compressed in a block, so that a block compresses to at most 64 KiB
+static const uint32_t BLOCK_SIZE = 65280;
+/// Size of the gzip header of a block, with the BGZF extra field
+static const uint32_t BLOCK_HEADER_SIZE = 18;
+/// Size of the gzip trailer of a block: CRC32 and size of the data
+static const uint32_t BLOCK_TRAILER_SIZE = 8;
+/// Largest number of blocks of a file waiting for the background thread
+static const uint32_t MAX_PENDING_BLOCKS = 8;
+
+/// Empty block ending a BGZF file
+static const uint8_t EOF_BLOCK[28] = {
+  0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+  0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/**
+ * \brief Store a little endian 16 bits value
+ * \param p the destination
+ * \param v the value
+ */
+static void
+WriteLe16 (char *p, uint16_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+}
+
+/**
+ * \brief Store a little endian 32 bits value
+ * \param p the destination
+ * \param v the value
+ */
+static void
+WriteLe32 (char *p, uint32_t v)
+{
+  WriteLe16 (p, v & 0xffff);
+  WriteLe16 (p + 2, v >> 16);
+}
+
+/**
+ * \brief Compressor of BGZF blocks
+ *
+ * The deflate state is kept from one block to the next to avoid
+ * reallocating it.
+ */
+class BlockCompressor
+{
+public:
+  BlockCompressor ();
+  ~BlockCompressor ();
+  /**
+   * \brief Compress a block
+   * \param data the data to compress
+   * \param size the number of bytes to compress, at most BLOCK_SIZE
+   * \param out the compressed block, header and trailer included
+   * \returns false on failure
+   */
+  bool Compress (char const *data, uint32_t size, std::vector<char> &out);
+
+private:
+#ifdef HAVE_ZLIB_H
+  z_stream m_stream; //!< the deflate state
+  bool m_ok;         //!< the deflate state is initialized
+#endif
+};
+
+BlockCompressor::BlockCompressor ()
+{
+#ifdef HAVE_ZLIB_H
+  std::memset (&m_stream, 0, sizeof (m_stream));
+  m_ok = deflateInit2 (&m_stream, Z_BEST_SPEED, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+#endif
+}
+
+BlockCompressor::~BlockCompressor ()
+{
+#ifdef HAVE_ZLIB_H
+  if (m_ok)
+    {
+      deflateEnd (&m_stream);
+    }
+#endif
+}
+
+bool
+BlockCompressor::Compress (char const *data, uint32_t size, std::vector<char> &out)
+{
+  NS_ASSERT (size <= BLOCK_SIZE);
+#ifdef HAVE_ZLIB_H
+  if (!m_ok || deflateReset (&m_stream) != Z_OK)
+    {
+      return false;
+    }
+  uint32_t bound = deflateBound (&m_stream, size);
+  out.resize (BLOCK_HEADER_SIZE + bound + BLOCK_TRAILER_SIZE);
+  m_stream.next_in = (Bytef *)data;
+  m_stream.avail_in = size;
+  m_stream.next_out = (Bytef *)&out[BLOCK_HEADER_SIZE];
+  m_stream.avail_out = bound;
+  if (deflate (&m_stream, Z_FINISH) != Z_STREAM_END)
+    {
+      return false;
+    }
+  uint32_t total = BLOCK_HEADER_SIZE + m_stream.total_out + BLOCK_TRAILER_SIZE;
+  if (total > 65536)
+    {
+      return false;
+    }
+  out.resize (total);
+
+  // gzip header with the BGZF extra field, holding the block size minus one
+  static const uint8_t header[16] = {
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00
+  };
+  std::memcpy (&out[0], header, sizeof (header));
+  WriteLe16 (&out[16], total - 1);
+  WriteLe32 (&out[total - BLOCK_TRAILER_SIZE], crc32 (crc32 (0, Z_NULL, 0), (Bytef const *)data, size));
+  WriteLe32 (&out[total - 4], size);
+  return true;
+#else
+  return false;
+#endif
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * \brief Background thread compressing and writing the blocks of the
+ * compressed files
+ *
+ * The thread runs while compressed files are open.  Each file has at
+ * most MAX_PENDING_BLOCKS blocks waiting for the thread: beyond that,
+ * the simulation waits for the thread to catch up.
+ */
+class CompressionWorker
+{
+public:
+  /**
+   * \brief Register a compressed file, starting the thread if needed
+   */
+  static void Register (void);
+  /**
+   * \brief Unregister a compressed file, stopping the thread once the
+   * last one is unregistered
+   */
+  static void Unregister (void);
+  /**
+   * \brief Hand the block of a file over to the thread
+   * \param buf the stream buffer of the file
+   *
+   * The block of the stream buffer is replaced with a block already
+   * written, if any.
+   */
+  static void Submit (CompressedStreamBuf *buf);
+  /**
+   * \brief Wait until the blocks of a file are written
+   * \param buf the stream buffer of the file
+   */
+  static void Wait (CompressedStreamBuf *buf);
+  /**
+   * \param buf the stream buffer of a file
+   * \returns true if a block of the file could not be compressed or written
+   */
+  static bool HasFailed (CompressedStreamBuf *buf);
+
+private:
+  /// Block to compress and write
+  struct Job
+  {
+    CompressedStreamBuf *buf; //!< the stream buffer of the file
+    std::vector<char> data;   //!< the data to compress
+  };
+
+  /// Body of the thread
+  static void Run (void);
+
+  static SystemMutex g_mutex;         //!< protects the jobs and the state of the files
+  static SystemCondition g_work;      //!< set when jobs are submitted
+  static SystemCondition g_written;   //!< set when jobs are written
+  static std::deque<Job> g_jobs;      //!< jobs not taken by the thread yet
+  static Ptr<SystemThread> g_thread;  //!< the thread, while it runs
+  static uint32_t g_nFiles;           //!< number of registered files
+  static bool g_stop;                 //!< the thread must stop once the jobs are written
+};
+
+/// Longest wait for a condition, should a notification be missed
+static const uint64_t WORKER_WAIT_NS = 10000000;
+
+SystemMutex CompressionWorker::g_mutex;
+SystemCondition CompressionWorker::g_work;
+SystemCondition CompressionWorker::g_written;
+std::deque<CompressionWorker::Job> CompressionWorker::g_jobs;
+Ptr<SystemThread> CompressionWorker::g_thread;
+uint32_t CompressionWorker::g_nFiles = 0;
+bool CompressionWorker::g_stop = false;
+
+void
+CompressionWorker::Register (void)
+{
+  if (g_nFiles++ == 0)
+    {
+      g_stop = false;
+      g_thread = Create<SystemThread> (MakeCallback (&CompressionWorker::Run));
+      g_thread->Start ();
+    }
+}
+
+void
+CompressionWorker::Unregister (void)
+{
+  NS_ASSERT (g_nFiles > 0);
+  if (--g_nFiles == 0)
+    {
+      {
+        CriticalSection cs (g_mutex);
+        g_stop = true;
+      }
+      g_work.SetCondition (true);
+      g_work.Signal ();
+      g_thread->Join ();
+      g_thread = 0;
+    }
+}
+
+void
+CompressionWorker::Submit (CompressedStreamBuf *buf)
+{
+  while (true)
+    {
+      g_written.SetCondition (false);
+      {
+        CriticalSection cs (g_mutex);
+        if (buf->m_pending < MAX_PENDING_BLOCKS)
+          {
+            g_jobs.push_back (Job ());
+            g_jobs.back ().buf = buf;
+            g_jobs.back ().data.swap (buf->m_block);
+            buf->m_pending++;
+            if (!buf->m_free.empty ())
+              {
+                buf->m_block.swap (buf->m_free.back ());
+                buf->m_free.pop_back ();
+              }
+            break;
+          }
+      }
+      g_written.TimedWait (WORKER_WAIT_NS);
+    }
+  g_work.SetCondition (true);
+  g_work.Signal ();
+}
+
+void
+CompressionWorker::Wait (CompressedStreamBuf *buf)
+{
+  while (true)
+    {
+      g_written.SetCondition (false);
+      {
+        CriticalSection cs (g_mutex);
+        if (buf->m_pending == 0)
+          {
+            return;
+          }
+      }
+      g_written.TimedWait (WORKER_WAIT_NS);
+    }
+}
+
+bool
+CompressionWorker::HasFailed (CompressedStreamBuf *buf)
+{
+  CriticalSection cs (g_mutex);
+  return buf->m_failed;
+}
+
+void
+CompressionWorker::Run (void)
+{
+  BlockCompressor compressor;
+  std::vector<char> out;
+  std::deque<Job> jobs;
+  while (true)
+    {
+      g_work.SetCondition (false);
+      bool stop;
+      {
+        CriticalSection cs (g_mutex);
+        jobs.swap (g_jobs);
+        stop = g_stop;
+      }
+      if (jobs.empty ())
+        {
+          if (stop)
+            {
+              return;
+            }
+          g_work.TimedWait (WORKER_WAIT_NS);
+          continue;
+        }
+
+      for (std::deque<Job>::iterator i = jobs.begin (); i != jobs.end (); ++i)
+        {
+          bool ok = compressor.Compress (&i->data[0], i->data.size (), out);
+          if (ok)
+            {
+              i->buf->m_file.write (&out[0], out.size ());
+              ok = i->buf->m_file.good ();
+            }
+          CriticalSection cs (g_mutex);
+          if (!ok)
+            {
+              i->buf->m_failed = true;
+            }
+          i->buf->m_pending--;
+          if (i->buf->m_free.size () < MAX_PENDING_BLOCKS)
+            {
+              i->buf->m_free.push_back (std::vector<char> ());
+              i->buf->m_free.back ().swap (i->data);
+            }
+        }
+      jobs.clear ();
+      g_written.SetCondition (true);
+      g_written.Broadcast ();
+    }
+}
+#endif /* HAVE_PTHREAD_H */
+
+CompressedStreamBuf::CompressedStreamBuf ()
+  : m_pending (0),
+    m_failed (false),
+    m_async (false),
+    m_compressor (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CompressedStreamBuf::~CompressedStreamBuf ()
+{
+  NS_LOG_FUNCTION (this);
+  if (IsOpen ())
+    {
+      Close ();
+    }
+}
+
+bool
+CompressedStreamBuf::IsCompressedFilename (std::string const &filename)
+{
+  std::string const suffix = ".gz";
+  return filename.size () > suffix.size ()
+         && filename.compare (filename.size () - suffix.size (), suffix.size (), suffix) == 0;
+}
+
+bool
+CompressedStreamBuf::IsEnabled (void)
+{
+#ifdef HAVE_ZLIB_H
+  return true;
+#else
+  return false;
+#endif
+}
+
+CompressedStreamBuf *
+CompressedStreamBuf::Open (std::string const &filename, std::ios::openmode mode)
+{
+  NS_LOG_FUNCTION (this << filename << mode);
+  NS_ASSERT_MSG ((mode & std::ios::in) == 0, "CompressedStreamBuf::Open(): compressed files are write-only");
+  if (IsOpen ())
+    {
+      return 0;
+    }
+  if (!IsEnabled ())
+    {
+      NS_LOG_ERROR ("Cannot write the compressed file " << filename << ": ns-3 was built without zlib");
+      return 0;
+    }
+  m_file.open (filename.c_str (), mode | std::ios::out | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      return 0;
+    }
+  m_pending = 0;
+  m_failed = false;
+#ifdef HAVE_PTHREAD_H
+  m_async = true;
+  CompressionWorker::Register ();
+#else
+  m_async = false;
+  m_compressor = new BlockCompressor ();
+#endif
+  ResetBlock ();
+  return this;
+}
+
+bool
+CompressedStreamBuf::IsOpen (void) const
+{
+  return m_file.is_open ();
+}
+
+void
+CompressedStreamBuf::ResetBlock (void)
+{
+  m_block.resize (BLOCK_SIZE);
+  setp (&m_block[0], &m_block[0] + BLOCK_SIZE);
+}
+
+bool
+CompressedStreamBuf::SubmitBlock (void)
+{
+  uint32_t size = pptr () - pbase ();
+  if (size == 0)
+    {
+      return !m_failed;
+    }
+  m_block.resize (size);
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      CompressionWorker::Submit (this);
+      ResetBlock ();
+      return !CompressionWorker::HasFailed (this);
+    }
+#endif
+  std::vector<char> out;
+  if (m_compressor->Compress (&m_block[0], size, out))
+    {
+      m_file.write (&out[0], out.size ());
+    }
+  else
+    {
+      m_failed = true;
+    }
+  ResetBlock ();
+  return !m_failed && m_file.good ();
+}
+
+CompressedStreamBuf::int_type
+CompressedStreamBuf::overflow (int_type c)
+{
+  NS_LOG_FUNCTION (this);
+  if (!IsOpen () || !SubmitBlock ())
+    {
+      return traits_type::eof ();
+    }
+  if (!traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      *pptr () = traits_type::to_char_type (c);
+      pbump (1);
+    }
+  return traits_type::not_eof (c);
+}
+
+bool
+CompressedStreamBuf::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!IsOpen ())
+    {
+      return false;
+    }
+  bool ok = SubmitBlock ();
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      CompressionWorker::Wait (this);
+      ok = !CompressionWorker::HasFailed (this);
+    }
+#endif
+  m_file.flush ();
+  return ok && m_file.good ();
+}
+
+CompressedStreamBuf *
+CompressedStreamBuf::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!IsOpen ())
+    {
+      return 0;
+    }
+  bool ok = Flush ();
+  m_file.write ((char const *)EOF_BLOCK, sizeof (EOF_BLOCK));
+  m_file.close ();
+  ok = ok && !m_file.fail ();
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      CompressionWorker::Unregister ();
+      m_async = false;
+    }
+#endif
+  delete m_compressor;
+  m_compressor = 0;
+  m_free.clear ();
+  setp (0, 0);
+  return ok ? this : 0;
+}
+
+CompressedOfstream::CompressedOfstream ()
+  : std::ostream (0)
+{
+  init (&m_buf);
+}
+
+CompressedOfstream::~CompressedOfstream ()
+{
+}
+
+void
+CompressedOfstream::Open (std::string const &filename, std::ios::openmode mode)
+{
+  if (m_buf.Open (filename, mode) == 0)
+    {
+      setstate (std::ios::failbit);
+    }
+  else
+    {
+      clear ();
+    }
+}
+
+bool
+CompressedOfstream::IsOpen (void) const
+{
+  return m_buf.IsOpen ();
+}
+
+void
+CompressedOfstream::Flush (void)
+{
+  if (!m_buf.Flush ())
+    {
+      setstate (std::ios::badbit);
+    }
+}
+
+void
+CompressedOfstream::Close (void)
+{
+  if (m_buf.Close () == 0)
+    {
+      setstate (std::ios::failbit);
+    }
+}
+
+} // namespace ns3
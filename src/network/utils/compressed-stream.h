@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPRESSED_STREAM_H
+#define COMPRESSED_STREAM_H
+
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+class BlockCompressor;
+class CompressionWorker;
+
+/**
+ * \ingroup network
+ * \brief A stream buffer writing a file compressed with gzip, in blocks
+ *
+ * The data are compressed in independent blocks of at most 65280 bytes,
+ * in the BGZF (blocked gzip) format: the file is a sequence of gzip
+ * members, which the gzip tools read as one stream, and the header of
+ * each member gives its compressed size.  A reader can thus find the
+ * block boundaries without decompressing, and decompress the blocks in
+ * parallel.
+ *
+ * When threads are available, the blocks are compressed and written by
+ * a background thread shared by all the compressed files, with at most
+ * a few blocks pending per file.  Synchronizing the stream (std::flush,
+ * std::endl) does not end the current block: the data reach the file
+ * when a block is full, on Flush and on Close.
+ *
+ * Compression requires ns-3 to be built with zlib.
+ */
+class CompressedStreamBuf : public std::streambuf
+{
+public:
+  CompressedStreamBuf ();
+  virtual ~CompressedStreamBuf ();
+
+  /**
+   * \param filename a file name
+   * \returns true if the file name has the suffix of compressed files, ".gz"
+   */
+  static bool IsCompressedFilename (std::string const &filename);
+
+  /**
+   * \returns true if ns-3 was built with zlib, which compression requires
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * \brief Open a file for writing
+   * \param filename the name of the file
+   * \param mode the access mode, which must not include std::ios::in;
+   * with std::ios::app, the blocks are appended to the file
+   * \returns this stream buffer, or 0 if the file could not be opened
+   */
+  CompressedStreamBuf * Open (std::string const &filename, std::ios::openmode mode);
+
+  /**
+   * \returns true if the file is open
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \brief Write the current block and wait until the pending blocks are
+   * written to the file
+   * \returns false if a block could not be compressed or written
+   */
+  bool Flush (void);
+
+  /**
+   * \brief Write the buffered data and the end of file marker, and close
+   * the file
+   * \returns this stream buffer, or 0 on failure
+   */
+  CompressedStreamBuf * Close (void);
+
+protected:
+  /**
+   * \brief Hand the full block over for compression, and start a new one
+   * \param c a character to put in the new block, or eof
+   * \returns eof on failure
+   */
+  virtual int_type overflow (int_type c);
+
+private:
+  friend class CompressionWorker;
+
+  /**
+   * \brief Hand the current block over for compression, if not empty
+   * \returns false if a block could not be compressed or written
+   */
+  bool SubmitBlock (void);
+
+  /// Start a new block in the put area
+  void ResetBlock (void);
+
+  std::ofstream m_file;                       //!< the compressed file
+  std::vector<char> m_block;                  //!< block being filled
+  std::vector<std::vector<char> > m_free;     //!< blocks written by the background thread, for reuse
+  uint32_t m_pending;                         //!< number of blocks handed over to the background thread
+  bool m_failed;                              //!< a block could not be compressed or written
+  bool m_async;                               //!< the blocks are compressed by the background thread
+  BlockCompressor *m_compressor;              //!< compressor of the blocks, if not asynchronous
+};
+
+/**
+ * \ingroup network
+ * \brief An output stream writing a file compressed with gzip, in blocks
+ *
+ * \see CompressedStreamBuf
+ */
+class CompressedOfstream : public std::ostream
+{
+public:
+  CompressedOfstream ();
+  virtual ~CompressedOfstream ();
+
+  /**
+   * \brief Open a file for writing, setting the failbit on failure
+   * \param filename the name of the file
+   * \param mode the access mode
+   */
+  void Open (std::string const &filename, std::ios::openmode mode = std::ios::out);
+
+  /**
+   * \returns true if the file is open
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \brief Write the buffered data to the file, setting the badbit on failure
+   */
+  void Flush (void);
+
+  /**
+   * \brief Close the file, setting the failbit on failure
+   */
+  void Close (void);
+
+private:
+  CompressedStreamBuf m_buf; //!< the stream buffer
+};
+
+} // namespace ns3
+
+#endif /* COMPRESSED_STREAM_H */
@@ -87,14 +87,18 @@ DropTailQueue::DoEnqueue (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.size () >= m_maxPackets))
+  // the fluid takes room as well
+  double fluidBytes = HasFluid () ? GetFluidBytes () : 0;
+
+  if (m_mode == QUEUE_MODE_PACKETS
+      && (m_packets.size () + fluidBytes / GetFluidPacketSize () >= m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
       Drop (p);
       return false;
     }
 
-  if (m_mode == QUEUE_MODE_BYTES && (m_bytesInQueue + p->GetSize () >= m_maxBytes))
+  if (m_mode == QUEUE_MODE_BYTES && (m_bytesInQueue + p->GetSize () + fluidBytes >= m_maxBytes))
     {
       NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- droppping pkt");
       Drop (p);
@@ -133,6 +137,16 @@ DropTailQueue::DoDequeue (void)
   return p;
 }
 
+double
+DropTailQueue::DoGetFluidCapacity (void) const
+{
+  if (m_mode == QUEUE_MODE_PACKETS)
+    {
+      return (static_cast<double> (m_maxPackets) - m_packets.size ()) * GetFluidPacketSize ();
+    }
+  return static_cast<double> (m_maxBytes) - m_bytesInQueue;
+}
+
 Ptr<const Packet>
 DropTailQueue::DoPeek (void) const
 {
@@ -67,6 +67,7 @@ private:
   virtual bool DoEnqueue (Ptr<Packet> p);
   virtual Ptr<Packet> DoDequeue (void);
   virtual Ptr<const Packet> DoPeek (void) const;
+  virtual double DoGetFluidCapacity (void) const;
 
   std::queue<Ptr<Packet> > m_packets; //!< the packets in the queue
   uint32_t m_maxPackets;              //!< max packets in the queue
@@ -17,6 +17,7 @@
  */
 
 #include "output-stream-wrapper.h"
+#include "compressed-stream.h"
 #include "ns3/log.h"
 #include "ns3/fatal-impl.h"
 #include "ns3/abort.h"
@@ -30,11 +31,23 @@ OutputStreamWrapper::OutputStreamWrapper (std::string filename, std::ios::openmo
   : m_destroyable (true)
 {
   NS_LOG_FUNCTION (this << filename << filemode);
-  std::ofstream* os = new std::ofstream ();
-  os->open (filename.c_str (), filemode);
-  m_ostream = os;
+  bool isOpen;
+  if (CompressedStreamBuf::IsCompressedFilename (filename))
+    {
+      CompressedOfstream* os = new CompressedOfstream ();
+      os->Open (filename, filemode);
+      isOpen = os->IsOpen ();
+      m_ostream = os;
+    }
+  else
+    {
+      std::ofstream* os = new std::ofstream ();
+      os->open (filename.c_str (), filemode);
+      isOpen = os->is_open ();
+      m_ostream = os;
+    }
   FatalImpl::RegisterStream (m_ostream);
-  NS_ABORT_MSG_UNLESS (os->is_open (), "AsciiTraceHelper::CreateFileStream():  " <<
+  NS_ABORT_MSG_UNLESS (isOpen, "AsciiTraceHelper::CreateFileStream():  " <<
                        "Unable to Open " << filename << " for mode " << filemode);
 }
 
@@ -72,6 +72,10 @@ class OutputStreamWrapper : public SimpleRefCount<OutputStreamWrapper>
 public:
   /**
    * Constructor
+   *
+   * A file name ending in ".gz" is written compressed by a
+   * CompressedOfstream.
+   *
    * \param filename file name
    * \param filemode std::ios::openmode flags
    */
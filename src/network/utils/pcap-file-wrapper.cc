@@ -83,6 +83,13 @@ PcapFileWrapper::Close (void)
   m_file.Close ();
 }
 
+void
+PcapFileWrapper::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_file.Flush ();
+}
+
 void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
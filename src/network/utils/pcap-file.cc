@@ -20,6 +20,8 @@
 
 #include <iostream>
 #include <cstring>
+#include <deque>
+#include "ns3/core-config.h"
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
@@ -27,8 +29,17 @@
 #include "ns3/header.h"
 #include "ns3/buffer.h"
 #include "pcap-file.h"
+#include "compressed-stream.h"
 #include "ns3/log.h"
 #include "ns3/build-profile.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
 //
 // This file is used as part of the ns-3 test framework, so please refrain from 
 // adding any ns-3 specific constructs such as Packet to this file.
@@ -47,9 +58,206 @@ const uint32_t NS_SWAPPED_MAGIC = 0xd43cb2a1; /**< Looks this way if byte swappi
 const uint16_t VERSION_MAJOR = 2;             /**< Major version of supported pcap file format */
 const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pcap file format */
 
+const uint32_t RECORD_HEADER_SIZE = 16;       /**< Size of a record header in the file */
+
+/**
+ * \brief Size of the write buffer of each pcap file
+ */
+static GlobalValue g_pcapWriteBufferSize = GlobalValue ("PcapWriteBufferSize",
+                                                        "Size in bytes of the buffer gathering the records "
+                                                        "written to each pcap file (0, the default, for "
+                                                        "no buffering)",
+                                                        UintegerValue (0),
+                                                        MakeUintegerChecker<uint32_t> ());
+
+/**
+ * \brief Whether the pcap write buffers are written by a background thread
+ */
+static GlobalValue g_pcapWriteAsync = GlobalValue ("PcapWriteAsync",
+                                                   "Write the full pcap write buffers to the files "
+                                                   "from a background thread",
+                                                   BooleanValue (false),
+                                                   MakeBooleanChecker ());
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * \brief Background thread writing the buffers of the pcap files
+ *
+ * The thread runs while files written asynchronously are open, and
+ * writes the buffers handed over to it in batches.
+ */
+class PcapFileWriter
+{
+public:
+  /**
+   * \brief Register a file written asynchronously, starting the thread
+   * if needed
+   */
+  static void Register (void);
+  /**
+   * \brief Unregister a file written asynchronously, stopping the thread
+   * once the last one is unregistered
+   */
+  static void Unregister (void);
+  /**
+   * \brief Hand a buffer over to the thread
+   * \param file the file to write to
+   * \param data the buffer
+   * \param size the number of bytes in the buffer
+   * \param busy flag to clear once the buffer is written
+   */
+  static void Submit (std::fstream *file, uint8_t const *data, uint32_t size, bool *busy);
+  /**
+   * \brief Wait until a buffer handed over to the thread is written
+   * \param busy the flag given to Submit
+   */
+  static void Wait (bool const *busy);
+
+private:
+  /// Buffer to write
+  struct Job
+  {
+    std::fstream *file;    //!< the file to write to
+    uint8_t const *data;   //!< the buffer
+    uint32_t size;         //!< the number of bytes in the buffer
+    bool *busy;            //!< flag to clear once the buffer is written
+  };
+
+  /// Body of the thread
+  static void Run (void);
+
+  static SystemMutex g_mutex;         //!< protects the jobs and the busy flags
+  static SystemCondition g_work;      //!< set when jobs are submitted
+  static SystemCondition g_written;   //!< set when jobs are written
+  static std::deque<Job> g_jobs;      //!< jobs not taken by the thread yet
+  static Ptr<SystemThread> g_thread;  //!< the thread, while it runs
+  static uint32_t g_nFiles;           //!< number of registered files
+  static bool g_stop;                 //!< the thread must stop once the jobs are written
+};
+
+/// Longest wait for a condition, should a notification be missed
+static const uint64_t WRITER_WAIT_NS = 10000000;
+
+SystemMutex PcapFileWriter::g_mutex;
+SystemCondition PcapFileWriter::g_work;
+SystemCondition PcapFileWriter::g_written;
+std::deque<PcapFileWriter::Job> PcapFileWriter::g_jobs;
+Ptr<SystemThread> PcapFileWriter::g_thread;
+uint32_t PcapFileWriter::g_nFiles = 0;
+bool PcapFileWriter::g_stop = false;
+
+void
+PcapFileWriter::Register (void)
+{
+  if (g_nFiles++ == 0)
+    {
+      g_stop = false;
+      g_thread = Create<SystemThread> (MakeCallback (&PcapFileWriter::Run));
+      g_thread->Start ();
+    }
+}
+
+void
+PcapFileWriter::Unregister (void)
+{
+  NS_ASSERT (g_nFiles > 0);
+  if (--g_nFiles == 0)
+    {
+      {
+        CriticalSection cs (g_mutex);
+        g_stop = true;
+      }
+      g_work.SetCondition (true);
+      g_work.Signal ();
+      g_thread->Join ();
+      g_thread = 0;
+    }
+}
+
+void
+PcapFileWriter::Submit (std::fstream *file, uint8_t const *data, uint32_t size, bool *busy)
+{
+  Job job;
+  job.file = file;
+  job.data = data;
+  job.size = size;
+  job.busy = busy;
+  {
+    CriticalSection cs (g_mutex);
+    *busy = true;
+    g_jobs.push_back (job);
+  }
+  g_work.SetCondition (true);
+  g_work.Signal ();
+}
+
+void
+PcapFileWriter::Wait (bool const *busy)
+{
+  while (true)
+    {
+      g_written.SetCondition (false);
+      {
+        CriticalSection cs (g_mutex);
+        if (!*busy)
+          {
+            return;
+          }
+      }
+      g_written.TimedWait (WRITER_WAIT_NS);
+    }
+}
+
+void
+PcapFileWriter::Run (void)
+{
+  std::deque<Job> jobs;
+  while (true)
+    {
+      g_work.SetCondition (false);
+      bool stop;
+      {
+        CriticalSection cs (g_mutex);
+        jobs.swap (g_jobs);
+        stop = g_stop;
+      }
+      if (jobs.empty ())
+        {
+          if (stop)
+            {
+              return;
+            }
+          g_work.TimedWait (WRITER_WAIT_NS);
+          continue;
+        }
+
+      for (std::deque<Job>::const_iterator i = jobs.begin (); i != jobs.end (); ++i)
+        {
+          i->file->write ((const char *)i->data, i->size);
+        }
+      {
+        CriticalSection cs (g_mutex);
+        for (std::deque<Job>::const_iterator i = jobs.begin (); i != jobs.end (); ++i)
+          {
+            *i->busy = false;
+          }
+      }
+      jobs.clear ();
+      g_written.SetCondition (true);
+      g_written.Broadcast ();
+    }
+}
+#endif /* HAVE_PTHREAD_H */
+
 PcapFile::PcapFile ()
   : m_file (),
-    m_swapMode (false)
+    m_compressed (0),
+    m_output (&m_file),
+    m_swapMode (false),
+    m_bufferSize (0),
+    m_bufferUsed (0),
+    m_async (false),
+    m_spareBusy (false)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file);
@@ -67,19 +275,22 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_file.fail ();
+  WaitWritten ();
+  return m_output->fail ();
 }
 bool 
 PcapFile::Eof (void) const
 {
   NS_LOG_FUNCTION (this);
+  WaitWritten ();
   return m_file.eof ();
 }
 void 
 PcapFile::Clear (void)
 {
   NS_LOG_FUNCTION (this);
-  m_file.clear ();
+  WaitWritten ();
+  m_output->clear ();
 }
 
 
@@ -87,9 +298,112 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_file.is_open () || m_compressed)
+    {
+      FlushBuffer ();
+      WaitWritten ();
+    }
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      PcapFileWriter::Unregister ();
+      m_async = false;
+    }
+#endif
+  m_bufferSize = 0;
+  m_buffer.clear ();
+  m_spare.clear ();
+  if (m_compressed)
+    {
+      m_compressed->Close ();
+      FatalImpl::UnregisterStream (m_compressed);
+      delete m_compressed;
+      m_compressed = 0;
+      m_output = &m_file;
+    }
   m_file.close ();
 }
 
+void
+PcapFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  FlushBuffer ();
+  WaitWritten ();
+  if (m_compressed)
+    {
+      m_compressed->Flush ();
+    }
+  else
+    {
+      m_file.flush ();
+    }
+}
+
+void
+PcapFile::WriteBytes (uint8_t const *data, uint32_t size)
+{
+  if (m_bufferSize == 0)
+    {
+      m_output->write ((const char *)data, size);
+    }
+  else
+    {
+      std::memcpy (Reserve (size), data, size);
+    }
+}
+
+uint8_t *
+PcapFile::Reserve (uint32_t size)
+{
+  if (m_bufferUsed + size > m_bufferSize && m_bufferUsed > 0)
+    {
+      FlushBuffer ();
+    }
+  if (m_buffer.size () < m_bufferUsed + size)
+    {
+      // a record larger than the buffer
+      m_buffer.resize (m_bufferUsed + size);
+    }
+  uint8_t *start = &m_buffer[0] + m_bufferUsed;
+  m_bufferUsed += size;
+  return start;
+}
+
+void
+PcapFile::FlushBuffer (void)
+{
+  if (m_bufferUsed == 0)
+    {
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      // hand the buffer over to the background thread, and
+      // go on with the spare one once it is written
+      WaitWritten ();
+      m_buffer.swap (m_spare);
+      PcapFileWriter::Submit (&m_file, &m_spare[0], m_bufferUsed, &m_spareBusy);
+      m_bufferUsed = 0;
+      return;
+    }
+#endif
+  m_output->write ((const char *)&m_buffer[0], m_bufferUsed);
+  m_bufferUsed = 0;
+}
+
+void
+PcapFile::WaitWritten (void) const
+{
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      PcapFileWriter::Wait (&m_spareBusy);
+    }
+#endif
+}
+
 uint32_t
 PcapFile::GetMagic (void)
 {
@@ -194,11 +508,18 @@ void
 PcapFile::WriteFileHeader (void)
 {
   NS_LOG_FUNCTION (this);
+  FlushBuffer ();
+  WaitWritten ();
+
   //
   // If we're initializing the file, we need to write the pcap file header
-  // at the start of the file.
+  // at the start of the file (a compressed file is only written once,
+  // right after it is opened).
   //
-  m_file.seekp (0, std::ios::beg);
+  if (m_output == &m_file)
+    {
+      m_file.seekp (0, std::ios::beg);
+    }
  
   //
   // We have the ability to write out the pcap file header in a foreign endian
@@ -226,13 +547,13 @@ PcapFile::WriteFileHeader (void)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
-  m_file.write ((const char *)&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
-  m_file.write ((const char *)&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
-  m_file.write ((const char *)&headerOut->m_zone, sizeof(headerOut->m_zone));
-  m_file.write ((const char *)&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
-  m_file.write ((const char *)&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
-  m_file.write ((const char *)&headerOut->m_type, sizeof(headerOut->m_type));
+  m_output->write ((const char *)&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
+  m_output->write ((const char *)&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
+  m_output->write ((const char *)&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
+  m_output->write ((const char *)&headerOut->m_zone, sizeof(headerOut->m_zone));
+  m_output->write ((const char *)&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
+  m_output->write ((const char *)&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
+  m_output->write ((const char *)&headerOut->m_type, sizeof(headerOut->m_type));
 }
 
 void
@@ -318,12 +639,42 @@ PcapFile::Open (std::string const &filename, std::ios::openmode mode)
   //
   mode |= std::ios::binary;
 
-  m_file.open (filename.c_str (), mode);
+  if ((mode & std::ios::in) == 0 && CompressedStreamBuf::IsCompressedFilename (filename))
+    {
+      m_compressed = new CompressedOfstream ();
+      m_compressed->Open (filename, mode);
+      FatalImpl::RegisterStream (m_compressed);
+      m_output = m_compressed;
+    }
+  else
+    {
+      m_file.open (filename.c_str (), mode);
+    }
   if (mode & std::ios::in)
     {
       // will set the fail bit if file header is invalid.
       ReadAndVerifyFileHeader ();
     }
+  else if (m_file.is_open () || (m_compressed && m_compressed->IsOpen ()))
+    {
+      // records written to the file are buffered
+      UintegerValue bufferSize;
+      g_pcapWriteBufferSize.GetValue (bufferSize);
+      m_bufferSize = bufferSize.Get ();
+      m_buffer.resize (m_bufferSize);
+      m_bufferUsed = 0;
+#ifdef HAVE_PTHREAD_H
+      BooleanValue async;
+      g_pcapWriteAsync.GetValue (async);
+      // compressed files are already written by a background thread
+      if (m_bufferSize > 0 && async.Get () && !m_compressed)
+        {
+          m_async = true;
+          m_spare.resize (m_bufferSize);
+          PcapFileWriter::Register ();
+        }
+#endif
+    }
 }
 
 void
@@ -375,7 +726,8 @@ uint32_t
 PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
-  NS_ASSERT (m_file.good ());
+  // the stream is written by the background thread in asynchronous mode
+  NS_ASSERT (m_async || m_output->good ());
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
@@ -391,14 +743,15 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
     }
 
   //
-  // Watch out for memory alignment differences between machines, so write
-  // them all individually.
+  // Watch out for memory alignment differences between machines, so copy
+  // them all individually, and write the record header at once.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
-  NS_BUILD_DEBUG(m_file.flush());
+  uint8_t record[RECORD_HEADER_SIZE];
+  std::memcpy (record, &header.m_tsSec, sizeof(header.m_tsSec));
+  std::memcpy (record + 4, &header.m_tsUsec, sizeof(header.m_tsUsec));
+  std::memcpy (record + 8, &header.m_inclLen, sizeof(header.m_inclLen));
+  std::memcpy (record + 12, &header.m_origLen, sizeof(header.m_origLen));
+  WriteBytes (record, RECORD_HEADER_SIZE);
   return inclLen;
 }
 
@@ -407,8 +760,11 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, ui
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
-  m_file.write ((const char *)data, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  WriteBytes (data, inclLen);
+  if (m_bufferSize == 0)
+    {
+      NS_BUILD_DEBUG(m_output->flush());
+    }
 }
 
 void 
@@ -416,8 +772,17 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
-  p->CopyData (&m_file, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  if (m_bufferSize == 0)
+    {
+      p->CopyData (m_output, inclLen);
+      NS_BUILD_DEBUG(m_output->flush());
+    }
+  else
+    {
+      // only the first inclLen bytes of the packet are copied,
+      // straight into the write buffer
+      p->CopyData (Reserve (inclLen), inclLen);
+    }
 }
 
 void 
@@ -432,9 +797,18 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<cons
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
   uint32_t toCopy = std::min (headerSize, inclLen);
-  headerBuffer.CopyData (&m_file, toCopy);
-  inclLen -= toCopy;
-  p->CopyData (&m_file, inclLen);
+  if (m_bufferSize == 0)
+    {
+      headerBuffer.CopyData (m_output, toCopy);
+      inclLen -= toCopy;
+      p->CopyData (m_output, inclLen);
+    }
+  else
+    {
+      headerBuffer.CopyData (Reserve (toCopy), toCopy);
+      inclLen -= toCopy;
+      p->CopyData (Reserve (inclLen), inclLen);
+    }
 }
 
 void
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ptr.h"
 
@@ -30,6 +31,7 @@ namespace ns3 {
 
 class Packet;
 class Header;
+class CompressedOfstream;
 
 
 /**
@@ -38,6 +40,18 @@ class Header;
  * A class representing a pcap file.  This allows easy creation, writing and 
  * reading of files composed of stored packets; which may be viewed using
  * standard tools.
+ *
+ * The records written to a file opened for writing may be gathered in a
+ * write buffer of PcapWriteBufferSize bytes (a global value; the default
+ * of 0 writes each record to the file stream as it comes, as ns-3 always
+ * did).  When PcapWriteAsync is true, the full buffers are handed over to
+ * a background thread that writes them to the files, while the simulation
+ * fills a second buffer.  The buffered records are written out by Flush
+ * and Close.
+ *
+ * A file opened for writing with a name ending in ".gz" is written
+ * compressed by a CompressedOfstream, which compresses in a background
+ * thread of its own.  Compressed files can not be read back by this class.
  */
 class PcapFile
 {
@@ -85,6 +99,11 @@ public:
    */
   void Close (void);
 
+  /**
+   * Write the buffered records out to the underlying file.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this object.  This file must have
    * been previously opened with write permissions.
@@ -353,10 +372,46 @@ private:
    */
   void ReadAndVerifyFileHeader (void);
 
+  /**
+   * \brief Write bytes to the file, through the write buffer if any
+   * \param data the bytes
+   * \param size the number of bytes
+   */
+  void WriteBytes (uint8_t const *data, uint32_t size);
+
+  /**
+   * \brief Reserve space at the end of the write buffer, handing the
+   * buffer over to the file first if the space does not fit
+   * \param size the number of bytes
+   * \returns the start of the reserved space
+   */
+  uint8_t * Reserve (uint32_t size);
+
+  /**
+   * \brief Hand the records of the write buffer over to the file,
+   * or to the background thread
+   */
+  void FlushBuffer (void);
+
+  /**
+   * \brief Wait until the background thread wrote the buffer handed
+   * over to it
+   */
+  void WaitWritten (void) const;
+
   std::string    m_filename;    //!< file name
   std::fstream   m_file;        //!< file stream
+  CompressedOfstream *m_compressed; //!< compressed file stream, if the file is compressed
+  std::ostream  *m_output;      //!< stream written to: m_file, or m_compressed
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
+
+  uint32_t m_bufferSize;        //!< size of the write buffer, 0 if records are not buffered
+  std::vector<uint8_t> m_buffer; //!< write buffer
+  uint32_t m_bufferUsed;        //!< number of bytes in the write buffer
+  bool m_async;                 //!< buffers are written by the background thread
+  std::vector<uint8_t> m_spare; //!< buffer being written by the background thread
+  bool m_spareBusy;             //!< the background thread did not write the spare buffer yet
 };
 
 } // namespace ns3
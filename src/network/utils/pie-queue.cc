@@ -67,6 +67,8 @@
 #include "pie-queue.h"
 #include "ns3/timer.h"
 
+#include <algorithm>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PieQueue");
@@ -148,7 +150,8 @@ PieQueue::PieQueue ()
   : Queue (),
     m_packets (),
     m_bytesInQueue (0),
-    m_hasPieStarted (false)
+    m_hasPieStarted (false),
+    m_fluidMeasured (0)
 {
   NS_LOG_FUNCTION (this);
   
@@ -253,7 +256,12 @@ PieQueue::DoEnqueue (Ptr<Packet> pkt)
       m_hasPieStarted = true;
     }
 
+  // the fluid takes room as well
   uint32_t QLen = m_bytesInQueue;
+  if (HasFluid ())
+    {
+      QLen += static_cast<uint32_t> (GetFluidBytes ());
+    }
   m_curq = QLen;
   uint32_t QLim = m_qLim * m_meanPktSize;
 
@@ -350,65 +358,123 @@ Ptr<Packet> PieQueue::DoDequeue ()
       p = m_packets.front ();
       m_packets.pop ();
       m_bytesInQueue -= p->GetSize ();
-      double now = Simulator::Now ().GetSeconds ();
       uint32_t pktSize = p->GetSize ();
-
-      /* if not in a measurement cycle and the queue has built up to dq_threshold,
-      start the measurement cycle*/
-
-      if ( (m_bytesInQueue >= (uint32_t )(m_dqThreshold)) && (m_inMeasurement == 0) )
+      uint32_t qLen = m_bytesInQueue;
+      if (HasFluid ())
         {
-          m_dqStart = now;
-          m_dqCount = 0;
-          m_inMeasurement = 1;
+          // the fluid served since the last dequeue departed as well
+          pktSize += TakeFluidDeparted ();
+          qLen += static_cast<uint32_t> (GetFluidBytes ());
         }
 
-      if (m_inMeasurement == 1)
+      MeasureDequeueRate (pktSize, qLen);
+
+      m_curq = m_bytesInQueue;
+      return (p);
+    }
+}
+
+void PieQueue::MeasureDequeueRate (uint32_t bytes, uint32_t qLen)
+{
+  NS_LOG_FUNCTION (this << bytes << qLen);
+  double now = Simulator::Now ().GetSeconds ();
+
+  /* if not in a measurement cycle and the queue has built up to dq_threshold,
+  start the measurement cycle*/
+
+  if ( (qLen >= (uint32_t )(m_dqThreshold)) && (m_inMeasurement == 0) )
+    {
+      m_dqStart = now;
+      m_dqCount = 0;
+      m_inMeasurement = 1;
+    }
+
+  if (m_inMeasurement == 1)
+    {
+      m_dqCount += bytes;
+      // done with a measurement cycle
+      if (m_dqCount >= (m_dqThreshold))
         {
-          m_dqCount += pktSize;
-          // done with a measurement cycle
-          if (m_dqCount >= (m_dqThreshold))
+          
+          double tmp = now - m_dqStart;
+         
+          if (m_avgDqRate == 0)
+            {
+              m_avgDqRate = m_dqCount / tmp;
+            }
+          else
             {
-              
-              double tmp = now - m_dqStart;
-             
-              if (m_avgDqRate == 0)
-                {
-                  m_avgDqRate = m_dqCount / tmp;
-                }
-              else
-                {
-                  m_avgDqRate = 0.5 * m_avgDqRate + 0.5 * m_dqCount / tmp;
-                }
-              // restart a measurement cycle if there is enough data
-              if (m_bytesInQueue > (uint32_t) (m_dqThreshold))
-                {
-                  m_dqStart = now;
-                  m_dqCount = 0;
-                  m_inMeasurement = 1;
-                }
-              else
-                {
-                  m_dqCount = 0;
-                  m_inMeasurement = 0;
-                }
+              m_avgDqRate = 0.5 * m_avgDqRate + 0.5 * m_dqCount / tmp;
+            }
+          // restart a measurement cycle if there is enough data
+          if (qLen > (uint32_t) (m_dqThreshold))
+            {
+              m_dqStart = now;
+              m_dqCount = 0;
+              m_inMeasurement = 1;
+            }
+          else
+            {
+              m_dqCount = 0;
+              m_inMeasurement = 0;
             }
         }
+    }
+}
 
-      m_curq = m_bytesInQueue;
-      return (p);
+uint32_t PieQueue::TakeFluidDeparted (void)
+{
+  NS_LOG_FUNCTION (this);
+  double bytes = GetTotalFluidDepartedBytes () - m_fluidMeasured;
+  uint32_t whole = static_cast<uint32_t> (bytes);
+  m_fluidMeasured += whole;
+  return m_inMeasurement ? whole : 0;
+}
+
+double PieQueue::DoGetFluidCapacity (void) const
+{
+  return static_cast<double> (m_qLim) * m_meanPktSize - m_bytesInQueue;
+}
+
+double PieQueue::DoGetFluidDropProbability (void) const
+{
+  // the fluid is dropped early as the packets would be, in DropEarly
+  if (m_burstAllowance.GetSeconds () > 0)
+    {
+      return 0;
     }
+  if (m_qDelayOld.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds () && m_dropProb < 0.2)
+    {
+      return 0;
+    }
+  if (m_bytesInQueue + GetFluidBacklog () <= 2 * m_meanPktSize)
+    {
+      return 0;
+    }
+  double p = m_dropProb;
+  if (m_queueInBytes)
+    {
+      p = p * GetFluidPacketSize () / m_meanPktSize;
+    }
+  return std::min (p, 1.0);
 }
 
 void PieQueue::CalculateP ()
 {
   NS_LOG_FUNCTION (this);
   Time qDelay;
-  double p;
+  double p = 0.0;
   bool missingInitFlag = false;
+  double qLen = m_bytesInQueue;
+  if (HasFluid ())
+    {
+      // the fluid served since the last dequeue departed, and the rest is queued
+      qLen += GetFluidBytes ();
+      MeasureDequeueRate (TakeFluidDeparted (), static_cast<uint32_t> (qLen));
+    }
   if (m_avgDqRate > 0)
     {
-      qDelay = Time (Seconds (m_bytesInQueue / m_avgDqRate));
+      qDelay = Time (Seconds (qLen / m_avgDqRate));
     }
   else
     {
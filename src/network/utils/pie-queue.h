@@ -178,6 +178,8 @@ private:
   virtual bool DoEnqueue (Ptr<Packet> p);
   virtual Ptr<Packet> DoDequeue (void);
   virtual Ptr<const Packet> DoPeek (void) const;
+  virtual double DoGetFluidCapacity (void) const;
+  virtual double DoGetFluidDropProbability (void) const;
 
   /**
   * \brief Initialize the queue parameters.
@@ -204,6 +206,20 @@ private:
    */
   void CalculateP ();
 
+  /**
+   * Measure the dequeue rate
+   * \param bytes bytes departed since the last call
+   * \param qlen queue length, in bytes
+   */
+  void MeasureDequeueRate (uint32_t bytes, uint32_t qlen);
+
+  /**
+   * \return the fluid bytes served since the last call, or 0 outside of a
+   * measurement cycle: the fluid served before a cycle starts is not
+   * part of it
+   */
+  uint32_t TakeFluidDeparted (void);
+
   std::queue<Ptr<Packet> > m_packets;           //!< packets in the queue
   uint32_t m_bytesInQueue;                      //!< bytes in the queue
   bool m_hasPieStarted;                         //!< True if PIE has started
@@ -238,6 +254,7 @@ private:
   uint32_t m_dqCount;                           //!< number of bytes departed since current measurement cycle starts
   uint32_t m_curq;                              //!< helps to trace queue during arrival, if enabled
   EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  double m_fluidMeasured;                       //!< fluid bytes served, accounted in the dequeue rate
   Ptr<UniformRandomVariable> m_uv;              //!< rng stream
 
 };
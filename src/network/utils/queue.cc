@@ -18,8 +18,12 @@
 
 #include "ns3/log.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/simulator.h"
 #include "queue.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Queue");
@@ -51,7 +55,19 @@ Queue::Queue() :
   m_nPackets (0),
   m_nTotalReceivedPackets (0),
   m_nTotalDroppedBytes (0),
-  m_nTotalDroppedPackets (0)
+  m_nTotalDroppedPackets (0),
+  m_fluidActive (false),
+  m_fluidRate (0),
+  m_fluidPacketRate (0),
+  m_fluidPacketSize (1),
+  m_fluidServiceRate (0),
+  m_fluidServing (true),
+  m_fluidBytes (0),
+  m_fluidArrived (0),
+  m_fluidDeparted (0),
+  m_fluidDropped (0),
+  m_fluidAhead (0),
+  m_fluidUnmarked (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -67,6 +83,8 @@ Queue::Enqueue (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
 
+  CatchUp ();
+  UpdateFluid ();
   //
   // If DoEnqueue fails, Queue::Drop is called by the subclass
   //
@@ -75,6 +93,10 @@ Queue::Enqueue (Ptr<Packet> p)
     {
       NS_LOG_LOGIC ("m_traceEnqueue (p)");
       m_traceEnqueue (p);
+      if (m_fluidActive)
+        {
+          m_fluidMarks.push_back (std::make_pair (p->GetUid (), m_fluidArrived));
+        }
 
       uint32_t size = p->GetSize ();
       m_nBytes += size;
@@ -91,6 +113,8 @@ Queue::Dequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
+  CatchUp ();
+  UpdateFluid ();
   Ptr<Packet> packet = DoDequeue ();
 
   if (packet != 0)
@@ -101,6 +125,25 @@ Queue::Dequeue (void)
       m_nBytes -= packet->GetSize ();
       m_nPackets--;
 
+      m_fluidAhead = 0;
+      if (m_fluidUnmarked > 0)
+        {
+          m_fluidUnmarked--;
+        }
+      else if (m_fluidActive)
+        {
+          // skip the marks of the packets dropped by the queue
+          while (!m_fluidMarks.empty () && m_fluidMarks.front ().first != packet->GetUid ())
+            {
+              m_fluidMarks.pop_front ();
+            }
+          if (!m_fluidMarks.empty ())
+            {
+              m_fluidAhead = std::max (0.0, m_fluidMarks.front ().second - m_fluidDeparted);
+              m_fluidMarks.pop_front ();
+            }
+        }
+
       NS_LOG_LOGIC ("m_traceDequeue (packet)");
       m_traceDequeue (packet);
     }
@@ -121,6 +164,7 @@ Ptr<const Packet>
 Queue::Peek (void) const
 {
   NS_LOG_FUNCTION (this);
+  CatchUp ();
   return DoPeek ();
 }
 
@@ -129,6 +173,7 @@ uint32_t
 Queue::GetNPackets (void) const
 {
   NS_LOG_FUNCTION (this);
+  CatchUp ();
   NS_LOG_LOGIC ("returns " << m_nPackets);
   return m_nPackets;
 }
@@ -137,6 +182,7 @@ uint32_t
 Queue::GetNBytes (void) const
 {
   NS_LOG_FUNCTION (this);
+  CatchUp ();
   NS_LOG_LOGIC (" returns " << m_nBytes);
   return m_nBytes;
 }
@@ -145,10 +191,33 @@ bool
 Queue::IsEmpty (void) const
 {
   NS_LOG_FUNCTION (this);
+  CatchUp ();
   NS_LOG_LOGIC ("returns " << (m_nPackets == 0));
   return m_nPackets == 0;
 }
 
+void
+Queue::SetCatchUpCallback (Callback<void> catchUp)
+{
+  NS_LOG_FUNCTION (this);
+  m_catchUp = catchUp;
+}
+
+void
+Queue::CatchUp (void) const
+{
+  if (!m_catchUp.IsNull ())
+    {
+      m_catchUp ();
+    }
+}
+
+bool
+Queue::IsDequeueTraced (void) const
+{
+  return !m_traceDequeue.IsEmpty ();
+}
+
 uint32_t
 Queue::GetTotalReceivedBytes (void) const
 {
@@ -191,6 +260,171 @@ Queue::ResetStatistics (void)
   m_nTotalDroppedPackets = 0;
 }
 
+void
+Queue::AddFluid (DataRate rate, uint32_t packetSize)
+{
+  NS_LOG_FUNCTION (this << rate << packetSize);
+  NS_ASSERT (packetSize > 0);
+  UpdateFluid ();
+  if (!m_fluidActive)
+    {
+      m_fluidActive = true;
+      m_fluidUnmarked = m_nPackets;
+      m_fluidUpdate = Simulator::Now ();
+    }
+  m_fluidRate += rate.GetBitRate () / 8.0;
+  m_fluidPacketRate += rate.GetBitRate () / 8.0 / packetSize;
+  m_fluidPacketSize = m_fluidRate / m_fluidPacketRate;
+}
+
+void
+Queue::RemoveFluid (DataRate rate, uint32_t packetSize)
+{
+  NS_LOG_FUNCTION (this << rate << packetSize);
+  NS_ASSERT (packetSize > 0);
+  UpdateFluid ();
+  m_fluidRate -= rate.GetBitRate () / 8.0;
+  m_fluidPacketRate -= rate.GetBitRate () / 8.0 / packetSize;
+  if (m_fluidRate < 1e-6 || m_fluidPacketRate < 1e-9)
+    {
+      // the last flow, but for the rounding errors
+      m_fluidRate = 0;
+      m_fluidPacketRate = 0;
+    }
+  else
+    {
+      m_fluidPacketSize = m_fluidRate / m_fluidPacketRate;
+    }
+}
+
+void
+Queue::SetFluidServiceRate (DataRate rate)
+{
+  NS_LOG_FUNCTION (this << rate);
+  UpdateFluid ();
+  m_fluidServiceRate = rate.GetBitRate () / 8.0;
+}
+
+void
+Queue::SetFluidServing (bool serving)
+{
+  NS_LOG_FUNCTION (this << serving);
+  UpdateFluid ();
+  m_fluidServing = serving;
+}
+
+bool
+Queue::HasFluid (void) const
+{
+  return m_fluidActive && m_fluidServiceRate > 0;
+}
+
+Time
+Queue::GetFluidWait (void) const
+{
+  if (m_fluidAhead <= 0 || m_fluidServiceRate <= 0)
+    {
+      return Seconds (0);
+    }
+  return Seconds (m_fluidAhead / m_fluidServiceRate);
+}
+
+double
+Queue::GetFluidBytes (void)
+{
+  UpdateFluid ();
+  return m_fluidBytes;
+}
+
+double
+Queue::GetFluidPackets (void)
+{
+  UpdateFluid ();
+  return m_fluidBytes / m_fluidPacketSize;
+}
+
+double
+Queue::GetTotalFluidDroppedBytes (void)
+{
+  UpdateFluid ();
+  return m_fluidDropped;
+}
+
+double
+Queue::GetTotalFluidDepartedBytes (void)
+{
+  UpdateFluid ();
+  return m_fluidDeparted;
+}
+
+double
+Queue::GetFluidPacketSize (void) const
+{
+  return m_fluidPacketSize;
+}
+
+double
+Queue::GetFluidBacklog (void) const
+{
+  return m_fluidBytes;
+}
+
+double
+Queue::DoGetFluidCapacity (void) const
+{
+  return std::numeric_limits<double>::max ();
+}
+
+double
+Queue::DoGetFluidDropProbability (void) const
+{
+  return 0;
+}
+
+void
+Queue::UpdateFluid (void)
+{
+  if (!m_fluidActive)
+    {
+      return;
+    }
+  Time now = Simulator::Now ();
+  if (m_fluidServiceRate <= 0)
+    {
+      m_fluidUpdate = now;
+      return;
+    }
+  double dt = (now - m_fluidUpdate).GetSeconds ();
+  m_fluidUpdate = now;
+  if (dt <= 0)
+    {
+      return;
+    }
+  // the rates are constant since the last update: the backlog is linear
+  // until it empties or fills the queue
+  double drop = std::min (1.0, std::max (0.0, DoGetFluidDropProbability ()));
+  double in = m_fluidRate * (1 - drop) * dt;
+  double out = m_fluidServing ? m_fluidServiceRate * dt : 0;
+  double backlog = m_fluidBytes + in - out;
+  double served = out;
+  if (backlog < 0)
+    {
+      served = m_fluidBytes + in;
+      backlog = 0;
+    }
+  double lost = 0;
+  double capacity = std::max (0.0, DoGetFluidCapacity ());
+  if (backlog > capacity)
+    {
+      lost = std::min (in, backlog - capacity);
+      backlog -= lost;
+    }
+  m_fluidBytes = backlog;
+  m_fluidArrived += in - lost;
+  m_fluidDeparted += served;
+  m_fluidDropped += m_fluidRate * drop * dt + lost;
+}
+
 void
 Queue::Drop (Ptr<Packet> p)
 {
@@ -26,9 +26,13 @@
 
 #include <string>
 #include <list>
+#include <deque>
 #include "ns3/packet.h"
 #include "ns3/object.h"
+#include "ns3/callback.h"
 #include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
 
 namespace ns3 {
 
@@ -41,6 +45,20 @@ namespace ns3 {
  * \brief Abstract base class for packet Queues
  * 
  * This class defines the base APIs for packet queues in the ns-3 system
+ *
+ * Besides packets, a queue may hold fluid: background traffic described
+ * by its rate rather than by packets, added with AddFluid ().  The fluid
+ * is served at the rate set by the device with SetFluidServiceRate (),
+ * while the device is not sending a packet, and its backlog is
+ * integrated analytically between the operations on the queue.  It
+ * takes room in the queue, and a packet dequeued waits for the fluid
+ * which was queued before it (see GetFluidWait ()).  A queue whose
+ * device does not set the service rate ignores the fluid.
+ *
+ * A device may also apply its dequeues lazily, as a PointToPointNetDevice
+ * coalescing a burst does, provided it sets a catch-up callback (see
+ * SetCatchUpCallback ()), which the queue calls before it is enqueued to,
+ * dequeued from or looked at.
  */
 class Queue : public Object
 {
@@ -58,6 +76,11 @@ public:
    * \return true if the queue is empty; false otherwise
    */
   bool IsEmpty (void) const;
+  /**
+   * \return true if a sink is connected to the Dequeue trace source, so
+   * that the time of each dequeue is observed
+   */
+  bool IsDequeueTraced (void) const;
   /**
    * Place a packet into the rear of the Queue
    * \param p packet to enqueue
@@ -119,6 +142,66 @@ public:
    */
   void ResetStatistics (void);
 
+  /**
+   * \brief Set the callback applying the dequeues due by now
+   *
+   * A device which does not dequeue its packets when they are sent sets
+   * this callback, so that the packets sent by now are dequeued before
+   * the queue is enqueued to, dequeued from or its occupancy is read.
+   * A null callback, the default, removes it.
+   *
+   * \param catchUp the callback
+   */
+  void SetCatchUpCallback (Callback<void> catchUp);
+
+  /**
+   * \brief Add a fluid flow to the queue
+   * \param rate the rate of the flow
+   * \param packetSize the size of its packets, in bytes
+   */
+  void AddFluid (DataRate rate, uint32_t packetSize);
+  /**
+   * \brief Remove a fluid flow added with AddFluid ()
+   * \param rate the rate of the flow
+   * \param packetSize the size of its packets, in bytes
+   */
+  void RemoveFluid (DataRate rate, uint32_t packetSize);
+  /**
+   * \brief Set the rate at which the fluid is served, by the device
+   * \param rate the rate of the line
+   */
+  void SetFluidServiceRate (DataRate rate);
+  /**
+   * \brief Tell whether the line serves the fluid, by the device
+   * \param serving false while the device sends a packet
+   */
+  void SetFluidServing (bool serving);
+  /**
+   * \return true if the queue holds or receives fluid
+   */
+  bool HasFluid (void) const;
+  /**
+   * \return the time to serve the fluid queued before the packet last
+   * dequeued, which the packet waits for
+   */
+  Time GetFluidWait (void) const;
+  /**
+   * \return the fluid backlog, in bytes
+   */
+  double GetFluidBytes (void);
+  /**
+   * \return the fluid backlog, in packets of the mean size of the fluid
+   */
+  double GetFluidPackets (void);
+  /**
+   * \return the total number of fluid bytes dropped by this Queue
+   */
+  double GetTotalFluidDroppedBytes (void);
+  /**
+   * \return the total number of fluid bytes served by this Queue
+   */
+  double GetTotalFluidDepartedBytes (void);
+
   /**
    * \brief Enumeration of the modes supported in the class.
    *
@@ -171,6 +254,26 @@ private:
    * \return the packet.
    */
   virtual Ptr<const Packet> DoPeek (void) const = 0;
+  /**
+   * \return the maximum fluid backlog, in bytes, given the packets in
+   * the queue; by default, there is no limit
+   */
+  virtual double DoGetFluidCapacity (void) const;
+  /**
+   * \return the probability that the fluid arriving now is dropped
+   * early; by default, zero
+   */
+  virtual double DoGetFluidDropProbability (void) const;
+
+  /**
+   * Integrate the fluid backlog up to now
+   */
+  void UpdateFluid (void);
+
+  /**
+   * Call the catch-up callback, if any
+   */
+  void CatchUp (void) const;
 
 protected:
   /**
@@ -179,6 +282,14 @@ protected:
    *  This method is called by subclasses to notify parent (this class) of packet drops.
    */
   void Drop (Ptr<Packet> packet);
+  /**
+   * \return the mean size of the fluid packets, in bytes
+   */
+  double GetFluidPacketSize (void) const;
+  /**
+   * \return the fluid backlog when last integrated, in bytes
+   */
+  double GetFluidBacklog (void) const;
 
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const Packet> > m_traceEnqueue;
@@ -193,6 +304,24 @@ protected:
   uint32_t m_nTotalReceivedPackets; //!< Total received packets
   uint32_t m_nTotalDroppedBytes;    //!< Total dropped bytes
   uint32_t m_nTotalDroppedPackets;  //!< Total dropped packets
+
+private:
+  bool m_fluidActive;            //!< Whether fluid was ever added
+  double m_fluidRate;            //!< Offered fluid rate, in bytes per second
+  double m_fluidPacketRate;      //!< Offered fluid rate, in packets per second
+  double m_fluidPacketSize;      //!< Mean size of the fluid packets
+  double m_fluidServiceRate;     //!< Rate of the line, in bytes per second
+  bool m_fluidServing;           //!< Whether the line serves the fluid
+  Time m_fluidUpdate;            //!< Time the fluid was last integrated
+  double m_fluidBytes;           //!< Fluid backlog
+  double m_fluidArrived;         //!< Total fluid bytes accepted
+  double m_fluidDeparted;        //!< Total fluid bytes served
+  double m_fluidDropped;         //!< Total fluid bytes dropped
+  double m_fluidAhead;           //!< Fluid bytes queued before the packet last dequeued
+  uint32_t m_fluidUnmarked;      //!< Packets enqueued before the fluid was added
+  /// Uid of each packet enqueued, with the fluid accepted before it
+  std::deque<std::pair<uint64_t, double> > m_fluidMarks;
+  Callback<void> m_catchUp;      //!< Applies the dequeues due by now
 };
 
 } // namespace ns3
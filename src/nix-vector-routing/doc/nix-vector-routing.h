@@ -30,8 +30,9 @@
  * when dealing with a large number of nodes.
  *
  * Currently, the ns-3 model of nix-vector routing supports IPv4 p2p links 
- * as well as CSMA links.  It does not (yet) provide support for 
- * efficient adaptation to link failures.  It simply flushes all nix-vector 
+ * as well as CSMA links.  When an interface goes down or loses an 
+ * address, only the cached paths through its node are recomputed; an 
+ * interface that comes up or gains an address flushes all the nix-vector 
  * routing caches. Finally, IPv6 is not supported.
  *
  * \section api API and Usage
@@ -65,4 +66,14 @@
  * current node extracts the appropriate neighbor-index from the 
  * nix-vector and transmits the packet through the corresponding 
  * net-device.  This continues until the packet reaches the destination.
+ *
+ * The breadth-first search runs over an adjacency of all the nodes, in 
+ * compressed sparse row format, that is built once per topology and 
+ * shared by the nodes, together with an index of the node of each 
+ * address.  A search gives the paths from its source to all the 
+ * destinations: the search trees of the most recent sources are kept, 
+ * up to the NixVectorPathCacheSize global value (16 by default).  The 
+ * nix-vectors and routes of each node are cached by destination; the 
+ * MaxCacheEntries attribute bounds this cache, the least recently used 
+ * destination being evicted first (0, the default, for no limit).
  * */
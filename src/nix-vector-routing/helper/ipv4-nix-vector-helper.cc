@@ -47,4 +47,10 @@ Ipv4NixVectorHelper::Create (Ptr<Node> node) const
   node->AggregateObject (agent);
   return agent;
 }
+
+void 
+Ipv4NixVectorHelper::Set (std::string name, const AttributeValue &value)
+{
+  m_agentFactory.Set (name, value);
+}
 } // namespace ns3
@@ -20,10 +20,14 @@
 
 #include <queue>
 #include <iomanip>
+#include <algorithm>
 
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/names.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
 #include "ns3/ipv4-list-routing.h"
 
 #include "ipv4-nix-vector-routing.h"
@@ -35,6 +39,21 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4NixVectorRouting");
 NS_OBJECT_ENSURE_REGISTERED (Ipv4NixVectorRouting);
 
 bool Ipv4NixVectorRouting::g_isCacheDirty = false;
+uint64_t Ipv4NixVectorRouting::g_epoch = 0;
+std::vector<std::pair<uint64_t, uint32_t> > Ipv4NixVectorRouting::g_invalidNodes;
+std::vector<uint32_t> Ipv4NixVectorRouting::g_offsets;
+std::vector<uint32_t> Ipv4NixVectorRouting::g_neighbors;
+std::map<Ipv4Address, uint32_t> Ipv4NixVectorRouting::g_addresses;
+bool Ipv4NixVectorRouting::g_isTopologyDirty = true;
+std::map<uint32_t, Ipv4NixVectorRouting::PathTree> Ipv4NixVectorRouting::g_pathTrees;
+std::list<uint32_t> Ipv4NixVectorRouting::g_pathTreeLru;
+const uint32_t Ipv4NixVectorRouting::NO_PARENT;
+
+static GlobalValue g_nixVectorPathCacheSize = GlobalValue ("NixVectorPathCacheSize",
+                                                           "Number of sources whose breadth-first search trees "
+                                                           "are kept by the nix-vector routing (0 for none)",
+                                                           UintegerValue (16),
+                                                           MakeUintegerChecker<uint32_t> ());
 
 TypeId 
 Ipv4NixVectorRouting::GetTypeId (void)
@@ -43,12 +62,19 @@ Ipv4NixVectorRouting::GetTypeId (void)
     .SetParent<Ipv4RoutingProtocol> ()
     .SetGroupName ("NixVectorRouting")
     .AddConstructor<Ipv4NixVectorRouting> ()
+    .AddAttribute ("MaxCacheEntries",
+                   "Maximum number of destinations in the nix-vector and route cache "
+                   "of the node, the least recently used being evicted first (0 for no limit)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4NixVectorRouting::m_maxCacheEntries),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
 Ipv4NixVectorRouting::Ipv4NixVectorRouting ()
-  : m_totalNeighbors (0)
+  : m_maxCacheEntries (0),
+    m_totalNeighbors (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -102,27 +128,155 @@ Ipv4NixVectorRouting::FlushGlobalNixRoutingCache (void) const
           continue;
         }
       NS_LOG_LOGIC ("Flushing Nix caches.");
-      rp->FlushNixCache ();
-      rp->FlushIpv4RouteCache ();
+      rp->FlushCache ();
     }
+
+  // all the caches are empty, the targeted invalidations are no
+  // longer needed, and the topology itself may have changed
+  g_invalidNodes.clear ();
+  g_isTopologyDirty = true;
+  FlushPathTrees ();
 }
 
 void
-Ipv4NixVectorRouting::FlushNixCache (void) const
+Ipv4NixVectorRouting::FlushCache (void) const
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_nixCache.clear ();
+  m_cache.clear ();
+  m_lru.clear ();
 }
 
 void
-Ipv4NixVectorRouting::FlushIpv4RouteCache (void) const
+Ipv4NixVectorRouting::BuildTopology (void)
 {
+  uint32_t numberOfNodes = NodeList::GetNNodes ();
+  if (!g_isTopologyDirty && g_offsets.size () == numberOfNodes + 1)
+    {
+      return;
+    }
   NS_LOG_FUNCTION_NOARGS ();
-  m_ipv4RouteCache.clear ();
+
+  if (g_offsets.empty ())
+    {
+      // first build of this simulation
+      Simulator::ScheduleDestroy (&Ipv4NixVectorRouting::ResetTopology);
+    }
+  g_offsets.clear ();
+  g_neighbors.clear ();
+  g_addresses.clear ();
+  FlushPathTrees ();
+
+  // the neighbors of a node are in the order of its devices, and
+  // only through the interfaces and links that are up
+  g_offsets.reserve (numberOfNodes + 1);
+  for (uint32_t n = 0; n < numberOfNodes; n++)
+    {
+      g_offsets.push_back (g_neighbors.size ());
+      Ptr<Node> node = NodeList::GetNode (n);
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      for (uint32_t i = 0; i < node->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> localNetDevice = node->GetDevice (i);
+
+          // make sure that we can go this way
+          if (ipv4)
+            {
+              uint32_t interfaceIndex = (ipv4)->GetInterfaceForDevice (localNetDevice);
+              if (!(ipv4->IsUp (interfaceIndex)))
+                {
+                  continue;
+                }
+            }
+          if (!(localNetDevice->IsLinkUp ()))
+            {
+              continue;
+            }
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            { 
+              continue;
+            }
+
+          NetDeviceContainer netDeviceContainer;
+          GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
+          for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+            {
+              g_neighbors.push_back ((*iter)->GetNode ()->GetId ());
+            }
+        }
+
+      // the first node with an address owns it
+      if (ipv4)
+        {
+          for (uint32_t j = 0; j < ipv4->GetNInterfaces (); j++)
+            {
+              for (uint32_t k = 0; k < ipv4->GetNAddresses (j); k++)
+                {
+                  g_addresses.insert (std::make_pair (ipv4->GetAddress (j, k).GetLocal (), n));
+                }
+            }
+        }
+    }
+  g_offsets.push_back (g_neighbors.size ());
+  g_isTopologyDirty = false;
+  NS_LOG_LOGIC ("Built adjacency of " << numberOfNodes << " nodes and " << g_neighbors.size () << " neighbors");
+}
+
+const std::vector<uint32_t> &
+Ipv4NixVectorRouting::GetPathTree (uint32_t source)
+{
+  NS_LOG_FUNCTION (source);
+
+  BuildTopology ();
+  std::map<uint32_t, PathTree>::iterator it = g_pathTrees.find (source);
+  if (it != g_pathTrees.end ())
+    {
+      NS_LOG_LOGIC ("Found search tree of Node " << source << " in cache.");
+      g_pathTreeLru.splice (g_pathTreeLru.begin (), g_pathTreeLru, it->second.lru);
+      return it->second.parents;
+    }
+
+  UintegerValue cacheSize;
+  g_nixVectorPathCacheSize.GetValue (cacheSize);
+  if (cacheSize.Get () == 0)
+    {
+      static std::vector<uint32_t> parents;
+      BFS (NodeList::GetNode (source), parents, 0);
+      return parents;
+    }
+  while (g_pathTrees.size () >= cacheSize.Get ())
+    {
+      g_pathTrees.erase (g_pathTreeLru.back ());
+      g_pathTreeLru.pop_back ();
+    }
+  g_pathTreeLru.push_front (source);
+  PathTree &tree = g_pathTrees[source];
+  tree.lru = g_pathTreeLru.begin ();
+  BFS (NodeList::GetNode (source), tree.parents, 0);
+  return tree.parents;
+}
+
+void
+Ipv4NixVectorRouting::FlushPathTrees (void)
+{
+  g_pathTrees.clear ();
+  g_pathTreeLru.clear ();
+}
+
+void
+Ipv4NixVectorRouting::ResetTopology (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_offsets.clear ();
+  g_neighbors.clear ();
+  g_addresses.clear ();
+  g_invalidNodes.clear ();
+  g_isTopologyDirty = true;
+  FlushPathTrees ();
 }
 
 Ptr<NixVector>
-Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif, std::vector<uint32_t> &path)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -149,13 +303,29 @@ Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetD
   else
     {
       // otherwise proceed as normal 
-      // and build the nix vector
-      std::vector< Ptr<Node> > parentVector;
-
-      BFS (NodeList::GetNNodes (), source, destNode, parentVector, oif);
+      // and build the nix vector, from the shared
+      // search tree of the source unless a specific
+      // output interface is to be used
+      uint32_t sourceId = source->GetId ();
+      uint32_t destId = destNode->GetId ();
+      std::vector<uint32_t> oifParentVector;
+      const std::vector<uint32_t> *parentVector = &oifParentVector;
+      if (oif)
+        {
+          BFS (source, oifParentVector, oif);
+        }
+      else
+        {
+          parentVector = &GetPathTree (sourceId);
+        }
 
-      if (BuildNixVector (parentVector, source->GetId (), destNode->GetId (), nixVector))
+      if (BuildNixVector (*parentVector, sourceId, destId, nixVector))
         {
+          for (uint32_t node = destId; node != sourceId; node = parentVector->at (node))
+            {
+              path.push_back (node);
+            }
+          path.push_back (sourceId);
           return nixVector;
         }
       else
@@ -166,40 +336,93 @@ Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetD
     }
 }
 
-Ptr<NixVector>
-Ipv4NixVectorRouting::GetNixVectorInCache (Ipv4Address address)
+Ipv4NixVectorRouting::CacheEntry *
+Ipv4NixVectorRouting::FindCacheEntry (Ipv4Address address)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
   CheckCacheStateAndFlush ();
 
-  NixMap_t::iterator iter = m_nixCache.find (address);
-  if (iter != m_nixCache.end ())
+  Cache_t::iterator iter = m_cache.find (address);
+  if (iter == m_cache.end ())
+    {
+      // not in cache
+      return 0;
+    }
+  if (!IsCacheEntryValid (iter->second))
     {
-      NS_LOG_LOGIC ("Found Nix-vector in cache.");
-      return iter->second;
+      NS_LOG_LOGIC ("Path to " << address << " invalidated, removing it from cache.");
+      m_lru.erase (iter->second.lru);
+      m_cache.erase (iter);
+      return 0;
     }
-
-  // not in cache
-  return 0;
+  NS_LOG_LOGIC ("Found " << address << " in cache.");
+  m_lru.splice (m_lru.begin (), m_lru, iter->second.lru);
+  return &iter->second;
 }
 
-Ptr<Ipv4Route>
-Ipv4NixVectorRouting::GetIpv4RouteInCache (Ipv4Address address)
+Ipv4NixVectorRouting::CacheEntry &
+Ipv4NixVectorRouting::AddCacheEntry (Ipv4Address address)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  CheckCacheStateAndFlush ();
+  std::pair<Cache_t::iterator, bool> result = m_cache.insert (std::make_pair (address, CacheEntry ()));
+  CacheEntry &entry = result.first->second;
+  if (!result.second)
+    {
+      m_lru.splice (m_lru.begin (), m_lru, entry.lru);
+      return entry;
+    }
 
-  Ipv4RouteMap_t::iterator iter = m_ipv4RouteCache.find (address);
-  if (iter != m_ipv4RouteCache.end ())
+  entry.hasNixVector = false;
+  entry.neighborIndex = 0;
+  entry.epoch = g_epoch;
+  m_lru.push_front (address);
+  entry.lru = m_lru.begin ();
+  while (m_maxCacheEntries > 0 && m_cache.size () > m_maxCacheEntries)
     {
-      NS_LOG_LOGIC ("Found Ipv4Route in cache.");
-      return iter->second;
+      NS_LOG_LOGIC ("Evicting " << m_lru.back () << " from cache.");
+      m_cache.erase (m_lru.back ());
+      m_lru.pop_back ();
     }
+  return entry;
+}
 
-  // not in cache
-  return 0;
+bool
+Ipv4NixVectorRouting::IsCacheEntryValid (CacheEntry &entry)
+{
+  if (entry.epoch == g_epoch)
+    {
+      return true;
+    }
+
+  // check the invalidations since the entry was last validated,
+  // which are at the end of the list
+  for (std::vector<std::pair<uint64_t, uint32_t> >::const_reverse_iterator it = g_invalidNodes.rbegin ();
+       it != g_invalidNodes.rend () && it->first > entry.epoch; ++it)
+    {
+      if (std::find (entry.path.begin (), entry.path.end (), it->second) != entry.path.end ())
+        {
+          return false;
+        }
+    }
+  entry.epoch = g_epoch;
+  return true;
+}
+
+void
+Ipv4NixVectorRouting::InvalidatePathsThroughNode (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  g_isTopologyDirty = true;
+  if (!m_node)
+    {
+      g_isCacheDirty = true;
+      return;
+    }
+  g_epoch++;
+  g_invalidNodes.push_back (std::make_pair (g_epoch, m_node->GetId ()));
 }
 
 bool
@@ -230,7 +453,7 @@ Ipv4NixVectorRouting::BuildNixVectorLocal (Ptr<NixVector> nixVector)
 }
 
 bool
-Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
+Ipv4NixVectorRouting::BuildNixVector (const std::vector<uint32_t> & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -239,12 +462,12 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
       return true;
     }
 
-  if (parentVector.at (dest) == 0)
+  if (parentVector.at (dest) == NO_PARENT)
     {
       return false;
     }
 
-  Ptr<Node> parentNode = parentVector.at (dest);
+  Ptr<Node> parentNode = NodeList::GetNode (parentVector.at (dest));
 
   uint32_t numberOfDevices = parentNode->GetNDevices ();
   uint32_t destId = 0;
@@ -298,7 +521,7 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
 
   // recurse through parent vector, grabbing the path 
   // and building the nix vector
-  BuildNixVector (parentVector, source, (parentVector.at (dest))->GetId (), nixVector);
+  BuildNixVector (parentVector, source, parentVector.at (dest), nixVector);
   return true;
 }
 
@@ -347,27 +570,15 @@ Ipv4NixVectorRouting::GetNodeByIp (Ipv4Address dest)
 { 
   NS_LOG_FUNCTION_NOARGS ();
 
-  NodeContainer allNodes = NodeContainer::GetGlobal ();
-  Ptr<Node> destNode;
-
-  for (NodeContainer::Iterator i = allNodes.Begin (); i != allNodes.End (); ++i)
-    {
-      Ptr<Node> node = *i;
-      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-      if (ipv4->GetInterfaceForAddress (dest) != -1)
-        {
-          destNode = node;
-          break;
-        }
-    }
-
-  if (!destNode)
+  BuildTopology ();
+  std::map<Ipv4Address, uint32_t>::const_iterator it = g_addresses.find (dest);
+  if (it == g_addresses.end ())
     {
       NS_LOG_ERROR ("Couldn't find dest node given the IP" << dest);
       return 0;
     }
 
-  return destNode;
+  return NodeList::GetNode (it->second);
 }
 
 uint32_t
@@ -402,7 +613,7 @@ Ipv4NixVectorRouting::FindTotalNeighbors (void)
 }
 
 Ptr<BridgeNetDevice>
-Ipv4NixVectorRouting::NetDeviceIsBridged (Ptr<NetDevice> nd) const
+Ipv4NixVectorRouting::NetDeviceIsBridged (Ptr<NetDevice> nd)
 {
   NS_LOG_FUNCTION (nd);
 
@@ -442,7 +653,7 @@ Ipv4NixVectorRouting::NetDeviceIsBridged (Ptr<NetDevice> nd) const
 }
 
 uint32_t
-Ipv4NixVectorRouting::FindNetDeviceForNixIndex (uint32_t nodeIndex, Ipv4Address & gatewayIp)
+Ipv4NixVectorRouting::FindNetDeviceForNixIndex (uint32_t nodeIndex, Ipv4Address & gatewayIp, uint32_t & gatewayId)
 {
   uint32_t numberOfDevices = m_node->GetNDevices ();
   uint32_t index = 0;
@@ -479,6 +690,7 @@ Ipv4NixVectorRouting::FindNetDeviceForNixIndex (uint32_t nodeIndex, Ipv4Address
           uint32_t interfaceIndex = (ipv4)->GetInterfaceForDevice (gatewayDevice);
           Ipv4InterfaceAddress ifAddr = ipv4->GetAddress (interfaceIndex, 0);
           gatewayIp = ifAddr.GetLocal ();
+          gatewayId = gatewayNode->GetId ();
           break;
         }
       totalNeighbors += netDeviceContainer.GetN ();
@@ -499,19 +711,26 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
   NS_LOG_DEBUG ("Dest IP from header: " << header.GetDestination ());
   // check if cache
-  nixVectorInCache = GetNixVectorInCache (header.GetDestination ());
+  CacheEntry *entry = FindCacheEntry (header.GetDestination ());
 
   // not in cache
-  if (!nixVectorInCache)
+  if (!entry || !entry->hasNixVector)
     {
       NS_LOG_LOGIC ("Nix-vector not in cache, build: ");
       // Build the nix-vector, given this node and the
       // dest IP address
-      nixVectorInCache = GetNixVector (m_node, header.GetDestination (), oif);
-
-      // cache it
-      m_nixCache.insert (NixMap_t::value_type (header.GetDestination (), nixVectorInCache));
+      std::vector<uint32_t> path;
+      nixVectorInCache = GetNixVector (m_node, header.GetDestination (), oif, path);
+
+      // cache it, even if there is no path: only a new
+      // interface or address can create one, and these
+      // flush the caches
+      entry = &AddCacheEntry (header.GetDestination ());
+      entry->hasNixVector = true;
+      entry->nixVector = nixVectorInCache;
+      entry->path.insert (entry->path.end (), path.begin (), path.end ());
     }
+  nixVectorInCache = entry->nixVector;
 
   // path exists
   if (nixVectorInCache)
@@ -520,7 +739,6 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
       // create a new nix vector to be used, 
       // we want to keep the cached version clean
-      nixVectorForPacket = Create<NixVector> ();
       nixVectorForPacket = nixVectorInCache->Copy (); 
 
       // Get the interface number that we go out of, by extracting
@@ -537,23 +755,18 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
       // Search here in a cache for this node index 
       // and look for a Ipv4Route
-      rtentry = GetIpv4RouteInCache (header.GetDestination ());
+      rtentry = entry->route;
 
-      if (!rtentry || !(rtentry->GetOutputDevice () == oif))
+      if (!rtentry || entry->neighborIndex != nodeIndex
+          || (oif && !(rtentry->GetOutputDevice () == oif)))
         {
-          // not in cache or a different specified output
-          // device is to be used
-
-          // first, make sure we erase existing (incorrect)
-          // rtentry from the map
-          if (rtentry)
-            {
-              m_ipv4RouteCache.erase (header.GetDestination ());
-            }
-
+          // not in cache, or built for another neighbor
+          // or a different specified output device is
+          // to be used
           NS_LOG_LOGIC ("Ipv4Route not in cache, build: ");
           Ipv4Address gatewayIp;
-          uint32_t index = FindNetDeviceForNixIndex (nodeIndex, gatewayIp);
+          uint32_t gatewayId = 0;
+          uint32_t index = FindNetDeviceForNixIndex (nodeIndex, gatewayIp, gatewayId);
           int32_t interfaceIndex = 0;
 
           if (!oif)
@@ -588,7 +801,12 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
           sockerr = Socket::ERROR_NOTERROR;
 
           // add rtentry to cache
-          m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+          entry->route = rtentry;
+          entry->neighborIndex = nodeIndex;
+          if (std::find (entry->path.begin (), entry->path.end (), gatewayId) == entry->path.end ())
+            {
+              entry->path.push_back (gatewayId);
+            }
         }
 
       NS_LOG_LOGIC ("Nix-vector contents: " << *nixVectorInCache << " : Remaining bits: " << nixVectorForPacket->GetRemainingBits ());
@@ -636,13 +854,18 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
   uint32_t numberOfBits = nixVector->BitCount (m_totalNeighbors);
   uint32_t nodeIndex = nixVector->ExtractNeighborIndex (numberOfBits);
 
-  rtentry = GetIpv4RouteInCache (header.GetDestination ());
+  CacheEntry *entry = FindCacheEntry (header.GetDestination ());
+  if (entry && entry->route && entry->neighborIndex == nodeIndex)
+    {
+      rtentry = entry->route;
+    }
   // not in cache
   if (!rtentry)
     {
       NS_LOG_LOGIC ("Ipv4Route not in cache, build: ");
       Ipv4Address gatewayIp;
-      uint32_t index = FindNetDeviceForNixIndex (nodeIndex, gatewayIp);
+      uint32_t gatewayId = 0;
+      uint32_t index = FindNetDeviceForNixIndex (nodeIndex, gatewayIp, gatewayId);
       uint32_t interfaceIndex = (m_ipv4)->GetInterfaceForDevice (m_node->GetDevice (index));
       Ipv4InterfaceAddress ifAddr = m_ipv4->GetAddress (interfaceIndex, 0);
 
@@ -654,8 +877,19 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
       rtentry->SetDestination (header.GetDestination ());
       rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIndex));
 
-      // add rtentry to cache
-      m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+      // add rtentry to cache, depending on this
+      // node and the next hop
+      entry = &AddCacheEntry (header.GetDestination ());
+      entry->route = rtentry;
+      entry->neighborIndex = nodeIndex;
+      uint32_t hops[2] = { m_node->GetId (), gatewayId };
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          if (std::find (entry->path.begin (), entry->path.end (), hops[i]) == entry->path.end ())
+            {
+              entry->path.push_back (hops[i]);
+            }
+        }
     }
 
   NS_LOG_LOGIC ("At Node " << m_node->GetId () << ", Extracting " << numberOfBits <<
@@ -676,40 +910,60 @@ Ipv4NixVectorRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 
   CheckCacheStateAndFlush ();
 
+  // the entries invalidated since they were last used are not printed
+  std::vector<Cache_t::const_iterator> nixEntries;
+  std::vector<Cache_t::const_iterator> routeEntries;
+  for (Cache_t::iterator it = m_cache.begin (); it != m_cache.end (); it++)
+    {
+      if (!IsCacheEntryValid (it->second))
+        {
+          continue;
+        }
+      if (it->second.hasNixVector && it->second.nixVector)
+        {
+          nixEntries.push_back (it);
+        }
+      if (it->second.route)
+        {
+          routeEntries.push_back (it);
+        }
+    }
+
   std::ostream* os = stream->GetStream ();
   *os << "NixCache:" << std::endl;
-  if (m_nixCache.size () > 0)
+  if (nixEntries.size () > 0)
     {
       *os << "Destination     NixVector" << std::endl;
-      for (NixMap_t::const_iterator it = m_nixCache.begin (); it != m_nixCache.end (); it++)
+      for (std::vector<Cache_t::const_iterator>::const_iterator it = nixEntries.begin (); it != nixEntries.end (); it++)
         {
           std::ostringstream dest;
-          dest << it->first;
+          dest << (*it)->first;
           *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ();
-          *os << *(it->second) << std::endl;
+          *os << *((*it)->second.nixVector) << std::endl;
         }
     }
   *os << "Ipv4RouteCache:" << std::endl;
-  if (m_ipv4RouteCache.size () > 0)
+  if (routeEntries.size () > 0)
     {
       *os << "Destination     Gateway         Source            OutputDevice" << std::endl;
-      for (Ipv4RouteMap_t::const_iterator it = m_ipv4RouteCache.begin (); it != m_ipv4RouteCache.end (); it++)
+      for (std::vector<Cache_t::const_iterator>::const_iterator it = routeEntries.begin (); it != routeEntries.end (); it++)
         {
+          Ptr<Ipv4Route> route = (*it)->second.route;
           std::ostringstream dest, gw, src;
-          dest << it->second->GetDestination ();
+          dest << route->GetDestination ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ();
-          gw << it->second->GetGateway ();
+          gw << route->GetGateway ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << gw.str ();
-          src << it->second->GetSource ();
+          src << route->GetSource ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << src.str ();
           *os << "  ";
-          if (Names::FindName (it->second->GetOutputDevice ()) != "")
+          if (Names::FindName (route->GetOutputDevice ()) != "")
             {
-              *os << Names::FindName (it->second->GetOutputDevice ());
+              *os << Names::FindName (route->GetOutputDevice ());
             }
           else
             {
-              *os << it->second->GetOutputDevice ()->GetIfIndex ();
+              *os << route->GetOutputDevice ()->GetIfIndex ();
             }
           *os << std::endl;
         }
@@ -725,7 +979,7 @@ Ipv4NixVectorRouting::NotifyInterfaceUp (uint32_t i)
 void
 Ipv4NixVectorRouting::NotifyInterfaceDown (uint32_t i)
 {
-  g_isCacheDirty = true;
+  InvalidatePathsThroughNode ();
 }
 void
 Ipv4NixVectorRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
@@ -735,145 +989,87 @@ Ipv4NixVectorRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress
 void
 Ipv4NixVectorRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
-  g_isCacheDirty = true;
+  InvalidatePathsThroughNode ();
 }
 
 bool
-Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source, 
-                           Ptr<Node> dest, std::vector< Ptr<Node> > & parentVector,
+Ipv4NixVectorRouting::BFS (Ptr<Node> source, std::vector<uint32_t> & parentVector,
                            Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  NS_LOG_LOGIC ("Going from Node " << source->GetId () << " to Node " << dest->GetId ());
-  std::queue< Ptr<Node> > greyNodeList;  // discovered nodes with unexplored children
+  BuildTopology ();
+
+  NS_LOG_LOGIC ("Going from Node " << source->GetId ());
+  std::queue<uint32_t> greyNodeList;  // discovered nodes with unexplored children
 
   // reset the parent vector
-  parentVector.clear ();
-  parentVector.reserve (sizeof (Ptr<Node>)*numberOfNodes);
-  parentVector.insert (parentVector.begin (), sizeof (Ptr<Node>)*numberOfNodes, 0); // initialize to 0
+  parentVector.assign (g_offsets.size () - 1, NO_PARENT);
 
-  // Add the source node to the queue, set its parent to itself 
-  greyNodeList.push (source);
-  parentVector.at (source->GetId ()) = source;
+  // set the parent of the source node to itself 
+  uint32_t sourceId = source->GetId ();
+  parentVector.at (sourceId) = sourceId;
 
-  // BFS loop
-  while (greyNodeList.size () != 0)
+  // if a specific output interface was given,
+  // make sure we go this way
+  if (oif)
     {
-      Ptr<Node> currNode = greyNodeList.front ();
-      Ptr<Ipv4> ipv4 = currNode->GetObject<Ipv4> ();
- 
-      if (currNode == dest) 
+      // make sure that we can go this way
+      Ptr<Ipv4> ipv4 = source->GetObject<Ipv4> ();
+      if (ipv4)
         {
-          NS_LOG_LOGIC ("Made it to Node " << currNode->GetId ());
-          return true;
-        }
-
-      // if this is the first iteration of the loop and a 
-      // specific output interface was given, make sure 
-      // we go this way
-      if (currNode == source && oif)
-        {
-          // make sure that we can go this way
-          if (ipv4)
+          uint32_t interfaceIndex = (ipv4)->GetInterfaceForDevice (oif);
+          if (!(ipv4->IsUp (interfaceIndex)))
             {
-              uint32_t interfaceIndex = (ipv4)->GetInterfaceForDevice (oif);
-              if (!(ipv4->IsUp (interfaceIndex)))
-                {
-                  NS_LOG_LOGIC ("Ipv4Interface is down");
-                  return false;
-                }
-            }
-          if (!(oif->IsLinkUp ()))
-            {
-              NS_LOG_LOGIC ("Link is down.");
+              NS_LOG_LOGIC ("Ipv4Interface is down");
               return false;
             }
-          Ptr<Channel> channel = oif->GetChannel ();
-          if (channel == 0)
-            { 
-              return false;
-            }
-
-          // this function takes in the local net dev, and channnel, and
-          // writes to the netDeviceContainer the adjacent net devs
-          NetDeviceContainer netDeviceContainer;
-          GetAdjacentNetDevices (oif, channel, netDeviceContainer);
+        }
+      if (!(oif->IsLinkUp ()))
+        {
+          NS_LOG_LOGIC ("Link is down.");
+          return false;
+        }
+      Ptr<Channel> channel = oif->GetChannel ();
+      if (channel == 0)
+        { 
+          return false;
+        }
 
-          // Finally we can get the adjacent nodes
-          // and scan through them.  We push them
-          // to the greyNode queue, if they aren't 
-          // already there.
-          for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+      // this function takes in the local net dev, and channnel, and
+      // writes to the netDeviceContainer the adjacent net devs
+      NetDeviceContainer netDeviceContainer;
+      GetAdjacentNetDevices (oif, channel, netDeviceContainer);
+      for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+        {
+          uint32_t remoteNode = (*iter)->GetNode ()->GetId ();
+          if (parentVector.at (remoteNode) == NO_PARENT)
             {
-              Ptr<Node> remoteNode = (*iter)->GetNode ();
-
-              // check to see if this node has been pushed before
-              // by checking to see if it has a parent
-              // if it doesn't (null or 0), then set its parent and 
-              // push to the queue
-              if (parentVector.at (remoteNode->GetId ()) == 0)
-                {
-                  parentVector.at (remoteNode->GetId ()) = currNode;
-                  greyNodeList.push (remoteNode);
-                }
+              parentVector.at (remoteNode) = sourceId;
+              greyNodeList.push (remoteNode);
             }
         }
-      else
-        {
-          // Iterate over the current node's adjacent vertices
-          // and push them into the queue
-          for (uint32_t i = 0; i < (currNode->GetNDevices ()); i++)
-            {
-              // Get a net device from the node
-              // as well as the channel, and figure
-              // out the adjacent net device
-              Ptr<NetDevice> localNetDevice = currNode->GetDevice (i);
-
-              // make sure that we can go this way
-              if (ipv4)
-                {
-                  uint32_t interfaceIndex = (ipv4)->GetInterfaceForDevice (currNode->GetDevice (i));
-                  if (!(ipv4->IsUp (interfaceIndex)))
-                    {
-                      NS_LOG_LOGIC ("Ipv4Interface is down");
-                      continue;
-                    }
-                }
-              if (!(localNetDevice->IsLinkUp ()))
-                {
-                  NS_LOG_LOGIC ("Link is down.");
-                  continue;
-                }
-              Ptr<Channel> channel = localNetDevice->GetChannel ();
-              if (channel == 0)
-                { 
-                  continue;
-                }
-
-              // this function takes in the local net dev, and channnel, and
-              // writes to the netDeviceContainer the adjacent net devs
-              NetDeviceContainer netDeviceContainer;
-              GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
+    }
+  else
+    {
+      greyNodeList.push (sourceId);
+    }
 
-              // Finally we can get the adjacent nodes
-              // and scan through them.  We push them
-              // to the greyNode queue, if they aren't 
-              // already there.
-              for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
-                {
-                  Ptr<Node> remoteNode = (*iter)->GetNode ();
+  // BFS loop, over the shared adjacency
+  while (greyNodeList.size () != 0)
+    {
+      uint32_t currNode = greyNodeList.front ();
 
-                  // check to see if this node has been pushed before
-                  // by checking to see if it has a parent
-                  // if it doesn't (null or 0), then set its parent and 
-                  // push to the queue
-                  if (parentVector.at (remoteNode->GetId ()) == 0)
-                    {
-                      parentVector.at (remoteNode->GetId ()) = currNode;
-                      greyNodeList.push (remoteNode);
-                    }
-                }
+      // Iterate over the current node's adjacent vertices,
+      // and push them to the greyNode queue if they don't
+      // have a parent yet
+      for (uint32_t i = g_offsets[currNode]; i < g_offsets[currNode + 1]; i++)
+        {
+          uint32_t remoteNode = g_neighbors[i];
+          if (parentVector[remoteNode] == NO_PARENT)
+            {
+              parentVector[remoteNode] = currNode;
+              greyNodeList.push (remoteNode);
             }
         }
 
@@ -882,8 +1078,7 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
       greyNodeList.pop ();
     }
 
-  // Didn't find the dest...
-  return false;
+  return true;
 }
 
 void 
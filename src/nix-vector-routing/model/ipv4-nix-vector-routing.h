@@ -22,6 +22,8 @@
 #define IPV4_NIX_VECTOR_ROUTING_H
 
 #include <map>
+#include <list>
+#include <vector>
 
 #include "ns3/channel.h"
 #include "ns3/node-container.h"
@@ -48,6 +50,20 @@ typedef std::map<Ipv4Address, Ptr<Ipv4Route> > Ipv4RouteMap_t;
 /**
  * \ingroup nix-vector-routing
  * Nix-vector routing protocol
+ *
+ * The paths are computed with a breadth-first search over an adjacency
+ * of the nodes, in compressed sparse row format, that is shared by all
+ * the nodes and built once per topology.  The search from a source
+ * gives its paths to all the destinations: the search trees of the
+ * most recent sources are kept in a shared cache, whose size is set by
+ * the NixVectorPathCacheSize global value.  Each node caches the nix
+ * vectors and routes by destination, in a cache of at most
+ * MaxCacheEntries entries that evicts the least recently used one.
+ *
+ * When an interface goes down or loses an address, only the cached
+ * entries whose path goes through its node are invalidated, lazily.
+ * An interface that comes up or gains an address may shorten any path,
+ * so it flushes all the caches.
  */
 class Ipv4NixVectorRouting : public Ipv4RoutingProtocol
 {
@@ -82,13 +98,38 @@ public:
 
 private:
 
-  /* flushes the cache which stores nix-vector based on
-   * destination IP */
-  void FlushNixCache (void) const;
+  /**
+   * Entry of the cache of a node, by destination
+   */
+  struct CacheEntry
+  {
+    bool hasNixVector;            //!< the nix vector was computed
+    Ptr<NixVector> nixVector;     //!< nix vector to the destination, or 0 if there is no path
+    Ptr<Ipv4Route> route;         //!< route to the destination, or 0
+    uint32_t neighborIndex;       //!< nix index of the next hop of the route
+    std::vector<uint32_t> path;   //!< identifiers of the nodes the entry depends on
+    uint64_t epoch;               //!< invalidation epoch at which the entry was last validated
+    std::list<Ipv4Address>::iterator lru; //!< position in m_lru
+  };
+
+  /// Cache of a node, by destination
+  typedef std::map<Ipv4Address, CacheEntry> Cache_t;
+
+  /**
+   * Search tree of a source, in the shared cache
+   */
+  struct PathTree
+  {
+    std::vector<uint32_t> parents;   //!< parent of each node, NO_PARENT if unreachable
+    std::list<uint32_t>::iterator lru; //!< position in g_pathTreeLru
+  };
+
+  /// Parent of the nodes that the search did not reach
+  static const uint32_t NO_PARENT = 0xffffffff;
 
-  /* flushes the cache which stores the Ipv4 route
-   * based on the destination IP */
-  void FlushIpv4RouteCache (void) const;
+  /* flushes the cache which stores nix-vectors and
+   * Ipv4 routes based on destination IP */
+  void FlushCache (void) const;
 
   /* upon a run-time topology change caches are
    * flushed and the total number of neighbors is
@@ -97,25 +138,47 @@ private:
 
   /*  takes in the source node and dest IP and calls GetNodeByIp,
    *  BFS, accounting for any output interface specified, and finally
-   *  BuildNixVector to return the built nix-vector */
-  Ptr<NixVector> GetNixVector (Ptr<Node>, Ipv4Address, Ptr<NetDevice>);
+   *  BuildNixVector to return the built nix-vector.  The identifiers
+   *  of the nodes on the path are appended to the last parameter */
+  Ptr<NixVector> GetNixVector (Ptr<Node>, Ipv4Address, Ptr<NetDevice>, std::vector<uint32_t> &);
+
+  /* checks the cache based on dest IP, and returns the valid
+   * entry of the destination or 0 */
+  CacheEntry* FindCacheEntry (Ipv4Address);
+
+  /* returns the cache entry of a destination, adding it if needed,
+   * and evicts the least recently used entries beyond MaxCacheEntries */
+  CacheEntry& AddCacheEntry (Ipv4Address);
+
+  /* checks that the path of a cache entry did not go through a node
+   * whose interface went down or lost an address since it was validated */
+  static bool IsCacheEntryValid (CacheEntry &);
+
+  /* builds the shared adjacency and address index, if needed */
+  static void BuildTopology (void);
 
-  /* checks the cache based on dest IP for the nix-vector */
-  Ptr<NixVector> GetNixVectorInCache (Ipv4Address);
+  /* returns the search tree of a source, from the shared cache */
+  static const std::vector<uint32_t> & GetPathTree (uint32_t);
 
-  /* checks the cache based on dest IP for the Ipv4Route */
-  Ptr<Ipv4Route> GetIpv4RouteInCache (Ipv4Address);
+  /* clears the shared state at the end of the simulation */
+  static void ResetTopology (void);
+
+  /* clears the shared search trees */
+  static void FlushPathTrees (void);
+
+  /* records that the paths through this node are no longer valid */
+  void InvalidatePathsThroughNode (void);
 
   /* given a net-device returns all the adjacent net-devices,
    * essentially getting the neighbors on that channel */
-  void GetAdjacentNetDevices (Ptr<NetDevice>, Ptr<Channel>, NetDeviceContainer &);
+  static void GetAdjacentNetDevices (Ptr<NetDevice>, Ptr<Channel>, NetDeviceContainer &);
 
-  /* iterates through the node list and finds the one
+  /* looks up the shared address index and finds the node
    * corresponding to the given Ipv4Address */
   Ptr<Node> GetNodeByIp (Ipv4Address);
 
   /* Recurses the parent vector, created by BFS and actually builds the nixvector */
-  bool BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
+  bool BuildNixVector (const std::vector<uint32_t> & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
 
   /* special variation of BuildNixVector for when a node is sending to itself */
   bool BuildNixVectorLocal (Ptr<NixVector> nixVector);
@@ -125,26 +188,22 @@ private:
   uint32_t FindTotalNeighbors (void);
 
   /* determine if the netdevice is bridged */
-  Ptr<BridgeNetDevice> NetDeviceIsBridged (Ptr<NetDevice> nd) const;
+  static Ptr<BridgeNetDevice> NetDeviceIsBridged (Ptr<NetDevice> nd);
 
 
   /* Nix index is with respect to the neighbors.  The net-device index must be
    * derived from this */
-  uint32_t FindNetDeviceForNixIndex (uint32_t nodeIndex, Ipv4Address & gatewayIp);
-
-  /* Breadth first search algorithm
-   * Param1: total number of nodes
-   * Param2: Source Node
-   * Param3: Dest Node
-   * Param4: (returned) Parent vector for retracing routes
-   * Param5: specific output interface to use from source node, if not null
-   * Returns: false if dest not found, true o.w.
+  uint32_t FindNetDeviceForNixIndex (uint32_t nodeIndex, Ipv4Address & gatewayIp, uint32_t & gatewayId);
+
+  /* Breadth first search algorithm, over the shared adjacency
+   * Param1: Source Node
+   * Param2: (returned) Parent vector for retracing routes
+   * Param3: specific output interface to use from source node, if not null
+   * Returns: false if the output interface can not be used, true o.w.
    */
-  bool BFS (uint32_t numberOfNodes,
-            Ptr<Node> source,
-            Ptr<Node> dest,
-            std::vector< Ptr<Node> > & parentVector,
-            Ptr<NetDevice> oif);
+  static bool BFS (Ptr<Node> source,
+                   std::vector<uint32_t> & parentVector,
+                   Ptr<NetDevice> oif);
 
   void DoDispose (void);
 
@@ -171,11 +230,38 @@ private:
    */
   static bool g_isCacheDirty;
 
-  /* Cache stores nix-vectors based on destination ip */
-  mutable NixMap_t m_nixCache;
+  /* Epoch of the targeted invalidations, incremented by each of them */
+  static uint64_t g_epoch;
+
+  /* Nodes whose paths were invalidated since the last flush, with
+   * the epoch of the invalidation */
+  static std::vector<std::pair<uint64_t, uint32_t> > g_invalidNodes;
+
+  /* Shared adjacency: the neighbors of node i are
+   * g_neighbors[g_offsets[i]] to g_neighbors[g_offsets[i + 1] - 1] */
+  static std::vector<uint32_t> g_offsets;
+  static std::vector<uint32_t> g_neighbors;
+
+  /* Shared index of the node of each address */
+  static std::map<Ipv4Address, uint32_t> g_addresses;
+
+  /* The shared adjacency and address index must be rebuilt */
+  static bool g_isTopologyDirty;
+
+  /* Shared cache of the search trees, by source */
+  static std::map<uint32_t, PathTree> g_pathTrees;
+
+  /* Sources of the search trees, most recently used first */
+  static std::list<uint32_t> g_pathTreeLru;
+
+  /* Cache stores nix-vectors and Ipv4Routes based on destination ip */
+  mutable Cache_t m_cache;
+
+  /* Destinations of the cache, most recently used first */
+  mutable std::list<Ipv4Address> m_lru;
 
-  /* Cache stores Ipv4Routes based on destination ip */
-  mutable Ipv4RouteMap_t m_ipv4RouteCache;
+  /* Maximum number of entries of the cache, 0 for no limit */
+  uint32_t m_maxCacheEntries;
 
   Ptr<Ipv4> m_ipv4;
   Ptr<Node> m_node;
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/uinteger.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup nix-vector-routing
+ * Nix-vector routing of a topology with two paths between nodes 0
+ * and 3: 0-1-3, and 0-2-4-3.
+ */
+class NixVectorRoutingTestCase : public TestCase
+{
+public:
+  NixVectorRoutingTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// Connects two nodes with a link of simple net devices
+  Ptr<NetDevice> AddLink (Ptr<Node> a, Ptr<Node> b, const char *network);
+  /// Returns the gateway of the route of node 0, or 0.0.0.0
+  Ipv4Address GetGateway (Ipv4Address dest);
+  /// Returns the routing table of node 0
+  std::string GetRoutingTable (void);
+
+  NodeContainer m_nodes; //!< nodes of the topology
+};
+
+NixVectorRoutingTestCase::NixVectorRoutingTestCase ()
+  : TestCase ("Check the nix-vector routes, their cache and their invalidation")
+{
+}
+
+Ptr<NetDevice>
+NixVectorRoutingTestCase::AddLink (Ptr<Node> a, Ptr<Node> b, const char *network)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  Ptr<Node> nodes[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes[i]->AddDevice (device);
+      devices.Add (device);
+    }
+  Ipv4AddressHelper address;
+  address.SetBase (network, "255.255.255.0");
+  address.Assign (devices);
+  return devices.Get (0);
+}
+
+Ipv4Address
+NixVectorRoutingTestCase::GetGateway (Ipv4Address dest)
+{
+  Ptr<Ipv4RoutingProtocol> routing = m_nodes.Get (0)->GetObject<Ipv4> ()->GetRoutingProtocol ();
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = routing->RouteOutput (0, header, 0, sockerr);
+  return route ? route->GetGateway () : Ipv4Address::GetAny ();
+}
+
+std::string
+NixVectorRoutingTestCase::GetRoutingTable (void)
+{
+  std::ostringstream os;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&os);
+  m_nodes.Get (0)->GetObject<Ipv4> ()->GetRoutingProtocol ()->PrintRoutingTable (stream);
+  return os.str ();
+}
+
+void
+NixVectorRoutingTestCase::DoRun (void)
+{
+  m_nodes.Create (5);
+  Ipv4NixVectorHelper nixRouting;
+  nixRouting.Set ("MaxCacheEntries", UintegerValue (3));
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (nixRouting);
+  stack.Install (m_nodes);
+
+  AddLink (m_nodes.Get (0), m_nodes.Get (1), "10.1.1.0");
+  Ptr<NetDevice> shortcut = AddLink (m_nodes.Get (1), m_nodes.Get (3), "10.1.2.0");
+  AddLink (m_nodes.Get (0), m_nodes.Get (2), "10.1.3.0");
+  AddLink (m_nodes.Get (2), m_nodes.Get (4), "10.1.4.0");
+  AddLink (m_nodes.Get (4), m_nodes.Get (3), "10.1.5.0");
+
+  // shortest paths
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.2.2"), Ipv4Address ("10.1.1.2"), "Wrong gateway to node 3");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.5.2"), Ipv4Address ("10.1.1.2"), "Wrong gateway to node 3");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.4.1"), Ipv4Address ("10.1.3.2"), "Wrong gateway to node 2");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.9.9.9"), Ipv4Address::GetAny (), "Unexpected route to an unknown address");
+
+  // the least recently used destination is evicted
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.2.2"), Ipv4Address ("10.1.1.2"), "Wrong gateway to node 3");
+  std::string table = GetRoutingTable ();
+  NS_TEST_ASSERT_MSG_EQ ((table.find ("10.1.5.2") == std::string::npos), true, "Destination not evicted");
+  NS_TEST_ASSERT_MSG_NE (table.find ("10.1.2.2"), std::string::npos, "Destination evicted");
+  NS_TEST_ASSERT_MSG_NE (table.find ("10.1.4.1"), std::string::npos, "Destination evicted");
+
+  // taking down an interface of node 1 only invalidates the paths through it
+  Ptr<Ipv4> ipv4 = m_nodes.Get (1)->GetObject<Ipv4> ();
+  ipv4->SetDown (ipv4->GetInterfaceForDevice (shortcut->GetChannel ()->GetDevice (0)));
+  table = GetRoutingTable ();
+  NS_TEST_ASSERT_MSG_EQ ((table.find ("10.1.2.2") == std::string::npos), true, "Path through node 1 not invalidated");
+  NS_TEST_ASSERT_MSG_NE (table.find ("10.1.4.1"), std::string::npos, "Path to node 2 invalidated");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.2.2"), Ipv4Address ("10.1.3.2"), "Wrong gateway to node 3 after link down");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.5.2"), Ipv4Address ("10.1.3.2"), "Wrong gateway to node 3 after link down");
+
+  // taking it up again flushes all the caches
+  ipv4->SetUp (ipv4->GetInterfaceForDevice (shortcut->GetChannel ()->GetDevice (0)));
+  table = GetRoutingTable ();
+  NS_TEST_ASSERT_MSG_EQ ((table.find ("10.1.4.1") == std::string::npos), true, "Caches not flushed");
+  NS_TEST_ASSERT_MSG_EQ (GetGateway ("10.1.2.2"), Ipv4Address ("10.1.1.2"), "Wrong gateway to node 3 after link up");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup nix-vector-routing
+ * Nix-vector routing test suite
+ */
+class NixVectorRoutingTestSuite : public TestSuite
+{
+public:
+  NixVectorRoutingTestSuite ();
+};
+
+NixVectorRoutingTestSuite::NixVectorRoutingTestSuite ()
+  : TestSuite ("nix-vector-routing", UNIT)
+{
+  AddTestCase (new NixVectorRoutingTestCase, TestCase::QUICK);
+}
+
+static NixVectorRoutingTestSuite g_nixVectorRoutingTestSuite;
@@ -106,6 +106,27 @@ PointToPointChannel::TransmitStart (
   return true;
 }
 
+void
+PointToPointChannel::TransmitStarted (
+  Ptr<Packet> p,
+  Ptr<PointToPointNetDevice> src,
+  Time start,
+  Time txTime)
+{
+  NS_LOG_FUNCTION (this << p << src << start);
+  NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
+
+  uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  // the times are relative to now, as for a transmission starting now
+  Time end = start + txTime - Simulator::Now ();
+
+  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+                                  end + m_delay, &PointToPointNetDevice::Receive,
+                                  m_link[wire].m_dst, p);
+
+  m_txrxPointToPoint (p, src, m_link[wire].m_dst, end, end + m_delay);
+}
+
 uint32_t 
 PointToPointChannel::GetNDevices (void) const
 {
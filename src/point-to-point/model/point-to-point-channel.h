@@ -80,6 +80,19 @@ public:
    */
   virtual bool TransmitStart (Ptr<Packet> p, Ptr<PointToPointNetDevice> src, Time txTime);
 
+  /**
+   * \brief Transmit a packet whose transmission started in the past
+   *
+   * Used by a device which computes the start of its back-to-back
+   * transmissions ahead of time, see PointToPointNetDevice.
+   *
+   * \param p Packet to transmit
+   * \param src Source PointToPointNetDevice
+   * \param start Time at which the transmission started, no later than now
+   * \param txTime Transmit time to apply
+   */
+  void TransmitStarted (Ptr<Packet> p, Ptr<PointToPointNetDevice> src, Time start, Time txTime);
+
   /**
    * \brief Get number of devices on this channel
    * \returns number of devices on this channel
@@ -100,13 +113,14 @@ public:
    */
   virtual Ptr<NetDevice> GetDevice (uint32_t i) const;
 
-protected:
   /**
    * \brief Get the delay associated with this channel
    * \returns Time delay
    */
   Time GetDelay (void) const;
 
+protected:
+
   /**
    * \brief Check to make sure the link is initialized
    * \returns true if initialized, asserts otherwise
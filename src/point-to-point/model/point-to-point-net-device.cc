@@ -25,6 +25,8 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/drop-tail-queue.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -55,7 +57,8 @@ PointToPointNetDevice::GetTypeId (void)
     .AddAttribute ("DataRate", 
                    "The default data rate for point to point links",
                    DataRateValue (DataRate ("32768b/s")),
-                   MakeDataRateAccessor (&PointToPointNetDevice::m_bps),
+                   MakeDataRateAccessor (&PointToPointNetDevice::SetDataRate,
+                                         &PointToPointNetDevice::GetDataRate),
                    MakeDataRateChecker ())
     .AddAttribute ("ReceiveErrorModel", 
                    "The receiver error model used to simulate packet loss",
@@ -65,7 +68,8 @@ PointToPointNetDevice::GetTypeId (void)
     .AddAttribute ("InterframeGap", 
                    "The time to wait between packet (frame) transmissions",
                    TimeValue (Seconds (0.0)),
-                   MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
+                   MakeTimeAccessor (&PointToPointNetDevice::SetInterframeGap,
+                                     &PointToPointNetDevice::GetInterframeGap),
                    MakeTimeChecker ())
 
     //
@@ -77,6 +81,16 @@ PointToPointNetDevice::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&PointToPointNetDevice::m_queue),
                    MakePointerChecker<Queue> ())
+    .AddAttribute ("CoalesceTransmit",
+                   "Compute the start of the back-to-back transmissions of a burst "
+                   "rather than scheduling an event at the end of each, while the "
+                   "queue is a DropTailQueue, its dequeues and the transmissions "
+                   "are not traced, and the channel is local.  The packets reach "
+                   "the other end at the same times, and the queue is brought up "
+                   "to date whenever it is used or its occupancy is read.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointNetDevice::m_coalesce),
+                   MakeBooleanChecker ())
 
     //
     // Trace sources at the "top" of the net device, where packets transition
@@ -177,7 +191,10 @@ PointToPointNetDevice::PointToPointNetDevice ()
     m_txMachineState (READY),
     m_channel (0),
     m_linkUp (false),
-    m_currentPkt (0)
+    m_currentPkt (0),
+    m_coalesce (false),
+    m_coalescing (false),
+    m_catchingUp (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -214,23 +231,61 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_catchUpEvent.Cancel ();
+  if (m_coalescing)
+    {
+      m_queue->SetCatchUpCallback (MakeNullCallback<void> ());
+      m_coalescing = false;
+    }
   NetDevice::DoDispose ();
 }
 
+void
+PointToPointNetDevice::DoInitialize (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_queue != 0)
+    {
+      // the line serves the fluid of the queue
+      m_queue->SetFluidServiceRate (m_bps);
+    }
+  NetDevice::DoInitialize ();
+}
+
 void
 PointToPointNetDevice::SetDataRate (DataRate bps)
 {
   NS_LOG_FUNCTION (this);
+  CatchUp ();
   m_bps = bps;
+  if (m_queue != 0)
+    {
+      m_queue->SetFluidServiceRate (m_bps);
+    }
+}
+
+DataRate
+PointToPointNetDevice::GetDataRate (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bps;
 }
 
 void
 PointToPointNetDevice::SetInterframeGap (Time t)
 {
   NS_LOG_FUNCTION (this << t.GetSeconds ());
+  CatchUp ();
   m_tInterframeGap = t;
 }
 
+Time
+PointToPointNetDevice::GetInterframeGap (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_tInterframeGap;
+}
+
 bool
 PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
 {
@@ -246,12 +301,21 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_txMachineState = BUSY;
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
+  m_queue->SetFluidServing (false);
 
   Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
   Time txCompleteTime = txTime + m_tInterframeGap;
 
-  NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
-  Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
+  if (m_coalescing)
+    {
+      // the end of the transmission is applied by CatchUp ()
+      m_txFree = Simulator::Now () + txCompleteTime;
+    }
+  else
+    {
+      NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
+      Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
+    }
 
   bool result = m_channel->TransmitStart (p, this, txTime);
   if (result == false)
@@ -279,6 +343,7 @@ PointToPointNetDevice::TransmitComplete (void)
 
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
+  m_queue->SetFluidServing (true);
 
   Ptr<Packet> p = m_queue->Dequeue ();
   if (p == 0)
@@ -294,9 +359,96 @@ PointToPointNetDevice::TransmitComplete (void)
   //
   m_snifferTrace (p);
   m_promiscSnifferTrace (p);
+  TransmitAfterFluid (p);
+}
+
+bool
+PointToPointNetDevice::TransmitAfterFluid (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  Time wait = m_queue->GetFluidWait ();
+  if (wait.IsStrictlyPositive ())
+    {
+      // the line sends the fluid queued before the packet first
+      NS_LOG_LOGIC ("Wait " << wait.GetSeconds () << "sec for the fluid");
+      m_txMachineState = BUSY;
+      m_currentPkt = p;
+      Simulator::Schedule (wait, &PointToPointNetDevice::FluidSent, this, p);
+      return true;
+    }
+  return TransmitStart (p);
+}
+
+void
+PointToPointNetDevice::FluidSent (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  m_txMachineState = READY;
   TransmitStart (p);
 }
 
+bool
+PointToPointNetDevice::CanCoalesce (void) const
+{
+  return m_coalesce
+         && m_queue->GetInstanceTypeId () == DropTailQueue::GetTypeId ()
+         && !m_queue->IsDequeueTraced ()
+         && m_phyTxBeginTrace.IsEmpty () && m_phyTxEndTrace.IsEmpty ()
+         && m_snifferTrace.IsEmpty () && m_promiscSnifferTrace.IsEmpty ()
+         && !m_queue->HasFluid ()
+         && m_channel->GetInstanceTypeId () == PointToPointChannel::GetTypeId ();
+}
+
+void
+PointToPointNetDevice::CatchUp (void)
+{
+  if (!m_coalescing || m_catchingUp)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  // the queue calls back while it is dequeued from and read below
+  m_catchingUp = true;
+  Time now = Simulator::Now ();
+  while (m_txFree <= now)
+    {
+      // the line became free at m_txFree: start the next transmission then
+      Ptr<Packet> p = m_queue->Dequeue ();
+      if (p == 0)
+        {
+          m_txMachineState = READY;
+          m_currentPkt = 0;
+          m_coalescing = false;
+          m_queue->SetCatchUpCallback (MakeNullCallback<void> ());
+          m_queue->SetFluidServing (true);
+          m_catchingUp = false;
+          return;
+        }
+      Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+      Time start = m_txFree;
+      m_currentPkt = p;
+      m_txFree = start + txTime + m_tInterframeGap;
+      NS_LOG_LOGIC ("transmission of " << p->GetUid () << " started at " << start);
+      m_channel->TransmitStarted (p, this, start, txTime);
+    }
+  ScheduleCatchUp ();
+  m_catchingUp = false;
+}
+
+void
+PointToPointNetDevice::ScheduleCatchUp (void)
+{
+  if (!m_coalescing || m_catchUpEvent.IsRunning () || m_queue->IsEmpty ())
+    {
+      return;
+    }
+  // catch up while the first bit of the head of the queue is on the wire,
+  // so that the reception of all the packets started until then is still
+  // in the future
+  Time next = m_txFree + m_channel->GetDelay ();
+  m_catchUpEvent = Simulator::Schedule (next - Simulator::Now (), &PointToPointNetDevice::CatchUp, this);
+}
+
 bool
 PointToPointNetDevice::Attach (Ptr<PointToPointChannel> ch)
 {
@@ -320,6 +472,7 @@ PointToPointNetDevice::SetQueue (Ptr<Queue> q)
 {
   NS_LOG_FUNCTION (this << q);
   m_queue = q;
+  m_queue->SetFluidServiceRate (m_bps);
 }
 
 void
@@ -356,9 +509,13 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
 
       //
       // Trace sinks will expect complete packets, not packets without some of the
-      // headers.
+      // headers.  Only copy the packet if some sink is connected.
       //
-      Ptr<Packet> originalPacket = packet->Copy ();
+      Ptr<Packet> originalPacket;
+      if (!m_macPromiscRxTrace.IsEmpty () || !m_macRxTrace.IsEmpty ())
+        {
+          originalPacket = packet->Copy ();
+        }
 
       //
       // Strip off the point-to-point protocol header and forward this packet
@@ -545,8 +702,17 @@ PointToPointNetDevice::Send (
           packet = m_queue->Dequeue ();
           m_snifferTrace (packet);
           m_promiscSnifferTrace (packet);
-          return TransmitStart (packet);
+          m_coalescing = CanCoalesce ();
+          if (m_coalescing)
+            {
+              // the queue applies the transmissions started until it is
+              // used, so that it holds the packets it would hold without
+              // coalescing
+              m_queue->SetCatchUpCallback (MakeCallback (&PointToPointNetDevice::CatchUp, this));
+            }
+          return TransmitAfterFluid (packet);
         }
+      ScheduleCatchUp ();
       return true;
     }
 
@@ -30,6 +30,7 @@
 #include "ns3/data-rate.h"
 #include "ns3/ptr.h"
 #include "ns3/mac48-address.h"
+#include "ns3/event-id.h"
 
 namespace ns3 {
 
@@ -94,6 +95,13 @@ public:
    */
   void SetDataRate (DataRate bps);
 
+  /**
+   * Get the Data Rate used for transmission of packets.
+   *
+   * \return the data rate at which this object operates
+   */
+  DataRate GetDataRate (void) const;
+
   /**
    * Set the interframe gap used to separate packets.  The interframe gap
    * defines the minimum space required between packets sent by this device.
@@ -102,6 +110,13 @@ public:
    */
   void SetInterframeGap (Time t);
 
+  /**
+   * Get the interframe gap used to separate packets.
+   *
+   * \return the interframe gap time
+   */
+  Time GetInterframeGap (void) const;
+
   /**
    * Attach the device to a channel.
    *
@@ -224,6 +239,11 @@ private:
    */
   virtual void DoDispose (void);
 
+  /**
+   * \brief Initialize the object
+   */
+  virtual void DoInitialize (void);
+
 private:
 
   /**
@@ -275,6 +295,48 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * Start sending a packet dequeued, once the fluid queued before it is
+   * sent.
+   *
+   * \param p a reference to the packet to send
+   * \returns true if success, false on failure
+   */
+  bool TransmitAfterFluid (Ptr<Packet> p);
+
+  /**
+   * Start sending a packet, after the fluid queued before it.
+   *
+   * \param p a reference to the packet to send
+   */
+  void FluidSent (Ptr<Packet> p);
+
+  /**
+   * \return true if the next burst of transmissions may be coalesced:
+   * the CoalesceTransmit attribute is set, the queue is a DropTailQueue
+   * whose dequeues are not traced, the transmissions are not traced,
+   * and the channel is local.
+   */
+  bool CanCoalesce (void) const;
+
+  /**
+   * Apply the transmissions of a coalesced burst which started up to now.
+   *
+   * In a coalesced burst, no event marks the end of each transmission:
+   * the packets waiting in the queue leave it back-to-back, at times
+   * computed from their size.  They are dequeued and handed to the
+   * channel, with their start time, when the device or the queue is
+   * next used, or at the latest while the first of them is on the wire,
+   * so that the queue holds the right packets whenever it is looked at.
+   */
+  void CatchUp (void);
+
+  /**
+   * Schedule the next CatchUp () of a coalesced burst, if the queue is
+   * not empty.
+   */
+  void ScheduleCatchUp (void);
+
   /**
    * \brief Make the link up and running
    *
@@ -457,6 +519,12 @@ private:
 
   Ptr<Packet> m_currentPkt; //!< Current packet processed
 
+  bool m_coalesce;        //!< Whether to coalesce the back-to-back transmissions
+  bool m_coalescing;      //!< Whether the current burst is coalesced
+  Time m_txFree;          //!< End of the current transmission and its gap, in a coalesced burst
+  EventId m_catchUpEvent; //!< The next CatchUp () of a coalesced burst
+  bool m_catchingUp;      //!< Whether CatchUp () is running
+
   /**
    * \brief PPP to Ethernet protocol number mapping
    * \param protocol A PPP protocol number
@@ -23,6 +23,12 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/enum.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -93,6 +99,357 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test of the CoalesceTransmit attribute
+ *
+ * It sends bursts of packets, larger than the queue, and changes the
+ * data rate and interframe gap during a burst.  It checks that the
+ * packets are received and dropped as without coalescing, that the
+ * queue holds the same packets whenever it is read, and that there are
+ * fewer events.
+ */
+class PointToPointCoalesceTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointCoalesceTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send packets, with and without coalescing
+   *
+   * \param coalesce whether to coalesce the transmissions
+   * \param [out] times the reception times of the packets
+   * \param [out] drops the number of packets dropped by the queue
+   * \param [out] occupancy the packets and bytes in the queue, sampled
+   * \return the number of events scheduled
+   */
+  uint64_t RunBursts (bool coalesce, std::vector<Time> *times, uint32_t *drops,
+                      std::vector<uint32_t> *occupancy);
+
+  /**
+   * \brief Send packets of increasing size
+   *
+   * \param device NetDevice to send from
+   * \param n number of packets
+   */
+  void SendBurst (Ptr<PointToPointNetDevice> device, uint32_t n);
+
+  /**
+   * \brief Record the number of packets and bytes in a queue
+   *
+   * \param queue the queue
+   * \param [out] occupancy the vector the numbers are appended to
+   */
+  static void SampleQueue (Ptr<Queue> queue, std::vector<uint32_t> *occupancy);
+
+  /**
+   * \brief Change the data rate and interframe gap through the attributes
+   *
+   * \param device the NetDevice
+   */
+  static void ChangeRate (Ptr<PointToPointNetDevice> device);
+
+  /**
+   * \brief Receive a packet
+   *
+   * \param device receiving NetDevice
+   * \param packet the packet
+   * \param protocol protocol number
+   * \param from source address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Do nothing, to count the events scheduled
+   */
+  static void Nothing (void);
+
+  std::vector<Time> *m_times; //!< The reception times
+};
+
+PointToPointCoalesceTest::PointToPointCoalesceTest ()
+  : TestCase ("PointToPoint coalesced transmissions")
+{
+}
+
+void
+PointToPointCoalesceTest::SendBurst (Ptr<PointToPointNetDevice> device, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Ptr<Packet> p = Create<Packet> (100 + 10 * i);
+      device->Send (p, device->GetBroadcast (), 0x800);
+    }
+}
+
+void
+PointToPointCoalesceTest::SampleQueue (Ptr<Queue> queue, std::vector<uint32_t> *occupancy)
+{
+  occupancy->push_back (queue->GetNPackets ());
+  occupancy->push_back (queue->GetNBytes ());
+}
+
+void
+PointToPointCoalesceTest::ChangeRate (Ptr<PointToPointNetDevice> device)
+{
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("2Mbps")));
+  device->SetAttribute ("InterframeGap", TimeValue (MicroSeconds (20)));
+}
+
+bool
+PointToPointCoalesceTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                   uint16_t protocol, const Address &from)
+{
+  m_times->push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointCoalesceTest::Nothing (void)
+{
+}
+
+uint64_t
+PointToPointCoalesceTest::RunBursts (bool coalesce, std::vector<Time> *times, uint32_t *drops,
+                                     std::vector<uint32_t> *occupancy)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (20));
+  devA->SetAttribute ("CoalesceTransmit", BooleanValue (coalesce));
+  devA->SetDataRate (DataRate ("1Mbps"));
+  devA->SetInterframeGap (MicroSeconds (10));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (queue);
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  // Node::AddDevice sets the receive callback
+  devB->SetReceiveCallback (MakeCallback (&PointToPointCoalesceTest::Receive, this));
+
+  m_times = times;
+  // a burst overflowing the queue, packets sent while it drains, and a
+  // burst after the link is idle again
+  Simulator::Schedule (Seconds (1.0), &PointToPointCoalesceTest::SendBurst, this, devA, 30);
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0) + MilliSeconds (7 * i + 3),
+                           &PointToPointCoalesceTest::SendBurst, this, devA, 2);
+    }
+  Simulator::Schedule (Seconds (2.0), &PointToPointCoalesceTest::SendBurst, this, devA, 15);
+  Simulator::Schedule (Seconds (2.01), &PointToPointCoalesceTest::ChangeRate, devA);
+  for (uint32_t i = 0; i < 40; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0) + MicroSeconds (2500 * i + 1),
+                           &PointToPointCoalesceTest::SampleQueue, queue, occupancy);
+      Simulator::Schedule (Seconds (2.0) + MicroSeconds (1000 * i + 1),
+                           &PointToPointCoalesceTest::SampleQueue, queue, occupancy);
+    }
+
+  Simulator::Run ();
+  *drops = queue->GetTotalDroppedPackets ();
+  // the uid of an event is the number of events scheduled before it
+  uint64_t events = Simulator::Schedule (Seconds (0), &PointToPointCoalesceTest::Nothing).GetUid ();
+  Simulator::Destroy ();
+  return events;
+}
+
+void
+PointToPointCoalesceTest::DoRun (void)
+{
+  std::vector<Time> times;
+  uint32_t drops;
+  std::vector<uint32_t> occupancy;
+  uint64_t events = RunBursts (false, &times, &drops, &occupancy);
+  std::vector<Time> coalescedTimes;
+  uint32_t coalescedDrops;
+  std::vector<uint32_t> coalescedOccupancy;
+  uint64_t coalescedEvents = RunBursts (true, &coalescedTimes, &coalescedDrops, &coalescedOccupancy);
+
+  NS_TEST_ASSERT_MSG_GT (times.size (), 0, "no packet received");
+  NS_TEST_ASSERT_MSG_GT (drops, 0, "the queue did not overflow");
+  NS_TEST_ASSERT_MSG_EQ (coalescedDrops, drops, "wrong number of drops with coalescing");
+  NS_TEST_ASSERT_MSG_EQ (coalescedTimes.size (), times.size (),
+                         "wrong number of packets received with coalescing");
+  for (uint32_t i = 0; i < times.size () && i < coalescedTimes.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (coalescedTimes[i], times[i], "packet " << i << " received at a different time");
+    }
+  NS_TEST_ASSERT_MSG_EQ (coalescedOccupancy.size (), occupancy.size (), "wrong number of queue samples");
+  for (uint32_t i = 0; i < occupancy.size () && i < coalescedOccupancy.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (coalescedOccupancy[i], occupancy[i], "queue sample " << i << " differs");
+    }
+  NS_TEST_ASSERT_MSG_LT (coalescedEvents, events - times.size () / 2, "the transmissions were not coalesced");
+}
+
+/**
+ * \brief Test of fluid traffic in the transmit queue
+ *
+ * It adds fluid to the queue at a rate above the data rate, and checks
+ * the delay of the packets sent behind the fluid backlog, the drop of
+ * the packets and of the fluid when the queue is full, against the
+ * backlog computed by hand.
+ */
+class PointToPointFluidTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointFluidTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one packet of 100 bytes, with its PPP header
+   *
+   * \param device NetDevice to send from
+   */
+  void SendOnePacket (Ptr<PointToPointNetDevice> device);
+
+  /**
+   * \brief Receive a packet
+   *
+   * \param device receiving NetDevice
+   * \param packet the packet
+   * \param protocol protocol number
+   * \param from source address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Record the fluid backlog of a queue
+   *
+   * \param queue the queue
+   */
+  void RecordBacklog (Ptr<Queue> queue);
+
+  std::vector<Time> m_times; //!< The reception times
+  double m_backlog;          //!< The fluid backlog recorded
+};
+
+PointToPointFluidTest::PointToPointFluidTest ()
+  : TestCase ("PointToPoint fluid background traffic")
+{
+}
+
+void
+PointToPointFluidTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> (98);
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointFluidTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                uint16_t protocol, const Address &from)
+{
+  m_times.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointFluidTest::RecordBacklog (Ptr<Queue> queue)
+{
+  m_backlog = queue->GetFluidBytes ();
+}
+
+void
+PointToPointFluidTest::DoRun (void)
+{
+  for (uint32_t maxBytes = 50000; maxBytes <= 100000; maxBytes += 50000)
+    {
+      Ptr<Node> a = CreateObject<Node> ();
+      Ptr<Node> b = CreateObject<Node> ();
+      Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+      Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+
+      Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+      queue->SetAttribute ("Mode", EnumValue (Queue::QUEUE_MODE_BYTES));
+      queue->SetAttribute ("MaxBytes", UintegerValue (maxBytes));
+      devA->SetDataRate (DataRate ("1Mbps"));
+      devA->Attach (channel);
+      devA->SetAddress (Mac48Address::Allocate ());
+      devA->SetQueue (queue);
+      devB->Attach (channel);
+      devB->SetAddress (Mac48Address::Allocate ());
+      devB->SetQueue (CreateObject<DropTailQueue> ());
+
+      a->AddDevice (devA);
+      b->AddDevice (devB);
+      // Node::AddDevice sets the receive callback
+      devB->SetReceiveCallback (MakeCallback (&PointToPointFluidTest::Receive, this));
+
+      // 1.5Mbps of fluid during one second, on a 1Mbps line: the backlog
+      // grows by 62500 bytes per second
+      Simulator::Schedule (Seconds (1.0), &Queue::AddFluid, queue, DataRate ("1.5Mbps"), 1000);
+      Simulator::Schedule (Seconds (2.0), &Queue::RemoveFluid, queue, DataRate ("1.5Mbps"), 1000);
+      Simulator::Schedule (Seconds (1.5), &PointToPointFluidTest::SendOnePacket, this, devA);
+      Simulator::Schedule (Seconds (1.9), &PointToPointFluidTest::SendOnePacket, this, devA);
+      Simulator::Schedule (Seconds (2.0), &PointToPointFluidTest::RecordBacklog, this, queue);
+      m_times.clear ();
+
+      Simulator::Run ();
+
+      if (maxBytes == 100000)
+        {
+          // at 1.5s, the packet waits 31250 bytes of fluid, or 0.25s, then
+          // takes 0.8ms to send, and 10ms to arrive; the fluid waits for it
+          NS_TEST_ASSERT_MSG_EQ (m_times.size (), 2, "wrong number of packets received");
+          NS_TEST_ASSERT_MSG_EQ_TOL (m_times[0].GetSeconds (), 1.7608, 1e-6, "wrong delay behind the fluid");
+          // at 1.9s, the backlog is 56350 bytes with 100 bytes not served
+          // during the first packet: the packet waits 0.4508s
+          NS_TEST_ASSERT_MSG_EQ_TOL (m_times[1].GetSeconds (), 2.3616, 1e-6, "wrong delay behind the fluid");
+          NS_TEST_ASSERT_MSG_EQ_TOL (m_backlog, 62600, 1e-3, "wrong fluid backlog");
+          NS_TEST_ASSERT_MSG_EQ (queue->GetTotalDroppedPackets (), 0, "packet dropped");
+          NS_TEST_ASSERT_MSG_EQ_TOL (queue->GetTotalFluidDroppedBytes (), 0, 1e-3, "fluid dropped");
+        }
+      else
+        {
+          // the backlog reaches 50000 bytes at 1.8s, then the queue is
+          // full: the second packet and the fluid beyond are dropped
+          NS_TEST_ASSERT_MSG_EQ (m_times.size (), 1, "wrong number of packets received");
+          NS_TEST_ASSERT_MSG_EQ (queue->GetTotalDroppedPackets (), 1, "packet not dropped");
+          NS_TEST_ASSERT_MSG_EQ_TOL (m_backlog, 50000, 1e-3, "wrong fluid backlog");
+          NS_TEST_ASSERT_MSG_EQ_TOL (queue->GetTotalFluidDroppedBytes (), 12600, 1e-3,
+                                     "wrong fluid dropped");
+        }
+      // the fluid drains without events
+      Simulator::Stop (Seconds (1.0));
+      Simulator::Run ();
+      NS_TEST_ASSERT_MSG_EQ_TOL (queue->GetFluidBytes (), 0, 1e-3, "the fluid is not served");
+
+      Simulator::Destroy ();
+    }
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -109,6 +466,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointCoalesceTest, TestCase::QUICK);
+  AddTestCase (new PointToPointFluidTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -81,6 +81,53 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+void
+PropagationLossModel::CalcRxPowerBatch (double txPowerDbm,
+                                        Ptr<MobilityModel> a,
+                                        const std::vector<Ptr<MobilityModel> > &receivers,
+                                        std::vector<double> &rxPowerDbm) const
+{
+  uint32_t n = receivers.size ();
+  // gather the positions as a structure of arrays so that the distances
+  // can be computed in one tight loop
+  std::vector<double> x (n);
+  std::vector<double> y (n);
+  std::vector<double> z (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Vector position = receivers[i]->GetPosition ();
+      x[i] = position.x;
+      y[i] = position.y;
+      z[i] = position.z;
+    }
+  Vector source = a->GetPosition ();
+  std::vector<double> distances (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double dx = x[i] - source.x;
+      double dy = y[i] - source.y;
+      double dz = z[i] - source.z;
+      distances[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+    }
+  rxPowerDbm.assign (n, txPowerDbm);
+  for (const PropagationLossModel *model = this; model != 0; model = PeekPointer (model->m_next))
+    {
+      model->DoCalcRxPowerBatch (a, receivers, distances, rxPowerDbm);
+    }
+}
+
+void
+PropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                          const std::vector<Ptr<MobilityModel> > &receivers,
+                                          const std::vector<double> &distances,
+                                          std::vector<double> &rxPowerDbm) const
+{
+  for (uint32_t i = 0; i < receivers.size (); i++)
+    {
+      rxPowerDbm[i] = DoCalcRxPower (rxPowerDbm[i], a, receivers[i]);
+    }
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -269,6 +316,31 @@ FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - std::max (lossDb, m_minLoss);
 }
 
+void
+FriisPropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                               const std::vector<Ptr<MobilityModel> > &receivers,
+                                               const std::vector<double> &distances,
+                                               std::vector<double> &rxPowerDbm) const
+{
+  double numerator = m_lambda * m_lambda;
+  for (uint32_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      if (distance < 3*m_lambda)
+        {
+          NS_LOG_WARN ("distance not within the far field region => inaccurate propagation loss value");
+        }
+      if (distance <= 0)
+        {
+          rxPowerDbm[i] -= m_minLoss;
+          continue;
+        }
+      double denominator = 16 * M_PI * M_PI * distance * distance * m_systemLoss;
+      double lossDb = -10 * log10 (numerator / denominator);
+      rxPowerDbm[i] -= std::max (lossDb, m_minLoss);
+    }
+}
+
 int64_t
 FriisPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -531,6 +603,25 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm + rxc;
 }
 
+void
+LogDistancePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                     const std::vector<Ptr<MobilityModel> > &receivers,
+                                                     const std::vector<double> &distances,
+                                                     std::vector<double> &rxPowerDbm) const
+{
+  for (uint32_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      if (distance <= m_referenceDistance)
+        {
+          continue;
+        }
+      double pathLossDb = 10 * m_exponent * std::log10 (distance / m_referenceDistance);
+      double rxc = -m_referenceLoss - pathLossDb;
+      rxPowerDbm[i] += rxc;
+    }
+}
+
 int64_t
 LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -632,6 +723,45 @@ ThreeLogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - pathLossDb;
 }
 
+void
+ThreeLogDistancePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                          const std::vector<Ptr<MobilityModel> > &receivers,
+                                                          const std::vector<double> &distances,
+                                                          std::vector<double> &rxPowerDbm) const
+{
+  // the losses at the field boundaries do not depend on the receiver
+  double lossDb1 = m_referenceLoss
+    + 10 * m_exponent0 * std::log10 (m_distance1 / m_distance0);
+  double lossDb2 = lossDb1
+    + 10 * m_exponent1 * std::log10 (m_distance2 / m_distance1);
+  for (uint32_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      NS_ASSERT (distance >= 0);
+      double pathLossDb;
+      if (distance < m_distance0)
+        {
+          pathLossDb = 0;
+        }
+      else if (distance < m_distance1)
+        {
+          pathLossDb = m_referenceLoss
+            + 10 * m_exponent0 * std::log10 (distance / m_distance0);
+        }
+      else if (distance < m_distance2)
+        {
+          pathLossDb = lossDb1
+            + 10 * m_exponent1 * std::log10 (distance / m_distance1);
+        }
+      else
+        {
+          pathLossDb = lossDb2
+            + 10 * m_exponent2 * std::log10 (distance / m_distance2);
+        }
+      rxPowerDbm[i] -= pathLossDb;
+    }
+}
+
 int64_t
 ThreeLogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -745,6 +875,45 @@ NakagamiPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return resultPowerDbm;
 }
 
+void
+NakagamiPropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                  const std::vector<Ptr<MobilityModel> > &receivers,
+                                                  const std::vector<double> &distances,
+                                                  std::vector<double> &rxPowerDbm) const
+{
+  // the random variables are drawn in receiver order, as with CalcRxPower
+  for (uint32_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      NS_ASSERT (distance >= 0);
+      double m;
+      if (distance < m_distance1)
+        {
+          m = m_m0;
+        }
+      else if (distance < m_distance2)
+        {
+          m = m_m1;
+        }
+      else
+        {
+          m = m_m2;
+        }
+      double powerW = std::pow (10, (rxPowerDbm[i] - 30) / 10);
+      double resultPowerW;
+      unsigned int int_m = static_cast<unsigned int>(std::floor (m));
+      if (int_m == m)
+        {
+          resultPowerW = m_erlangRandomVariable->GetValue (int_m, powerW / m);
+        }
+      else
+        {
+          resultPowerW = m_gammaRandomVariable->GetValue (m, powerW / m);
+        }
+      rxPowerDbm[i] = 10 * std::log10 (resultPowerW) + 30;
+    }
+}
+
 int64_t
 NakagamiPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -919,6 +1088,21 @@ RangePropagationLossModel::DoCalcRxPower (double txPowerDbm,
     }
 }
 
+void
+RangePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                               const std::vector<Ptr<MobilityModel> > &receivers,
+                                               const std::vector<double> &distances,
+                                               std::vector<double> &rxPowerDbm) const
+{
+  for (uint32_t i = 0; i < distances.size (); i++)
+    {
+      if (distances[i] > m_range)
+        {
+          rxPowerDbm[i] = -1000;
+        }
+    }
+}
+
 int64_t
 RangePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -28,6 +28,7 @@
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
 #include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -93,6 +94,26 @@ public:
                       Ptr<MobilityModel> a,
                       Ptr<MobilityModel> b) const;
 
+  /**
+   * Returns the Rx Power at each of a set of receivers taking into
+   * account all the PropagationLossModel(s) chained to the current one.
+   *
+   * The result is the same as calling CalcRxPower once per receiver, but
+   * the positions of the receivers are fetched once and the distances to
+   * the source are computed in a single pass, shared by every model of
+   * the chain.
+   *
+   * \param txPowerDbm current transmission power (in dBm)
+   * \param a the mobility model of the source
+   * \param receivers the mobility models of the destinations
+   * \param rxPowerDbm the reception power at each destination (in dBm),
+   *        resized to the number of destinations
+   */
+  void CalcRxPowerBatch (double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         const std::vector<Ptr<MobilityModel> > &receivers,
+                         std::vector<double> &rxPowerDbm) const;
+
   /**
    * If this loss model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -134,6 +155,23 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const = 0;
 
+  /**
+   * Applies only the particular PropagationLossModel to the power received
+   * at a set of destinations.  The default implementation calls
+   * DoCalcRxPower for each destination; models whose loss only depends on
+   * the distance override it to work on the precomputed distances.
+   *
+   * \param a the mobility model of the source
+   * \param receivers the mobility models of the destinations
+   * \param distances the distance (m) between the source and each destination
+   * \param rxPowerDbm on input, the power (in dBm) entering this model for
+   *        each destination; on output, the power after the loss of this model
+   */
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const std::vector<Ptr<MobilityModel> > &receivers,
+                                   const std::vector<double> &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+
   /**
    * Subclasses must implement this; those not using random variables
    * can return zero
@@ -321,6 +359,10 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const std::vector<Ptr<MobilityModel> > &receivers,
+                                   const std::vector<double> &distances,
+                                   std::vector<double> &rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   /**
@@ -529,6 +571,10 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const std::vector<Ptr<MobilityModel> > &receivers,
+                                   const std::vector<double> &distances,
+                                   std::vector<double> &rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   /**
@@ -612,6 +658,10 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const std::vector<Ptr<MobilityModel> > &receivers,
+                                   const std::vector<double> &distances,
+                                   std::vector<double> &rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   double m_distance0; //!< Beginning of the first (near) distance field
@@ -676,6 +726,10 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const std::vector<Ptr<MobilityModel> > &receivers,
+                                   const std::vector<double> &distances,
+                                   std::vector<double> &rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   double m_distance1; //!< Distance1
@@ -844,6 +898,10 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const std::vector<Ptr<MobilityModel> > &receivers,
+                                   const std::vector<double> &distances,
+                                   std::vector<double> &rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 private:
   double m_range; //!< Maximum Transmission Range (meters)
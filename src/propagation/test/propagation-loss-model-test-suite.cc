@@ -436,6 +436,82 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class BatchPropagationLossModelTestCase : public TestCase
+{
+public:
+  BatchPropagationLossModelTestCase ();
+  virtual ~BatchPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \return a chain of loss models covering both the models with a batch
+   * implementation and the default one
+   */
+  Ptr<PropagationLossModel> CreateChain (void);
+};
+
+BatchPropagationLossModelTestCase::BatchPropagationLossModelTestCase ()
+  : TestCase ("Test CalcRxPowerBatch against CalcRxPower")
+{
+}
+
+BatchPropagationLossModelTestCase::~BatchPropagationLossModelTestCase ()
+{
+}
+
+Ptr<PropagationLossModel>
+BatchPropagationLossModelTestCase::CreateChain (void)
+{
+  Ptr<PropagationLossModel> friis = CreateObject<FriisPropagationLossModel> ();
+  Ptr<PropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationLossModel> threeLog = CreateObject<ThreeLogDistancePropagationLossModel> ();
+  Ptr<PropagationLossModel> twoRay = CreateObject<TwoRayGroundPropagationLossModel> ();
+  Ptr<PropagationLossModel> nakagami = CreateObject<NakagamiPropagationLossModel> ();
+  Ptr<PropagationLossModel> range = CreateObject<RangePropagationLossModel> ();
+  friis->SetNext (logDistance);
+  logDistance->SetNext (threeLog);
+  threeLog->SetNext (twoRay);
+  twoRay->SetNext (nakagami);
+  nakagami->SetNext (range);
+  friis->AssignStreams (1);
+  return friis;
+}
+
+void
+BatchPropagationLossModelTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (10, 20, 1.5));
+  std::vector<Ptr<MobilityModel> > receivers;
+  double offsets[] = { 0, 0.5, 1, 7, 49, 80, 120, 199, 250, 600, 1000, 1500 };
+  for (uint32_t i = 0; i < sizeof (offsets) / sizeof (offsets[0]); i++)
+    {
+      Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+      b->SetPosition (Vector (10 + offsets[i], 20 - offsets[i] / 2, 1.5));
+      receivers.push_back (b);
+    }
+
+  // both chains use the same random streams
+  Ptr<PropagationLossModel> single = CreateChain ();
+  Ptr<PropagationLossModel> batch = CreateChain ();
+
+  double txPowerDbm = 16.0206;
+  std::vector<double> rxPowerDbm;
+  for (uint32_t run = 0; run < 3; run++)
+    {
+      batch->CalcRxPowerBatch (txPowerDbm, a, receivers, rxPowerDbm);
+      NS_TEST_ASSERT_MSG_EQ (rxPowerDbm.size (), receivers.size (), "Wrong number of results");
+      for (uint32_t i = 0; i < receivers.size (); i++)
+        {
+          double expected = single->CalcRxPower (txPowerDbm, a, receivers[i]);
+          NS_TEST_EXPECT_MSG_EQ_TOL (rxPowerDbm[i], expected, 1e-9, "Got unexpected rcv power for receiver " << i);
+        }
+    }
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +526,7 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new BatchPropagationLossModelTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
@@ -0,0 +1,308 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This is a system test of the fluid background traffic: a fluid
+// OnOffApplication loads a two-hop route with a PIE bottleneck, and
+// packets sent over the same route see the queueing delay and the
+// drops that the fluid causes.
+
+#include <vector>
+
+#include "ns3/application-container.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/on-off-helper.h"
+#include "ns3/packet.h"
+#include "ns3/pie-queue.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/pointer.h"
+#include "ns3/seq-ts-header.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup system-tests-fluid
+ *
+ * \brief Fluid OnOffApplication over two hops with a PIE bottleneck
+ *
+ * n0 --10Mbps, 1ms-- n1 --1Mbps, 2ms-- n2.  A fluid OnOffApplication on
+ * n0 offers 1.5Mbps to n2 during on periods of 0.4s, separated by off
+ * periods of 0.6s, until it has sent 1.5 on periods worth of bytes.  The
+ * queue of n1 towards n2 is a PieQueue.  A UDP probe of 130 bytes on the
+ * line is sent from n0 to n2 every 10ms.
+ *
+ * Without early drops, the bottleneck serves the fluid and the probes
+ * first in, first out at 125000 bytes per second, so the delays of the
+ * probes follow from the bytes offered before them.  With early drops,
+ * PIE measures its dequeue rate from the fluid as well, and drops fluid
+ * and probes to bring the queue delay down.
+ */
+class OnOffFluidTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param earlyDrop whether PIE drops early, or only when the queue is full
+   */
+  OnOffFluidTestCase (bool earlyDrop);
+  virtual ~OnOffFluidTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Send a probe packet.
+   * \param socket the sending socket
+   * \param seq the sequence number of the probe
+   */
+  void SendProbe (Ptr<Socket> socket, uint32_t seq);
+  /**
+   * Receive the probe packets.
+   * \param socket the receiving socket
+   */
+  void ReceiveProbe (Ptr<Socket> socket);
+  /**
+   * Record the state of the PIE queue.
+   * \param queue the PIE queue
+   */
+  void RecordPie (Ptr<PieQueue> queue);
+  /**
+   * \param seq the sequence number of a probe
+   * \return the delay of the probe in seconds, or -1 if it was lost
+   */
+  double GetDelay (uint32_t seq) const;
+
+  bool m_earlyDrop;                 //!< Whether PIE drops early
+  std::vector<double> m_delay;      //!< The delay of each probe in seconds, or -1 if lost
+  std::vector<double> m_queued;     //!< The bytes in the PIE queue, fluid included, sampled
+  std::vector<double> m_queueDelay; //!< The queue delay estimated by PIE, sampled
+  std::vector<double> m_dropProb;   //!< The drop probability of PIE, sampled
+};
+
+OnOffFluidTestCase::OnOffFluidTestCase (bool earlyDrop)
+  : TestCase (earlyDrop ? "Fluid OnOffApplication through a PIE bottleneck that drops early"
+              : "Fluid OnOffApplication through a PIE bottleneck that drops only when full"),
+    m_earlyDrop (earlyDrop)
+{
+}
+
+OnOffFluidTestCase::~OnOffFluidTestCase ()
+{
+}
+
+void
+OnOffFluidTestCase::SendProbe (Ptr<Socket> socket, uint32_t seq)
+{
+  SeqTsHeader header;
+  header.SetSeq (seq);
+  // 100 bytes of UDP payload: 130 bytes on the line
+  Ptr<Packet> p = Create<Packet> (100 - header.GetSerializedSize ());
+  p->AddHeader (header);
+  socket->Send (p);
+}
+
+void
+OnOffFluidTestCase::ReceiveProbe (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      SeqTsHeader header;
+      p->RemoveHeader (header);
+      m_delay[header.GetSeq ()] = (Simulator::Now () - header.GetTs ()).GetSeconds ();
+    }
+}
+
+void
+OnOffFluidTestCase::RecordPie (Ptr<PieQueue> queue)
+{
+  m_queued.push_back (queue->GetNBytes () + queue->GetFluidBytes ());
+  m_queueDelay.push_back (queue->GetQueueDelay ().GetSeconds ());
+  m_dropProb.push_back (queue->GetDropProb ());
+}
+
+double
+OnOffFluidTestCase::GetDelay (uint32_t seq) const
+{
+  return m_delay.at (seq);
+}
+
+void
+OnOffFluidTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer access = p2p.Install (nodes.Get (0), nodes.Get (1));
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("1Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  if (m_earlyDrop)
+    {
+      p2p.SetQueue ("ns3::PieQueue");
+    }
+  else
+    {
+      // PIE never leaves its burst allowance: it only drops when full
+      p2p.SetQueue ("ns3::PieQueue", "MaxBurstAllowance", TimeValue (Seconds (100)));
+    }
+  NetDeviceContainer bottleneck = p2p.Install (nodes.Get (1), nodes.Get (2));
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (access);
+  ipv4.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer sinkInterfaces = ipv4.Assign (bottleneck);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  Ipv4Address sinkAddress = sinkInterfaces.GetAddress (1);
+
+  PointerValue ptr;
+  access.Get (0)->GetAttribute ("TxQueue", ptr);
+  Ptr<Queue> accessQueue = ptr.Get<Queue> ();
+  bottleneck.Get (0)->GetAttribute ("TxQueue", ptr);
+  Ptr<PieQueue> pie = ptr.Get<PieQueue> ();
+
+  // the fluid is on from 1.0s to 1.4s, then from 2.0s until MaxBytes is
+  // reached at 2.2s
+  OnOffHelper onoff ("ns3::UdpSocketFactory", InetSocketAddress (sinkAddress, 9));
+  onoff.SetAttribute ("Fluid", BooleanValue (true));
+  onoff.SetAttribute ("DataRate", DataRateValue (DataRate ("1.5Mbps")));
+  onoff.SetAttribute ("PacketSize", UintegerValue (1000));
+  onoff.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.4]"));
+  onoff.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.6]"));
+  onoff.SetAttribute ("MaxBytes", UintegerValue (112500));
+  ApplicationContainer apps = onoff.Install (nodes.Get (0));
+  apps.Start (Seconds (0.4));
+  apps.Stop (Seconds (5.0));
+
+  Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (2), TypeId::LookupByName ("ns3::UdpSocketFactory"));
+  sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 10));
+  sink->SetRecvCallback (MakeCallback (&OnOffFluidTestCase::ReceiveProbe, this));
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), TypeId::LookupByName ("ns3::UdpSocketFactory"));
+  source->Bind ();
+  source->Connect (InetSocketAddress (sinkAddress, 10));
+
+  // probe n at 0.5s + 10ms n, up to 3.0s
+  m_delay.assign (251, -1);
+  for (uint32_t seq = 0; seq < m_delay.size (); ++seq)
+    {
+      Simulator::Schedule (Seconds (0.5 + 0.01 * seq), &OnOffFluidTestCase::SendProbe, this, source, seq);
+    }
+  // the PIE queue late in the first on period, just after it updated its
+  // drop probability (every 30ms)
+  Simulator::Schedule (Seconds (1.2905), &OnOffFluidTestCase::RecordPie, this, pie);
+  Simulator::Schedule (Seconds (1.3805), &OnOffFluidTestCase::RecordPie, this, pie);
+
+  Simulator::Stop (Seconds (6.0));
+  Simulator::Run ();
+  double accessDeparted = accessQueue->GetTotalFluidDepartedBytes ();
+  double accessDropped = accessQueue->GetTotalFluidDroppedBytes ();
+  double pieDeparted = pie->GetTotalFluidDepartedBytes ();
+  double pieDropped = pie->GetTotalFluidDroppedBytes ();
+  double pieLeft = pie->GetFluidBytes ();
+  uint32_t probesDropped = pie->GetStats ().unforcedDrop + pie->GetStats ().forcedDrop;
+  Simulator::Destroy ();
+
+  // the probes sent at 0.9s, 1.1s, 1.4s, 1.8s, 2.1s and 2.5s
+  uint32_t before = 40, early = 60, late = 90, off = 130, second = 160, after = 200;
+
+  // no fluid yet: 104us and 1040us of transmission, 1ms and 2ms of
+  // propagation, to the nanosecond the transmission times are rounded to
+  NS_TEST_ASSERT_MSG_EQ_TOL (GetDelay (before), 0.004144, 1e-8, "delay before the fluid");
+  // the fluid is off again and the queue has drained
+  NS_TEST_ASSERT_MSG_EQ_TOL (GetDelay (off), 0.004144, 1e-8, "delay in the off period");
+  NS_TEST_ASSERT_MSG_EQ_TOL (GetDelay (after), 0.004144, 1e-8, "delay after MaxBytes");
+
+  // MaxBytes: every byte offered to the bottleneck was sent or dropped,
+  // and the faster access line sent them all
+  NS_TEST_ASSERT_MSG_EQ_TOL (accessDeparted, 112500, 1e-3, "fluid sent by the access line");
+  NS_TEST_ASSERT_MSG_EQ_TOL (accessDropped, 0, 1e-3, "fluid dropped by the access line");
+  NS_TEST_ASSERT_MSG_EQ_TOL (pieDeparted + pieDropped, 112500, 1e-3, "fluid offered to the bottleneck");
+  NS_TEST_ASSERT_MSG_EQ_TOL (pieLeft, 0, 1e-3, "fluid left at the bottleneck");
+
+  if (!m_earlyDrop)
+    {
+      // the fluid reaches the bottleneck at 1.001s and the probe sent at 1.1s
+      // at 1.101104s.  Before it, 0.100104s of fluid at 187500 bytes per
+      // second and the 11 probes sent from 1.0s, 20199.5 bytes in all, are
+      // sent at 125000 bytes per second: the probe is sent by 1.162596s
+      // and arrives 2ms later.
+      NS_TEST_ASSERT_MSG_EQ_TOL (GetDelay (early), 0.064596, 1e-6, "delay early in the on period");
+      // the whole on period, 75000 bytes, and 41 probes
+      NS_TEST_ASSERT_MSG_EQ_TOL (GetDelay (late), 0.245640, 1e-6, "delay late in the on period");
+      // as early in the first on period
+      NS_TEST_ASSERT_MSG_EQ_TOL (GetDelay (second), 0.064596, 1e-6, "delay in the second on period");
+      for (uint32_t seq = 0; seq < m_delay.size (); ++seq)
+        {
+          NS_TEST_ASSERT_MSG_GT (GetDelay (seq), 0, "probe " << seq << " lost");
+        }
+      NS_TEST_ASSERT_MSG_EQ_TOL (pieDropped, 0, 1e-3, "fluid dropped");
+      NS_TEST_ASSERT_MSG_EQ (probesDropped, 0, "probes dropped");
+      return;
+    }
+
+  // PIE estimates no queue delay, hence drops nothing, until it has
+  // measured its dequeue rate over 10000 bytes sent from a queue of 10000
+  // bytes or more, after 1.2s: early in the on period is as without drops
+  NS_TEST_ASSERT_MSG_EQ_TOL (GetDelay (early), 0.064596, 1e-6, "delay early in the on period");
+  // then it drops fluid and probes early, so that the queue delay is
+  // shorter than the 245.64ms without drops
+  NS_TEST_ASSERT_MSG_GT (pieDropped, 0, "no fluid dropped");
+  NS_TEST_ASSERT_MSG_GT (m_dropProb[1], 0, "no drop probability");
+  NS_TEST_ASSERT_MSG_LT (GetDelay (late), 0.245640, "delay late in the on period");
+  // PIE measures its dequeue rate, the line rate, from the fluid served
+  for (uint32_t i = 0; i < m_queued.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (m_queueDelay[i], m_queued[i] / 125000, 0.005,
+                                 "queue delay estimated by PIE, sample " << i);
+    }
+}
+
+/**
+ * \ingroup system-tests-fluid
+ *
+ * \brief Fluid background traffic system tests
+ */
+class OnOffFluidTestSuite : public TestSuite
+{
+public:
+  OnOffFluidTestSuite ();
+};
+
+OnOffFluidTestSuite::OnOffFluidTestSuite ()
+  : TestSuite ("onoff-fluid-system", SYSTEM)
+{
+  AddTestCase (new OnOffFluidTestCase (false), TestCase::QUICK);
+  AddTestCase (new OnOffFluidTestCase (true), TestCase::QUICK);
+}
+
+static OnOffFluidTestSuite onOffFluidTestSuite; //!< Static variable for test initialization
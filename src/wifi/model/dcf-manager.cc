@@ -315,6 +315,7 @@ DcfManager::DcfManager ()
     m_sleeping (false),
     m_slotTimeUs (0),
     m_sifs (Seconds (0.0)),
+    m_fastForwardBackoff (false),
     m_phyListener (0),
     m_lowListener (0)
 {
@@ -393,6 +394,19 @@ DcfManager::GetEifsNoDifs () const
   return m_eifsNoDifs;
 }
 
+void
+DcfManager::SetFastForwardBackoff (bool enable)
+{
+  NS_LOG_FUNCTION (this << enable);
+  m_fastForwardBackoff = enable;
+}
+
+bool
+DcfManager::GetFastForwardBackoff (void) const
+{
+  return m_fastForwardBackoff;
+}
+
 void
 DcfManager::Add (DcfState *dcf)
 {
@@ -672,8 +686,21 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
     {
       MY_DEBUG ("expected backoff end=" << expectedBackoffEnd);
       Time expectedBackoffDelay = expectedBackoffEnd - Simulator::Now ();
-      if (m_accessTimeout.IsRunning ()
-          && Simulator::GetDelayLeft (m_accessTimeout) > expectedBackoffDelay)
+      if (m_fastForwardBackoff)
+        {
+          /**
+           * Keep a single wake-up at the expected backoff end: remove the
+           * pending timer from the scheduler if it would expire earlier
+           * (i.e., before the medium became busy again) or later.
+           */
+          if (m_accessTimeout.IsRunning ()
+              && Simulator::GetDelayLeft (m_accessTimeout) != expectedBackoffDelay)
+            {
+              Simulator::Remove (m_accessTimeout);
+            }
+        }
+      else if (m_accessTimeout.IsRunning ()
+               && Simulator::GetDelayLeft (m_accessTimeout) > expectedBackoffDelay)
         {
           m_accessTimeout.Cancel ();
         }
@@ -685,6 +712,15 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
     }
 }
 
+void
+DcfManager::NotifyMediumStateChanged (void)
+{
+  if (m_fastForwardBackoff && !m_sleeping)
+    {
+      DoRestartAccessTimeoutIfNeeded ();
+    }
+}
+
 void
 DcfManager::NotifyRxStartNow (Time duration)
 {
@@ -694,6 +730,7 @@ DcfManager::NotifyRxStartNow (Time duration)
   m_lastRxStart = Simulator::Now ();
   m_lastRxDuration = duration;
   m_rxing = true;
+  NotifyMediumStateChanged ();
 }
 
 void
@@ -704,6 +741,7 @@ DcfManager::NotifyRxEndOkNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = true;
   m_rxing = false;
+  NotifyMediumStateChanged ();
 }
 
 void
@@ -714,6 +752,7 @@ DcfManager::NotifyRxEndErrorNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = false;
   m_rxing = false;
+  NotifyMediumStateChanged ();
 }
 
 void
@@ -734,6 +773,7 @@ DcfManager::NotifyTxStartNow (Time duration)
   UpdateBackoff ();
   m_lastTxStart = Simulator::Now ();
   m_lastTxDuration = duration;
+  NotifyMediumStateChanged ();
 }
 
 void
@@ -744,6 +784,7 @@ DcfManager::NotifyMaybeCcaBusyStartNow (Time duration)
   UpdateBackoff ();
   m_lastBusyStart = Simulator::Now ();
   m_lastBusyDuration = duration;
+  NotifyMediumStateChanged ();
 }
 
 void
@@ -877,6 +918,7 @@ DcfManager::NotifyNavStartNow (Time duration)
       m_lastNavStart = Simulator::Now ();
       m_lastNavDuration = duration;
     }
+  NotifyMediumStateChanged ();
 }
 
 void
@@ -885,6 +927,7 @@ DcfManager::NotifyAckTimeoutStartNow (Time duration)
   NS_LOG_FUNCTION (this << duration);
   NS_ASSERT (m_lastAckTimeoutEnd < Simulator::Now ());
   m_lastAckTimeoutEnd = Simulator::Now () + duration;
+  NotifyMediumStateChanged ();
 }
 
 void
@@ -900,6 +943,7 @@ DcfManager::NotifyCtsTimeoutStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
   m_lastCtsTimeoutEnd = Simulator::Now () + duration;
+  NotifyMediumStateChanged ();
 }
 
 void
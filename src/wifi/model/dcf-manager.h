@@ -300,6 +300,22 @@ public:
    * \return value set previously using SetEifsNoDifs.
    */
   Time GetEifsNoDifs () const;
+  /**
+   * \param enable whether to fast-forward idle backoffs.
+   *
+   * By default, the access timer is only moved earlier when needed, so
+   * that a timer scheduled before the medium became busy expires and
+   * is scheduled again for each busy period. When fast-forwarding is
+   * enabled, the expected end of the backoffs is computed again on every
+   * change of the medium state, and the single pending access timer is
+   * moved to it, earlier or later. Access is granted at the same times
+   * in both cases, with fewer events in the latter.
+   */
+  void SetFastForwardBackoff (bool enable);
+  /**
+   * \return whether idle backoffs are fast-forwarded.
+   */
+  bool GetFastForwardBackoff (void) const;
 
   /**
    * \param dcf a new DcfState.
@@ -493,6 +509,11 @@ private:
   Time GetBackoffEndFor (DcfState *state);
 
   void DoRestartAccessTimeoutIfNeeded (void);
+  /**
+   * Move the access timer to the expected end of the backoffs
+   * if fast-forwarding is enabled, after a change of the medium state.
+   */
+  void NotifyMediumStateChanged (void);
 
   /**
    * Called when access timeout should occur
@@ -538,6 +559,7 @@ private:
   EventId m_accessTimeout;
   uint32_t m_slotTimeUs;
   Time m_sifs;
+  bool m_fastForwardBackoff;
   PhyListener* m_phyListener;
   LowDcfListener* m_lowListener;
 };
@@ -19,9 +19,16 @@
  */
 
 #include "error-rate-model.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include <cmath>
+#include <limits>
 
 namespace ns3 {
 
+NS_LOG_COMPONENT_DEFINE ("ErrorRateModel");
+
 NS_OBJECT_ENSURE_REGISTERED (ErrorRateModel);
 
 TypeId ErrorRateModel::GetTypeId (void)
@@ -29,10 +36,56 @@ TypeId ErrorRateModel::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::ErrorRateModel")
     .SetParent<Object> ()
     .SetGroupName ("Wifi")
+    .AddAttribute ("UseLookupTable",
+                   "If true, chunk success rates are interpolated from tables "
+                   "precomputed for each mode instead of being evaluated exactly.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ErrorRateModel::SetUseLookupTable,
+                                        &ErrorRateModel::GetUseLookupTable),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LookupTableStep",
+                   "The SNR step (dB) between two consecutive entries of the lookup tables.",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&ErrorRateModel::SetLookupTableStep,
+                                       &ErrorRateModel::GetLookupTableStep),
+                   MakeDoubleChecker<double> (0.001, 1.0))
   ;
   return tid;
 }
 
+ErrorRateModel::ErrorRateModel ()
+  : m_useLookupTable (false),
+    m_tableStep (0.01),
+    m_tableMinSnr (-10.0),
+    m_tableMaxSnr (50.0)
+{
+}
+
+void
+ErrorRateModel::SetUseLookupTable (bool enable)
+{
+  m_useLookupTable = enable;
+}
+
+bool
+ErrorRateModel::GetUseLookupTable (void) const
+{
+  return m_useLookupTable;
+}
+
+void
+ErrorRateModel::SetLookupTableStep (double step)
+{
+  m_tableStep = step;
+  m_tables.clear ();
+}
+
+double
+ErrorRateModel::GetLookupTableStep (void) const
+{
+  return m_tableStep;
+}
+
 double
 ErrorRateModel::CalculateSnr (WifiMode txMode, double ber) const
 {
@@ -47,7 +100,7 @@ ErrorRateModel::CalculateSnr (WifiMode txMode, double ber) const
     {
       NS_ASSERT (high >= low);
       double middle = low + (high - low) / 2;
-      if ((1 - GetChunkSuccessRate (txMode, txVector, middle, 1)) > ber)
+      if ((1 - DoGetChunkSuccessRate (txMode, txVector, middle, 1)) > ber)
         {
           low = middle;
         }
@@ -59,4 +112,99 @@ ErrorRateModel::CalculateSnr (WifiMode txMode, double ber) const
   return low;
 }
 
+double
+ErrorRateModel::GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const
+{
+  if (m_useLookupTable)
+    {
+      return GetTabulatedChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  return DoGetChunkSuccessRate (mode, txVector, snr, nbits);
+}
+
+double
+ErrorRateModel::GetTabulatedChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const
+{
+  if (snr <= 0)
+    {
+      return DoGetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  uint64_t key = (static_cast<uint64_t> (mode.GetUid ()) << 32)
+    | (static_cast<uint64_t> (txVector.GetChannelWidth ()) << 1)
+    | (txVector.IsShortGuardInterval () ? 1 : 0);
+  LookupTables::iterator it = m_tables.find (key);
+  if (it == m_tables.end ())
+    {
+      NS_LOG_DEBUG ("build lookup table for mode " << mode << " width=" << txVector.GetChannelWidth ()
+                                                   << " sgi=" << txVector.IsShortGuardInterval ());
+      uint32_t size = static_cast<uint32_t> ((m_tableMaxSnr - m_tableMinSnr) / m_tableStep) + 1;
+      LookupTable table (size);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          double entrySnr = std::pow (10.0, (m_tableMinSnr + i * m_tableStep) / 10.0);
+          double csr = DoGetChunkSuccessRate (mode, txVector, entrySnr, 1);
+          if (csr >= 1.0)
+            {
+              table[i] = -std::numeric_limits<double>::infinity ();
+            }
+          else
+            {
+              // log of the per-bit loss; +inf if the chunk cannot succeed
+              table[i] = std::log (-std::log (csr));
+            }
+        }
+      it = m_tables.insert (std::make_pair (key, table)).first;
+    }
+  const LookupTable &table = it->second;
+
+  double index = (10.0 * std::log10 (snr) - m_tableMinSnr) / m_tableStep;
+  if (index < 0)
+    {
+      return DoGetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  if (index >= table.size () - 1)
+    {
+      if (table.back () == -std::numeric_limits<double>::infinity ())
+        {
+          return 1.0;
+        }
+      return DoGetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  uint32_t i = static_cast<uint32_t> (index);
+  double fraction = index - i;
+  double a = table[i];
+  double b = table[i + 1];
+  double loss;
+  if (std::isfinite (a) && std::isfinite (b))
+    {
+      if (std::max (a, b) > std::log (0.1))
+        {
+          // close to the waterfall, the per-bit success rate itself is
+          // the smoothest quantity to interpolate
+          double success = (1.0 - fraction) * std::exp (-std::exp (a)) + fraction * std::exp (-std::exp (b));
+          loss = -std::log (success);
+        }
+      else
+        {
+          // elsewhere, the per-bit loss is close to exponential in the SNR (dB)
+          loss = std::exp (a + fraction * (b - a));
+        }
+    }
+  else if (a == std::numeric_limits<double>::infinity ()
+           || b == std::numeric_limits<double>::infinity ())
+    {
+      if (a == b)
+        {
+          return 0.0;
+        }
+      return DoGetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  else
+    {
+      // at least one entry has no loss at all
+      loss = (1.0 - fraction) * std::exp (a) + fraction * std::exp (b);
+    }
+  return std::exp (-loss * nbits);
+}
+
 } //namespace ns3
@@ -22,6 +22,8 @@
 #define ERROR_RATE_MODEL_H
 
 #include <stdint.h>
+#include <map>
+#include <vector>
 #include "wifi-mode.h"
 #include "wifi-tx-vector.h"
 #include "ns3/object.h"
@@ -37,6 +39,8 @@ class ErrorRateModel : public Object
 public:
   static TypeId GetTypeId (void);
 
+  ErrorRateModel ();
+
   /**
    * \param txMode a specific transmission mode
    * \param ber a target ber
@@ -46,7 +50,6 @@ public:
   double CalculateSnr (WifiMode txMode, double ber) const;
 
   /**
-   * A pure virtual method that must be implemented in the subclass.
    * This method returns the probability that the given 'chunk' of the
    * packet will be successfully received by the PHY.
    *
@@ -54,14 +57,92 @@ public:
    * The probability of successfully receiving the chunk depends on
    * the mode, the SNR, and the size of the chunk.
    *
+   * If the UseLookupTable attribute is set, the result is interpolated
+   * from a table of per-bit success rates which is built lazily for each
+   * (mode, channel width, guard interval) combination the first time it
+   * is needed.  Otherwise, the subclass computes the exact value.
+   *
    * \param mode the Wi-Fi mode the chunk is sent
-   * \param txvector TXVECTOR of the transmission
+   * \param txVector TXVECTOR of the transmission
    * \param snr the SNR of the chunk
    * \param nbits the number of bits in this chunk
    *
    * \return probability of successfully receiving the chunk
    */
-  virtual double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const = 0;
+  double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
+
+  /**
+   * \param enable whether chunk success rates are interpolated from
+   *        precomputed lookup tables
+   */
+  void SetUseLookupTable (bool enable);
+  /**
+   * \return true if chunk success rates are interpolated from
+   *         precomputed lookup tables, false otherwise
+   */
+  bool GetUseLookupTable (void) const;
+  /**
+   * Set the SNR step (in dB) between two consecutive entries of the
+   * lookup tables.  Tables built so far are discarded.
+   *
+   * \param step the SNR step (dB)
+   */
+  void SetLookupTableStep (double step);
+  /**
+   * \return the SNR step (dB) between two consecutive entries of the
+   *         lookup tables
+   */
+  double GetLookupTableStep (void) const;
+
+
+private:
+  /**
+   * A pure virtual method that must be implemented in the subclass.
+   * This method returns the exact probability that the given 'chunk' of
+   * the packet will be successfully received by the PHY.
+   *
+   * \param mode the Wi-Fi mode the chunk is sent
+   * \param txVector TXVECTOR of the transmission
+   * \param snr the SNR of the chunk
+   * \param nbits the number of bits in this chunk
+   *
+   * \return probability of successfully receiving the chunk
+   */
+  virtual double DoGetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const = 0;
+
+  /**
+   * Return the chunk success rate interpolated from the lookup table
+   * of the given mode, building the table first if needed.
+   *
+   * \param mode the Wi-Fi mode the chunk is sent
+   * \param txVector TXVECTOR of the transmission
+   * \param snr the SNR of the chunk
+   * \param nbits the number of bits in this chunk
+   *
+   * \return probability of successfully receiving the chunk
+   */
+  double GetTabulatedChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
+
+  /**
+   * Every error rate model in this module gives a chunk success rate of
+   * the form csr (snr, nbits) = csr (snr, 1) ^ nbits.  A table stores,
+   * for SNR values evenly spaced (in dB) between m_tableMinSnr and
+   * m_tableMaxSnr, the per-bit loss -log (csr (snr, 1)) so that the
+   * success rate of a chunk of any size is exp (-nbits * loss).
+   */
+  typedef std::vector<double> LookupTable;
+  /**
+   * Tables are indexed by the mode UID, the channel width (MHz) and
+   * the guard interval, since the latter two change the PHY rate
+   * some models depend on.
+   */
+  typedef std::map<uint64_t, LookupTable> LookupTables;
+
+  bool m_useLookupTable;        //!< whether lookup tables are used
+  double m_tableStep;           //!< SNR step between table entries (dB)
+  double m_tableMinSnr;         //!< lowest tabulated SNR (dB)
+  double m_tableMaxSnr;         //!< highest tabulated SNR (dB)
+  mutable LookupTables m_tables; //!< tables built so far
 };
 
 } //namespace ns3
@@ -0,0 +1,907 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Some Comments:
+ *
+ * 1) The statistics and the multi-rate retry chain follow
+ *    MinstrelWifiManager; see minstrel-wifi-manager.cc.
+ *
+ * 2) MCS groups are only built for single spatial stream MCSs, since
+ *    WifiMode does not support MIMO yet.
+ *
+ * http://wireless.kernel.org/en/developers/Documentation/mac80211/RateControl/minstrel
+ */
+
+#include "minstrel-ht-wifi-manager.h"
+#include "wifi-phy.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MinstrelHtWifiManager");
+
+/**
+ * \brief hold per-remote-station state for Minstrel-HT Wifi manager.
+ *
+ * This struct extends from WifiRemoteStation struct to hold additional
+ * information required by the Minstrel-HT Wifi manager. All the
+ * rate statistics are held in fixed-size arrays, so that creating and
+ * initializing a station does not allocate beyond the station itself.
+ */
+struct MinstrelHtWifiRemoteStation : public WifiRemoteStation
+{
+  uint32_t m_sampleIndex[MINSTREL_HT_MAX_GROUPS];  ///< current row of the sample table, per group
+  uint32_t m_sampleCol[MINSTREL_HT_MAX_GROUPS];    ///< current column of the sample table, per group
+  uint32_t m_sampleGroup;        ///< next group to sample
+  uint32_t m_maxTpRate;          ///< the current throughput rate
+  uint32_t m_maxTpRate2;         ///< second highest throughput rate
+  uint32_t m_maxProbRate;        ///< rate with highest prob of success
+  uint32_t m_lowestRate;         ///< most robust rate, last stage of the retry chain
+  uint32_t m_packetCount;        ///< total number of packets as of now
+  uint32_t m_sampleCount;        ///< how many packets we have sample so far
+  bool m_isSampling;             ///< a flag to indicate we are currently sampling
+  uint32_t m_sampleRate;         ///< current sample rate
+  bool m_sampleRateSlower;       ///< a flag to indicate sample rate is slower
+  uint32_t m_shortRetry;         ///< short retries such as control packts
+  uint32_t m_longRetry;          ///< long retries such as data packets
+  uint32_t m_retry;              ///< total retries short + long
+  uint32_t m_err;                ///< retry errors
+  uint32_t m_txrate;             ///< current transmit rate
+  bool m_initialized;            ///< for initializing tables
+  bool m_isHt;                   ///< whether the MCS groups are used
+  uint32_t m_nSupported;         ///< number of supported modes at initialization
+  uint32_t m_nMcsSupported;      ///< number of supported MCSs at initialization
+  bool m_groupSupported[MINSTREL_HT_MAX_GROUPS];  ///< whether each group holds a supported rate
+  MinstrelHtRateInfo m_rates[MINSTREL_HT_MAX_GROUPS][MINSTREL_HT_MAX_GROUP_RATES];  ///< rate statistics
+};
+
+NS_OBJECT_ENSURE_REGISTERED (MinstrelHtWifiManager);
+
+TypeId
+MinstrelHtWifiManager::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MinstrelHtWifiManager")
+    .SetParent<WifiRemoteStationManager> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<MinstrelHtWifiManager> ()
+    .AddAttribute ("UpdateStatistics",
+                   "The minimum interval between two updates of the statistics of a rate",
+                   TimeValue (Seconds (0.1)),
+                   MakeTimeAccessor (&MinstrelHtWifiManager::m_updateStats),
+                   MakeTimeChecker ())
+    .AddAttribute ("LookAroundRate",
+                   "the percentage to try other rates",
+                   DoubleValue (10),
+                   MakeDoubleAccessor (&MinstrelHtWifiManager::m_lookAroundRate),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("EWMA",
+                   "EWMA level",
+                   DoubleValue (75),
+                   MakeDoubleAccessor (&MinstrelHtWifiManager::m_ewmaLevel),
+                   MakeDoubleChecker<double> (0, 100))
+    .AddAttribute ("PacketLength",
+                   "The packet length used for calculating mode TxTime",
+                   UintegerValue (1200),
+                   MakeUintegerAccessor (&MinstrelHtWifiManager::m_pktLen),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MinstrelHtWifiManager::MinstrelHtWifiManager ()
+  : m_sampleTableInitialized (false)
+{
+  m_uniformRandomVariable = CreateObject<UniformRandomVariable> ();
+}
+
+MinstrelHtWifiManager::~MinstrelHtWifiManager ()
+{
+}
+
+int64_t
+MinstrelHtWifiManager::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uniformRandomVariable->SetStream (stream);
+  return 1;
+}
+
+uint32_t
+MinstrelHtWifiManager::GetGroupChannelWidth (uint32_t group)
+{
+  NS_ASSERT (group > 0 && group < MINSTREL_HT_MAX_GROUPS);
+  return 20 << ((group - 1) / 2);
+}
+
+bool
+MinstrelHtWifiManager::GetGroupShortGuardInterval (uint32_t group)
+{
+  NS_ASSERT (group > 0 && group < MINSTREL_HT_MAX_GROUPS);
+  return ((group - 1) % 2) == 1;
+}
+
+MinstrelHtRateInfo &
+MinstrelHtWifiManager::GetRateInfo (MinstrelHtWifiRemoteStation *station, uint32_t rate)
+{
+  NS_ASSERT (rate < MINSTREL_HT_MAX_GROUPS * MINSTREL_HT_MAX_GROUP_RATES);
+  return station->m_rates[rate / MINSTREL_HT_MAX_GROUP_RATES][rate % MINSTREL_HT_MAX_GROUP_RATES];
+}
+
+Time
+MinstrelHtWifiManager::GetCalcTxTime (WifiMode mode, uint32_t channelWidth, bool shortGuardInterval)
+{
+  uint64_t key = (static_cast<uint64_t> (mode.GetUid ()) << 32) | (channelWidth << 1) | (shortGuardInterval ? 1 : 0);
+  std::map<uint64_t, Time>::const_iterator it = m_calcTxTime.find (key);
+  if (it != m_calcTxTime.end ())
+    {
+      return it->second;
+    }
+  WifiTxVector txVector;
+  txVector.SetMode (mode);
+  txVector.SetChannelWidth (channelWidth);
+  txVector.SetShortGuardInterval (shortGuardInterval);
+  txVector.SetNss (1);
+  txVector.SetNess (0);
+  txVector.SetStbc (false);
+  WifiPreamble preamble = WIFI_PREAMBLE_LONG;
+  if (mode.GetModulationClass () == WIFI_MOD_CLASS_HT)
+    {
+      preamble = WIFI_PREAMBLE_HT_MF;
+    }
+  else if (mode.GetModulationClass () == WIFI_MOD_CLASS_VHT)
+    {
+      preamble = WIFI_PREAMBLE_VHT;
+    }
+  Ptr<WifiPhy> phy = GetPhy ();
+  Time txTime = phy->CalculateTxDuration (m_pktLen, txVector, preamble, phy->GetFrequency (), 0, 0);
+  m_calcTxTime.insert (std::make_pair (key, txTime));
+  return txTime;
+}
+
+WifiRemoteStation *
+MinstrelHtWifiManager::DoCreateStation (void) const
+{
+  MinstrelHtWifiRemoteStation *station = new MinstrelHtWifiRemoteStation ();
+
+  for (uint32_t g = 0; g < MINSTREL_HT_MAX_GROUPS; g++)
+    {
+      station->m_sampleIndex[g] = 0;
+      station->m_sampleCol[g] = 0;
+      station->m_groupSupported[g] = false;
+      for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+        {
+          station->m_rates[g][i].supported = false;
+        }
+    }
+  station->m_sampleGroup = 0;
+  station->m_maxTpRate = 0;
+  station->m_maxTpRate2 = 0;
+  station->m_maxProbRate = 0;
+  station->m_lowestRate = 0;
+  station->m_packetCount = 0;
+  station->m_sampleCount = 0;
+  station->m_isSampling = false;
+  station->m_sampleRate = 0;
+  station->m_sampleRateSlower = false;
+  station->m_shortRetry = 0;
+  station->m_longRetry = 0;
+  station->m_retry = 0;
+  station->m_err = 0;
+  station->m_txrate = 0;
+  station->m_initialized = false;
+  station->m_isHt = false;
+  station->m_nSupported = 0;
+  station->m_nMcsSupported = 0;
+
+  return station;
+}
+
+void
+MinstrelHtWifiManager::CheckInit (MinstrelHtWifiRemoteStation *station)
+{
+  //Note: as in Minstrel, the table is initialized late to make sure that the
+  //set of supported rates has been initialized. Since the capabilities of a
+  //station may be learnt in several steps, the table is built again whenever
+  //its set of supported rates changes.
+  uint32_t nSupported = GetNSupported (station);
+  uint32_t nMcsSupported = GetNMcsSupported (station);
+  if (nSupported > 1
+      && (!station->m_initialized
+          || nSupported != station->m_nSupported
+          || nMcsSupported != station->m_nMcsSupported))
+    {
+      if (!m_sampleTableInitialized)
+        {
+          InitSampleTable ();
+        }
+      station->m_nSupported = nSupported;
+      station->m_nMcsSupported = nMcsSupported;
+      RateInit (station);
+      station->m_initialized = true;
+
+      PrintTable (station);
+    }
+}
+
+void
+MinstrelHtWifiManager::DoReportRxOk (WifiRemoteStation *st,
+                                     double rxSnr, WifiMode txMode)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MinstrelHtWifiManager::DoReportRtsFailed (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  NS_LOG_DEBUG ("DoReportRtsFailed m_txrate=" << station->m_txrate);
+
+  station->m_shortRetry++;
+}
+
+void
+MinstrelHtWifiManager::DoReportRtsOk (WifiRemoteStation *st, double ctsSnr, WifiMode ctsMode, double rtsSnr)
+{
+  NS_LOG_DEBUG ("self=" << st << " rts ok");
+}
+
+void
+MinstrelHtWifiManager::DoReportFinalRtsFailed (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  UpdateRetry (station);
+  station->m_err++;
+}
+
+void
+MinstrelHtWifiManager::DoReportDataFailed (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return;
+    }
+
+  station->m_longRetry++;
+  GetRateInfo (station, station->m_txrate).numRateAttempt++;
+  UpdateRateStats (station, station->m_txrate);
+
+  NS_LOG_DEBUG ("DoReportDataFailed " << station << " rate " << station->m_txrate << " longRetry " << station->m_longRetry);
+
+  uint32_t rate;
+  GetRetryChainRate (station, station->m_longRetry, rate);
+  station->m_txrate = rate;
+}
+
+void
+MinstrelHtWifiManager::DoReportDataOk (WifiRemoteStation *st,
+                                       double ackSnr, WifiMode ackMode, double dataSnr)
+{
+  NS_LOG_FUNCTION (st << ackSnr << ackMode << dataSnr);
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *) st;
+
+  station->m_isSampling = false;
+  station->m_sampleRateSlower = false;
+
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return;
+    }
+
+  MinstrelHtRateInfo &info = GetRateInfo (station, station->m_txrate);
+  info.numRateSuccess++;
+  info.numRateAttempt++;
+  UpdateRateStats (station, station->m_txrate);
+
+  NS_LOG_DEBUG ("DoReportDataOk m_txrate = " << station->m_txrate << ", attempt = " << info.numRateAttempt << ", success = " << info.numRateSuccess);
+
+  UpdateRetry (station);
+
+  station->m_packetCount++;
+
+  station->m_txrate = FindRate (station);
+}
+
+void
+MinstrelHtWifiManager::DoReportFinalDataFailed (WifiRemoteStation *st)
+{
+  NS_LOG_FUNCTION (st);
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *) st;
+
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return;
+    }
+
+  station->m_isSampling = false;
+  station->m_sampleRateSlower = false;
+
+  UpdateRetry (station);
+
+  station->m_err++;
+
+  station->m_txrate = FindRate (station);
+}
+
+void
+MinstrelHtWifiManager::UpdateRetry (MinstrelHtWifiRemoteStation *station)
+{
+  station->m_retry = station->m_shortRetry + station->m_longRetry;
+  station->m_shortRetry = 0;
+  station->m_longRetry = 0;
+}
+
+WifiTxVector
+MinstrelHtWifiManager::GetRateTxVector (MinstrelHtWifiRemoteStation *station, uint32_t rate)
+{
+  uint32_t group = rate / MINSTREL_HT_MAX_GROUP_RATES;
+  WifiMode mode = GetRateInfo (station, rate).mode;
+  if (group == 0)
+    {
+      uint32_t channelWidth = GetChannelWidth (station);
+      if (channelWidth > 20 && channelWidth != 22)
+        {
+          //legacy rates are sent over 20 MHz
+          channelWidth = 20;
+        }
+      return WifiTxVector (mode, GetDefaultTxPowerLevel (), GetLongRetryCount (station), false, 1, 0, channelWidth, GetAggregation (station), false);
+    }
+  return WifiTxVector (mode, GetDefaultTxPowerLevel (), GetLongRetryCount (station),
+                       GetGroupShortGuardInterval (group), 1, 0, GetGroupChannelWidth (group),
+                       GetAggregation (station), false);
+}
+
+WifiTxVector
+MinstrelHtWifiManager::DoGetDataTxVector (WifiRemoteStation *st,
+                                          uint32_t size)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *) st;
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      uint32_t channelWidth = GetChannelWidth (station);
+      if (channelWidth > 20 && channelWidth != 22)
+        {
+          channelWidth = 20;
+        }
+      return WifiTxVector (GetSupported (station, 0), GetDefaultTxPowerLevel (), GetLongRetryCount (station), false, 1, 0, channelWidth, GetAggregation (station), false);
+    }
+  return GetRateTxVector (station, station->m_txrate);
+}
+
+WifiTxVector
+MinstrelHtWifiManager::DoGetRtsTxVector (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *) st;
+  NS_LOG_DEBUG ("DoGetRtsMode m_txrate=" << station->m_txrate);
+  uint32_t channelWidth = GetChannelWidth (station);
+  if (channelWidth > 20 && channelWidth != 22)
+    {
+      //avoid to use legacy rate adaptation algorithms for IEEE 802.11n/ac
+      channelWidth = 20;
+    }
+  return WifiTxVector (GetSupported (station, 0), GetDefaultTxPowerLevel (), GetShortRetryCount (station), false, 1, 0, channelWidth, GetAggregation (station), false);
+}
+
+bool
+MinstrelHtWifiManager::DoNeedDataRetransmission (WifiRemoteStation *st, Ptr<const Packet> packet, bool normally)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return normally;
+    }
+
+  uint32_t rate;
+  return GetRetryChainRate (station, station->m_longRetry, rate);
+}
+
+bool
+MinstrelHtWifiManager::IsLowLatency (void) const
+{
+  return true;
+}
+
+bool
+MinstrelHtWifiManager::GetRetryChainRate (MinstrelHtWifiRemoteStation *station, uint32_t longRetries, uint32_t &rate)
+{
+  /**
+   * Retry Chain table, as in Minstrel:
+   *
+   * Try |         LOOKAROUND RATE              | NORMAL RATE
+   *     | random < best    | random > best     |
+   * --------------------------------------------------------------
+   *  1  | Best throughput  | Random rate       | Best throughput
+   *  2  | Random rate      | Best throughput   | Next best throughput
+   *  3  | Best probability | Best probability  | Best probability
+   *  4  | Lowest rate      | Lowest rate       | Lowest rate
+   */
+  uint32_t chain[4];
+  if (!station->m_isSampling)
+    {
+      chain[0] = station->m_maxTpRate;
+      chain[1] = station->m_maxTpRate2;
+    }
+  else if (station->m_sampleRateSlower)
+    {
+      chain[0] = station->m_maxTpRate;
+      chain[1] = station->m_sampleRate;
+    }
+  else
+    {
+      chain[0] = station->m_sampleRate;
+      chain[1] = station->m_maxTpRate;
+    }
+  chain[2] = station->m_maxProbRate;
+  chain[3] = station->m_lowestRate;
+
+  uint32_t limit = 0;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      limit += GetRateInfo (station, chain[i]).adjustedRetryCount;
+      if (longRetries < limit)
+        {
+          rate = chain[i];
+          return true;
+        }
+    }
+  rate = station->m_lowestRate;
+  return false;
+}
+
+uint32_t
+MinstrelHtWifiManager::GetNextSample (MinstrelHtWifiRemoteStation *station)
+{
+  for (uint32_t tries = 0; tries < MINSTREL_HT_MAX_GROUPS * MINSTREL_HT_MAX_GROUP_RATES; tries++)
+    {
+      uint32_t group = station->m_sampleGroup;
+      //move on to the next group holding supported rates
+      do
+        {
+          station->m_sampleGroup = (station->m_sampleGroup + 1) % MINSTREL_HT_MAX_GROUPS;
+        }
+      while (!station->m_groupSupported[station->m_sampleGroup]);
+
+      if (!station->m_groupSupported[group])
+        {
+          continue;
+        }
+      uint32_t index = m_sampleTable[station->m_sampleIndex[group]][station->m_sampleCol[group]];
+
+      //bookeeping for the per group row and column
+      station->m_sampleIndex[group]++;
+      if (station->m_sampleIndex[group] >= MINSTREL_HT_MAX_GROUP_RATES)
+        {
+          station->m_sampleIndex[group] = 0;
+          station->m_sampleCol[group] = (station->m_sampleCol[group] + 1) % MINSTREL_HT_SAMPLE_COLUMNS;
+        }
+
+      if (station->m_rates[group][index].supported)
+        {
+          return group * MINSTREL_HT_MAX_GROUP_RATES + index;
+        }
+    }
+  return station->m_maxTpRate;
+}
+
+uint32_t
+MinstrelHtWifiManager::FindRate (MinstrelHtWifiRemoteStation *station)
+{
+  NS_LOG_FUNCTION (this << station);
+
+  if ((station->m_sampleCount + station->m_packetCount) == 0)
+    {
+      return station->m_lowestRate;
+    }
+
+  uint32_t idx;
+
+  //for determining when to try a sample rate
+  int coinFlip = m_uniformRandomVariable->GetInteger (0, 100) % 2;
+
+  //if we are below the target of look around rate percentage, look around
+  if ((((100.0 * station->m_sampleCount) / (station->m_sampleCount + station->m_packetCount)) < m_lookAroundRate)
+      && (coinFlip == 1))
+    {
+      idx = GetNextSample (station);
+      if (idx != station->m_maxTpRate && idx != station->m_txrate)
+        {
+          station->m_sampleCount++;
+          station->m_isSampling = true;
+
+          //bookeeping for resetting stuff
+          if (station->m_packetCount >= 10000)
+            {
+              station->m_sampleCount = 0;
+              station->m_packetCount = 0;
+            }
+
+          station->m_sampleRate = idx;
+
+          //is this rate slower than the current best rate
+          station->m_sampleRateSlower =
+            (GetRateInfo (station, idx).perfectTxTime > GetRateInfo (station, station->m_maxTpRate).perfectTxTime);
+
+          //using the best rate instead
+          if (station->m_sampleRateSlower)
+            {
+              idx = station->m_maxTpRate;
+            }
+        }
+    }
+  //continue using the best rate
+  else
+    {
+      idx = station->m_maxTpRate;
+    }
+
+  NS_LOG_DEBUG ("Rate = " << idx << "(" << GetRateInfo (station, idx).mode << ")");
+
+  return idx;
+}
+
+void
+MinstrelHtWifiManager::UpdateRateStats (MinstrelHtWifiRemoteStation *station, uint32_t rate)
+{
+  MinstrelHtRateInfo &info = GetRateInfo (station, rate);
+  if (info.numRateAttempt == 0
+      || Simulator::Now () - info.lastUpdate < m_updateStats)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << station << rate);
+
+  double oldThroughput = info.throughput;
+  double oldProb = info.ewmaProb;
+
+  double prob = static_cast<double> (info.numRateSuccess) / info.numRateAttempt;
+  info.ewmaProb = (prob * (100 - m_ewmaLevel) + info.ewmaProb * m_ewmaLevel) / 100;
+  info.throughput = info.ewmaProb * (1e6 / info.perfectTxTime.GetMicroSeconds ());
+
+  info.numRateSuccess = 0;
+  info.numRateAttempt = 0;
+  info.lastUpdate = Simulator::Now ();
+
+  //Sample less often below 10% and above 95% of success
+  if (info.ewmaProb > 0.95 || info.ewmaProb < 0.1)
+    {
+      info.adjustedRetryCount = std::min<uint32_t> (info.retryCount, 2);
+    }
+  else
+    {
+      info.adjustedRetryCount = info.retryCount;
+    }
+
+  //if it's 0 allow one retry limit
+  if (info.adjustedRetryCount == 0)
+    {
+      info.adjustedRetryCount = 1;
+    }
+
+  NS_LOG_DEBUG (rate << " (" << info.mode << "): ewmaProb=" << info.ewmaProb << ", throughput=" << info.throughput);
+
+  if ((rate == station->m_maxTpRate || rate == station->m_maxTpRate2 || rate == station->m_maxProbRate)
+      && (info.throughput < oldThroughput || info.ewmaProb < oldProb))
+    {
+      //one of the best rates got worse: another rate may now be better
+      FindBestRates (station);
+    }
+  else
+    {
+      UpdateBestRates (station, rate);
+    }
+}
+
+void
+MinstrelHtWifiManager::UpdateBestRates (MinstrelHtWifiRemoteStation *station, uint32_t rate)
+{
+  const MinstrelHtRateInfo &info = GetRateInfo (station, rate);
+  if (rate != station->m_maxTpRate
+      && info.throughput > GetRateInfo (station, station->m_maxTpRate).throughput)
+    {
+      station->m_maxTpRate2 = station->m_maxTpRate;
+      station->m_maxTpRate = rate;
+    }
+  else if (rate != station->m_maxTpRate && rate != station->m_maxTpRate2
+           && info.throughput > GetRateInfo (station, station->m_maxTpRate2).throughput)
+    {
+      station->m_maxTpRate2 = rate;
+    }
+  if (rate != station->m_maxProbRate
+      && info.ewmaProb > GetRateInfo (station, station->m_maxProbRate).ewmaProb)
+    {
+      station->m_maxProbRate = rate;
+    }
+}
+
+void
+MinstrelHtWifiManager::FindBestRates (MinstrelHtWifiRemoteStation *station)
+{
+  NS_LOG_FUNCTION (this << station);
+  uint32_t indexMaxTp = station->m_lowestRate;
+  uint32_t indexMaxTp2 = station->m_lowestRate;
+  uint32_t indexMaxProb = station->m_lowestRate;
+  double maxTp = 0;
+  double maxTp2 = 0;
+  double maxProb = 0;
+  for (uint32_t g = 0; g < MINSTREL_HT_MAX_GROUPS; g++)
+    {
+      if (!station->m_groupSupported[g])
+        {
+          continue;
+        }
+      for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+        {
+          const MinstrelHtRateInfo &info = station->m_rates[g][i];
+          if (!info.supported)
+            {
+              continue;
+            }
+          uint32_t rate = g * MINSTREL_HT_MAX_GROUP_RATES + i;
+          if (info.throughput > maxTp)
+            {
+              indexMaxTp2 = indexMaxTp;
+              maxTp2 = maxTp;
+              indexMaxTp = rate;
+              maxTp = info.throughput;
+            }
+          else if (info.throughput > maxTp2)
+            {
+              indexMaxTp2 = rate;
+              maxTp2 = info.throughput;
+            }
+          if (info.ewmaProb > maxProb)
+            {
+              indexMaxProb = rate;
+              maxProb = info.ewmaProb;
+            }
+        }
+    }
+  station->m_maxTpRate = indexMaxTp;
+  station->m_maxTpRate2 = indexMaxTp2;
+  station->m_maxProbRate = indexMaxProb;
+
+  NS_LOG_DEBUG ("max throughput=" << indexMaxTp << "\tsecond max throughput=" << indexMaxTp2 <<
+                "\tmax prob=" << indexMaxProb);
+}
+
+void
+MinstrelHtWifiManager::RateInit (MinstrelHtWifiRemoteStation *station)
+{
+  NS_LOG_FUNCTION (station);
+
+  for (uint32_t g = 0; g < MINSTREL_HT_MAX_GROUPS; g++)
+    {
+      station->m_groupSupported[g] = false;
+      for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+        {
+          station->m_rates[g][i].supported = false;
+        }
+    }
+
+  station->m_isHt = false;
+  if (HasHtSupported () || HasVhtSupported ())
+    {
+      //use VHT MCSs if the station supports any of them, HT MCSs otherwise
+      bool useVht = false;
+      for (uint32_t i = 0; i < GetNMcsSupported (station); i++)
+        {
+          if (GetMcsSupported (station, i).GetModulationClass () == WIFI_MOD_CLASS_VHT)
+            {
+              useVht = true;
+            }
+        }
+      uint32_t channelWidth = std::min (GetChannelWidth (station), GetPhy ()->GetChannelWidth ());
+      bool shortGuardInterval = GetShortGuardInterval (station) && GetPhy ()->GetGuardInterval ();
+      for (uint32_t g = 1; g < MINSTREL_HT_MAX_GROUPS; g++)
+        {
+          if (GetGroupChannelWidth (g) > channelWidth
+              || (GetGroupShortGuardInterval (g) && !shortGuardInterval))
+            {
+              continue;
+            }
+          for (uint32_t i = 0; i < GetNMcsSupported (station); i++)
+            {
+              WifiMode mcs = GetMcsSupported (station, i);
+              if (mcs.GetModulationClass () != (useVht ? WIFI_MOD_CLASS_VHT : WIFI_MOD_CLASS_HT))
+                {
+                  continue;
+                }
+              uint8_t mcsValue = mcs.GetMcsValue ();
+              if (mcsValue >= (useVht ? 10 : 8)
+                  || (useVht && mcsValue == 9 && GetGroupChannelWidth (g) == 20))
+                {
+                  //multiple spatial streams, or not allowed in this group
+                  continue;
+                }
+              station->m_rates[g][mcsValue].supported = true;
+              station->m_rates[g][mcsValue].mode = mcs;
+              station->m_groupSupported[g] = true;
+              station->m_isHt = true;
+            }
+        }
+    }
+  if (!station->m_isHt)
+    {
+      for (uint32_t i = 0; i < std::min (GetNSupported (station), MINSTREL_HT_MAX_GROUP_RATES); i++)
+        {
+          station->m_rates[0][i].supported = true;
+          station->m_rates[0][i].mode = GetSupported (station, i);
+          station->m_groupSupported[0] = true;
+        }
+    }
+
+  bool first = true;
+  uint32_t highestGroup = 0;
+  for (uint32_t g = 0; g < MINSTREL_HT_MAX_GROUPS; g++)
+    {
+      if (!station->m_groupSupported[g])
+        {
+          continue;
+        }
+      highestGroup = g;
+      for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+        {
+          MinstrelHtRateInfo &info = station->m_rates[g][i];
+          if (!info.supported)
+            {
+              continue;
+            }
+          if (first)
+            {
+              station->m_lowestRate = g * MINSTREL_HT_MAX_GROUP_RATES + i;
+              first = false;
+            }
+          info.numRateAttempt = 0;
+          info.numRateSuccess = 0;
+          info.ewmaProb = 0;
+          info.throughput = 0;
+          info.lastUpdate = Simulator::Now ();
+          if (g == 0)
+            {
+              uint32_t channelWidth = GetChannelWidth (station);
+              info.perfectTxTime = GetCalcTxTime (info.mode, (channelWidth > 20 && channelWidth != 22) ? 20 : channelWidth, false);
+            }
+          else
+            {
+              info.perfectTxTime = GetCalcTxTime (info.mode, GetGroupChannelWidth (g), GetGroupShortGuardInterval (g));
+            }
+          info.retryCount = 1;
+          info.adjustedRetryCount = 1;
+          //Emulating minstrel.c::ath_rate_ctl_reset
+          //We only check from 2 to 10 retries. This guarantee that
+          //at least one retry is permitter.
+          for (uint32_t retries = 2; retries < 11; retries++)
+            {
+              if (CalculateTimeUnicastPacket (info.perfectTxTime, 0, retries) > MilliSeconds (6))
+                {
+                  break;
+                }
+              info.retryCount = retries;
+              info.adjustedRetryCount = retries;
+            }
+        }
+    }
+
+  //start the rate at half way of the fastest group
+  uint32_t nRates = 0;
+  for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+    {
+      if (station->m_rates[highestGroup][i].supported)
+        {
+          nRates = i + 1;
+        }
+    }
+  station->m_txrate = station->m_lowestRate;
+  for (uint32_t i = nRates / 2 + 1; i > 0; i--)
+    {
+      if (station->m_rates[highestGroup][i - 1].supported)
+        {
+          station->m_txrate = highestGroup * MINSTREL_HT_MAX_GROUP_RATES + i - 1;
+          break;
+        }
+    }
+  station->m_maxTpRate = station->m_txrate;
+  station->m_maxTpRate2 = station->m_txrate;
+  station->m_maxProbRate = station->m_txrate;
+  station->m_sampleGroup = highestGroup;
+  station->m_isSampling = false;
+  station->m_sampleRateSlower = false;
+}
+
+Time
+MinstrelHtWifiManager::CalculateTimeUnicastPacket (Time dataTransmissionTime, uint32_t shortRetries, uint32_t longRetries)
+{
+  NS_LOG_FUNCTION (this << dataTransmissionTime << shortRetries << longRetries);
+  //See rc80211_minstrel.c
+
+  //First transmission (DATA + ACK timeout)
+  Time tt = dataTransmissionTime + GetMac ()->GetAckTimeout ();
+
+  uint32_t cwMax = 1023;
+  uint32_t cw = 31;
+  for (uint32_t retry = 0; retry < longRetries; retry++)
+    {
+      //Add one re-transmission (DATA + ACK timeout)
+      tt += dataTransmissionTime + GetMac ()->GetAckTimeout ();
+
+      //Add average back off (half the current contention window)
+      tt += NanoSeconds ((cw / 2) * GetMac ()->GetSlot ());
+
+      //Update contention window
+      cw = std::min (cwMax, (cw + 1) * 2);
+    }
+
+  return tt;
+}
+
+void
+MinstrelHtWifiManager::InitSampleTable (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  //each column is a random permutation of the rate indices of a group
+  for (uint32_t col = 0; col < MINSTREL_HT_SAMPLE_COLUMNS; col++)
+    {
+      for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+        {
+          m_sampleTable[i][col] = MINSTREL_HT_MAX_GROUP_RATES;
+        }
+      for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+        {
+          uint32_t newIndex = (i + m_uniformRandomVariable->GetInteger (0, MINSTREL_HT_MAX_GROUP_RATES)) % MINSTREL_HT_MAX_GROUP_RATES;
+
+          //this loop is used for filling in other uninitilized places
+          while (m_sampleTable[newIndex][col] != MINSTREL_HT_MAX_GROUP_RATES)
+            {
+              newIndex = (newIndex + 1) % MINSTREL_HT_MAX_GROUP_RATES;
+            }
+          m_sampleTable[newIndex][col] = i;
+        }
+    }
+  m_sampleTableInitialized = true;
+}
+
+void
+MinstrelHtWifiManager::PrintTable (MinstrelHtWifiRemoteStation *station)
+{
+  NS_LOG_DEBUG ("PrintTable=" << station);
+
+  for (uint32_t g = 0; g < MINSTREL_HT_MAX_GROUPS; g++)
+    {
+      for (uint32_t i = 0; i < MINSTREL_HT_MAX_GROUP_RATES; i++)
+        {
+          const MinstrelHtRateInfo &info = station->m_rates[g][i];
+          if (info.supported)
+            {
+              NS_LOG_DEBUG (g * MINSTREL_HT_MAX_GROUP_RATES + i << " (" << info.mode << "): " << info.perfectTxTime << ", retryCount = " << info.retryCount << ", adjustedRetryCount = " << info.adjustedRetryCount);
+            }
+        }
+    }
+}
+
+} //namespace ns3
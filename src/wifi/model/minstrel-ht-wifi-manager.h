@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MINSTREL_HT_WIFI_MANAGER_H
+#define MINSTREL_HT_WIFI_MANAGER_H
+
+#include "wifi-remote-station-manager.h"
+#include "wifi-mode.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include <map>
+
+namespace ns3 {
+
+struct MinstrelHtWifiRemoteStation;
+
+/**
+ * Maximum number of rates held by a Minstrel-HT group. The legacy group
+ * may hold up to twelve rates (DSSS and ERP-OFDM), MCS groups up to ten.
+ */
+static const uint32_t MINSTREL_HT_MAX_GROUP_RATES = 12;
+/**
+ * Number of Minstrel-HT groups: one legacy group followed by one group
+ * per channel width (20, 40, 80 and 160 MHz) and guard interval.
+ */
+static const uint32_t MINSTREL_HT_MAX_GROUPS = 9;
+/**
+ * Number of columns of the sample table shared by all stations.
+ */
+static const uint32_t MINSTREL_HT_SAMPLE_COLUMNS = 10;
+
+/**
+ * A struct to contain the statistics of a rate of a Minstrel-HT group
+ */
+struct MinstrelHtRateInfo
+{
+  WifiMode mode;                ///< the mode of this rate
+  bool supported;               ///< whether the remote station supports this rate
+  Time perfectTxTime;           ///< time to send a reference packet without retries
+  uint32_t retryCount;          ///< retry limit
+  uint32_t adjustedRetryCount;  ///< adjust the retry limit for this rate
+  uint32_t numRateAttempt;      ///< attempts since the last statistics update
+  uint32_t numRateSuccess;      ///< successes since the last statistics update
+  double ewmaProb;              ///< EWMA of the success probability, in [0, 1]
+  double throughput;            ///< expected throughput (successful packets per second)
+  Time lastUpdate;              ///< time of the last statistics update of this rate
+};
+
+
+/**
+ * \brief Implementation of the Minstrel-HT rate control algorithm
+ * \ingroup wifi
+ *
+ * Minstrel-HT extends Minstrel to IEEE 802.11n/ac stations by organizing
+ * MCSs into groups sharing the same channel width and guard interval.
+ * Stations without HT support are handled by a single legacy group, which
+ * makes this manager usable as a drop-in replacement of MinstrelWifiManager.
+ *
+ * The per-station state is kept in fixed-size arrays indexed by group and
+ * rate, and there is no periodic statistics table recomputation: the
+ * statistics of a rate are folded into its EWMA when a transmission status
+ * is reported for that rate and at least UpdateStatistics has elapsed since
+ * its previous update. The best rates are then adjusted incrementally, and
+ * the whole table is only scanned again when one of the current best rates
+ * gets worse. The cost of a status report is thus independent of the number
+ * of remote stations and, in the common case, of the number of rates.
+ *
+ * Only single spatial stream MCSs are used.
+ */
+class MinstrelHtWifiManager : public WifiRemoteStationManager
+{
+public:
+  static TypeId GetTypeId (void);
+  MinstrelHtWifiManager ();
+  virtual ~MinstrelHtWifiManager ();
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   *
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+
+private:
+  //overriden from base class
+  virtual WifiRemoteStation * DoCreateStation (void) const;
+  virtual void DoReportRxOk (WifiRemoteStation *station,
+                             double rxSnr, WifiMode txMode);
+  virtual void DoReportRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportDataFailed (WifiRemoteStation *station);
+  virtual void DoReportRtsOk (WifiRemoteStation *station,
+                              double ctsSnr, WifiMode ctsMode, double rtsSnr);
+  virtual void DoReportDataOk (WifiRemoteStation *station,
+                               double ackSnr, WifiMode ackMode, double dataSnr);
+  virtual void DoReportFinalRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportFinalDataFailed (WifiRemoteStation *station);
+  virtual WifiTxVector DoGetDataTxVector (WifiRemoteStation *station, uint32_t size);
+  virtual WifiTxVector DoGetRtsTxVector (WifiRemoteStation *station);
+
+  virtual bool DoNeedDataRetransmission (WifiRemoteStation *st, Ptr<const Packet> packet, bool normally);
+
+  virtual bool IsLowLatency (void) const;
+
+  /**
+   * \param group the group index
+   *
+   * \return the channel width (in MHz) of the given MCS group
+   */
+  static uint32_t GetGroupChannelWidth (uint32_t group);
+  /**
+   * \param group the group index
+   *
+   * \return true if the given MCS group uses the short guard interval
+   */
+  static bool GetGroupShortGuardInterval (uint32_t group);
+
+  /**
+   * Return the time needed to transmit a reference packet with the
+   * given mode, channel width and guard interval. Results are cached
+   * per manager, so that they are computed once for all stations.
+   *
+   * \param mode the mode
+   * \param channelWidth the channel width (in MHz)
+   * \param shortGuardInterval whether the short guard interval is used
+   *
+   * \return the transmission time of a reference packet
+   */
+  Time GetCalcTxTime (WifiMode mode, uint32_t channelWidth, bool shortGuardInterval);
+
+  /**
+   * Build the tx vector used to send data at the given rate.
+   *
+   * \param station the remote station
+   * \param rate the flat rate index (group * MINSTREL_HT_MAX_GROUP_RATES + rate)
+   *
+   * \return the tx vector
+   */
+  WifiTxVector GetRateTxVector (MinstrelHtWifiRemoteStation *station, uint32_t rate);
+
+  /**
+   * \param station the remote station
+   * \param rate the flat rate index
+   *
+   * \return the statistics of the given rate
+   */
+  static MinstrelHtRateInfo & GetRateInfo (MinstrelHtWifiRemoteStation *station, uint32_t rate);
+
+  //update the number of retries and reset accordingly
+  void UpdateRetry (MinstrelHtWifiRemoteStation *station);
+
+  //getting the next rate to sample, cycling through the groups
+  uint32_t GetNextSample (MinstrelHtWifiRemoteStation *station);
+
+  //find a rate to use for the next packet
+  uint32_t FindRate (MinstrelHtWifiRemoteStation *station);
+
+  /**
+   * Fold the counters of the given rate into its EWMA if UpdateStatistics
+   * elapsed since its previous update, and adjust the best rates.
+   *
+   * \param station the remote station
+   * \param rate the flat rate index
+   */
+  void UpdateRateStats (MinstrelHtWifiRemoteStation *station, uint32_t rate);
+
+  /**
+   * Adjust the best throughput and best probability rates after the
+   * statistics of the given rate changed.
+   *
+   * \param station the remote station
+   * \param rate the flat rate index
+   */
+  void UpdateBestRates (MinstrelHtWifiRemoteStation *station, uint32_t rate);
+
+  //find the best rates by scanning all the supported rates
+  void FindBestRates (MinstrelHtWifiRemoteStation *station);
+
+  /**
+   * Select the rate to use for the next retry, following the Minstrel
+   * multi-rate retry chain.
+   *
+   * \param station the remote station
+   * \param longRetries the number of failed attempts so far
+   * \param [out] rate the rate to use for the next retry
+   *
+   * \return false if the retry chain is exhausted
+   */
+  bool GetRetryChainRate (MinstrelHtWifiRemoteStation *station, uint32_t longRetries, uint32_t &rate);
+
+  //initialize the per station rate table
+  void RateInit (MinstrelHtWifiRemoteStation *station);
+
+  /**
+   * Estimate the time to transmit the given packet with the given number of retries.
+   * See MinstrelWifiManager::CalculateTimeUnicastPacket.
+   *
+   * \param dataTransmissionTime the transmission time of the data
+   * \param shortRetries the number of short retries
+   * \param longRetries the number of long retries
+   *
+   * \return the estimated transmission time
+   */
+  Time CalculateTimeUnicastPacket (Time dataTransmissionTime, uint32_t shortRetries, uint32_t longRetries);
+
+  //initialize the Sample Table shared by all stations
+  void InitSampleTable (void);
+
+  //printing Minstrel-HT Table
+  void PrintTable (MinstrelHtWifiRemoteStation *station);
+
+  void CheckInit (MinstrelHtWifiRemoteStation *station);  ///< check for initializations
+
+  std::map<uint64_t, Time> m_calcTxTime;  ///< cached reference packet TxTime per mode, width and guard interval
+  Time m_updateStats;       ///< minimum interval between two statistics updates of a rate
+  double m_lookAroundRate;  ///< the % to try other rates than our current rate
+  double m_ewmaLevel;       ///< exponential weighted moving average
+  uint32_t m_pktLen;        ///< packet length used for calculate mode TxTime
+
+  uint32_t m_sampleTable[MINSTREL_HT_MAX_GROUP_RATES][MINSTREL_HT_SAMPLE_COLUMNS];  ///< sample table shared by all stations
+  bool m_sampleTableInitialized;  ///< whether the sample table has been filled
+
+  //Provides uniform random variables.
+  Ptr<UniformRandomVariable> m_uniformRandomVariable;
+};
+
+} //namespace ns3
+
+#endif /* MINSTREL_HT_WIFI_MANAGER_H */
@@ -43,10 +43,9 @@ public:
 
   NistErrorRateModel ();
 
-  virtual double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
-
-
 private:
+  virtual double DoGetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
+
   /**
    * Return the coded BER for the given p and b.
    *
@@ -294,6 +294,19 @@ RegularWifiMac::GetCtsToSelfSupported () const
   return m_low->GetCtsToSelfSupported ();
 }
 
+void
+RegularWifiMac::SetFastForwardBackoff (bool enable)
+{
+  NS_LOG_FUNCTION (this << enable);
+  m_dcfManager->SetFastForwardBackoff (enable);
+}
+
+bool
+RegularWifiMac::GetFastForwardBackoff (void) const
+{
+  return m_dcfManager->GetFastForwardBackoff ();
+}
+
 void
 RegularWifiMac::SetSlot (Time slotTime)
 {
@@ -684,6 +697,14 @@ RegularWifiMac::GetTypeId (void)
                    MakeBooleanAccessor (&RegularWifiMac::SetCtsToSelfSupported,
                                         &RegularWifiMac::GetCtsToSelfSupported),
                    MakeBooleanChecker ())
+    .AddAttribute ("FastForwardBackoff",
+                   "Schedule a single access timer at the expected end of the backoffs, "
+                   "moved on every change of the medium state, instead of waking up "
+                   "after each busy period",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RegularWifiMac::SetFastForwardBackoff,
+                                        &RegularWifiMac::GetFastForwardBackoff),
+                   MakeBooleanChecker ())
     .AddAttribute ("DcaTxop", "The DcaTxop object",
                    PointerValue (),
                    MakePointerAccessor (&RegularWifiMac::GetDcaTxop),
@@ -128,6 +128,20 @@ public:
    *         false otherwise.
    */
   bool GetCtsToSelfSupported () const;
+
+  /**
+   * Enable or disable the fast-forwarding of idle backoffs by the
+   * DcfManager (see DcfManager::SetFastForwardBackoff).
+   *
+   * \param enable true to fast-forward idle backoffs,
+   *               false otherwise
+   */
+  void SetFastForwardBackoff (bool enable);
+  /**
+   * \return true if idle backoffs are fast-forwarded,
+   *         false otherwise.
+   */
+  bool GetFastForwardBackoff (void) const;
   /**
    * \return the MAC address associated to this MAC layer.
    */
@@ -83,6 +83,8 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 {
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
+  std::vector<uint32_t> receivers;
+  std::vector<Ptr<MobilityModel> > receiverMobilities;
   uint32_t j = 0;
   for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
     {
@@ -93,35 +95,44 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
             {
               continue;
             }
+          receivers.push_back (j);
+          receiverMobilities.push_back ((*i)->GetMobility ()->GetObject<MobilityModel> ());
+        }
+    }
 
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
-            {
-              dstNode = 0xffffffff;
-            }
-          else
-            {
-              dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
-            }
-
-          struct Parameters parameters;
-          parameters.rxPowerDbm = rxPowerDbm;
-          parameters.aMpdu = aMpdu;
-          parameters.duration = duration;
-          parameters.txVector = txVector;
-          parameters.preamble = preamble;
+  std::vector<double> rxPowersDbm;
+  m_loss->CalcRxPowerBatch (txPowerDbm, senderMobility, receiverMobilities, rxPowersDbm);
 
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive, this,
-                                          j, copy, parameters);
+  for (uint32_t k = 0; k < receivers.size (); k++)
+    {
+      j = receivers[k];
+      Ptr<MobilityModel> receiverMobility = receiverMobilities[k];
+      Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+      double rxPowerDbm = rxPowersDbm[k];
+      NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                    "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+      Ptr<Packet> copy = packet->Copy ();
+      Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
+      uint32_t dstNode;
+      if (dstNetDevice == 0)
+        {
+          dstNode = 0xffffffff;
+        }
+      else
+        {
+          dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
         }
+
+      struct Parameters parameters;
+      parameters.rxPowerDbm = rxPowerDbm;
+      parameters.aMpdu = aMpdu;
+      parameters.duration = duration;
+      parameters.txVector = txVector;
+      parameters.preamble = preamble;
+
+      Simulator::ScheduleWithContext (dstNode,
+                                      delay, &YansWifiChannel::Receive, this,
+                                      j, copy, parameters);
     }
 }
 
@@ -62,7 +62,10 @@ private:
 class DcfManagerTest : public TestCase
 {
 public:
-  DcfManagerTest ();
+  /**
+   * \param fastForward whether the DcfManager fast-forwards idle backoffs
+   */
+  DcfManagerTest (bool fastForward);
   virtual void DoRun (void);
 
   void NotifyAccessGranted (uint32_t i);
@@ -105,6 +108,7 @@ private:
   DcfManager *m_dcfManager;
   DcfStates m_dcfStates;
   uint32_t m_ackTimeoutValue;
+  bool m_fastForward;
 };
 
 DcfStateTest::DcfStateTest (DcfManagerTest *test, uint32_t i)
@@ -153,8 +157,9 @@ DcfStateTest::DoNotifyWakeUp (void)
 {
 }
 
-DcfManagerTest::DcfManagerTest ()
-  : TestCase ("DcfManager")
+DcfManagerTest::DcfManagerTest (bool fastForward)
+  : TestCase (fastForward ? "DcfManager with fast-forwarded backoffs" : "DcfManager"),
+    m_fastForward (fastForward)
 {
 }
 
@@ -239,6 +244,7 @@ DcfManagerTest::StartTest (uint64_t slotTime, uint64_t sifs, uint64_t eifsNoDifs
   m_dcfManager->SetSlot (MicroSeconds (slotTime));
   m_dcfManager->SetSifs (MicroSeconds (sifs));
   m_dcfManager->SetEifsNoDifs (MicroSeconds (eifsNoDifsNoSifs + sifs));
+  m_dcfManager->SetFastForwardBackoff (m_fastForward);
   m_ackTimeoutValue = ackTimeoutValue;
 }
 
@@ -702,7 +708,8 @@ public:
 DcfTestSuite::DcfTestSuite ()
   : TestSuite ("devices-wifi-dcf", UNIT)
 {
-  AddTestCase (new DcfManagerTest, TestCase::QUICK);
+  AddTestCase (new DcfManagerTest (false), TestCase::QUICK);
+  AddTestCase (new DcfManagerTest (true), TestCase::QUICK);
 }
 
 static DcfTestSuite g_dcfTestSuite;
@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/object.h>
+#include <ns3/object-factory.h>
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/double.h>
+#include <ns3/boolean.h>
+#include "ns3/wifi-phy.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/yans-error-rate-model.h"
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ErrorRateModelTest");
+
+/**
+ * Check that the chunk success rates interpolated from the lookup tables
+ * stay within a fixed bound of the exact values, for every modulation
+ * family (DSSS, OFDM, HT and VHT) and a range of chunk sizes.
+ */
+class ErrorRateModelLookupTableTest : public TestCase
+{
+public:
+  ErrorRateModelLookupTableTest (std::string typeName);
+  virtual ~ErrorRateModelLookupTableTest ();
+  virtual void DoRun (void);
+
+
+private:
+  /**
+   * \param exact model computing exact success rates
+   * \param tabulated model interpolating success rates
+   * \param mode the mode to check
+   * \param channelWidth the channel width (MHz)
+   *
+   * \return the largest absolute difference found between both models
+   */
+  double GetMaxError (Ptr<ErrorRateModel> exact, Ptr<ErrorRateModel> tabulated,
+                      WifiMode mode, uint32_t channelWidth);
+
+  std::string m_typeName;
+};
+
+ErrorRateModelLookupTableTest::ErrorRateModelLookupTableTest (std::string typeName)
+  : TestCase ("Check lookup table accuracy of " + typeName),
+    m_typeName (typeName)
+{
+}
+
+ErrorRateModelLookupTableTest::~ErrorRateModelLookupTableTest ()
+{
+}
+
+double
+ErrorRateModelLookupTableTest::GetMaxError (Ptr<ErrorRateModel> exact, Ptr<ErrorRateModel> tabulated,
+                                            WifiMode mode, uint32_t channelWidth)
+{
+  WifiTxVector txVector;
+  txVector.SetMode (mode);
+  txVector.SetChannelWidth (channelWidth);
+  double maxError = 0;
+  uint32_t chunkSizes[] = { 1, 100, 1500, 12000, 120000 };
+  for (double snrDb = -15.0; snrDb <= 55.0; snrDb += 0.173)
+    {
+      double snr = std::pow (10.0, snrDb / 10.0);
+      for (uint32_t i = 0; i < sizeof (chunkSizes) / sizeof (chunkSizes[0]); i++)
+        {
+          double expected = exact->GetChunkSuccessRate (mode, txVector, snr, chunkSizes[i]);
+          double actual = tabulated->GetChunkSuccessRate (mode, txVector, snr, chunkSizes[i]);
+          maxError = std::max (maxError, std::fabs (expected - actual));
+        }
+    }
+  return maxError;
+}
+
+void
+ErrorRateModelLookupTableTest::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_typeName);
+  Ptr<ErrorRateModel> exact = factory.Create<ErrorRateModel> ();
+  factory.Set ("UseLookupTable", BooleanValue (true));
+  Ptr<ErrorRateModel> tabulated = factory.Create<ErrorRateModel> ();
+
+  std::vector<WifiMode> modes;
+  modes.push_back (WifiPhy::GetDsssRate1Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate2Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate5_5Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate11Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate6Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate9Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate12Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate18Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate24Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate36Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate48Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate54Mbps ());
+  for (uint32_t i = 0; i < modes.size (); i++)
+    {
+      double error = GetMaxError (exact, tabulated, modes[i], 20);
+      NS_TEST_EXPECT_MSG_LT (error, 1e-3, "Inaccurate lookup table for mode " << modes[i]);
+    }
+
+  std::vector<WifiMode> htModes;
+  htModes.push_back (WifiPhy::GetHtMcs0 ());
+  htModes.push_back (WifiPhy::GetHtMcs3 ());
+  htModes.push_back (WifiPhy::GetHtMcs5 ());
+  htModes.push_back (WifiPhy::GetHtMcs7 ());
+  htModes.push_back (WifiPhy::GetVhtMcs0 ());
+  htModes.push_back (WifiPhy::GetVhtMcs5 ());
+  htModes.push_back (WifiPhy::GetVhtMcs8 ());
+  htModes.push_back (WifiPhy::GetVhtMcs9 ());
+  for (uint32_t i = 0; i < htModes.size (); i++)
+    {
+      double error = GetMaxError (exact, tabulated, htModes[i], 80);
+      NS_TEST_EXPECT_MSG_LT (error, 1e-3, "Inaccurate lookup table for mode " << htModes[i]);
+    }
+
+  // Out of the tabulated range, the exact value must be returned
+  WifiTxVector txVector;
+  txVector.SetMode (WifiPhy::GetOfdmRate54Mbps ());
+  txVector.SetChannelWidth (20);
+  double snr = std::pow (10.0, -20.0 / 10.0);
+  NS_TEST_EXPECT_MSG_EQ_TOL (tabulated->GetChunkSuccessRate (WifiPhy::GetOfdmRate54Mbps (), txVector, snr, 1),
+                             exact->GetChunkSuccessRate (WifiPhy::GetOfdmRate54Mbps (), txVector, snr, 1),
+                             1e-12, "Out of range SNR not evaluated exactly");
+}
+
+
+class ErrorRateModelTestSuite : public TestSuite
+{
+public:
+  ErrorRateModelTestSuite ();
+};
+
+ErrorRateModelTestSuite::ErrorRateModelTestSuite ()
+  : TestSuite ("devices-wifi-error-rate-model", UNIT)
+{
+  AddTestCase (new ErrorRateModelLookupTableTest ("ns3::NistErrorRateModel"), TestCase::QUICK);
+  AddTestCase (new ErrorRateModelLookupTableTest ("ns3::YansErrorRateModel"), TestCase::QUICK);
+}
+
+static ErrorRateModelTestSuite g_errorRateModelTestSuite;
@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/wifi-net-device.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/adhoc-wifi-mac.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/minstrel-ht-wifi-manager.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/rng-seed-manager.h"
+
+using namespace ns3;
+
+/**
+ * Drive a MinstrelHtWifiManager over an emulated channel on which all
+ * the rates up to a given data rate succeed and all faster rates fail,
+ * and check that the manager converges to the fastest working rate.
+ */
+class MinstrelHtConvergenceTest : public TestCase
+{
+public:
+  /**
+   * \param name the name of the test
+   * \param standard the standard to configure
+   * \param channelWidth the channel width (MHz) of the phy
+   * \param maxDataRate the data rate above which transmissions fail
+   * \param expectedDataRate the data rate the manager should converge to
+   */
+  MinstrelHtConvergenceTest (std::string name, enum WifiPhyStandard standard, uint32_t channelWidth,
+                             uint64_t maxDataRate, uint64_t expectedDataRate);
+
+  virtual void DoRun (void);
+private:
+  /// Send one packet, with retries, and record the rate used at the first attempt
+  void SendPacket (void);
+  /**
+   * \param txVector the tx vector used
+   * \return the data rate of the given tx vector
+   */
+  static uint64_t GetDataRate (WifiTxVector txVector);
+
+  enum WifiPhyStandard m_standard;  ///< standard
+  uint32_t m_channelWidth;          ///< channel width of the phy
+  uint64_t m_maxDataRate;           ///< highest working data rate
+  uint64_t m_expectedDataRate;      ///< expected data rate
+  Ptr<WifiRemoteStationManager> m_manager;  ///< manager under test
+  Mac48Address m_remote;            ///< remote station address
+  uint32_t m_sent;                  ///< packets sent after warm-up
+  uint32_t m_sentAtExpectedRate;    ///< packets first sent at the expected rate after warm-up
+  uint32_t m_failedAboveMax;        ///< attempts above the highest working rate after warm-up
+};
+
+MinstrelHtConvergenceTest::MinstrelHtConvergenceTest (std::string name, enum WifiPhyStandard standard,
+                                                      uint32_t channelWidth, uint64_t maxDataRate,
+                                                      uint64_t expectedDataRate)
+  : TestCase ("Check Minstrel-HT convergence with " + name),
+    m_standard (standard),
+    m_channelWidth (channelWidth),
+    m_maxDataRate (maxDataRate),
+    m_expectedDataRate (expectedDataRate),
+    m_sent (0),
+    m_sentAtExpectedRate (0),
+    m_failedAboveMax (0)
+{
+}
+
+uint64_t
+MinstrelHtConvergenceTest::GetDataRate (WifiTxVector txVector)
+{
+  return txVector.GetMode ().GetDataRate (txVector.GetChannelWidth (), txVector.IsShortGuardInterval (), 1);
+}
+
+void
+MinstrelHtConvergenceTest::SendPacket (void)
+{
+  WifiMacHeader hdr;
+  hdr.SetTypeData ();
+  hdr.SetAddr1 (m_remote);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  bool warm = Simulator::Now () > Seconds (5);
+
+  WifiTxVector txVector = m_manager->GetDataTxVector (m_remote, &hdr, packet, packet->GetSize ());
+  if (warm)
+    {
+      m_sent++;
+      if (GetDataRate (txVector) == m_expectedDataRate)
+        {
+          m_sentAtExpectedRate++;
+        }
+    }
+  while (true)
+    {
+      if (GetDataRate (txVector) <= m_maxDataRate)
+        {
+          m_manager->ReportDataOk (m_remote, &hdr, 0, WifiMode (), 0);
+          break;
+        }
+      if (warm)
+        {
+          m_failedAboveMax++;
+        }
+      m_manager->ReportDataFailed (m_remote, &hdr);
+      if (!m_manager->NeedDataRetransmission (m_remote, &hdr, packet))
+        {
+          m_manager->ReportFinalDataFailed (m_remote, &hdr);
+          break;
+        }
+      txVector = m_manager->GetDataTxVector (m_remote, &hdr, packet, packet->GetSize ());
+    }
+}
+
+void
+MinstrelHtConvergenceTest::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  Ptr<AdhocWifiMac> mac = CreateObject<AdhocWifiMac> ();
+  mac->ConfigureStandard (m_standard);
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<WifiNetDevice> dev = CreateObject<WifiNetDevice> ();
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetChannel (channel);
+  phy->SetDevice (dev);
+  phy->SetMobility (mobility);
+  phy->ConfigureStandard (m_standard);
+  phy->SetChannelWidth (m_channelWidth);
+  phy->SetGuardInterval (m_standard == WIFI_PHY_STANDARD_80211ac);
+  Ptr<MinstrelHtWifiManager> manager = CreateObject<MinstrelHtWifiManager> ();
+  manager->AssignStreams (1);
+  Ptr<Node> node = CreateObject<Node> ();
+  mac->SetAddress (Mac48Address::Allocate ());
+  dev->SetMac (mac);
+  dev->SetPhy (phy);
+  dev->SetRemoteStationManager (manager);
+  node->AddDevice (dev);
+  m_manager = manager;
+
+  //Adhoc stations learn every legacy mode; add the MCSs by hand
+  m_remote = Mac48Address::Allocate ();
+  m_manager->AddAllSupportedModes (m_remote);
+  if (m_standard == WIFI_PHY_STANDARD_80211ac)
+    {
+      m_manager->SetHtSupported (true);
+      m_manager->SetVhtSupported (true);
+      for (uint32_t i = 0; i < phy->GetNMcs (); i++)
+        {
+          m_manager->AddSupportedMcs (m_remote, phy->GetMcs (i));
+        }
+    }
+
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      Simulator::Schedule (MilliSeconds (2 * i), &MinstrelHtConvergenceTest::SendPacket, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  //About LookAroundRate percent of the packets are sent at sampled rates
+  NS_TEST_ASSERT_MSG_GT (m_sent, 0, "No packet sent after warm-up");
+  NS_TEST_EXPECT_MSG_GT (m_sentAtExpectedRate, m_sent * 8 / 10, "Minstrel-HT did not converge to the expected rate");
+  NS_TEST_EXPECT_MSG_LT (m_failedAboveMax, m_sent * 2 / 10, "Too many attempts at failing rates");
+  m_manager = 0;
+}
+
+
+class MinstrelHtTestSuite : public TestSuite
+{
+public:
+  MinstrelHtTestSuite ();
+};
+
+MinstrelHtTestSuite::MinstrelHtTestSuite ()
+  : TestSuite ("devices-wifi-minstrel-ht", UNIT)
+{
+  AddTestCase (new MinstrelHtConvergenceTest ("802.11a legacy rates", WIFI_PHY_STANDARD_80211a, 20,
+                                              24000000, 24000000), TestCase::QUICK);
+  AddTestCase (new MinstrelHtConvergenceTest ("802.11ac MCS groups", WIFI_PHY_STANDARD_80211ac, 80,
+                                              WifiPhy::GetVhtMcs5 ().GetDataRate (80, true, 1),
+                                              WifiPhy::GetVhtMcs5 ().GetDataRate (80, true, 1)), TestCase::QUICK);
+}
+
+static MinstrelHtTestSuite g_minstrelHtTestSuite;